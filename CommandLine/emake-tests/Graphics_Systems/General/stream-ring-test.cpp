@@ -0,0 +1,93 @@
+#include "Graphics_Systems/General/GSstream_ring.cpp"
+#include "Graphics_Systems/General/GSstream_ring.h"
+
+#include <gtest/gtest.h>
+
+#include <memory>
+
+using enigma::HostStreamRingStorage;
+using enigma::StreamRing;
+using enigma::StreamRingStorage;
+
+namespace {
+
+// Storage that can't be mapped, like a context without persistent mapping.
+class UnmappableStorage : public StreamRingStorage {
+ public:
+  unsigned char* map(std::size_t) override { return nullptr; }
+  void unmap() override {}
+  Fence fence() override { return 0; }
+  void wait(Fence) override {}
+};
+
+}  // namespace
+
+TEST(StreamRingTest, AllocatesAlignedWithinASegment) {
+  StreamRing ring(std::unique_ptr<StreamRingStorage>(new HostStreamRingStorage()), 256);
+  ASSERT_TRUE(ring.ready());
+
+  StreamRing::Allocation a, b;
+  unsigned char* pa = ring.allocate(100, 16, &a);
+  unsigned char* pb = ring.allocate(10, 16, &b);
+  ASSERT_NE(pa, nullptr);
+  ASSERT_NE(pb, nullptr);
+  EXPECT_EQ(a.offset, 0u);
+  EXPECT_EQ(b.offset, 112u);
+  EXPECT_EQ(pb - pa, 112);
+  EXPECT_EQ(a.generation, b.generation);
+  EXPECT_TRUE(ring.valid(a));
+  EXPECT_TRUE(ring.valid(b));
+
+  auto storage = static_cast<HostStreamRingStorage*>(ring.get_storage());
+  EXPECT_EQ(storage->fences_pending(), 0u);
+  EXPECT_EQ(storage->waits(), 0u);
+}
+
+TEST(StreamRingTest, RefusesWhatDoesNotFitInASegment) {
+  StreamRing ring(std::unique_ptr<StreamRingStorage>(new HostStreamRingStorage()), 256);
+  StreamRing::Allocation a;
+  EXPECT_EQ(ring.allocate(257, 1, &a), nullptr);
+  EXPECT_NE(ring.allocate(256, 1, &a), nullptr);
+}
+
+TEST(StreamRingTest, WrapsAroundTheSegmentsWaitingOnFences) {
+  StreamRing ring(std::unique_ptr<StreamRingStorage>(new HostStreamRingStorage()), 256);
+  auto storage = static_cast<HostStreamRingStorage*>(ring.get_storage());
+
+  StreamRing::Allocation first, second, third, fourth;
+  ASSERT_NE(ring.allocate(200, 4, &first), nullptr);
+  EXPECT_EQ(first.offset, 0u);
+
+  // each allocation that doesn't fit moves on a segment, fencing the last
+  ASSERT_NE(ring.allocate(200, 4, &second), nullptr);
+  EXPECT_EQ(second.offset, 256u);
+  EXPECT_EQ(storage->fences_pending(), 1u);
+  ASSERT_NE(ring.allocate(200, 4, &third), nullptr);
+  EXPECT_EQ(third.offset, 512u);
+  EXPECT_EQ(storage->fences_pending(), 2u);
+  EXPECT_EQ(storage->waits(), 0u);
+  EXPECT_TRUE(ring.valid(first));
+
+  // coming back to the first segment has to wait on the fence it was left with
+  ASSERT_NE(ring.allocate(200, 4, &fourth), nullptr);
+  EXPECT_EQ(fourth.offset, 0u);
+  EXPECT_EQ(storage->waits(), 1u);
+  EXPECT_EQ(storage->fences_pending(), 2u);
+
+  EXPECT_FALSE(ring.valid(first));
+  EXPECT_TRUE(ring.valid(second));
+  EXPECT_TRUE(ring.valid(third));
+  EXPECT_TRUE(ring.valid(fourth));
+}
+
+TEST(StreamRingTest, DefaultAllocationIsNeverValid) {
+  StreamRing ring(std::unique_ptr<StreamRingStorage>(new HostStreamRingStorage()), 256);
+  EXPECT_FALSE(ring.valid(StreamRing::Allocation()));
+}
+
+TEST(StreamRingTest, UnmappableStorageIsNotReady) {
+  StreamRing ring(std::unique_ptr<StreamRingStorage>(new UnmappableStorage()), 256);
+  StreamRing::Allocation a;
+  EXPECT_FALSE(ring.ready());
+  EXPECT_EQ(ring.allocate(16, 1, &a), nullptr);
+}
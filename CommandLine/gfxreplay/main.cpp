@@ -0,0 +1,755 @@
+/** This file is a part of the ENIGMA Development Environment.
+***
+*** ENIGMA is free software: you can redistribute it and/or modify it under the
+*** terms of the GNU General Public License as published by the Free Software
+*** Foundation, version 3 of the license or any later version.
+***
+*** This application and its source code is distributed AS-IS, WITHOUT ANY
+*** WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+*** FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+*** details.
+***
+*** You should have received a copy of the GNU General Public License along
+*** with this code. If not, see <http://www.gnu.org/licenses/>
+**/
+
+// Replays a frame captured with graphics_capture_frame without a GPU, either
+// through the software backend's rasterizer or through nothing at all like
+// the None backend, and reports what every call cost on the CPU along with
+// the batch breaks, texture swaps and redundant state changes in the frame.
+
+#include "Graphics_Systems/General/GScapture_format.h"
+#include "Graphics_Systems/General/GSvertex.h"
+#include "Graphics_Systems/General/GSprimitives.h"
+#include "Graphics_Systems/Software/SWraster.h"
+#include "Graphics_Systems/Software/SWtextures_impl.h"
+#include "Universal_System/worker_pool.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace enigma::capture_format;
+using std::string;
+using std::vector;
+
+namespace {
+
+struct Call {
+  int op;
+  // format, texture, vertices and indices
+  int id = -1, format = -1, type = 0;
+  unsigned width = 0, height = 0, fullwidth = 0, fullheight = 0;
+  size_t count = 0;
+  bool available = false;
+  vector<std::pair<int, int> > flags;
+  vector<uint32_t> data;
+  // state
+  int reason = state_flush;
+  State state;
+  // draw
+  int vertex = -1, index = -1, instances = -1, primitive = 0, drawflags = 0;
+  unsigned offset = 0, start = 0;
+};
+
+struct Trace {
+  uint32_t color_layout;
+  unsigned width, height;
+  vector<Call> calls;
+};
+
+const char* const primitive_names[] = {
+  "", "pointlist", "linelist", "linestrip", "trianglelist", "trianglestrip", "trianglefan"
+};
+
+const char* primitive_name(int primitive) {
+  return (primitive >= 1 && primitive <= 6) ? primitive_names[primitive] : "unknown";
+}
+
+// where each byte of a color packed like the capturing backend goes in ARGB,
+// false if they are the same or the layout can't be told apart
+bool color_order(uint32_t layout, int (&order)[4]) {
+  const uint32_t argb = 0xFF010203;
+  bool identity = true;
+  for (int b = 0; b < 4; ++b) {
+    order[b] = -1;
+    for (int p = 0; p < 4; ++p)
+      if (((layout >> (b * 8)) & 255) == ((argb >> (p * 8)) & 255)) order[b] = p;
+    if (order[b] < 0) return false;
+    identity &= order[b] == b;
+  }
+  return !identity;
+}
+
+size_t attribute_size(int type) {
+  using namespace enigma_user;
+  return (type <= vertex_type_float4) ? type - vertex_type_float1 + 1 : 1;
+}
+
+size_t format_stride(const vector<std::pair<int, int> >& flags) {
+  size_t stride = 0;
+  for (const auto& flag : flags) stride += attribute_size(flag.first);
+  return stride;
+}
+
+bool read_trace(const vector<unsigned char>& file, Trace& trace, string& error) {
+  reader r(file.data(), file.size());
+  if (!r.has(header_size) || memcmp(r.take(4), magic, 4)) {
+    error = "not a frame capture";
+    return false;
+  }
+  const unsigned file_version = r.u8();
+  if (file_version > version) {
+    error = "capture version " + std::to_string(file_version) + " is newer than this replayer";
+    return false;
+  }
+  r.take(3);
+  trace.color_layout = r.u32();
+  trace.width = r.u32();
+  trace.height = r.u32();
+
+  int order[4];
+  const bool swizzle = color_order(trace.color_layout, order);
+  std::map<int, vector<std::pair<int, int> > > formats;
+
+  while (r.has(1)) {
+    Call call;
+    call.op = r.u8();
+    switch (call.op) {
+      case op_end:
+        return true;
+      case op_format: {
+        if (!r.has(8)) break;
+        call.id = r.u32();
+        const size_t count = r.u32();
+        if (!r.has(count * 4)) break;
+        for (size_t i = 0; i < count; ++i) {
+          const int type = r.u16();
+          call.flags.emplace_back(type, r.u16());
+        }
+        formats[call.id] = call.flags;
+        trace.calls.push_back(std::move(call));
+        continue;
+      }
+      case op_texture: {
+        if (!r.has(24)) break;
+        call.id = r.u32();
+        call.width = r.u32(), call.height = r.u32();
+        call.fullwidth = r.u32(), call.fullheight = r.u32();
+        const size_t bytes = r.u32();
+        if (!r.has(bytes) || (bytes && bytes != size_t(call.fullwidth) * call.fullheight * 4)) break;
+        call.available = bytes > 0;
+        call.data.resize(bytes / 4);
+        if (bytes) memcpy(call.data.data(), r.take(bytes), bytes);
+        trace.calls.push_back(std::move(call));
+        continue;
+      }
+      case op_vertices: {
+        if (!r.has(13)) break;
+        call.id = r.u32();
+        call.format = r.u32();
+        call.count = r.u32();
+        call.available = r.u8();
+        if (call.available) {
+          if (!r.has(call.count * 4)) break;
+          call.data.resize(call.count);
+          for (uint32_t& element : call.data) element = r.u32();
+        }
+        // colors are put in the software backend's order the way uploading
+        // them would convert them
+        auto format = formats.find(call.format);
+        if (swizzle && call.available && format != formats.end() && !format->second.empty()) {
+          size_t element = 0;
+          while (element < call.data.size()) {
+            for (const auto& flag : format->second) {
+              if (flag.first == enigma_user::vertex_type_color && element < call.data.size()) {
+                uint32_t color = 0;
+                for (int b = 0; b < 4; ++b) color |= ((call.data[element] >> (b * 8)) & 255) << (order[b] * 8);
+                call.data[element] = color;
+              }
+              element += attribute_size(flag.first);
+            }
+          }
+        }
+        trace.calls.push_back(std::move(call));
+        continue;
+      }
+      case op_indices: {
+        if (!r.has(10)) break;
+        call.id = r.u32();
+        call.type = r.u8();
+        call.count = r.u32();
+        call.available = r.u8();
+        if (call.available) {
+          if (!r.has(call.count * 4)) break;
+          call.data.resize(call.count);
+          for (uint32_t& index : call.data) index = r.u32();
+        }
+        trace.calls.push_back(std::move(call));
+        continue;
+      }
+      case op_state: {
+        if (!r.has(1 + State::words * 4)) break;
+        call.reason = r.u8();
+        call.state = r.state();
+        trace.calls.push_back(std::move(call));
+        continue;
+      }
+      case op_draw: {
+        if (!r.has(26)) break;
+        call.vertex = r.u32();
+        call.index = r.u32();
+        call.instances = r.u32();
+        call.primitive = r.u8();
+        call.drawflags = r.u8();
+        call.offset = r.u32();
+        call.start = r.u32();
+        call.count = r.u32();
+        trace.calls.push_back(std::move(call));
+        continue;
+      }
+      default:
+        error = "unknown record " + std::to_string(call.op) + " after " + std::to_string(trace.calls.size()) + " calls";
+        return false;
+    }
+    error = "truncated record after " + std::to_string(trace.calls.size()) + " calls";
+    return false;
+  }
+  error = "the capture ends without its end record";
+  return false;
+}
+
+// The state words the report groups changes by, which are the ones the
+// backends apply together.
+struct Group {
+  const char* name;
+  size_t begin, end;
+};
+
+#define STATE_GROUP(name, first, last) {name, offsetof(State, first), offsetof(State, last) + sizeof(State::last)}
+const Group groups[] = {
+  STATE_GROUP("texture", textures, textures),
+  STATE_GROUP("sampler", samplers, samplers),
+  STATE_GROUP("blend", blend_src, alpha_blend),
+  STATE_GROUP("alpha test", alpha_test, alpha_ref),
+  STATE_GROUP("depth", depth_test, depth_func),
+  STATE_GROUP("culling", culling, culling),
+  STATE_GROUP("fill", fill_mode, line_width),
+  STATE_GROUP("color write", color_write, color_write),
+  STATE_GROUP("lighting", lighting, stencil_test),
+  STATE_GROUP("world", world, world),
+  STATE_GROUP("view", view, view),
+  STATE_GROUP("projection", projection, projection)
+};
+#undef STATE_GROUP
+const size_t group_count = sizeof(groups) / sizeof(groups[0]);
+
+// which groups differ, one bit each
+unsigned changed_groups(const State& a, const State& b) {
+  const unsigned char* pa = reinterpret_cast<const unsigned char*>(&a);
+  const unsigned char* pb = reinterpret_cast<const unsigned char*>(&b);
+  unsigned changed = 0;
+  for (size_t g = 0; g < group_count; ++g)
+    if (memcmp(pa + groups[g].begin, pb + groups[g].begin, groups[g].end - groups[g].begin)) changed |= 1u << g;
+  return changed;
+}
+
+string group_names(unsigned changed) {
+  string names;
+  for (size_t g = 0; g < group_count; ++g) {
+    if (!(changed & (1u << g))) continue;
+    if (!names.empty()) names += ", ";
+    names += groups[g].name;
+  }
+  return names;
+}
+
+// The backends the trace can be replayed against. Both keep the contents of
+// the trace the way a backend keeps its peers, but only the software one
+// transforms and rasterizes the draws.
+class Replayer {
+ public:
+  Replayer(const Trace& trace, bool rasterize): trace(trace), rasterize(rasterize) {
+    color.assign(size_t(width()) * height(), 0);
+    depth.assign(color.size(), 1.0f);
+  }
+
+  void execute(const Call& call) {
+    switch (call.op) {
+      case op_format: formats[call.id] = call.flags; break;
+      case op_texture: upload_texture(call); break;
+      case op_vertices: {
+        VertexPeer& peer = vertices[call.id];
+        peer.format = call.format;
+        peer.available = call.available;
+        peer.elements = call.data;
+        break;
+      }
+      case op_indices: {
+        IndexPeer& peer = indices[call.id];
+        peer.available = call.available;
+        peer.indices = call.data;
+        break;
+      }
+      case op_state: if (rasterize) apply_state(call.state); break;
+      case op_draw: if (rasterize) draw(call); break;
+    }
+  }
+
+  // whether the buffers of a draw were all captured
+  bool complete(const Call& call) const {
+    auto vertex = vertices.find(call.vertex);
+    if (vertex == vertices.end() || !vertex->second.available) return false;
+    if (call.index >= 0) {
+      auto index = indices.find(call.index);
+      if (index == indices.end() || !index->second.available) return false;
+    }
+    if (call.instances >= 0) {
+      auto instance = vertices.find(call.instances);
+      if (instance == vertices.end() || !instance->second.available) return false;
+    }
+    return true;
+  }
+
+  enigma::software::RenderTarget target() {
+    return {color.data(), depth.data(), int(width()), int(height())};
+  }
+
+  const enigma::SWTexture* texture(int id) const {
+    auto peer = textures.find(id);
+    return peer == textures.end() ? nullptr : peer->second.get();
+  }
+
+ private:
+  struct VertexPeer {
+    int format = -1;
+    bool available = false;
+    vector<uint32_t> elements;
+  };
+  struct IndexPeer {
+    bool available = false;
+    vector<uint32_t> indices;
+  };
+
+  unsigned width() const { return trace.width ? trace.width : 640; }
+  unsigned height() const { return trace.height ? trace.height : 480; }
+
+  void upload_texture(const Call& call) {
+    auto& peer = textures[call.id];
+    peer.reset(new enigma::SWTexture());
+    peer->width = call.width, peer->height = call.height;
+    peer->fullwidth = call.fullwidth, peer->fullheight = call.fullheight;
+    if (rasterize) peer->pixels = call.data;
+  }
+
+  // what the software backend's graphics_state_flush does
+  void apply_state(const State& s) {
+    using enigma::software::state;
+
+    // projection * view * world, a column at a time
+    for (int c = 0; c < 4; ++c) {
+      float column[4];
+      for (int r = 0; r < 4; ++r) {
+        column[r] = 0;
+        for (int k = 0; k < 4; ++k) column[r] += s.view[k * 4 + r] * s.world[c * 4 + k];
+      }
+      for (int r = 0; r < 4; ++r) {
+        state.mvp[c * 4 + r] = 0;
+        for (int k = 0; k < 4; ++k) state.mvp[c * 4 + r] += s.projection[k * 4 + r] * column[k];
+      }
+    }
+    state.perspective = !(state.mvp[3] == 0 && state.mvp[7] == 0 && state.mvp[11] == 0 && state.mvp[15] == 1);
+
+    state.texture = s.textures[0];
+    state.wrapu = s.samplers[0] & sampler_wrapu, state.wrapv = s.samplers[0] & sampler_wrapv;
+    state.interpolate = s.samplers[0] & sampler_interpolate;
+
+    state.blend = s.alpha_blend;
+    state.blendsrc = s.blend_src, state.blenddst = s.blend_dest;
+    state.alphatest = s.alpha_test;
+    state.alpharef = s.alpha_ref;
+
+    state.depthtest = s.depth_test;
+    state.depthwrite = s.depth_write;
+    state.depthfunc = s.depth_func;
+    state.culling = s.culling;
+    state.fillmode = s.fill_mode;
+    state.pointsize = s.point_size;
+
+    state.writemask = ((s.color_write & 1) ? 0x00FF0000 : 0) | ((s.color_write & 2) ? 0x0000FF00 : 0) |
+                      ((s.color_write & 4) ? 0x000000FF : 0) | ((s.color_write & 8) ? 0xFF000000 : 0);
+  }
+
+  // what the software backend's vertex submission does, and for instances
+  // what the General fallback does when it expands them
+  void draw(const Call& call) {
+    using namespace enigma_user;
+
+    if (!complete(call)) return;
+    const VertexPeer& peer = vertices[call.vertex];
+    auto format = formats.find(peer.format);
+    if (format == formats.end()) return;
+    const size_t stride = format_stride(format->second);
+    if (!stride) return;
+
+    size_t first = call.offset + size_t(call.start) * stride, count = call.count;
+    const uint32_t* index_data = nullptr;
+    if (call.index >= 0) {
+      const vector<uint32_t>& index_peer = indices[call.index].indices;
+      if (call.start >= index_peer.size()) return;
+      count = std::min<size_t>(count, index_peer.size() - call.start);
+      index_data = index_peer.data() + call.start;
+      first = 0;
+    }
+    const size_t available = first < peer.elements.size() ? (peer.elements.size() - first) / stride : 0;
+    const size_t vertex_count = index_data ? available : std::min(count, available);
+
+    if (call.instances < 0) {
+      transform(format->second, peer.elements.data() + first, vertex_count, nullptr);
+      enigma::software::draw_primitives(call.primitive, transformed.data(), transformed.size(),
+                                        index_data, index_data ? count : transformed.size());
+      return;
+    }
+    const vector<uint32_t>& instance_data = vertices[call.instances].elements;
+    for (size_t i = 0; i + 17 <= instance_data.size(); i += 17) {
+      transform(format->second, peer.elements.data() + first, vertex_count, instance_data.data() + i);
+      enigma::software::draw_primitives(call.primitive, transformed.data(), transformed.size(),
+                                        index_data, index_data ? count : transformed.size());
+    }
+  }
+
+  static float as_float(uint32_t word) {
+    float f;
+    memcpy(&f, &word, 4);
+    return f;
+  }
+
+  // transforms vertices into clip space like the software backend, first by
+  // an instance's rows of an affine transform, color and texture offset
+  void transform(const vector<std::pair<int, int> >& flags, const uint32_t* vertex, size_t count,
+                 const uint32_t* instance) {
+    using namespace enigma_user;
+
+    int position = -1, color_at = -1, texcoord = -1;
+    size_t position_size = 0, offset = 0;
+    for (const auto& flag : flags) {
+      const size_t size = attribute_size(flag.first);
+      if (flag.second == vertex_usage_position && position < 0) {
+        position = offset, position_size = size;
+      } else if (flag.second == vertex_usage_color && color_at < 0 && flag.first == vertex_type_color) {
+        color_at = offset;
+      } else if (flag.second == vertex_usage_textcoord && texcoord < 0 && size >= 2) {
+        texcoord = offset;
+      }
+      offset += size;
+    }
+    transformed.clear();
+    if (position < 0) return;
+
+    float rows[12] = {1,0,0,0, 0,1,0,0, 0,0,1,0}, tex[4] = {0, 0, 1, 1};
+    uint32_t tint = 0xFFFFFFFF;
+    if (instance) {
+      for (int i = 0; i < 12; ++i) rows[i] = as_float(instance[i]);
+      tint = instance[12];
+      for (int i = 0; i < 4; ++i) tex[i] = as_float(instance[13 + i]);
+    }
+
+    transformed.resize(count);
+    const float* m = enigma::software::state.mvp;
+    const size_t stride = offset;
+    for (size_t i = 0; i < count; ++i, vertex += stride) {
+      const float px = as_float(vertex[position]),
+                  py = position_size > 1 ? as_float(vertex[position + 1]) : 0,
+                  pz = position_size > 2 ? as_float(vertex[position + 2]) : 0;
+      const float x = rows[0] * px + rows[1] * py + rows[2] * pz + rows[3],
+                  y = rows[4] * px + rows[5] * py + rows[6] * pz + rows[7],
+                  z = rows[8] * px + rows[9] * py + rows[10] * pz + rows[11];
+      enigma::software::ClipVertex& out = transformed[i];
+      out.x = m[0] * x + m[4] * y + m[8] * z + m[12];
+      out.y = m[1] * x + m[5] * y + m[9] * z + m[13];
+      out.z = m[2] * x + m[6] * y + m[10] * z + m[14];
+      out.w = m[3] * x + m[7] * y + m[11] * z + m[15];
+      if (texcoord >= 0) {
+        out.u = tex[0] + as_float(vertex[texcoord]) * tex[2];
+        out.v = tex[1] + as_float(vertex[texcoord + 1]) * tex[3];
+      } else {
+        out.u = out.v = 0;
+      }
+      const uint32_t argb = color_at >= 0 ? vertex[color_at] : 0xFFFFFFFF;
+      out.a = ((argb >> 24) * (tint >> 24) + 127) / 255;
+      out.r = (((argb >> 16) & 255) * ((tint >> 16) & 255) + 127) / 255;
+      out.g = (((argb >> 8) & 255) * ((tint >> 8) & 255) + 127) / 255;
+      out.b = ((argb & 255) * (tint & 255) + 127) / 255;
+    }
+  }
+
+  const Trace& trace;
+  const bool rasterize;
+  std::map<int, vector<std::pair<int, int> > > formats;
+  std::map<int, VertexPeer> vertices;
+  std::map<int, IndexPeer> indices;
+  std::map<int, std::unique_ptr<enigma::SWTexture> > textures;
+  vector<enigma::software::ClipVertex> transformed;
+  vector<uint32_t> color;
+  vector<float> depth;
+};
+
+Replayer* replayer = nullptr;
+
+// What the calls did to the frame, worked out from the trace alone.
+struct Analysis {
+  vector<string> notes; // one for each call
+  size_t draws = 0, batched = 0, batches = 0, incomplete = 0;
+  size_t texture_swaps = 0, flushes = 0, redundant = 0;
+  std::map<string, size_t> breaks;
+  size_t group_changes[group_count] = {};
+};
+
+Analysis analyze(const Trace& trace) {
+  Analysis a;
+  a.notes.resize(trace.calls.size());
+
+  State current{}, drawn{};
+  bool have_state = false, have_draw = false, have_batch = false;
+  // what happened since the last batch was drawn
+  bool other_draw = false, rewritten = false, new_texture = false;
+  unsigned changed = 0;
+  size_t redundant = 0;
+  std::map<int, bool> vertices_available, indices_available;
+  int batch_buffer = -1;
+
+  for (size_t i = 0; i < trace.calls.size(); ++i) {
+    const Call& call = trace.calls[i];
+    string& note = a.notes[i];
+    switch (call.op) {
+      case op_vertices:
+        vertices_available[call.id] = call.available;
+        if (call.id == batch_buffer) rewritten = true;
+        if (!call.available) note = "contents were uploaded before the capture";
+        break;
+      case op_indices:
+        indices_available[call.id] = call.available;
+        if (!call.available) note = "contents were uploaded before the capture";
+        break;
+      case op_texture:
+        if (!call.available) note = "pixels could not be read back";
+        break;
+      case op_state: {
+        if (call.reason == state_initial || !have_state) {
+          current = call.state;
+          have_state = true;
+          if (call.reason == state_initial) note = "initial";
+          break;
+        }
+        ++a.flushes;
+        const unsigned groups_changed = changed_groups(current, call.state);
+        if (!groups_changed) {
+          ++a.redundant, ++redundant;
+          note = "redundant, nothing changed";
+        } else {
+          note = "changes " + group_names(groups_changed);
+          for (size_t g = 0; g < group_count; ++g)
+            if (groups_changed & (1u << g)) ++a.group_changes[g];
+        }
+        changed |= groups_changed;
+        current = call.state;
+        break;
+      }
+      case op_draw: {
+        ++a.draws;
+        if (!vertices_available[call.vertex] || (call.index >= 0 && !indices_available[call.index]) ||
+            (call.instances >= 0 && !vertices_available[call.instances])) {
+          ++a.incomplete;
+          note = "buffers missing";
+        }
+        if (have_draw && current.textures[0] != drawn.textures[0]) {
+          ++a.texture_swaps;
+          new_texture = true;
+          note += string(note.empty() ? "" : ", ") + "texture swap";
+        }
+        drawn = current;
+        have_draw = true;
+
+        if (!(call.drawflags & draw_batched)) {
+          other_draw = true;
+          break;
+        }
+        ++a.batched;
+        // a batch that is drawn as more than one draw only writes its
+        // vertices before the first
+        if (have_batch && call.vertex == batch_buffer && !rewritten) break;
+        ++a.batches;
+        if (have_batch) {
+          string reason;
+          if (other_draw) {
+            reason = "another draw";
+          } else if (new_texture) {
+            reason = "texture swap";
+          } else if (changed) {
+            reason = "state change (" + group_names(changed) + ")";
+          } else if (redundant) {
+            reason = "redundant state change";
+          } else {
+            reason = "full or flushed";
+          }
+          ++a.breaks[reason];
+          note += string(note.empty() ? "" : ", ") + "batch broken by " + reason;
+        }
+        have_batch = true;
+        batch_buffer = call.vertex;
+        other_draw = rewritten = new_texture = false;
+        changed = 0;
+        redundant = 0;
+        break;
+      }
+    }
+  }
+  return a;
+}
+
+string describe(const Call& call) {
+  switch (call.op) {
+    case op_format:
+      return "format " + std::to_string(call.id) + ", " + std::to_string(call.flags.size()) + " attributes";
+    case op_texture:
+      return "texture " + std::to_string(call.id) + ", " + std::to_string(call.width) + "x" +
+             std::to_string(call.height);
+    case op_vertices:
+      return "vertex buffer " + std::to_string(call.id) + ", " + std::to_string(call.count) + " elements";
+    case op_indices:
+      return "index buffer " + std::to_string(call.id) + ", " + std::to_string(call.count) + " indices";
+    case op_state:
+      return "state";
+    case op_draw: {
+      string text = string(call.drawflags & draw_batched ? "batch " : "draw ") + std::to_string(call.count) + " " +
+                    primitive_name(call.primitive) + " from vertex buffer " + std::to_string(call.vertex);
+      if (call.index >= 0) text += " by index buffer " + std::to_string(call.index);
+      if (call.instances >= 0) text += " per instance in " + std::to_string(call.instances);
+      return text;
+    }
+  }
+  return "";
+}
+
+const char* const op_names[] = {"end", "format", "texture", "vertices", "indices", "state", "draw"};
+
+int usage() {
+  std::cerr << "Usage: gfxreplay [--backend software|none] [--repeat <count>] [--summary] <capture>" << std::endl;
+  return -1;
+}
+
+} // anonymous namespace
+
+namespace enigma {
+
+SWTexture* get_texture_peer(int texid) {
+  return const_cast<SWTexture*>(replayer ? replayer->texture(texid) : nullptr);
+}
+
+namespace software {
+
+RenderTarget bound_target() {
+  return replayer ? replayer->target() : RenderTarget{nullptr, nullptr, 0, 0};
+}
+
+} // namespace software
+} // namespace enigma
+
+int main(int argc, char *argv[]) {
+  string path, backend = "software";
+  int repeat = 1;
+  bool summary = false;
+  for (int i = 1; i < argc; ++i) {
+    const string arg = argv[i];
+    if (arg == "--backend" && i + 1 < argc) {
+      backend = argv[++i];
+    } else if (arg == "--repeat" && i + 1 < argc) {
+      repeat = std::max(1, std::atoi(argv[++i]));
+    } else if (arg == "--summary") {
+      summary = true;
+    } else if (path.empty() && arg.size() && arg[0] != '-') {
+      path = arg;
+    } else {
+      return usage();
+    }
+  }
+  if (path.empty() || (backend != "software" && backend != "none")) return usage();
+
+  std::ifstream in(path, std::ios::binary);
+  if (!in) {
+    std::cerr << "Error: Failure opening file \"" << path << "\"" << std::endl;
+    return -3;
+  }
+  const vector<unsigned char> file((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+  Trace trace;
+  string error;
+  if (!read_trace(file, trace, error)) {
+    std::cerr << "Error: \"" << path << "\" could not be read: " << error << std::endl;
+    return -4;
+  }
+
+  // every replay starts from nothing, so each call costs the same as it
+  // did the first time and the costs are averaged over the replays
+  vector<double> costs(trace.calls.size(), 0);
+  for (int r = 0; r < repeat; ++r) {
+    Replayer replay(trace, backend == "software");
+    replayer = &replay;
+    for (size_t i = 0; i < trace.calls.size(); ++i) {
+      const auto begin = std::chrono::steady_clock::now();
+      replay.execute(trace.calls[i]);
+      const auto end = std::chrono::steady_clock::now();
+      costs[i] += std::chrono::duration<double, std::micro>(end - begin).count();
+    }
+    replayer = nullptr;
+  }
+  for (double& cost : costs) cost /= repeat;
+
+  const Analysis analysis = analyze(trace);
+
+  std::printf("%s: %ux%u, %zu calls replayed %d time%s against the %s backend with %zu worker%s\n",
+              path.c_str(), trace.width, trace.height, trace.calls.size(), repeat, repeat == 1 ? "" : "s",
+              backend.c_str(), enigma::worker_count(), enigma::worker_count() == 1 ? "" : "s");
+  if (!summary) {
+    std::printf("\n%6s  %10s  %s\n", "call", "cpu (us)", "arguments");
+    for (size_t i = 0; i < trace.calls.size(); ++i) {
+      const string& note = analysis.notes[i];
+      std::printf("%6zu  %10.2f  %s%s%s\n", i, costs[i], describe(trace.calls[i]).c_str(),
+                  note.empty() ? "" : "  ; ", note.c_str());
+    }
+  }
+
+  std::printf("\n%-9s %7s %12s %10s\n", "call", "count", "total (ms)", "avg (us)");
+  double total = 0;
+  for (int op = op_format; op <= op_draw; ++op) {
+    size_t count = 0;
+    double sum = 0;
+    for (size_t i = 0; i < trace.calls.size(); ++i) {
+      if (trace.calls[i].op != op) continue;
+      ++count, sum += costs[i];
+    }
+    total += sum;
+    if (count) std::printf("%-9s %7zu %12.3f %10.2f\n", op_names[op], count, sum / 1000, sum / count);
+  }
+  std::printf("%-9s %7zu %12.3f\n", "total", trace.calls.size(), total / 1000);
+
+  std::printf("\ndraws: %zu, %zu of them batched into %zu batches", analysis.draws, analysis.batched, analysis.batches);
+  if (analysis.incomplete) std::printf(", %zu missing buffers", analysis.incomplete);
+  std::printf("\nbatch breaks: %zu\n", analysis.batches ? analysis.batches - 1 : 0);
+  for (const auto& reason : analysis.breaks) std::printf("  %6zu  %s\n", reason.second, reason.first.c_str());
+  std::printf("texture swaps: %zu\n", analysis.texture_swaps);
+  std::printf("state flushes: %zu, %zu redundant\n", analysis.flushes, analysis.redundant);
+  for (size_t g = 0; g < group_count; ++g)
+    if (analysis.group_changes[g]) std::printf("  %6zu  %s\n", analysis.group_changes[g], groups[g].name);
+  if (analysis.incomplete)
+    std::printf("\nSome buffers were uploaded before the capture; call graphics_capture_retain_buffers(true)\n"
+                "before creating them to record their contents.\n");
+  return 0;
+}
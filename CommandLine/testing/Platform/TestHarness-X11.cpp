@@ -13,7 +13,7 @@
 #include <X11/Xlib.h>
 #include <X11/Xutil.h>
 
-std::vector<TestConfig> GetValidConfigs(bool platforms, bool graphics, bool audio, bool collisions, bool widgets, bool network) {
+std::vector<TestConfig> GetValidConfigs(bool platforms, bool graphics, bool audio, bool collisions, bool widgets, bool network, bool headless) {
   std::vector<TestConfig> tcs;
   
   for (std::string_view p : {"xlib", "SDL"} ) {
@@ -46,6 +46,20 @@ std::vector<TestConfig> GetValidConfigs(bool platforms, bool graphics, bool audi
     }
     if (!platforms) break;
   }
+
+  if (headless) {
+    for (std::string_view c : {"Precise", "BBox" }) {
+      TestConfig tc;
+      tc.platform = "None";
+      tc.graphics = "Software";
+      tc.audio = "None";
+      tc.collision = c;
+      tc.widgets = "None";
+      tc.network = "None";
+      tcs.push_back(tc);
+      if (!collisions) break;
+    }
+  }
   
   return tcs;
 }
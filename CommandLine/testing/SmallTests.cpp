@@ -19,6 +19,8 @@ using NameMap = map<string, string>;
 
 const char *const kSimpleTestDirectory = "CommandLine/testing/SimpleTests";
 const char *const kDrivenTestDirectory = "CommandLine/testing/Tests";
+const char *const kBenchmarkDirectory = "CommandLine/testing/Benchmarks";
+const char *const kTestExtensions = "Alarms,Timelines,Paths,MotionPlanning,IniFilesystem,ParticleSystems,DateTime,DataStructures,libpng,GTest,Json,Steamworks";
 
 void read_files(string directory,
                 NameMap *games, NameMap *sources, NameMap *others) {
@@ -88,13 +90,13 @@ void bitch_about_junk_files(const NameMap &junk) {
   }
 }
 
-vector<string> enumerate_simple_games() {
+vector<string> enumerate_games(const char *directory) {
   NameMap games, others;
-  read_files(kSimpleTestDirectory, &games, nullptr, &others);
+  read_files(directory, &games, nullptr, &others);
   bitch_about_junk_files(others);
   vector<string> result;
   for (auto &kv : games) {
-    result.push_back(string(kSimpleTestDirectory) + "/" + kv.first);
+    result.push_back(string(directory) + "/" + kv.first);
   }
   return result;
 }
@@ -104,10 +106,11 @@ class SimpleTestHarness : public testing::TestWithParam<string> {};
 TEST_P(SimpleTestHarness, SimpleTestRunner) {
   string game = GetParam();
     
-  // Iterate only platforms, graphics & collision systems for now
-  for (TestConfig tc : GetValidConfigs(true, true, false, true, false, false)) {
+  // Iterate only platforms, graphics & collision systems for now, plus the
+  // headless software rasterizer, which needs neither a display nor a GPU
+  for (TestConfig tc : GetValidConfigs(true, true, false, true, false, false, true)) {
   
-    tc.extensions = "Alarms,Timelines,Paths,MotionPlanning,IniFilesystem,ParticleSystems,DateTime,DataStructures,libpng,GTest,Json,Steamworks";
+    tc.extensions = kTestExtensions;
     int ret = TestHarness::run_to_completion(game, tc);
     if (!ret) continue;
     switch (ret) {
@@ -135,7 +138,26 @@ TEST_P(SimpleTestHarness, SimpleTestRunner) {
 }
 
 INSTANTIATE_TEST_CASE_P(SimpleTests, SimpleTestHarness,
-                        testing::ValuesIn(enumerate_simple_games()));
+                        testing::ValuesIn(enumerate_games(kSimpleTestDirectory)));
+
+// Benchmarks time themselves and print what they measured, so they are
+// disabled and CI never runs them; `make benchmarks` does.
+class BenchmarkHarness : public testing::TestWithParam<string> {};
+
+TEST_P(BenchmarkHarness, DISABLED_BenchmarkRunner) {
+  string game = GetParam();
+
+  // A single headless configuration, so that runs on different machines
+  // measure the same thing
+  TestConfig tc = GetValidConfigs(false, false, false, false, false, false, true).back();
+  tc.extensions = kTestExtensions;
+  int ret = TestHarness::run_to_completion(game, tc);
+  EXPECT_EQ(ret, 0) << "Benchmark \"" << game << "\" returned " << ret << ". "
+                       "Check log for other errors (possibly gTest-flavored).";
+}
+
+INSTANTIATE_TEST_CASE_P(Benchmarks, BenchmarkHarness,
+                        testing::ValuesIn(enumerate_games(kBenchmarkDirectory)));
 
 
 }  // namespace
@@ -42,7 +42,9 @@ struct TestConfig {
   }
 };
 
-std::vector<TestConfig> GetValidConfigs(bool platforms, bool graphics, bool audio, bool collisions, bool widgets, bool network);
+// With headless set, configurations that need no display, such as the
+// software rasterizer on the None platform, are included too.
+std::vector<TestConfig> GetValidConfigs(bool platforms, bool graphics, bool audio, bool collisions, bool widgets, bool network, bool headless = false);
 
 class TestHarness {
  public:
@@ -7,16 +7,14 @@
  */
 
 #include "GameData.h"
+#include "ResourceEncoder.h"
 #include "event_reader/event_parser.h"
-
-#include "libpng-util/libpng-util.h"
+#include "settings.h"
 
 #include <map>
 #include <string>
 #include <iostream>
 
-#include <zlib.h>
-
 using std::cout;
 using std::cerr;
 using std::endl;
@@ -28,18 +26,6 @@ static inline uint32_t javaColor(int c) {
   return ((c & 0xFF0000) >> 8) | ((c & 0xFF00) << 8) | ((c & 0xFF000000) >> 24);
 }
 
-static unsigned char* zlib_compress(unsigned char* inbuffer, int &actualsize)
-{
-  uLongf outsize=(int)(actualsize*1.1)+12;
-  Bytef* outbytef=new Bytef[outsize];
-
-  compress(outbytef,&outsize,(Bytef*)inbuffer,actualsize);
-
-  actualsize = outsize;
-
-  return (unsigned char*)outbytef;
-}
-
 BinaryData loadBinaryData(const std::string &filePath, int &errorc) {
   FILE *afile = fopen(filePath.c_str(),"rb");
   if (!afile) {
@@ -59,37 +45,6 @@ BinaryData loadBinaryData(const std::string &filePath, int &errorc) {
   return BinaryData(fdata, fdata + flen);
 }
 
-ImageData loadImageData(const std::string &filePath, int &errorc) {
-  unsigned error;
-  unsigned char* image;
-  unsigned pngwidth, pngheight;
-
-  error = libpng_decode32_file(&image, &pngwidth, &pngheight, filePath.c_str());
-  if (error) {
-    errorc = -1;
-    printf("libpng-util error %u\n", error);
-    return ImageData(0, 0, 0, 0);
-  }
-
-  const unsigned pitch = pngwidth * 4;
-  for (unsigned i = 0; i < pngheight; i++) {
-    const unsigned row = i*pitch;
-    for (unsigned j = 0; j < pngwidth; j++) {
-      const unsigned px = row+j*4;
-      unsigned char temp = image[px+2];
-      image[px+2] = image[px+0];
-      image[px+0] = temp;
-    }
-  }
-
-  int dataSize = pngwidth*pngheight*4;
-  const unsigned char* data = zlib_compress(image, dataSize);
-  delete[] image;
-
-  errorc = 0;
-  return ImageData(pngwidth, pngheight, data, dataSize);;
-}
-
 struct ESLookup {
   struct Lookup {
     std::string kind;
@@ -474,17 +429,26 @@ void ImportSettings(const deprecated::JavaStruct::GameSettings &settings,
 }
 
 
-int FlattenTree(const buffers::TreeNode &root, GameData *gameData) {
+// Image files are collected while flattening and encoded afterward, in
+// parallel; each job records where in GameData its result belongs.
+struct ImageJob {
+  enum Kind { SPRITE, BACKGROUND } kind;
+  size_t resource, subimage;
+  std::string path;
+  int error;
+};
+
+int FlattenTree(const buffers::TreeNode &root, GameData *gameData,
+                std::vector<ImageJob> *images) {
   int error = 0;
   switch (root.type_case()) {
     case TypeCase::kFolder: break;
     case TypeCase::kSprite: {
-      std::vector<ImageData> subimages;
       const buffers::resources::Sprite &sprite = root.sprite();
-      for (auto sub : sprite.subimages()) {
-        ImageData data = loadImageData(sub, error);
-        if (error) return -1; // sprite load error
-        subimages.emplace_back(data);
+      std::vector<ImageData> subimages(sprite.subimages_size(), ImageData(0, 0, 0, 0));
+      for (int i = 0; i < sprite.subimages_size(); ++i) {
+        images->push_back({ImageJob::SPRITE, gameData->sprites.size(), (size_t) i,
+                           sprite.subimages(i), 0});
       }
       gameData->sprites.emplace_back(sprite, root.name(), subimages);
       break;
@@ -496,9 +460,10 @@ int FlattenTree(const buffers::TreeNode &root, GameData *gameData) {
       break;
     }
     case TypeCase::kBackground: {
-      ImageData data = loadImageData(root.background().image(), error);
-      if (error) return -3; // background load error
-      gameData->backgrounds.emplace_back(root.background(), root.name(), data);
+      images->push_back({ImageJob::BACKGROUND, gameData->backgrounds.size(), 0,
+                         root.background().image(), 0});
+      gameData->backgrounds.emplace_back(root.background(), root.name(),
+                                         ImageData(0, 0, 0, 0));
       break;
     }
     case TypeCase::kPath:     gameData->paths.emplace_back(root.path(), root.name()); break;
@@ -514,17 +479,46 @@ int FlattenTree(const buffers::TreeNode &root, GameData *gameData) {
   }
 
   for (auto child : root.folder().children()) {
-    int res = FlattenTree(child, gameData);
+    int res = FlattenTree(child, gameData, images);
     if (res) return res;
   }
 
   return 0; // success
 }
 
+int EncodeImages(std::vector<ImageJob> &images, GameData *gameData) {
+  using namespace enigma::resource_encoder;
+  EncodeCache cache(codegen_directory.empty() ? codegen_directory
+                                              : codegen_directory/"ResourceCache");
+
+  ParallelFor(images.size(), [&](size_t i) {
+    ImageJob &job = images[i];
+    ImageData img = cache.LoadImage(job.path, job.error);
+    if (job.error) return;
+    if (job.kind == ImageJob::SPRITE)
+      gameData->sprites[job.resource].image_data[job.subimage] = std::move(img);
+    else
+      gameData->backgrounds[job.resource].image_data = std::move(img);
+  });
+
+  cout << "- Encoded " << images.size() << " images (" << cache.hits()
+       << " cached, " << cache.misses() << " encoded)" << endl;
+
+  for (const ImageJob &job : images) {
+    if (job.error) {
+      cerr << "Failed to load image " << job.path << endl;
+      return job.kind == ImageJob::SPRITE ? -1 : -3; // sprite/background load error
+    }
+  }
+  return 0;
+}
+
 int FlattenProto(const buffers::Project &proj, GameData *gameData) {
   cout << "Flattening tree." << endl;
 
-  int ret = FlattenTree(proj.game().root(), gameData);
+  std::vector<ImageJob> images;
+  int ret = FlattenTree(proj.game().root(), gameData, &images);
+  if (!ret) ret = EncodeImages(images, gameData);
 
   if (ret)
     cout << "Transfer error, see log for details." << endl << endl;
@@ -0,0 +1,200 @@
+/*
+ * This file is part of ENIGMA.
+ * ENIGMA is free software and comes with ABSOLUTELY NO WARRANTY.
+ * See LICENSE for details.
+ */
+
+#include "ResourceEncoder.h"
+
+#include "libpng-util/libpng-util.h"
+
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+#include <zlib.h>
+
+namespace enigma {
+namespace resource_encoder {
+
+namespace {
+
+// Everything besides the source bytes that influences EncodeImage's output.
+const char kImageEncodingSettings[] = "png>bgra8>zlib-default";
+const char kCacheMagic[4] = {'E', 'R', 'C', '1'};
+
+unsigned char* zlib_compress(unsigned char* inbuffer, int &actualsize) {
+  uLongf outsize = compressBound(actualsize);
+  Bytef* outbytef = new Bytef[outsize];
+
+  compress(outbytef, &outsize, (Bytef*)inbuffer, actualsize);
+
+  actualsize = outsize;
+
+  return (unsigned char*)outbytef;
+}
+
+// 64-bit FNV-1a; not cryptographic, but cheap and well distributed enough to
+// key a build cache.
+struct Fnv1a64 {
+  uint64_t value = 0xcbf29ce484222325ULL;
+  void update(const void *data, size_t size) {
+    const unsigned char *bytes = static_cast<const unsigned char*>(data);
+    for (size_t i = 0; i < size; ++i) {
+      value ^= bytes[i];
+      value *= 0x100000001b3ULL;
+    }
+  }
+};
+
+bool HashFile(const std::string &filePath, std::string *key) {
+  std::ifstream in(filePath, std::ios::binary);
+  if (!in) return false;
+
+  Fnv1a64 hash;
+  hash.update(&kImageEncodingVersion, sizeof(kImageEncodingVersion));
+  hash.update(kImageEncodingSettings, sizeof(kImageEncodingSettings));
+  char chunk[1 << 16];
+  uint64_t total = 0;
+  while (in) {
+    in.read(chunk, sizeof(chunk));
+    hash.update(chunk, in.gcount());
+    total += in.gcount();
+  }
+
+  char hex[40];
+  snprintf(hex, sizeof(hex), "%016llx-%llx", (unsigned long long) hash.value,
+           (unsigned long long) total);
+  *key = hex;
+  return true;
+}
+
+}  // namespace
+
+ImageData EncodeImage(const std::string &filePath, int &errorc) {
+  unsigned error;
+  unsigned char* image;
+  unsigned pngwidth, pngheight;
+
+  error = libpng_decode32_file(&image, &pngwidth, &pngheight, filePath.c_str(), true);
+  if (error) {
+    errorc = -1;
+    printf("libpng-util error %u\n", error);
+    return ImageData(0, 0, 0, 0);
+  }
+
+  int dataSize = pngwidth*pngheight*4;
+  const unsigned char* data = zlib_compress(image, dataSize);
+  delete[] image;
+
+  ImageData result(pngwidth, pngheight, data, dataSize);
+  delete[] data;
+
+  errorc = 0;
+  return result;
+}
+
+EncodeCache::EncodeCache(const std::filesystem::path &directory):
+    directory_(directory) {
+  if (directory_.empty()) return;
+  std::error_code ec;
+  std::filesystem::create_directories(directory_, ec);
+  if (ec) {
+    std::cerr << "Resource cache disabled; cannot create " << directory_
+              << ": " << ec.message() << std::endl;
+    directory_.clear();
+  }
+}
+
+ImageData EncodeCache::LoadImage(const std::string &filePath, int &errorc) {
+  std::string key;
+  if (directory_.empty() || !HashFile(filePath, &key)) {
+    ++misses_;
+    return EncodeImage(filePath, errorc);
+  }
+
+  const std::filesystem::path entry = directory_ / (key + ".erc");
+  ImageData img(0, 0, 0, 0);
+  if (Read(entry, &img)) {
+    ++hits_;
+    errorc = 0;
+    return img;
+  }
+
+  ++misses_;
+  img = EncodeImage(filePath, errorc);
+  if (!errorc) Write(entry, img);
+  return img;
+}
+
+bool EncodeCache::Read(const std::filesystem::path &entry, ImageData *out) const {
+  std::ifstream in(entry, std::ios::binary);
+  if (!in) return false;
+
+  char magic[4];
+  int32_t width, height;
+  uint32_t size;
+  in.read(magic, 4);
+  in.read((char*) &width, 4);
+  in.read((char*) &height, 4);
+  in.read((char*) &size, 4);
+  if (!in || !std::equal(magic, magic + 4, kCacheMagic)) return false;
+
+  out->width = width;
+  out->height = height;
+  out->pixels.resize(size);
+  in.read((char*) out->pixels.data(), size);
+  return in.gcount() == (std::streamsize) size;
+}
+
+void EncodeCache::Write(const std::filesystem::path &entry, const ImageData &img) const {
+  // Write beside the final name and rename into place, so that a concurrent
+  // or interrupted build never observes a partially written entry.
+  std::ostringstream tmpname;
+  tmpname << entry.filename().string() << '.' << std::this_thread::get_id() << ".tmp";
+  const std::filesystem::path tmp = entry.parent_path() / tmpname.str();
+  {
+    std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+    if (!out) return;
+    const int32_t width = img.width, height = img.height;
+    const uint32_t size = img.pixels.size();
+    out.write(kCacheMagic, 4);
+    out.write((const char*) &width, 4);
+    out.write((const char*) &height, 4);
+    out.write((const char*) &size, 4);
+    out.write((const char*) img.pixels.data(), size);
+    if (!out) {
+      out.close();
+      std::filesystem::remove(tmp);
+      return;
+    }
+  }
+  std::error_code ec;
+  std::filesystem::rename(tmp, entry, ec);
+  if (ec) std::filesystem::remove(tmp, ec);
+}
+
+void ParallelFor(size_t count, const std::function<void(size_t)> &job) {
+  size_t threads = std::min<size_t>(std::thread::hardware_concurrency(), count);
+  if (threads <= 1) {
+    for (size_t i = 0; i < count; ++i) job(i);
+    return;
+  }
+
+  std::atomic<size_t> next{0};
+  auto worker = [&]() {
+    for (size_t i; (i = next++) < count; ) job(i);
+  };
+  std::vector<std::thread> pool;
+  pool.reserve(threads - 1);
+  for (size_t t = 1; t < threads; ++t) pool.emplace_back(worker);
+  worker();
+  for (std::thread &t : pool) t.join();
+}
+
+}  // namespace resource_encoder
+}  // namespace enigma
@@ -0,0 +1,58 @@
+/*
+ * This file is part of ENIGMA.
+ * ENIGMA is free software and comes with ABSOLUTELY NO WARRANTY.
+ * See LICENSE for details.
+ */
+
+#ifndef ENIGMA_RESOURCE_ENCODER_H
+#define ENIGMA_RESOURCE_ENCODER_H
+
+#include "GameData.h"
+
+#include <atomic>
+#include <filesystem>
+#include <functional>
+#include <string>
+
+namespace enigma {
+namespace resource_encoder {
+
+/// Bump whenever the bytes produced by EncodeImage change for the same input,
+/// so that stale cache entries from older builds are never reused.
+static const int kImageEncodingVersion = 1;
+
+/// Decodes a PNG to BGRA and zlib-compresses it into the layout written into
+/// the game module. Returns a zero-sized image and sets errorc on failure.
+ImageData EncodeImage(const std::string &filePath, int &errorc);
+
+/// Content-addressed cache of encoded images. An entry is keyed by a hash of
+/// the source file's bytes together with the encoding settings, so moving or
+/// renaming an asset still hits while any edit to its pixels misses.
+class EncodeCache {
+ public:
+  /// An empty directory disables the cache; every lookup then re-encodes.
+  explicit EncodeCache(const std::filesystem::path &directory);
+
+  /// Returns the encoded image for the given file, loading it from the cache
+  /// when an entry exists and encoding (then storing) it otherwise.
+  ImageData LoadImage(const std::string &filePath, int &errorc);
+
+  size_t hits() const { return hits_; }
+  size_t misses() const { return misses_; }
+
+ private:
+  std::filesystem::path directory_;
+  std::atomic<size_t> hits_{0}, misses_{0};
+
+  bool Read(const std::filesystem::path &entry, ImageData *out) const;
+  void Write(const std::filesystem::path &entry, const ImageData &img) const;
+};
+
+/// Runs job(0) ... job(count - 1) across hardware_concurrency() threads.
+/// Jobs must be independent; they are claimed in index order.
+void ParallelFor(size_t count, const std::function<void(size_t)> &job);
+
+}  // namespace resource_encoder
+}  // namespace enigma
+
+#endif  // ENIGMA_RESOURCE_ENCODER_H
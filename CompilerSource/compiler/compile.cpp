@@ -62,6 +62,7 @@ using namespace std;
 #include "settings-parse/crawler.h"
 
 #include "components/components.h"
+#include "components/module_index.h"
 
 #include "general/bettersystem.h"
 #include "event_reader/event_parser.h"
@@ -149,9 +150,12 @@ static int write_res_helper(FILE* gameModule, int& resourceblock_start, const Ga
   // Start by setting off our location with a DWord of NULLs
   fwrite("\0\0\0",1,4,gameModule);
 
+  ModuleIndex index;
+
   idpr("Adding Sprites",90);
 
-  int res = current_language->module_write_sprites(game, gameModule);
+  index.add_section("SPR ", gameModule);
+  int res = current_language->module_write_sprites(game, gameModule, &index);
   if (res) { 
     idpr("Error occurred; see scrollback for details.",-1); 
     return res;
@@ -160,16 +164,24 @@ static int write_res_helper(FILE* gameModule, int& resourceblock_start, const Ga
   edbg << "Finalized sprites." << flushl;
   idpr("Adding Sounds",93);
 
-  current_language->module_write_sounds(game, gameModule);
+  index.add_section("SND ", gameModule);
+  current_language->module_write_sounds(game, gameModule, &index);
 
-  current_language->module_write_backgrounds(game, gameModule);
+  index.add_section("BKG ", gameModule);
+  current_language->module_write_backgrounds(game, gameModule, &index);
 
+  index.add_section("FNT ", gameModule);
   current_language->module_write_fonts(game, gameModule);
 
+  index.add_section("PTH ", gameModule);
   current_language->module_write_paths(game, gameModule);
 
-  // Tell where the resources start
-  fwrite("\0\0\0\0res0",8,1,gameModule);
+  // Write the table of contents used by the indexed (res1) loader
+  const int index_start = index.write(gameModule);
+
+  // Tell where the index and the resources start
+  fwrite(&index_start,4,1,gameModule);
+  fwrite("res1",4,1,gameModule);
   fwrite(&resourceblock_start,4,1,gameModule);
 
   // Close the game module; we're done adding resources
@@ -648,7 +660,7 @@ int lang_CPP::compile(const GameData &game, const char* exe_filename, int mode)
   irrr();
 
   edbg << "Writing room data" << flushl;
-  res = current_language->compile_writeRoomData(game, state.parsed_rooms, &state.global_object, mode);
+  res = current_language->compile_writeRoomData(game, state, &state.global_object, mode);
   irrr();
 
   edbg << "Writing shader data" << flushl;
@@ -0,0 +1,68 @@
+/** This file is a part of the ENIGMA Development Environment.
+***
+*** ENIGMA is free software: you can redistribute it and/or modify it under the
+*** terms of the GNU General Public License as published by the Free Software
+*** Foundation, version 3 of the license or any later version.
+***
+*** This application and its source code is distributed AS-IS, WITHOUT ANY
+*** WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+*** FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+*** details.
+***
+*** You should have received a copy of the GNU General Public License along
+*** with this code. If not, see <http://www.gnu.org/licenses/>
+**/
+
+#include "module_index.h"
+
+#include <cstring>
+
+static uint32_t fnv1a(const uint8_t *data, uint32_t size) {
+  uint32_t hash = 2166136261u;
+  for (uint32_t i = 0; i < size; ++i) {
+    hash ^= data[i];
+    hash *= 16777619u;
+  }
+  return hash;
+}
+
+void ModuleIndex::add_section(const char *kind, FILE *module) {
+  Entry e;
+  memcpy(e.kind, kind, 4);
+  e.id = -1;
+  e.subimage = 0;
+  e.offset = ftell(module);
+  e.size = e.unpacked = e.hash = 0;
+  entries.push_back(e);
+}
+
+void ModuleIndex::add_asset(const char *kind, int id, int subimage, FILE *module,
+                            const uint8_t *data, uint32_t size, uint32_t unpacked) {
+  Entry e;
+  memcpy(e.kind, kind, 4);
+  e.id = id;
+  e.subimage = subimage;
+  e.offset = ftell(module);
+  e.size = size;
+  e.unpacked = unpacked;
+  e.hash = fnv1a(data, size);
+  entries.push_back(e);
+}
+
+long ModuleIndex::write(FILE *module) const {
+  const long start = ftell(module);
+  const uint32_t count = entries.size();
+  fwrite("TOC ", 4, 1, module);
+  fwrite(&kVersion, 4, 1, module);
+  fwrite(&count, 4, 1, module);
+  for (const Entry &e : entries) {
+    fwrite(e.kind, 4, 1, module);
+    fwrite(&e.id, 4, 1, module);
+    fwrite(&e.subimage, 4, 1, module);
+    fwrite(&e.offset, 8, 1, module);
+    fwrite(&e.size, 4, 1, module);
+    fwrite(&e.unpacked, 4, 1, module);
+    fwrite(&e.hash, 4, 1, module);
+  }
+  return start;
+}
@@ -0,0 +1,58 @@
+/** This file is a part of the ENIGMA Development Environment.
+***
+*** ENIGMA is free software: you can redistribute it and/or modify it under the
+*** terms of the GNU General Public License as published by the Free Software
+*** Foundation, version 3 of the license or any later version.
+***
+*** This application and its source code is distributed AS-IS, WITHOUT ANY
+*** WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+*** FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+*** details.
+***
+*** You should have received a copy of the GNU General Public License along
+*** with this code. If not, see <http://www.gnu.org/licenses/>
+**/
+
+#ifndef ENIGMA_MODULE_INDEX_H
+#define ENIGMA_MODULE_INDEX_H
+
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+/// Table of contents for a version 1 ("res1") game module.
+///
+/// The resource sections themselves keep the layout read by the sequential
+/// ("res0") loader. The index is appended after them and records where each
+/// section starts and where each asset's packed payload lives, so the runtime
+/// can map the module and inflate individual assets on first use.
+///
+/// Index layout, all integers little-endian:
+///   "TOC " | u32 version | u32 count | count * Entry
+/// Module trailer:
+///   u32 index offset | "res1" | u32 resource block offset
+struct ModuleIndex {
+  static const uint32_t kVersion = 1;
+
+  struct Entry {
+    char kind[4];       ///< Section magic, e.g. "SPR ", "BKG ", "SND ".
+    int32_t id;         ///< Resource ID, or -1 for a section entry.
+    int32_t subimage;   ///< Subimage number for sprites; otherwise 0.
+    uint64_t offset;    ///< Absolute offset of the payload (or section) in the file.
+    uint32_t size;      ///< Packed payload size in bytes.
+    uint32_t unpacked;  ///< Payload size once inflated; equal to size if stored.
+    uint32_t hash;      ///< FNV-1a hash of the packed payload.
+  };
+  std::vector<Entry> entries;
+
+  /// Records the start of a resource section at the current file position.
+  void add_section(const char *kind, FILE *module);
+  /// Records an asset payload about to be written at the current file position.
+  void add_asset(const char *kind, int id, int subimage, FILE *module,
+                 const uint8_t *data, uint32_t size, uint32_t unpacked);
+
+  /// Writes the index at the current position and returns that position.
+  long write(FILE *module) const;
+};
+
+#endif  // ENIGMA_MODULE_INDEX_H
@@ -38,13 +38,14 @@ using namespace std;
 #include "compiler/compile_common.h"
 
 #include "backend/ideprint.h"
+#include "module_index.h"
 #include "languages/lang_CPP.h"
 
 inline void writei(int x, FILE *f) {
   fwrite(&x,4,1,f);
 }
 
-int lang_CPP::module_write_backgrounds(const GameData &game, FILE *gameModule)
+int lang_CPP::module_write_backgrounds(const GameData &game, FILE *gameModule, ModuleIndex *index)
 {
   // Now we're going to add backgrounds
   edbg << game.backgrounds.size() << " Adding Backgrounds to Game Module: " << flushl;
@@ -81,6 +82,9 @@ int lang_CPP::module_write_backgrounds(const GameData &game, FILE *gameModule)
 
     const int sz = game.backgrounds[i].image_data.pixels.size();
     writei(sz, gameModule); // size
+    index->add_asset("BKG ", game.backgrounds[i].id(), 0, gameModule,
+                     game.backgrounds[i].image_data.pixels.data(), sz,
+                     game.backgrounds[i].image_data.width * game.backgrounds[i].image_data.height * 4);
     fwrite(game.backgrounds[i].image_data.pixels.data(), 1, sz, gameModule); // data
   }
 
@@ -39,13 +39,14 @@ using namespace std;
 #include "compiler/compile_common.h"
 
 #include "backend/ideprint.h"
+#include "module_index.h"
 #include "languages/lang_CPP.h"
 
 inline void writei(int x, FILE *f) {
   fwrite(&x,4,1,f);
 }
 
-int lang_CPP::module_write_sounds(const GameData &game, FILE *gameModule)
+int lang_CPP::module_write_sounds(const GameData &game, FILE *gameModule, ModuleIndex *index)
 {
   // Now we're going to add sounds
   edbg << game.sounds.size() << " Sounds:" << flushl;
@@ -77,6 +78,8 @@ int lang_CPP::module_write_sounds(const GameData &game, FILE *gameModule)
 
     writei(game.sounds[i].id(), gameModule); // ID
     writei(sndsz, gameModule); // Size
+    index->add_asset("SND ", game.sounds[i].id(), 0, gameModule,
+                     game.sounds[i].audio.data(), sndsz, sndsz);
     fwrite(game.sounds[i].audio.data(), 1, sndsz, gameModule); // Data
   }
 
@@ -40,13 +40,14 @@ using namespace std;
 #include "compiler/compile_common.h"
 
 #include "backend/ideprint.h"
+#include "module_index.h"
 
 inline void writei(int x, FILE *f) {
   fwrite(&x,4,1,f);
 }
 
 #include "languages/lang_CPP.h"
-int lang_CPP::module_write_sprites(const GameData &game, FILE *gameModule)
+int lang_CPP::module_write_sprites(const GameData &game, FILE *gameModule, ModuleIndex *index)
 {
   // Now we're going to add sprites
   edbg << game.sprites.size() << " Adding Sprites to Game Module: " << flushl;
@@ -107,6 +108,9 @@ int lang_CPP::module_write_sprites(const GameData &game, FILE *gameModule)
       //strans = game.sprites[i].image_data[ii].transColor, fwrite(&idttrans,4,1,exe); //Transparent color
       writei(swidth * sheight * 4, gameModule); // size when unpacked
       writei(game.sprites[i].image_data[ii].pixels.size(), gameModule);  // size
+      index->add_asset("SPR ", game.sprites[i].id(), ii, gameModule,
+                       game.sprites[i].image_data[ii].pixels.data(),
+                       game.sprites[i].image_data[ii].pixels.size(), swidth * sheight * 4);
       fwrite(game.sprites[i].image_data[ii].pixels.data(), 1,
              game.sprites[i].image_data[ii].pixels.size(), gameModule);  // data
       writei(0,gameModule);
@@ -0,0 +1,112 @@
+/** This file is a part of the ENIGMA Development Environment.
+***
+*** ENIGMA is free software: you can redistribute it and/or modify it under the
+*** terms of the GNU General Public License as published by the Free Software
+*** Foundation, version 3 of the license or any later version.
+***
+*** This application and its source code is distributed AS-IS, WITHOUT ANY
+*** WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+*** FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+*** details.
+***
+*** You should have received a copy of the GNU General Public License along
+*** with this code. If not, see <http://www.gnu.org/licenses/>
+**/
+
+#include "room_asset_groups.h"
+
+namespace {
+
+// Collects every identifier in a parsed body of code. String literals were
+// already lifted out by the parser, so they can't produce false matches.
+void scan_identifiers(const ParsedCode *code, std::vector<std::string> *out) {
+  if (!code) return;
+  const std::string &synt = code->synt;
+  for (size_t pos = 0; pos < synt.length(); ) {
+    if (synt[pos] != 'n') { ++pos; continue; }
+    const size_t start = pos;
+    while (pos < synt.length() && synt[pos] == 'n') ++pos;
+    out->push_back(code->code.substr(start, pos - start));
+  }
+}
+
+}  // namespace
+
+RoomAssetGroups::RoomAssetGroups(const GameData &game, const CompileState &state): state_(state) {
+  for (const auto &r : game.sprites)     kinds_[r.name] = Kind::SPRITE;
+  for (const auto &r : game.backgrounds) kinds_[r.name] = Kind::BACKGROUND;
+  for (const auto &r : game.sounds)      kinds_[r.name] = Kind::SOUND;
+  for (const auto &r : game.fonts)       kinds_[r.name] = Kind::FONT;
+  for (const auto &r : game.scripts)     kinds_[r.name] = Kind::SCRIPT;
+  for (const auto &r : game.timelines)   kinds_[r.name] = Kind::TIMELINE;
+  for (const parsed_object *obj : state.parsed_objects) {
+    kinds_[obj->name] = Kind::OBJECT;
+    objects_[obj->name] = obj;
+  }
+}
+
+const std::vector<std::string> &RoomAssetGroups::references(const std::string &name, Kind kind) const {
+  auto cached = refs_.find(name);
+  if (cached != refs_.end()) return cached->second;
+
+  std::vector<std::string> &refs = refs_[name];
+  switch (kind) {
+    case Kind::OBJECT: {
+      auto it = objects_.find(name);
+      if (it == objects_.end()) break;
+      const parsed_object *obj = it->second;
+      refs.push_back(obj->sprite_name);
+      refs.push_back(obj->mask_name);
+      // Inherited events run the parent's code on this object's behalf.
+      if (obj->parent) refs.push_back(obj->parent->name);
+      for (const ParsedEvent &ev : obj->all_events) scan_identifiers(&ev, &refs);
+      for (const auto &tline : obj->tlines) refs.push_back(tline.first);
+      break;
+    }
+    case Kind::SCRIPT: {
+      auto it = state_.script_lookup.find(name);
+      if (it != state_.script_lookup.end()) scan_identifiers(&it->second->code, &refs);
+      break;
+    }
+    case Kind::TIMELINE: {
+      auto it = state_.timeline_lookup.find(name);
+      if (it == state_.timeline_lookup.end()) break;
+      for (const parsed_moment &moment : it->second.moments) scan_identifiers(&moment.script->code, &refs);
+      break;
+    }
+    default: break;
+  }
+  return refs;
+}
+
+void RoomAssetGroups::visit(const std::string &name, RoomAssetGroup *group, std::set<std::string> *seen) const {
+  auto it = kinds_.find(name);
+  if (it == kinds_.end() || !seen->insert(name).second) return;
+
+  switch (it->second) {
+    case Kind::SPRITE:     group->sprites.insert(name);     return;
+    case Kind::BACKGROUND: group->backgrounds.insert(name); return;
+    case Kind::SOUND:      group->sounds.insert(name);      return;
+    case Kind::FONT:       group->fonts.insert(name);       return;
+    default: break;
+  }
+  for (const std::string &ref : references(name, it->second)) visit(ref, group, seen);
+}
+
+RoomAssetGroup RoomAssetGroups::compute(const RoomData &room, const parsed_room *parsed) const {
+  RoomAssetGroup group;
+  std::set<std::string> seen;
+
+  for (const auto &background : room->backgrounds()) visit(background.background_name(), &group, &seen);
+  for (const auto &tile : room->tiles())              visit(tile.background_name(), &group, &seen);
+  for (const auto &instance : room->instances())      visit(instance.object_type(), &group, &seen);
+
+  if (parsed) {
+    std::vector<std::string> refs;
+    scan_identifiers(parsed->creation_code, &refs);
+    for (const auto &icode : parsed->instance_create_codes)    scan_identifiers(icode.second.code, &refs);
+    for (const auto &icode : parsed->instance_precreate_codes) scan_identifiers(icode.second.code, &refs);
+    for (const std::string &ref : refs) visit(ref, &group, &seen);
+  }
+  return group;
+}
@@ -0,0 +1,58 @@
+/** This file is a part of the ENIGMA Development Environment.
+***
+*** ENIGMA is free software: you can redistribute it and/or modify it under the
+*** terms of the GNU General Public License as published by the Free Software
+*** Foundation, version 3 of the license or any later version.
+***
+*** This application and its source code is distributed AS-IS, WITHOUT ANY
+*** WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+*** FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+*** details.
+***
+*** You should have received a copy of the GNU General Public License along
+*** with this code. If not, see <http://www.gnu.org/licenses/>
+**/
+
+#ifndef ENIGMA_ROOM_ASSET_GROUPS_H
+#define ENIGMA_ROOM_ASSET_GROUPS_H
+
+#include "backend/GameData.h"
+#include "parser/object_storage.h"
+
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+/// The drawable and audible resources a room can reach, by name.
+struct RoomAssetGroup {
+  std::set<std::string> sprites, backgrounds, sounds, fonts;
+};
+
+/// Works out which resources each room needs: those placed in it directly
+/// (backgrounds, tiles, instances), the sprites and masks of the objects it
+/// creates, and anything named in the code those objects, their parents, the
+/// scripts and timelines they use, or the room's creation code can run. A
+/// resource named in code is assumed to be needed even if that code never
+/// actually runs, so the groups err on the side of keeping things resident.
+class RoomAssetGroups {
+ public:
+  RoomAssetGroups(const GameData &game, const CompileState &state);
+
+  RoomAssetGroup compute(const RoomData &room, const parsed_room *parsed) const;
+
+ private:
+  enum class Kind { SPRITE, BACKGROUND, SOUND, FONT, OBJECT, SCRIPT, TIMELINE };
+
+  std::map<std::string, Kind> kinds_;
+  std::map<std::string, const parsed_object*> objects_;
+  const CompileState &state_;
+  // Names referenced directly by each object, script or timeline; filled on
+  // first visit so each body of code is only scanned once.
+  mutable std::map<std::string, std::vector<std::string>> refs_;
+
+  const std::vector<std::string> &references(const std::string &name, Kind kind) const;
+  void visit(const std::string &name, RoomAssetGroup *group, std::set<std::string> *seen) const;
+};
+
+#endif  // ENIGMA_ROOM_ASSET_GROUPS_H
@@ -31,6 +31,7 @@
 #include <iostream>
 #include <fstream>
 #include <sstream>
+#include <set>
 #include <vector>
 
 using namespace std;
@@ -42,6 +43,7 @@ using namespace std;
 #include "backend/GameData.h"
 #include "parser/object_storage.h"
 #include "compiler/compile_common.h"
+#include "room_asset_groups.h"
 
 #include <math.h> //log2 to calculate passes.
 
@@ -60,8 +62,26 @@ inline string resname(string name) {
   return name.empty() ? "-1" : name;
 }
 
-int lang_CPP::compile_writeRoomData(const GameData &game, const ParsedRoomVec &parsed_rooms, ParsedScope *EGMglobal, int mode)
+static void write_names(ofstream &wto, const set<string> &names) {
+  wto << "{";
+  for (const string &name : names) wto << " " << name << ",";
+  wto << " }";
+}
+
+// Emits the room's asset group, in roomassets field order.
+static void write_asset_group(ofstream &wto, const RoomAssetGroup &group) {
+  wto << "{ ";
+  write_names(wto, group.sprites);     wto << ", ";
+  write_names(wto, group.backgrounds); wto << ", ";
+  write_names(wto, group.sounds);      wto << ", ";
+  write_names(wto, group.fonts);
+  wto << " }";
+}
+
+int lang_CPP::compile_writeRoomData(const GameData &game, const CompileState &state, ParsedScope *EGMglobal, int mode)
 {
+  const ParsedRoomVec &parsed_rooms = state.parsed_rooms;
+  const RoomAssetGroups asset_groups(game, state);
   ofstream wto((codegen_directory/"Preprocessor_Environment_Editable/IDE_EDIT_roomarrays.h").u8string().c_str(),ios_base::out);
 
   wto << license << "namespace enigma {\n"
@@ -169,8 +189,10 @@ int lang_CPP::compile_writeRoomData(const GameData &game, const ParsedRoomVec &p
     wto <<
     " },\n" //End of Backgrounds
     "      " << "insts_" << room.id() << ",\n"
-    "      " << "tiles_" << room.id() << "\n"
-    "    },\n";
+    "      " << "tiles_" << room.id() << ",\n"
+    "      ";
+    write_asset_group(wto, asset_groups.compute(room, parsed_rooms[room_index]));
+    wto << "\n    },\n";
 
     if (room.id() > room_highid)
       room_highid = room.id();
@@ -48,14 +48,14 @@ struct lang_CPP: language_adapter {
   int compile_writeObjectData(const GameData &game, const CompileState &state, int mode) final;
   int compile_writeObjAccess(const ParsedObjectVec &parsed_objects, const DotLocalMap &dot_accessed_locals, const ParsedScope* global, bool treatUninitAs0) final;
   int compile_writeFontInfo(const GameData &game) final;
-  int compile_writeRoomData(const GameData &game, const ParsedRoomVec &parsed_rooms, ParsedScope *EGMglobal, int mode) final;
+  int compile_writeRoomData(const GameData &game, const CompileState &state, ParsedScope *EGMglobal, int mode) final;
   int compile_writeShaderData(const GameData &game, ParsedScope *EGMglobal) final;
   int compile_writeDefraggedEvents(const GameData &game, const std::set<EventGroupKey> &used_events, const ParsedObjectVec &parsed_objects) final;
 
   // Resources added to module
-  int module_write_sprites(const GameData &game, FILE *gameModule) final;
-  int module_write_sounds(const GameData &game, FILE *gameModule) final;
-  int module_write_backgrounds(const GameData &game, FILE *gameModule) final;
+  int module_write_sprites(const GameData &game, FILE *gameModule, ModuleIndex *index) final;
+  int module_write_sounds(const GameData &game, FILE *gameModule, ModuleIndex *index) final;
+  int module_write_backgrounds(const GameData &game, FILE *gameModule, ModuleIndex *index) final;
   int module_write_paths(const GameData &game, FILE *gameModule) final;
   int module_write_fonts(const GameData &game, FILE *gameModule) final;
 
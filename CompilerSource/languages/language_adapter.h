@@ -32,6 +32,8 @@
 #include "parser/object_storage.h"
 #include "frontend.h"
 
+struct ModuleIndex;
+
 struct language_adapter {
   virtual string get_name() = 0;
 
@@ -45,14 +47,14 @@ struct language_adapter {
   virtual int compile_writeObjectData(const GameData &game, const CompileState &state, int mode) = 0;
   virtual int compile_writeObjAccess(const ParsedObjectVec &parsed_objects, const DotLocalMap &dot_accessed_locals, const ParsedScope* global, bool treatUninitAs0) = 0;
   virtual int compile_writeFontInfo(const GameData &game) = 0;
-  virtual int compile_writeRoomData(const GameData &game, const ParsedRoomVec &parsed_rooms, ParsedScope *EGMglobal, int mode) = 0;
+  virtual int compile_writeRoomData(const GameData &game, const CompileState &state, ParsedScope *EGMglobal, int mode) = 0;
   virtual int compile_writeShaderData(const GameData &game, ParsedScope *EGMglobal) = 0;
   virtual int compile_writeDefraggedEvents(const GameData &game, const std::set<EventGroupKey> &used_events, const ParsedObjectVec &parsed_objects) = 0;
 
   // Resources added to module
-  virtual int module_write_sprites(const GameData &game, FILE *gameModule) = 0;
-  virtual int module_write_sounds(const GameData &game, FILE *gameModule) = 0;
-  virtual int module_write_backgrounds(const GameData &game, FILE *gameModule) = 0;
+  virtual int module_write_sprites(const GameData &game, FILE *gameModule, ModuleIndex *index) = 0;
+  virtual int module_write_sounds(const GameData &game, FILE *gameModule, ModuleIndex *index) = 0;
+  virtual int module_write_backgrounds(const GameData &game, FILE *gameModule, ModuleIndex *index) = 0;
   virtual int module_write_paths(const GameData &game, FILE *gameModule) = 0;
   virtual int module_write_fonts(const GameData &game, FILE *gameModule) = 0;
 
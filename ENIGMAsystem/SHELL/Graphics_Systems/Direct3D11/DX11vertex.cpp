@@ -21,6 +21,7 @@
 #include "Graphics_Systems/General/GSprimitives.h"
 #include "Graphics_Systems/General/GScolor_macros.h"
 #include "Graphics_Systems/General/GSstdraw.h"
+#include "Graphics_Systems/General/GScapture.h"
 
 #include "Widget_Systems/widgets_mandatory.h" // for show_error
 
@@ -61,6 +62,42 @@ PixelInputType VS(VertexInputType input) {
 }
 )";
 
+// the default vertex shader with the per-instance attributes applied
+const char* g_strVSInstanced = R"(
+cbuffer MatrixBuffer
+{
+    matrix worldMatrix;
+    matrix viewMatrix;
+    matrix projectionMatrix;
+};
+struct VertexInputType {
+  float4 position : POSITION;
+  float2 tex : TEXCOORD0;
+  float4 color : COLOR;
+  float4 transform0 : INSTANCE0;
+  float4 transform1 : INSTANCE1;
+  float4 transform2 : INSTANCE2;
+  float4 instanceColor : INSTANCECOLOR;
+  float4 texRect : INSTANCETEXRECT;
+};
+struct PixelInputType {
+  float4 position : SV_POSITION;
+  float2 tex : TEXCOORD0;
+  float4 color : COLOR;
+};
+PixelInputType VS(VertexInputType input) {
+  PixelInputType output;
+  float4 position = float4(input.position.xyz, 1.0);
+  output.position = float4(dot(input.transform0, position), dot(input.transform1, position), dot(input.transform2, position), 1.0);
+  output.position = mul(output.position, worldMatrix);
+  output.position = mul(output.position, viewMatrix);
+  output.position = mul(output.position, projectionMatrix);
+  output.tex = input.texRect.xy + input.tex * input.texRect.zw;
+  output.color = input.color * input.instanceColor;
+  return output;
+}
+)";
+
 const char* g_strPS = R"(
 Texture2D gm_BaseTextureObject : register(t0);
 SamplerState gm_BaseTexture : register(S0);
@@ -77,6 +114,7 @@ float4 PS(PixelInputType input) : SV_TARGET {
 )";
 
 ID3D10Blob* pBlobVS = NULL;
+ID3D10Blob* pBlobVSInstanced = NULL;
 ID3D10Blob* pBlobPS = NULL;
 
 static const size_t primitive_types_size = 7;
@@ -113,14 +151,29 @@ size_t dxgi_format_sizes[] = {
 map<int, ID3D11Buffer*> vertexBufferPeers;
 map<int, ID3D11Buffer*> indexBufferPeers;
 map<int, std::pair<ID3D11InputLayout*, size_t> > vertexFormatPeers;
+map<int, std::pair<ID3D11InputLayout*, size_t> > vertexFormatInstancedPeers;
+
+// Streamed vertex buffers are appended to one dynamic buffer with
+// D3D11_MAP_WRITE_NO_OVERWRITE, which is D3D11's persistently mapped ring:
+// the driver only has to rename it when we wrap around and discard it.
+const UINT stream_ring_size = 12 << 20;
+ID3D11Buffer* streamRing = NULL;
+UINT streamRingHead = 0;
+unsigned streamRingGeneration = 1; // bumped every discard, which loses what was written
+struct StreamAllocation { UINT offset; unsigned generation; };
+map<int, StreamAllocation> vertexBufferStreams;
 
 } // namespace anonymous
 
 namespace enigma {
 
 void graphics_delete_vertex_buffer_peer(int buffer) {
-  vertexBufferPeers[buffer]->Release();
-  vertexBufferPeers.erase(buffer);
+  auto it = vertexBufferPeers.find(buffer);
+  if (it != vertexBufferPeers.end()) {
+    it->second->Release();
+    vertexBufferPeers.erase(it);
+  }
+  vertexBufferStreams.erase(buffer);
 }
 
 void graphics_delete_index_buffer_peer(int buffer) {
@@ -128,6 +181,58 @@ void graphics_delete_index_buffer_peer(int buffer) {
   indexBufferPeers.erase(buffer);
 }
 
+color_t graphics_pack_vertex_color(int color, double alpha) {
+  return (CLAMP_ALPHA(alpha) << 24) | (COL_GET_R(color) << 16) | (COL_GET_G(color) << 8) | COL_GET_B(color);
+}
+
+// appends a streamed vertex buffer to the stream ring instead of mapping its
+// own peer, returning false when it has to go through its peer anyway
+static bool graphics_prepare_stream_buffer(const int buffer) {
+  auto& vertexBuffer = vertexBuffers[buffer];
+  if (vertexBuffer->dirty) {
+    const UINT size = enigma_user::vertex_get_buffer_size(buffer);
+    if (size > stream_ring_size) {
+      vertexBufferStreams.erase(buffer);
+      return false;
+    }
+    if (!streamRing) {
+      D3D11_BUFFER_DESC bd = { };
+      bd.Usage = D3D11_USAGE_DYNAMIC;
+      bd.ByteWidth = stream_ring_size;
+      bd.BindFlags = D3D11_BIND_VERTEX_BUFFER;
+      bd.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+      if (FAILED(m_device->CreateBuffer(&bd, NULL, &streamRing))) return false;
+    }
+
+    // the first write after creating or wrapping has to discard, the rest
+    // promise not to touch anything a draw may still be reading
+    D3D11_MAP mapType = D3D11_MAP_WRITE_NO_OVERWRITE;
+    UINT offset = (streamRingHead + 15) & ~15u;
+    if (!streamRingHead || offset + size > stream_ring_size) {
+      mapType = D3D11_MAP_WRITE_DISCARD;
+      offset = 0;
+      ++streamRingGeneration;
+    }
+
+    D3D11_MAPPED_SUBRESOURCE mappedResource;
+    if (FAILED(m_deviceContext->Map(streamRing, 0, mapType, 0, &mappedResource))) return false;
+    memcpy((char*)mappedResource.pData + offset, &vertexBuffer->vertices[0], size);
+    m_deviceContext->Unmap(streamRing, 0);
+
+    streamRingHead = offset + size;
+    vertexBufferStreams[buffer] = StreamAllocation{offset, streamRingGeneration};
+    vertexBuffer->clearData();
+  }
+
+  auto it = vertexBufferStreams.find(buffer);
+  if (it == vertexBufferStreams.end()) return false;
+  if (it->second.generation != streamRingGeneration) {
+    vertexBufferStreams.erase(it);
+    return false;
+  }
+  return true;
+}
+
 void graphics_prepare_buffer(const int buffer, const bool isIndex) {
   auto &bufferPeers = isIndex ? indexBufferPeers : vertexBufferPeers;
   const bool dirty = isIndex ? indexBuffers[buffer]->dirty : vertexBuffers[buffer]->dirty;
@@ -186,13 +291,24 @@ void graphics_prepare_buffer(const int buffer, const bool isIndex) {
   }
 }
 
-inline ID3D11InputLayout* vertex_format_layout(const enigma::VertexFormat* vertexFormat) {
+// prepares a vertex buffer, returning what to bind for it and adding the
+// offset of its contents in there to offset
+ID3D11Buffer* graphics_prepare_vertex_buffer(const int buffer, UINT* offset) {
+  if (vertexBuffers[buffer]->streamed && graphics_prepare_stream_buffer(buffer)) {
+    *offset += vertexBufferStreams[buffer].offset;
+    return streamRing;
+  }
+  graphics_prepare_buffer(buffer, false);
+  return vertexBufferPeers[buffer];
+}
+
+inline ID3D11InputLayout* vertex_format_layout(const enigma::VertexFormat* vertexFormat, ID3D10Blob* pBlob) {
   ID3D11ShaderReflection* pVertexShaderReflection = NULL;
   // because the vertex format describes the contents of the vertex buffer
   // in the GM/ENIGMA API, we need to reflect over the current shader to
   // match its inputs with those specified in the vertex format so that
   // input layout validation will succeed
-  if (FAILED(D3DReflect(pBlobVS->GetBufferPointer(), pBlobVS->GetBufferSize(), IID_ID3D11ShaderReflection, (void**) &pVertexShaderReflection)))
+  if (FAILED(D3DReflect(pBlob->GetBufferPointer(), pBlob->GetBufferSize(), IID_ID3D11ShaderReflection, (void**) &pVertexShaderReflection)))
     return nullptr;
 
   D3D11_SHADER_DESC shaderDesc;
@@ -216,6 +332,18 @@ inline ID3D11InputLayout* vertex_format_layout(const enigma::VertexFormat* verte
     // unused shader inputs will produce warnings in the debug layer
     // about being reinterpreted, but they can be safely ignored
     elementDesc.Format = DXGI_FORMAT_R8_UINT;
+    // the instance attributes come from the instance buffer in the second
+    // slot, which has a fixed layout
+    if (strncmp(paramDesc.SemanticName, "INSTANCE", 8) == 0) {
+      const bool color = strcmp(paramDesc.SemanticName, "INSTANCECOLOR") == 0;
+      const bool texRect = strcmp(paramDesc.SemanticName, "INSTANCETEXRECT") == 0;
+      elementDesc.InputSlot = 1;
+      elementDesc.InputSlotClass = D3D11_INPUT_PER_INSTANCE_DATA;
+      elementDesc.InstanceDataStepRate = 1;
+      elementDesc.Format = color ? DXGI_FORMAT_B8G8R8A8_UNORM : DXGI_FORMAT_R32G32B32A32_FLOAT;
+      elementDesc.AlignedByteOffset = (color ? 12 : texRect ? 13 : paramDesc.SemanticIndex * 4) * sizeof(enigma::VertexElement);
+      continue;
+    }
     // look for any matching element present in the vertex format
     // to link with the shader input in the actual input layout
     UINT semanticIndex = 0;
@@ -236,21 +364,22 @@ inline ID3D11InputLayout* vertex_format_layout(const enigma::VertexFormat* verte
   }
 
   ID3D11InputLayout* vertexLayout;
-  m_device->CreateInputLayout(vertexLayoutElements.data(), vertexLayoutElements.size(), pBlobVS->GetBufferPointer(),
-                              pBlobVS->GetBufferSize(), &vertexLayout);
+  m_device->CreateInputLayout(vertexLayoutElements.data(), vertexLayoutElements.size(), pBlob->GetBufferPointer(),
+                              pBlob->GetBufferSize(), &vertexLayout);
 
   return vertexLayout;
 }
 
-inline void graphics_apply_vertex_format(int format, size_t &stride) {
+inline void graphics_apply_vertex_format(int format, size_t &stride, bool instanced = false) {
   const auto& vertexFormat = enigma::vertexFormats[format];
 
-  auto search = vertexFormatPeers.find(format);
+  auto& formatPeers = instanced ? vertexFormatInstancedPeers : vertexFormatPeers;
+  auto search = formatPeers.find(format);
   ID3D11InputLayout* vertexLayout = NULL;
-  if (search == vertexFormatPeers.end()) {
+  if (search == formatPeers.end()) {
     stride = vertexFormat->stride_size;
-    vertexLayout = vertex_format_layout(vertexFormat.get());
-    vertexFormatPeers[format] = std::make_pair(vertexLayout, stride);
+    vertexLayout = vertex_format_layout(vertexFormat.get(), instanced ? pBlobVSInstanced : pBlobVS);
+    formatPeers[format] = std::make_pair(vertexLayout, stride);
   } else {
     vertexLayout = search->second.first;
     stride = search->second.second;
@@ -277,8 +406,9 @@ void graphics_compile_shader(const char* src, ID3D10Blob** pBlob, const char* na
   }
 }
 
-void graphics_prepare_default_shader() {
+void graphics_prepare_default_shader(bool instanced = false) {
   static ID3D11VertexShader* g_pVertexShader = NULL;
+  static ID3D11VertexShader* g_pVertexShaderInstanced = NULL;
   static ID3D11PixelShader* g_pPixelShader = NULL;
 
   if (g_pVertexShader == NULL) {
@@ -293,7 +423,13 @@ void graphics_prepare_default_shader() {
                                 NULL, &g_pPixelShader);
   }
 
-  m_deviceContext->VSSetShader(g_pVertexShader, NULL, 0);
+  if (instanced && g_pVertexShaderInstanced == NULL) {
+    graphics_compile_shader(g_strVSInstanced, &pBlobVSInstanced, "VSInstanced", "VS", "vs_4_0");
+    m_device->CreateVertexShader(pBlobVSInstanced->GetBufferPointer(), pBlobVSInstanced->GetBufferSize(),
+                                NULL, &g_pVertexShaderInstanced);
+  }
+
+  m_deviceContext->VSSetShader(instanced ? g_pVertexShaderInstanced : g_pVertexShader, NULL, 0);
   m_deviceContext->PSSetShader(g_pPixelShader, NULL, 0);
 }
 
@@ -308,6 +444,34 @@ void graphics_prepare_default_shader() {
 #define set_primitive_mode(primitive) m_deviceContext->IASetPrimitiveTopology(primitive_types[primitive]);
 #endif
 
+bool graphics_instancing_supported() {
+  return true;
+}
+
+void graphics_submit_instanced(int buffer, int primitive, unsigned offset, unsigned start, unsigned count, int instances) {
+  enigma_user::draw_state_flush();
+  capture_draw_instanced(buffer, primitive, offset, start, count, instances);
+
+  const auto& vertexBuffer = vertexBuffers[buffer];
+  UINT strides[2] = { 0, instance_stride * sizeof(VertexElement) }, offsets[2] = { offset, 0 };
+  const UINT instance_count = enigma_user::vertex_get_buffer_size(instances) / strides[1];
+
+  graphics_prepare_default_shader(true);
+  ID3D11Buffer* buffers[2] = {
+    graphics_prepare_vertex_buffer(buffer, &offsets[0]),
+    graphics_prepare_vertex_buffer(instances, &offsets[1])
+  };
+
+  size_t stride = 0;
+  graphics_apply_vertex_format(vertexBuffer->format, stride, true);
+  strides[0] = stride;
+
+  m_deviceContext->IASetVertexBuffers(0, 2, buffers, strides, offsets);
+
+  set_primitive_mode(primitive);
+  m_deviceContext->DrawInstanced(count, instance_count, start, 0);
+}
+
 } // namespace enigma
 
 namespace enigma_user {
@@ -317,22 +481,21 @@ void vertex_argb(int buffer, unsigned argb) {
 }
 
 void vertex_color(int buffer, int color, double alpha) {
-  enigma::color_t finalcol = (CLAMP_ALPHA(alpha) << 24) | (COL_GET_R(color) << 16) | (COL_GET_G(color) << 8) | COL_GET_B(color);
-  enigma::vertexBuffers[buffer]->vertices.push_back(finalcol);
+  enigma::vertexBuffers[buffer]->vertices.push_back(enigma::graphics_pack_vertex_color(color, alpha));
 }
 
 void vertex_submit_offset(int buffer, int primitive, unsigned offset, unsigned start, unsigned count) {
   draw_state_flush();
+  enigma::capture_draw(buffer, primitive, offset, start, count);
 
   const auto& vertexBuffer = enigma::vertexBuffers[buffer];
 
   enigma::graphics_prepare_default_shader();
-  enigma::graphics_prepare_buffer(buffer, false);
+  ID3D11Buffer* vertexBufferPeer = enigma::graphics_prepare_vertex_buffer(buffer, &offset);
 
   size_t stride = 0;
   enigma::graphics_apply_vertex_format(vertexBuffer->format, stride);
 
-  ID3D11Buffer* vertexBufferPeer = vertexBufferPeers[buffer];
   m_deviceContext->IASetVertexBuffers(0, 1, &vertexBufferPeer, (UINT*)&stride, &offset);
 
   set_primitive_mode(primitive);
@@ -341,19 +504,19 @@ void vertex_submit_offset(int buffer, int primitive, unsigned offset, unsigned s
 
 void index_submit_range(int buffer, int vertex, int primitive, unsigned start, unsigned count) {
   draw_state_flush();
+  enigma::capture_draw_indexed(buffer, vertex, primitive, start, count);
 
   const auto& vertexBuffer = enigma::vertexBuffers[vertex];
   const auto& indexBuffer = enigma::indexBuffers[buffer];
 
   enigma::graphics_prepare_default_shader();
   enigma::graphics_prepare_buffer(buffer, true);
-  enigma::graphics_prepare_buffer(vertex, false);
+  UINT offset = 0;
+  ID3D11Buffer* vertexBufferPeer = enigma::graphics_prepare_vertex_buffer(vertex, &offset);
 
   size_t stride = 0;
   enigma::graphics_apply_vertex_format(vertexBuffer->format, stride);
 
-  UINT offset = 0;
-  ID3D11Buffer* vertexBufferPeer = vertexBufferPeers[vertex];
   m_deviceContext->IASetVertexBuffers(0, 1, &vertexBufferPeer, (UINT*)&stride, &offset);
 
   ID3D11Buffer* indexBufferPeer = indexBufferPeers[buffer];
@@ -20,6 +20,7 @@
 #include "Graphics_Systems/General/GSprimitives.h" // for enigma_user::draw_primitive_count
 #include "Graphics_Systems/General/GScolor_macros.h"
 #include "Graphics_Systems/General/GSstdraw.h"
+#include "Graphics_Systems/General/GScapture.h"
 
 #include <map>
 using std::map;
@@ -52,6 +53,18 @@ void graphics_delete_index_buffer_peer(int buffer) {
   indexBufferPeers.erase(buffer);
 }
 
+color_t graphics_pack_vertex_color(int color, double alpha) {
+  return (CLAMP_ALPHA(alpha) << 24) | (COL_GET_R(color) << 16) | (COL_GET_G(color) << 8) | COL_GET_B(color);
+}
+
+// stream frequencies only instance with a vertex shader and we draw with
+// the fixed function pipeline, so instances are expanded on the CPU
+bool graphics_instancing_supported() {
+  return false;
+}
+
+void graphics_submit_instanced(int buffer, int primitive, unsigned offset, unsigned start, unsigned count, int instances) {}
+
 void graphics_prepare_vertex_buffer(const int buffer) {
   auto& vertexBuffer = enigma::vertexBuffers[buffer];
 
@@ -204,12 +217,12 @@ void vertex_argb(int buffer, unsigned argb) {
 }
 
 void vertex_color(int buffer, int color, double alpha) {
-  enigma::color_t finalcol = (CLAMP_ALPHA(alpha) << 24) | (COL_GET_R(color) << 16) | (COL_GET_G(color) << 8) | COL_GET_B(color);
-  enigma::vertexBuffers[buffer]->vertices.push_back(finalcol);
+  enigma::vertexBuffers[buffer]->vertices.push_back(enigma::graphics_pack_vertex_color(color, alpha));
 }
 
 void vertex_submit_offset(int buffer, int primitive, unsigned offset, unsigned start, unsigned count) {
   draw_state_flush();
+  enigma::capture_draw(buffer, primitive, offset, start, count);
 
   const auto& vertexBuffer = enigma::vertexBuffers[buffer];
 
@@ -228,6 +241,7 @@ void vertex_submit_offset(int buffer, int primitive, unsigned offset, unsigned s
 
 void index_submit_range(int buffer, int vertex, int primitive, unsigned start, unsigned count) {
   draw_state_flush();
+  enigma::capture_draw_indexed(buffer, vertex, primitive, start, count);
 
   const auto& vertexBuffer = enigma::vertexBuffers[vertex];
 
@@ -0,0 +1,66 @@
+/** This file is a part of the ENIGMA Development Environment.
+***
+*** ENIGMA is free software: you can redistribute it and/or modify it under the
+*** terms of the GNU General Public License as published by the Free Software
+*** Foundation, version 3 of the license or any later version.
+***
+*** This application and its source code is distributed AS-IS, WITHOUT ANY
+*** WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+*** FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+*** details.
+***
+*** You should have received a copy of the GNU General Public License along
+*** with this code. If not, see <http://www.gnu.org/licenses/>
+**/
+
+// Little-endian writing and reading for the binary model format and frame
+// traces. The gfxreplay tool reads traces with these too, so this must not
+// include anything of the engine's.
+
+#ifndef ENIGMA_GSBINARY_IO_H
+#define ENIGMA_GSBINARY_IO_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace enigma {
+namespace binary_io {
+
+class writer {
+ public:
+  void bytes(const void* data, size_t size) {
+    const unsigned char* p = static_cast<const unsigned char*>(data);
+    out.insert(out.end(), p, p + size);
+  }
+  void u8(uint8_t n) { out.push_back(n); }
+  void u16(uint16_t n) { u8(n & 255); u8(n >> 8); }
+  void u32(uint32_t n) { u16(n & 0xFFFF); u16(n >> 16); }
+  void f32(float f) { uint32_t n; memcpy(&n, &f, 4); u32(n); }
+
+  std::vector<unsigned char> out;
+};
+
+// Callers check has() before taking anything; take() does no bounds checks.
+class reader {
+ public:
+  reader(const unsigned char* data, size_t size): data(data), size(size) {}
+
+  bool has(size_t n) const { return size - pos >= n; }
+  size_t remaining() const { return size - pos; }
+  const unsigned char* take(size_t n) { const unsigned char* p = data + pos; pos += n; return p; }
+  uint8_t u8() { return *take(1); }
+  uint16_t u16() { const unsigned char* p = take(2); return p[0] | (p[1] << 8); }
+  uint32_t u32() { const unsigned char* p = take(4); return p[0] | (p[1] << 8) | (p[2] << 16) | (uint32_t(p[3]) << 24); }
+  float f32() { uint32_t n = u32(); float f; memcpy(&f, &n, 4); return f; }
+
+ private:
+  const unsigned char* data;
+  size_t size, pos = 0;
+};
+
+} // namespace binary_io
+} // namespace enigma
+
+#endif // ENIGMA_GSBINARY_IO_H
@@ -0,0 +1,356 @@
+/** This file is a part of the ENIGMA Development Environment.
+***
+*** ENIGMA is free software: you can redistribute it and/or modify it under the
+*** terms of the GNU General Public License as published by the Free Software
+*** Foundation, version 3 of the license or any later version.
+***
+*** This application and its source code is distributed AS-IS, WITHOUT ANY
+*** WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+*** FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+*** details.
+***
+*** You should have received a copy of the GNU General Public License along
+*** with this code. If not, see <http://www.gnu.org/licenses/>
+**/
+
+#include "GScapture.h"
+#include "GScapture_format.h"
+#include "GSvertex_impl.h"
+#include "GStextures.h"
+#include "GStextures_impl.h"
+#include "GSblend.h"
+#include "GSd3d.h"
+#include "GSstdraw.h"
+#include "GScolors.h"
+#include "GSmatrix_impl.h"
+
+#include "Graphics_Systems/graphics_mandatory.h"
+#include "Platforms/General/PFwindow.h"
+#include "Platforms/General/fileio.h"
+#include "Widget_Systems/widgets_mandatory.h"
+
+#include <unordered_map>
+#include <unordered_set>
+
+using namespace enigma::capture_format;
+
+namespace {
+
+enum { capture_idle, capture_armed, capture_recording };
+int capturePhase = capture_idle;
+std::string capturePath;
+writer trace;
+bool retainBuffers = false, batched = false;
+
+// contents this capture has written, which are only written again if they
+// change; textures are read back when the frame is done, because reading
+// them can disturb the state of the draw they were first used in, and
+// spliced in where that draw was recorded
+std::unordered_set<int> writtenFormats, writtenVertices, writtenIndices, usedTextures;
+vector<std::pair<size_t, int> > textureSplices;
+
+// copies of buffers from when they were last uploaded
+struct RetainedVertices { int format; vector<enigma::VertexElement> vertices; };
+struct RetainedIndices { int type; vector<uint16_t> indices; };
+std::unordered_map<int, RetainedVertices> retainedVertices;
+std::unordered_map<int, RetainedIndices> retainedIndices;
+
+enigma::capture_format::State current_state() {
+  using namespace enigma;
+
+  capture_format::State s;
+  for (int i = 0; i < 8; ++i) {
+    s.textures[i] = samplers[i].texture;
+    s.samplers[i] = (samplers[i].wrapu ? sampler_wrapu : 0) | (samplers[i].wrapv ? sampler_wrapv : 0) |
+                    (samplers[i].wrapw ? sampler_wrapw : 0) | (samplers[i].interpolate ? sampler_interpolate : 0);
+  }
+  s.blend_src = blendMode[0], s.blend_dest = blendMode[1];
+  s.alpha_blend = alphaBlend, s.alpha_test = alphaTest, s.alpha_ref = alphaTestRef;
+  s.depth_test = d3dHidden, s.depth_write = d3dZWriteEnable;
+  s.depth_func = d3dDepthOperator, s.culling = d3dCulling, s.fill_mode = drawFillMode;
+  s.point_size = drawPointSize, s.line_width = drawLineWidth;
+  s.color_write = 0;
+  for (int c = 0; c < 4; ++c) s.color_write |= colorWriteEnable[c] << c;
+  s.lighting = d3dLighting, s.fog = d3dFogEnabled, s.stencil_test = d3dStencilTest;
+  memcpy(s.world, &world[0][0], sizeof(s.world));
+  memcpy(s.view, &view[0][0], sizeof(s.view));
+  memcpy(s.projection, &projection[0][0], sizeof(s.projection));
+  return s;
+}
+
+void write_format(int format) {
+  if (!enigma_user::vertex_format_exists(format) || !writtenFormats.insert(format).second) return;
+  const auto& flags = enigma::vertexFormats[format]->flags;
+  trace.u8(op_format);
+  trace.u32(format);
+  trace.u32(flags.size());
+  for (const auto& flag : flags) {
+    trace.u16(flag.first);
+    trace.u16(flag.second);
+  }
+}
+
+void write_vertices(int buffer, int format, const vector<enigma::VertexElement>* vertices, size_t count) {
+  using namespace enigma_user;
+
+  // a double precision build has to narrow the floats, which means walking
+  // the format to tell them apart from colors; without a format to walk the
+  // contents are recorded as missing
+  const bool narrow = sizeof(enigma::VertexElement) != 4;
+  if (narrow && (!vertex_format_exists(format) || enigma::vertexFormats[format]->flags.empty()))
+    vertices = nullptr;
+
+  write_format(format);
+  trace.u8(op_vertices);
+  trace.u32(buffer);
+  trace.u32(format);
+  trace.u32(count);
+  trace.u8(vertices != nullptr);
+  if (!vertices) return;
+
+  if (!narrow) {
+    trace.bytes(vertices->data(), vertices->size() * 4);
+    return;
+  }
+  const auto& flags = enigma::vertexFormats[format]->flags;
+  size_t element = 0;
+  while (element < vertices->size()) {
+    for (const auto& flag : flags) {
+      const size_t size = (flag.first <= vertex_type_float4) ? flag.first - vertex_type_float1 + 1 : 1;
+      for (size_t i = 0; i < size && element < vertices->size(); ++i, ++element) {
+        if (flag.first > vertex_type_float4) {
+          trace.u32((*vertices)[element].d);
+        } else {
+          trace.f32((*vertices)[element].f);
+        }
+      }
+    }
+  }
+}
+
+void write_indices(int buffer, int type, const vector<uint16_t>* indices, size_t count) {
+  trace.u8(op_indices);
+  trace.u32(buffer);
+  trace.u8(type);
+  trace.u32(count);
+  trace.u8(indices != nullptr);
+  if (!indices) return;
+
+  // the low half of a 32-bit index comes first
+  if (type == enigma_user::index_type_uint) {
+    for (size_t i = 0; i + 1 < indices->size(); i += 2)
+      trace.u32((*indices)[i] | (uint32_t((*indices)[i + 1]) << 16));
+  } else {
+    for (uint16_t index : *indices) trace.u32(index);
+  }
+}
+
+void record_vertices(int buffer) {
+  const auto& vertexBuffer = enigma::vertexBuffers[buffer];
+  // dirty contents are new, anything else only has to be written the first
+  // time the capture sees it
+  if (!writtenVertices.insert(buffer).second && !vertexBuffer->dirty) return;
+
+  if (vertexBuffer->dirty || vertexBuffer->shadowed) {
+    write_vertices(buffer, vertexBuffer->format, &vertexBuffer->vertices, vertexBuffer->vertices.size());
+    return;
+  }
+  auto retained = retainedVertices.find(buffer);
+  if (retained != retainedVertices.end()) {
+    write_vertices(buffer, retained->second.format, &retained->second.vertices, retained->second.vertices.size());
+  } else {
+    write_vertices(buffer, vertexBuffer->format, nullptr, vertexBuffer->getNumber());
+  }
+}
+
+void record_indices(int buffer) {
+  const auto& indexBuffer = enigma::indexBuffers[buffer];
+  if (!writtenIndices.insert(buffer).second && !indexBuffer->dirty) return;
+
+  const bool wide = indexBuffer->type == enigma_user::index_type_uint;
+  if (indexBuffer->dirty) {
+    const auto& indices = indexBuffer->indices;
+    write_indices(buffer, indexBuffer->type, &indices, wide ? indices.size() / 2 : indices.size());
+    return;
+  }
+  auto retained = retainedIndices.find(buffer);
+  if (retained != retainedIndices.end()) {
+    const auto& indices = retained->second.indices;
+    write_indices(buffer, retained->second.type, &indices,
+                  retained->second.type == enigma_user::index_type_uint ? indices.size() / 2 : indices.size());
+  } else {
+    write_indices(buffer, indexBuffer->type, nullptr, indexBuffer->getNumber());
+  }
+}
+
+void record_textures() {
+  for (const enigma::Sampler& sampler : enigma::samplers) {
+    if (sampler.texture < 0 || !usedTextures.insert(sampler.texture).second) continue;
+    textureSplices.emplace_back(trace.out.size(), sampler.texture);
+  }
+}
+
+void write_texture(writer& w, int id) {
+  w.u8(op_texture);
+  w.u32(id);
+  if (size_t(id) >= enigma::textures.size() || !enigma::textures[id]) {
+    for (int i = 0; i < 5; ++i) w.u32(0);
+    return;
+  }
+  const auto& texture = enigma::textures[id];
+  unsigned fullwidth = texture->fullwidth, fullheight = texture->fullheight;
+  unsigned char* pixels = enigma::graphics_copy_texture_pixels(id, &fullwidth, &fullheight);
+  const size_t size = pixels ? size_t(fullwidth) * fullheight * 4 : 0;
+  w.u32(texture->width);
+  w.u32(texture->height);
+  w.u32(fullwidth);
+  w.u32(fullheight);
+  w.u32(size);
+  if (pixels) w.bytes(pixels, size);
+  delete[] pixels;
+}
+
+void retain(int vertex, int index) {
+  const auto& vertexBuffer = enigma::vertexBuffers[vertex];
+  if (vertexBuffer->dirty && !vertexBuffer->streamed) {
+    RetainedVertices& copy = retainedVertices[vertex];
+    copy.format = vertexBuffer->format;
+    copy.vertices = vertexBuffer->vertices;
+  }
+  if (index < 0) return;
+  const auto& indexBuffer = enigma::indexBuffers[index];
+  if (indexBuffer->dirty) {
+    RetainedIndices& copy = retainedIndices[index];
+    copy.type = indexBuffer->type;
+    copy.indices = indexBuffer->indices;
+  }
+}
+
+void capture_begin() {
+  trace.out.clear();
+  trace.bytes(magic, 4);
+  trace.u8(version);
+  for (int i = 0; i < 3; ++i) trace.u8(0);
+  trace.u32(enigma::graphics_pack_vertex_color(0x030201, 1.0));
+  trace.u32(enigma_user::window_get_region_width());
+  trace.u32(enigma_user::window_get_region_height());
+
+  trace.u8(op_state);
+  trace.u8(state_initial);
+  trace.state(current_state());
+
+  capturePhase = capture_recording;
+  enigma::captureRecording = enigma::captureHooked = true;
+}
+
+void capture_end() {
+  trace.u8(op_end);
+
+  // the textures go in front of the draws that first used them
+  writer out;
+  out.out.reserve(trace.out.size());
+  size_t copied = 0;
+  for (const auto& splice : textureSplices) {
+    out.bytes(trace.out.data() + copied, splice.first - copied);
+    copied = splice.first;
+    write_texture(out, splice.second);
+  }
+  out.bytes(trace.out.data() + copied, trace.out.size() - copied);
+  // reading them back may have bound them in the backend's place
+  if (!textureSplices.empty()) enigma::draw_set_state_dirty();
+
+  FILE_t* file = fopen_wrapper(capturePath.c_str(), "wb");
+  const size_t written = file ? fwrite_wrapper(out.out.data(), 1, out.out.size(), file) : 0;
+  if (file) fclose_wrapper(file);
+  if (written != out.out.size())
+    DEBUG_MESSAGE("Could not write the frame capture to \"" + capturePath + "\"", MESSAGE_TYPE::M_ERROR);
+
+  vector<unsigned char>().swap(trace.out);
+  writtenFormats.clear(), writtenVertices.clear(), writtenIndices.clear(), usedTextures.clear();
+  textureSplices.clear();
+  capturePhase = capture_idle;
+  enigma::captureRecording = false;
+  enigma::captureHooked = retainBuffers;
+}
+
+} // anonymous namespace
+
+namespace enigma {
+
+bool captureHooked = false, captureRecording = false;
+
+void capture_record_draw(int vertex, int index, int instances, int primitive,
+                         unsigned offset, unsigned start, unsigned count) {
+  if (captureRecording) {
+    record_textures();
+    record_vertices(vertex);
+    if (index >= 0) record_indices(index);
+    if (instances >= 0) record_vertices(instances);
+
+    trace.u8(op_draw);
+    trace.u32(vertex);
+    trace.u32(index);
+    trace.u32(instances);
+    trace.u8(primitive);
+    trace.u8(batched ? draw_batched : 0);
+    trace.u32(offset / sizeof(VertexElement));
+    trace.u32(start);
+    trace.u32(count);
+  }
+  if (retainBuffers) {
+    retain(vertex, index);
+    if (instances >= 0) retain(instances, -1);
+  }
+}
+
+void capture_record_state() {
+  trace.u8(op_state);
+  trace.u8(state_flush);
+  trace.state(current_state());
+}
+
+void capture_forget_buffer(int buffer, bool index) {
+  if (index) {
+    retainedIndices.erase(buffer);
+  } else {
+    retainedVertices.erase(buffer);
+  }
+}
+
+void capture_set_batched(bool batch) {
+  batched = batch;
+}
+
+void capture_screen_refresh() {
+  if (capturePhase == capture_recording) {
+    capture_end();
+  } else if (capturePhase == capture_armed) {
+    capture_begin();
+  }
+}
+
+} // namespace enigma
+
+namespace enigma_user {
+
+bool graphics_capture_frame(std::string fname) {
+  if (capturePhase != capture_idle) return false;
+  capturePath = fname;
+  capturePhase = capture_armed;
+  return true;
+}
+
+bool graphics_capture_pending() {
+  return capturePhase != capture_idle;
+}
+
+void graphics_capture_retain_buffers(bool enable) {
+  retainBuffers = enable;
+  if (!enable) {
+    retainedVertices.clear();
+    retainedIndices.clear();
+  }
+  enigma::captureHooked = enable || enigma::captureRecording;
+}
+
+} // namespace enigma_user
@@ -0,0 +1,69 @@
+/** This file is a part of the ENIGMA Development Environment.
+***
+*** ENIGMA is free software: you can redistribute it and/or modify it under the
+*** terms of the GNU General Public License as published by the Free Software
+*** Foundation, version 3 of the license or any later version.
+***
+*** This application and its source code is distributed AS-IS, WITHOUT ANY
+*** WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+*** FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+*** details.
+***
+*** You should have received a copy of the GNU General Public License along
+*** with this code. If not, see <http://www.gnu.org/licenses/>
+**/
+
+#ifndef ENIGMA_GSCAPTURE_H
+#define ENIGMA_GSCAPTURE_H
+
+#include <string>
+
+namespace enigma {
+
+// whether draws have to be seen by the capture, either because a frame is
+// being recorded or because buffers are being kept for one
+extern bool captureHooked;
+// whether a frame is being recorded
+extern bool captureRecording;
+
+void capture_record_draw(int vertex, int index, int instances, int primitive,
+                         unsigned offset, unsigned start, unsigned count);
+void capture_record_state();
+void capture_forget_buffer(int buffer, bool index);
+
+// Backends call these at the start of every draw, after flushing the state
+// but before uploading the buffers, which is the last time their contents
+// are sure to be in memory.
+inline void capture_draw(int buffer, int primitive, unsigned offset, unsigned start, unsigned count) {
+  if (captureHooked) capture_record_draw(buffer, -1, -1, primitive, offset, start, count);
+}
+inline void capture_draw_indexed(int buffer, int vertex, int primitive, unsigned start, unsigned count) {
+  if (captureHooked) capture_record_draw(vertex, buffer, -1, primitive, 0, start, count);
+}
+inline void capture_draw_instanced(int buffer, int primitive, unsigned offset, unsigned start, unsigned count,
+                                   int instances) {
+  if (captureHooked) capture_record_draw(buffer, -1, instances, primitive, offset, start, count);
+}
+
+// marks the draws until the next call as a batch flush
+void capture_set_batched(bool batched);
+// starts a frame that was asked for or ends the one being recorded
+void capture_screen_refresh();
+
+} // namespace enigma
+
+namespace enigma_user {
+
+// Records every draw of the next whole frame, with the state it was drawn in
+// and the vertices, indices and textures it used, into a trace for gfxreplay.
+// Buffers uploaded before the capture are only in memory if they were kept
+// with graphics_capture_retain_buffers, or they are recorded as missing.
+// Returns false if a capture is already under way.
+bool graphics_capture_frame(std::string fname);
+bool graphics_capture_pending();
+// keeps a copy of every buffer that isn't streamed when it's uploaded
+void graphics_capture_retain_buffers(bool enable);
+
+} // namespace enigma_user
+
+#endif // ENIGMA_GSCAPTURE_H
@@ -0,0 +1,129 @@
+/** This file is a part of the ENIGMA Development Environment.
+***
+*** ENIGMA is free software: you can redistribute it and/or modify it under the
+*** terms of the GNU General Public License as published by the Free Software
+*** Foundation, version 3 of the license or any later version.
+***
+*** This application and its source code is distributed AS-IS, WITHOUT ANY
+*** WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+*** FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+*** details.
+***
+*** You should have received a copy of the GNU General Public License along
+*** with this code. If not, see <http://www.gnu.org/licenses/>
+**/
+
+// The layout of the frame traces written by graphics_capture_frame, which is
+// shared with the gfxreplay tool and so must not include anything of the
+// engine's.
+//
+// A trace is a header followed by records, each an op byte and its fields,
+// all little endian. The header is the magic, the version, three reserved
+// bytes, the capturing backend's packing of the color 0x030201 at full alpha
+// and the size of the window region.
+//
+//   op_format   u32 id, u32 attributes, then u16 type and u16 usage each
+//   op_texture  u32 id, u32 width, height, fullwidth, fullheight, u32 bytes,
+//               then the pixels as BGRA if the backend could read them back
+//   op_vertices u32 buffer, u32 format, u32 elements, u8 available, then the
+//               elements as floats or packed colors if they were available
+//   op_indices  u32 buffer, u8 type, u32 indices, u8 available, then the
+//               indices widened to u32 if they were available
+//   op_state    u8 reason, then every word of State in order
+//   op_draw     u32 vertex buffer, u32 index buffer, u32 instance buffer,
+//               u8 primitive, u8 flags, u32 offset in elements, start, count
+//   op_end      nothing, and the trace ends
+//
+// Ids that don't apply are written as -1. Contents are written before the
+// draw that uses them and again whenever they have changed since.
+
+#ifndef ENIGMA_GSCAPTURE_FORMAT_H
+#define ENIGMA_GSCAPTURE_FORMAT_H
+
+#include "GSbinary_io.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace enigma {
+namespace capture_format {
+
+const unsigned char magic[4] = {'E', 'G', 'F', 'X'};
+const unsigned char version = 1;
+const size_t header_size = 20;
+
+enum {
+  op_end,
+  op_format,
+  op_texture,
+  op_vertices,
+  op_indices,
+  op_state,
+  op_draw
+};
+
+enum {
+  state_initial, // the state when the capture began
+  state_flush    // the backend applied the state before a draw
+};
+
+enum {
+  draw_batched = 1 // the draw was a batch of primitives or sprites
+};
+
+enum {
+  sampler_wrapu = 1,
+  sampler_wrapv = 2,
+  sampler_wrapw = 4,
+  sampler_interpolate = 8
+};
+
+// everything the backend applies when it flushes the state, as 32-bit words
+// so it can be compared and written as a whole
+struct State {
+  int32_t textures[8];
+  uint32_t samplers[8];
+  int32_t blend_src, blend_dest;
+  uint32_t alpha_blend, alpha_test, alpha_ref;
+  uint32_t depth_test, depth_write;
+  int32_t depth_func, culling, fill_mode;
+  float point_size, line_width;
+  uint32_t color_write; // red, green, blue and alpha from the lowest bit
+  uint32_t lighting, fog, stencil_test;
+  float world[16], view[16], projection[16]; // column-major like glm
+
+  static const size_t words = 32 + 48;
+
+  bool operator==(const State& other) const { return !memcmp(this, &other, sizeof(State)); }
+  bool operator!=(const State& other) const { return !(*this == other); }
+};
+
+static_assert(sizeof(State) == State::words * 4, "capture state must be tightly packed words");
+
+class writer : public binary_io::writer {
+ public:
+  void state(const State& s) {
+    uint32_t words[State::words];
+    memcpy(words, &s, sizeof(words));
+    for (uint32_t word : words) u32(word);
+  }
+};
+
+class reader : public binary_io::reader {
+ public:
+  using binary_io::reader::reader;
+
+  State state() {
+    uint32_t words[State::words];
+    for (uint32_t& word : words) word = u32();
+    State s;
+    memcpy(&s, words, sizeof(words));
+    return s;
+  }
+};
+
+} // namespace capture_format
+} // namespace enigma
+
+#endif // ENIGMA_GSCAPTURE_FORMAT_H
@@ -19,6 +19,7 @@
 #include "GSd3d.h"
 #include "GSstdraw.h"
 #include "GSmatrix.h"
+#include "GSmatrix_impl.h"
 #include "GSprimitives.h"
 #include "GScolors.h"
 #include "GScolor_macros.h"
@@ -32,6 +33,50 @@ namespace {
 std::unordered_map<int,enigma::Light> d3dLights;
 std::vector<int> d3dLightsEnabled;
 
+unsigned cullCulled = 0, cullVisible = 0;
+
+// the clip planes are only extracted again when the matrices change
+glm::mat4 frustumWorld, frustumView, frustumProjection;
+glm::vec4 frustumPlanes[6];
+bool frustumExtracted = false;
+
+const glm::vec4* frustum_planes() {
+  using enigma::world;
+  using enigma::view;
+  using enigma::projection;
+
+  if (frustumExtracted && world == frustumWorld && view == frustumView && projection == frustumProjection)
+    return frustumPlanes;
+  frustumWorld = world, frustumView = view, frustumProjection = projection;
+  frustumExtracted = true;
+
+  // a point is inside when -w <= x, y, z <= w after the transform, so each
+  // plane is the last row of the matrix plus or minus one of the others
+  const glm::mat4 mvp = projection * view * world;
+  glm::vec4 rows[4];
+  for (int i = 0; i < 4; ++i)
+    rows[i] = glm::vec4(mvp[0][i], mvp[1][i], mvp[2][i], mvp[3][i]);
+  for (int i = 0; i < 3; ++i) {
+    frustumPlanes[i * 2] = rows[3] + rows[i];
+    frustumPlanes[i * 2 + 1] = rows[3] - rows[i];
+  }
+  return frustumPlanes;
+}
+
+bool frustum_outside_box(gs_scalar x1, gs_scalar y1, gs_scalar z1, gs_scalar x2, gs_scalar y2, gs_scalar z2) {
+  if (x1 > x2) std::swap(x1, x2);
+  if (y1 > y2) std::swap(y1, y2);
+  if (z1 > z2) std::swap(z1, z2);
+  const glm::vec4* planes = frustum_planes();
+  for (int i = 0; i < 6; ++i) {
+    // the corner furthest along the plane's normal is the last to leave it
+    const glm::vec4& p = planes[i];
+    if (p.x * (p.x > 0 ? x2 : x1) + p.y * (p.y > 0 ? y2 : y1) + p.z * (p.z > 0 ? z2 : z1) + p.w < 0)
+      return true;
+  }
+  return false;
+}
+
 } // namespace anonymous
 
 namespace enigma {
@@ -59,6 +104,14 @@ int d3dStencilFunc = enigma_user::rs_always, d3dStencilFuncRef = 0, d3dStencilFu
     d3dStencilOpStencilFail = enigma_user::rs_keep, d3dStencilOpDepthFail = enigma_user::rs_keep,
     d3dStencilOpPass = enigma_user::rs_keep;
 
+bool d3dFrustumCulling = false, d3dInstanceCulling = false;
+
+bool frustum_cull_box(gs_scalar x1, gs_scalar y1, gs_scalar z1, gs_scalar x2, gs_scalar y2, gs_scalar z2) {
+  const bool culled = frustum_outside_box(x1, y1, z1, x2, y2, z2);
+  ++(culled ? cullCulled : cullVisible);
+  return culled;
+}
+
 } // namespace enigma
 
 namespace enigma_user {
@@ -299,4 +352,17 @@ int d3d_get_culling() { return enigma::d3dCulling; }
 bool d3d_get_lighting() { return enigma::d3dLighting; }
 bool d3d_get_shading() { return enigma::d3dShading; }
 
+void d3d_set_frustum_culling(bool enable) { enigma::d3dFrustumCulling = enable; }
+bool d3d_get_frustum_culling() { return enigma::d3dFrustumCulling; }
+void d3d_set_instance_culling(bool enable) { enigma::d3dInstanceCulling = enable; }
+bool d3d_get_instance_culling() { return enigma::d3dInstanceCulling; }
+
+bool d3d_frustum_test_box(gs_scalar x1, gs_scalar y1, gs_scalar z1, gs_scalar x2, gs_scalar y2, gs_scalar z2) {
+  return !frustum_outside_box(x1, y1, z1, x2, y2, z2);
+}
+
+unsigned d3d_cull_get_culled_count() { return cullCulled; }
+unsigned d3d_cull_get_visible_count() { return cullVisible; }
+void d3d_cull_reset_stats() { cullCulled = cullVisible = 0; }
+
 } // namespace enigma_user
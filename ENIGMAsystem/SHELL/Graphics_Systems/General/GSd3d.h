@@ -44,6 +44,13 @@ struct Light {
 extern int d3dLightsActive, d3dLightingAmbient;
 const Light& get_active_light(int id);
 
+extern bool d3dFrustumCulling, d3dInstanceCulling;
+
+// whether an axis aligned box in model space would be drawn entirely outside
+// the clip volume of the current world, view and projection, which is then
+// counted as culled or visible
+bool frustum_cull_box(gs_scalar x1, gs_scalar y1, gs_scalar z1, gs_scalar x2, gs_scalar y2, gs_scalar z2);
+
 extern bool d3dStencilTest;
 extern unsigned int d3dStencilMask;
 extern int d3dStencilFunc, d3dStencilFuncRef, d3dStencilFuncMask,
@@ -121,6 +128,20 @@ namespace enigma_user {
   int d3d_get_culling();
   bool d3d_get_hidden();
 
+  // Frustum culling skips draws that would land entirely outside the current
+  // view. Frustum culling tests models with their bounds and instance culling
+  // tests the default draw event of instances with a sprite. Both are off by
+  // default, since a shader may move vertices outside the tested bounds.
+  void d3d_set_frustum_culling(bool enable);
+  bool d3d_get_frustum_culling();
+  void d3d_set_instance_culling(bool enable);
+  bool d3d_get_instance_culling();
+  // whether any part of the box may be visible, without counting it
+  bool d3d_frustum_test_box(gs_scalar x1, gs_scalar y1, gs_scalar z1, gs_scalar x2, gs_scalar y2, gs_scalar z2);
+  unsigned d3d_cull_get_culled_count();
+  unsigned d3d_cull_get_visible_count();
+  void d3d_cull_reset_stats();
+
   // Fog
   void d3d_set_fog(bool enable, int color, double start, double end);
   void d3d_set_fog_enabled(bool enable);
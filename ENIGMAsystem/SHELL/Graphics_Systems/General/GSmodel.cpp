@@ -26,8 +26,10 @@
 #include "GScolors.h"
 #include "GSmatrix.h"
 #include "GSmatrix_impl.h"
+#include "GSd3d.h"
 #include "GSstdraw.h"
 #include "GStextures.h"
+#include "GSbinary_io.h"
 
 #include "Widget_Systems/widgets_mandatory.h"
 #include "Platforms/General/fileio.h"
@@ -35,6 +37,8 @@
 #include <glm/gtc/matrix_transform.hpp>
 
 #include <algorithm> // min/max
+#include <cstring>
+#include <unordered_map>
 #include <math.h>
 
 using namespace std;
@@ -142,6 +146,527 @@ void string_parse(string *s) {
   }
 }
 
+// finds the box around the positions of every primitive while the vertices
+// are still in memory, before the buffer is uploaded
+static void model_find_bounds(Model& model) {
+  using namespace enigma_user;
+
+  model.bounded = false;
+  const std::vector<VertexElement>& vertices = vertexBuffers[model.vertex_buffer]->vertices;
+  for (const Primitive& primitive : model.primitives) {
+    if (!vertex_format_exists(primitive.format)) continue;
+    const VertexFormat& format = *vertexFormats[primitive.format];
+
+    size_t position = 0, size = 0, offset = 0;
+    for (const auto& flag : format.flags) {
+      if (flag.second == vertex_usage_position && flag.first <= vertex_type_float4) {
+        position = offset, size = flag.first - vertex_type_float1 + 1;
+        break;
+      }
+      offset += (flag.first <= vertex_type_float4) ? flag.first - vertex_type_float1 + 1 : 1;
+    }
+    if (!size) continue;
+
+    const size_t first = primitive.vertex_offset / sizeof(VertexElement);
+    for (size_t v = 0; v < primitive.vertex_count; ++v) {
+      const size_t element = first + v * format.stride + position;
+      if (element + size > vertices.size()) break;
+      for (size_t i = 0; i < 3; ++i) {
+        const gs_scalar coord = (i < size) ? vertices[element + i].f : 0;
+        if (!model.bounded || coord < model.bounds_min[i]) model.bounds_min[i] = coord;
+        if (!model.bounded || coord > model.bounds_max[i]) model.bounds_max[i] = coord;
+      }
+      model.bounded = true;
+    }
+  }
+}
+
+// reorders triangles so that their vertices are still in the post-transform
+// cache when they are used again, which is Tom Forsyth's linear-speed vertex
+// cache optimisation: every vertex is scored by how recently it was used and
+// how few triangles still need it, and the best triangle among those of the
+// cached vertices is drawn next
+static void optimize_vertex_cache(vector<uint32_t>& indices, size_t vertex_count) {
+  const int cache_size = 32;
+  const size_t triangle_count = indices.size() / 3;
+  if (triangle_count < 2) return;
+
+  // the triangles of each vertex, with the ones already drawn swapped out of
+  // the front of its range until its remaining count reaches zero
+  vector<uint32_t> remaining(vertex_count, 0), first(vertex_count + 1, 0);
+  for (uint32_t index : indices) ++remaining[index];
+  for (size_t v = 0; v < vertex_count; ++v) first[v + 1] = first[v] + remaining[v];
+  vector<uint32_t> adjacency(indices.size()), filled(vertex_count, 0);
+  for (size_t t = 0; t < triangle_count; ++t)
+    for (int c = 0; c < 3; ++c) {
+      const uint32_t v = indices[t * 3 + c];
+      adjacency[first[v] + filled[v]++] = t;
+    }
+
+  vector<int> position(vertex_count, -1);
+  vector<float> vertex_score(vertex_count), triangle_score(triangle_count, 0);
+  vector<bool> drawn(triangle_count, false);
+  auto score = [&](uint32_t v) -> float {
+    if (!remaining[v]) return -1;
+    float cached = 0;
+    if (position[v] >= 0) {
+      cached = (position[v] < 3) ? 0.75f : pow(1 - float(position[v] - 3) / (cache_size - 3), 1.5f);
+    }
+    return cached + 2 / sqrt(float(remaining[v]));
+  };
+  for (size_t v = 0; v < vertex_count; ++v) vertex_score[v] = score(v);
+  for (size_t t = 0; t < triangle_count; ++t)
+    for (int c = 0; c < 3; ++c) triangle_score[t] += vertex_score[indices[t * 3 + c]];
+
+  vector<uint32_t> cache, next_cache, output;
+  output.reserve(indices.size());
+  size_t best = std::max_element(triangle_score.begin(), triangle_score.end()) - triangle_score.begin();
+  size_t cursor = 0; // every triangle before it has been drawn
+  for (size_t drawn_count = 0; drawn_count < triangle_count; ++drawn_count) {
+    if (best >= triangle_count) {
+      // nothing cached has triangles left, so carry on from the first
+      // triangle that hasn't been drawn yet
+      while (drawn[cursor]) ++cursor;
+      best = cursor;
+    }
+    drawn[best] = true;
+    const uint32_t* triangle = &indices[best * 3];
+    output.insert(output.end(), triangle, triangle + 3);
+
+    // the triangle's vertices move to the front of the cache and lose it
+    next_cache.assign(triangle, triangle + 3);
+    for (int c = 0; c < 3; ++c) {
+      const uint32_t v = triangle[c];
+      uint32_t* begin = &adjacency[first[v]];
+      *std::find(begin, begin + remaining[v], uint32_t(best)) = begin[remaining[v] - 1];
+      --remaining[v];
+    }
+    for (uint32_t v : cache)
+      if (v != triangle[0] && v != triangle[1] && v != triangle[2]) next_cache.push_back(v);
+    for (size_t i = 0; i < next_cache.size(); ++i)
+      position[next_cache[i]] = (i < size_t(cache_size)) ? int(i) : -1;
+
+    // rescore what the cache touched and pick the best triangle among them
+    float best_score = -1;
+    best = triangle_count;
+    for (uint32_t v : next_cache) {
+      const float updated = score(v);
+      const float delta = updated - vertex_score[v];
+      vertex_score[v] = updated;
+      for (uint32_t i = first[v]; i < first[v] + remaining[v]; ++i) {
+        const uint32_t t = adjacency[i];
+        triangle_score[t] += delta;
+        if (triangle_score[t] > best_score) best_score = triangle_score[t], best = t;
+      }
+    }
+    if (next_cache.size() > size_t(cache_size)) next_cache.resize(cache_size);
+    cache.swap(next_cache);
+  }
+  indices.swap(output);
+}
+
+// welds the identical vertices of a model whose primitives are all triangles
+// of one format into an indexed triangle list ordered for the vertex cache,
+// with the vertices in the order it first uses them; returns false and
+// leaves the model alone if it can't
+static bool model_optimize(Model& model) {
+  using namespace enigma_user;
+
+  if (model.index_buffer != -1 || model.primitives.empty()) return false;
+  const int format = model.primitives[0].format;
+  for (const Primitive& primitive : model.primitives) {
+    if (primitive.format != format) return false;
+    if (primitive.type != pr_trianglelist && primitive.type != pr_trianglestrip && primitive.type != pr_trianglefan)
+      return false;
+  }
+  if (!vertex_format_exists(format)) return false;
+  const size_t stride = vertexFormats[format]->stride;
+  const size_t stride_bytes = stride * sizeof(VertexElement);
+
+  auto& vertexBuffer = vertexBuffers[model.vertex_buffer];
+  const vector<VertexElement>& vertices = vertexBuffer->vertices;
+
+  auto hash = [stride_bytes](const VertexElement* vertex) {
+    // FNV-1a over the bytes of the whole vertex
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(vertex);
+    size_t h = size_t(14695981039346656037ULL);
+    for (size_t i = 0; i < stride_bytes; ++i) h = (h ^ bytes[i]) * size_t(1099511628211ULL);
+    return h;
+  };
+  auto equal = [stride_bytes](const VertexElement* a, const VertexElement* b) {
+    return !memcmp(a, b, stride_bytes);
+  };
+  std::unordered_map<const VertexElement*, uint32_t, decltype(hash), decltype(equal)>
+    welded(vertices.size() / stride, hash, equal);
+  vector<const VertexElement*> unique;
+  vector<uint32_t> indices, ids;
+  auto triangle = [&](uint32_t a, uint32_t b, uint32_t c) {
+    // degenerates, like the ones joining strips, are left out altogether
+    if (a == b || b == c || a == c) return;
+    indices.push_back(a), indices.push_back(b), indices.push_back(c);
+  };
+
+  for (const Primitive& primitive : model.primitives) {
+    const size_t first = primitive.vertex_offset / sizeof(VertexElement);
+    if (first + primitive.vertex_count * stride > vertices.size()) return false;
+    ids.clear();
+    for (size_t v = 0; v < primitive.vertex_count; ++v) {
+      const VertexElement* vertex = &vertices[first + v * stride];
+      auto inserted = welded.emplace(vertex, unique.size());
+      if (inserted.second) unique.push_back(vertex);
+      ids.push_back(inserted.first->second);
+    }
+    for (size_t i = 0; i + 2 < ids.size(); ) {
+      if (primitive.type == pr_trianglelist) {
+        triangle(ids[i], ids[i + 1], ids[i + 2]);
+        i += 3;
+      } else if (primitive.type == pr_trianglestrip) {
+        // every other triangle of a strip is wound the other way around
+        if (i % 2) triangle(ids[i + 1], ids[i], ids[i + 2]); else triangle(ids[i], ids[i + 1], ids[i + 2]);
+        ++i;
+      } else {
+        triangle(ids[0], ids[i + 1], ids[i + 2]);
+        ++i;
+      }
+    }
+  }
+  if (indices.empty()) return false;
+
+  optimize_vertex_cache(indices, unique.size());
+
+  // lay the vertices out in the order they are first used
+  vector<uint32_t> remap(unique.size(), uint32_t(-1));
+  vector<VertexElement> ordered;
+  ordered.reserve(unique.size() * stride);
+  uint32_t next = 0;
+  for (uint32_t& index : indices) {
+    if (remap[index] == uint32_t(-1)) {
+      remap[index] = next++;
+      ordered.insert(ordered.end(), unique[index], unique[index] + stride);
+    }
+    index = remap[index];
+  }
+  vertexBuffer->vertices.swap(ordered);
+  vertexBuffer->number = vertexBuffer->vertices.size();
+
+  // 16-bit indices whenever they can reach every vertex
+  const bool wide = next > 0x10000;
+  model.index_buffer = index_create_buffer();
+  index_begin(model.index_buffer, wide ? index_type_uint : index_type_ushort);
+  vector<uint16_t>& out = indexBuffers[model.index_buffer]->indices;
+  out.reserve(indices.size() * (wide ? 2 : 1));
+  for (uint32_t index : indices) {
+    out.push_back(index & 0xFFFF);
+    if (wide) out.push_back(index >> 16);
+  }
+  index_end(model.index_buffer);
+
+  Primitive list(pr_trianglelist, format, true, 0);
+  list.vertex_count = indices.size();
+  model.primitives.assign(1, list);
+  return true;
+}
+
+// ends the model's vertex buffer and freezes it as the model's type asks
+static void model_freeze(Model& model) {
+  using namespace enigma_user;
+
+  vertex_end(model.vertex_buffer);
+  if (model.index_buffer != -1) index_end(model.index_buffer);
+
+  // freeze the model if it's static to indicate to the driver that
+  // we don't intend on updating this sucker so it will draw faster
+  if (model.type == model_static) {
+    vertex_freeze(model.vertex_buffer, false);
+    if (model.index_buffer != -1) index_freeze(model.index_buffer, false);
+  } else if (model.type == model_dynamic) {
+    vertex_freeze(model.vertex_buffer, true);
+    if (model.index_buffer != -1) index_freeze(model.index_buffer, true);
+  }
+  // model_stream type is never frozen because it means the user
+  // will be updating and specifying new primitives every frame
+}
+
+bool modelAutoOptimize = false;
+
+// finishes specifying the model's vertices if it was being specified, which
+// optimizes static models when that's been enabled and the model is going to
+// be drawn without instances
+static void model_end(Model& model, bool optimize = true) {
+  using namespace enigma_user;
+
+  if (!model.vertex_started) return;
+  model.vertex_started = false;
+  // stream models change every frame, including the primitive batch, so
+  // they aren't worth finding the bounds of and are never culled
+  if (model.type != model_stream) model_find_bounds(model);
+  if (optimize && modelAutoOptimize && model.type == model_static) model_optimize(model);
+  model_freeze(model);
+}
+
+// drops the index buffer of an optimized model
+static void model_unindex(Model& model) {
+  if (model.index_buffer == -1) return;
+  enigma_user::index_delete_buffer(model.index_buffer);
+  model.index_buffer = -1;
+}
+
+// Binary models keep the vertices the way they are drawn, so loading one is
+// a single copy out of the mapped file. Integers are little endian and every
+// vertex element is 4 bytes:
+//
+//   "EMDL"  u8 version  u8 type  u8 flags  u8 index size
+//   u32 color layout  u32 formats  u32 primitives  u32 elements  u32 indices
+//   f32 bounds min[3]  f32 bounds max[3]
+//   formats:     u32 attributes, then u16 type  u16 usage for each
+//   primitives:  u32 type  u32 format  u32 first element  u32 vertex count
+//   elements:    floats as IEEE singles, colors packed by the saving backend
+//   indices:     u16 or u32 each, as the index size in bytes says
+//
+// Optimized models are indexed, and their primitives give the first index
+// and the index count instead. Version 1 had neither indices nor their count.
+//
+// The color layout is the saving backend's packing of the color 0x030201 at
+// full alpha, which tells the loader how to reorder the bytes of colors when
+// its own backend packs them differently.
+namespace model_binary {
+
+const unsigned char magic[4] = {'E', 'M', 'D', 'L'};
+const unsigned char version = 2;
+const unsigned char flag_bounded = 1;
+const size_t header_size = 52;
+
+// vertices read with one format from one element on
+struct Run {
+  int format;
+  size_t element, count;
+};
+
+// the vertices the primitives read, which is every vertex of an indexed
+// model since all of its primitives share one format
+vector<Run> runs(const vector<Primitive>& primitives, bool indexed, size_t element_count) {
+  vector<Run> result;
+  if (indexed) {
+    if (!primitives.empty())
+      result.push_back({primitives[0].format, 0, element_count / vertexFormats[primitives[0].format]->stride});
+    return result;
+  }
+  for (const Primitive& primitive : primitives)
+    result.push_back({primitive.format, primitive.vertex_offset / sizeof(VertexElement), primitive.vertex_count});
+  return result;
+}
+
+color_t color_layout() {
+  return graphics_pack_vertex_color(0x030201, 1.0);
+}
+
+using binary_io::writer;
+using binary_io::reader;
+
+bool write(const Model& model, writer& w) {
+  const vector<VertexElement>& vertices = vertexBuffers[model.vertex_buffer]->vertices;
+  const bool indexed = model.index_buffer != -1;
+  const bool wide = indexed && indexBuffers[model.index_buffer]->type == enigma_user::index_type_uint;
+  const vector<uint16_t> no_indices;
+  const vector<uint16_t>& indices = indexed ? indexBuffers[model.index_buffer]->indices : no_indices;
+
+  // formats are written once each, in the order primitives first use them
+  vector<int> formats;
+  for (const Primitive& primitive : model.primitives) {
+    if (!enigma_user::vertex_format_exists(primitive.format)) return false;
+    if (std::find(formats.begin(), formats.end(), primitive.format) == formats.end())
+      formats.push_back(primitive.format);
+  }
+
+  w.bytes(magic, 4);
+  w.u8(version);
+  w.u8(model.type);
+  w.u8(model.bounded ? flag_bounded : 0);
+  w.u8(indexed ? (wide ? 4 : 2) : 0);
+  w.u32(color_layout());
+  w.u32(formats.size());
+  w.u32(model.primitives.size());
+  w.u32(vertices.size());
+  w.u32(wide ? indices.size() / 2 : indices.size());
+  for (int i = 0; i < 3; ++i) w.f32(model.bounds_min[i]);
+  for (int i = 0; i < 3; ++i) w.f32(model.bounds_max[i]);
+
+  for (int format : formats) {
+    const auto& flags = vertexFormats[format]->flags;
+    w.u32(flags.size());
+    for (const auto& flag : flags) {
+      w.u16(flag.first);
+      w.u16(flag.second);
+    }
+  }
+  for (const Primitive& primitive : model.primitives) {
+    w.u32(primitive.type);
+    w.u32(std::find(formats.begin(), formats.end(), primitive.format) - formats.begin());
+    w.u32(indexed ? primitive.vertex_offset : primitive.vertex_offset / sizeof(VertexElement));
+    w.u32(primitive.vertex_count);
+  }
+
+  if (sizeof(VertexElement) == 4) {
+    w.bytes(vertices.data(), vertices.size() * 4);
+  } else {
+    // a double precision build has to narrow the floats, which means
+    // walking the formats to tell them apart from colors
+    vector<bool> colors(vertices.size(), false);
+    for (const Run& run : runs(model.primitives, indexed, vertices.size())) {
+      const VertexFormat& format = *vertexFormats[run.format];
+      size_t element = run.element;
+      for (size_t v = 0; v < run.count; ++v) {
+        for (const auto& flag : format.flags) {
+          if (flag.first > enigma_user::vertex_type_float4 && element < colors.size()) colors[element] = true;
+          element += (flag.first <= enigma_user::vertex_type_float4) ? flag.first - enigma_user::vertex_type_float1 + 1 : 1;
+        }
+      }
+    }
+    for (size_t i = 0; i < vertices.size(); ++i) {
+      if (colors[i]) {
+        w.u32(vertices[i].d);
+      } else {
+        w.f32(vertices[i].f);
+      }
+    }
+  }
+
+  // the low half of a 32-bit index comes first, so both sizes are written
+  // as they are stored
+  for (uint16_t index : indices) w.u16(index);
+  return true;
+}
+
+bool read(Model& model, reader& r) {
+  using namespace enigma_user;
+
+  if (!r.has(header_size - 4) || memcmp(r.take(4), magic, 4)) return false;
+  const unsigned char file_version = r.u8();
+  if (file_version > version || (file_version > 1 && !r.has(header_size - 5))) return false;
+  r.u8(); // the type is the one the model was created with, not the saved one
+  const bool bounded = r.u8() & flag_bounded;
+  const unsigned char index_size = r.u8();
+  const uint32_t layout = r.u32(), format_count = r.u32(), primitive_count = r.u32(), element_count = r.u32();
+  const uint32_t index_count = (file_version > 1) ? r.u32() : 0;
+  const bool indexed = index_size != 0;
+  if (indexed && (file_version < 2 || (index_size != 2 && index_size != 4))) return false;
+  float bounds[6];
+  for (float& bound : bounds) bound = r.f32();
+
+  vector<int> formats;
+  for (uint32_t i = 0; i < format_count; ++i) {
+    if (!r.has(4)) return false;
+    const uint32_t attributes = r.u32();
+    if (!attributes || !r.has(size_t(attributes) * 4)) return false;
+    // every attribute is checked before the format is begun, so a bad one
+    // can't leave a half specified format behind
+    vector<std::pair<int, int> > flags(attributes);
+    for (auto& flag : flags) {
+      flag.first = r.u16(), flag.second = r.u16();
+      if (flag.first > vertex_type_ubyte4 || flag.second > vertex_usage_sample) return false;
+    }
+    vertex_format_begin();
+    for (const auto& flag : flags) vertex_format_add_custom(flag.first, flag.second);
+    formats.push_back(vertex_format_end());
+  }
+
+  if (!r.has(size_t(primitive_count) * 16)) return false;
+  vector<Primitive> primitives;
+  primitives.reserve(primitive_count);
+  for (uint32_t i = 0; i < primitive_count; ++i) {
+    const int type = r.u32();
+    const uint32_t format = r.u32(), first = r.u32(), count = r.u32();
+    if (format >= formats.size()) return false;
+    if (indexed) {
+      // we only ever index models whose primitives share one format
+      if (formats[format] != formats[0] || first > index_count || index_count - first < count) return false;
+      primitives.emplace_back(type, formats[format], true, first);
+    } else {
+      const size_t stride = vertexFormats[formats[format]]->stride;
+      if (first > element_count || (element_count - first) / stride < count) return false;
+      primitives.emplace_back(type, formats[format], true, first * sizeof(VertexElement));
+    }
+    primitives.back().vertex_count = count;
+  }
+
+  if (!r.has(size_t(element_count) * 4)) return false;
+  const unsigned char* elements = r.take(size_t(element_count) * 4);
+
+  // every index has to land on a vertex, since nothing checks them once
+  // they are drawn
+  vector<uint16_t> indices;
+  if (indexed) {
+    if (!r.has(size_t(index_count) * index_size)) return false;
+    const size_t vertex_count = primitives.empty() ? 0 : element_count / vertexFormats[formats[0]]->stride;
+    indices.reserve(size_t(index_count) * index_size / 2);
+    for (uint32_t i = 0; i < index_count; ++i) {
+      const uint32_t index = (index_size == 4) ? r.u32() : r.u16();
+      if (index >= vertex_count) return false;
+      indices.push_back(index & 0xFFFF);
+      if (index_size == 4) indices.push_back(index >> 16);
+    }
+  }
+  vector<VertexElement>& vertices = vertexBuffers[model.vertex_buffer]->vertices;
+  if (sizeof(VertexElement) == 4) {
+    const VertexElement* first = reinterpret_cast<const VertexElement*>(elements);
+    vertices.assign(first, first + element_count);
+  } else {
+    reader e(elements, size_t(element_count) * 4);
+    vertices.clear();
+    vertices.reserve(element_count);
+    for (uint32_t i = 0; i < element_count; ++i)
+      vertices.push_back(gs_scalar(e.f32()));
+  }
+
+  // colors only have to be touched when the backends pack them differently,
+  // or when they were widened as floats above
+  int order[4];
+  const bool swizzle = color_swizzle(layout, color_layout(), order);
+  if (swizzle || sizeof(VertexElement) != 4) {
+    for (const Run& run : runs(primitives, indexed, element_count)) {
+      const VertexFormat& format = *vertexFormats[run.format];
+      size_t element = run.element;
+      for (size_t v = 0; v < run.count; ++v) {
+        for (const auto& flag : format.flags) {
+          if (flag.first == vertex_type_color) {
+            uint32_t packed;
+            memcpy(&packed, elements + element * 4, 4);
+            vertices[element].d = swizzle ? color_swizzled(packed, order) : packed;
+          } else if (flag.first == vertex_type_ubyte4 && sizeof(VertexElement) != 4) {
+            uint32_t packed;
+            memcpy(&packed, elements + element * 4, 4);
+            vertices[element].d = packed;
+          }
+          element += (flag.first <= vertex_type_float4) ? flag.first - vertex_type_float1 + 1 : 1;
+        }
+      }
+    }
+  }
+
+  if (indexed) {
+    model.index_buffer = enigma_user::index_create_buffer();
+    enigma_user::index_begin(model.index_buffer, index_size == 4 ? index_type_uint : index_type_ushort);
+    indexBuffers[model.index_buffer]->indices.swap(indices);
+  }
+  model.primitives.swap(primitives);
+  model.bounded = bounded;
+  std::copy(bounds, bounds + 3, model.bounds_min);
+  std::copy(bounds + 3, bounds + 6, model.bounds_max);
+  return true;
+}
+
+// whether the file starts like a binary model
+bool detect(const string& fname) {
+  FILE_t* file = fopen_wrapper(fname.c_str(), "rb");
+  if (!file) return false;
+  unsigned char head[4] = {};
+  const bool binary = fread_wrapper(head, 1, 4, file) == 4 && !memcmp(head, magic, 4);
+  fclose_wrapper(file);
+  return binary;
+}
+
+} // namespace model_binary
+
 } // namespace enigma
 
 namespace enigma_user {
@@ -155,6 +680,7 @@ int d3d_model_create(int type, bool use_draw_color) {
 void d3d_model_destroy(int id) {
   enigma::Model& model = enigma::models.get(id);
   vertex_delete_buffer(model.vertex_buffer);
+  enigma::model_unindex(model);
 
   model.destroy();
 }
@@ -166,29 +692,30 @@ bool d3d_model_exists(int id) {
 void d3d_model_clear(int id) {
   enigma::Model& model = enigma::models.get(id);
   vertex_clear(model.vertex_buffer);
+  enigma::model_unindex(model);
   model.primitives.clear();
   model.vertex_started = false;
   model.vertex_colored = true;
+  model.bounded = false;
 }
 
 void d3d_model_draw(int id) {
   enigma::Model& model = enigma::models.get(id);
-  if (model.vertex_started) {
-    model.vertex_started = false;
-    vertex_end(model.vertex_buffer);
-
-    // freeze the model if it's static to indicate to the driver that
-    // we don't intend on updating this sucker so it will draw faster
-    if (model.type == model_static) {
-      vertex_freeze(model.vertex_buffer, false);
-    } else if (model.type == model_dynamic) {
-      vertex_freeze(model.vertex_buffer, true);
-    }
-    // model_stream type is never frozen because it means the user
-    // will be updating and specifying new primitives every frame
+  enigma::model_end(model);
+  if (enigma::d3dFrustumCulling && model.bounded &&
+      enigma::frustum_cull_box(model.bounds_min[0], model.bounds_min[1], model.bounds_min[2],
+                               model.bounds_max[0], model.bounds_max[1], model.bounds_max[2])) {
+    return;
   }
   for (auto primitive : model.primitives) {
     vertex_set_format(model.vertex_buffer, primitive.format);
+    if (model.index_buffer != -1) {
+      index_submit_range(
+        model.index_buffer, model.vertex_buffer, primitive.type,
+        primitive.vertex_offset, primitive.vertex_count
+      );
+      continue;
+    }
     vertex_submit_offset(
       model.vertex_buffer, primitive.type,
       primitive.vertex_offset, 0, primitive.vertex_count
@@ -221,11 +748,42 @@ void d3d_model_draw(int id, gs_scalar x, gs_scalar y, gs_scalar z, int texId) {
   d3d_model_draw(id, x, y, z);
 }
 
+bool d3d_model_draw_instanced(int id, int instances) {
+  enigma::Model& model = enigma::models.get(id);
+  // instances are submitted without indices, so the model has to stay as
+  // it was specified
+  enigma::model_end(model, false);
+  if (model.index_buffer != -1) {
+    DEBUG_MESSAGE("Model " + std::to_string(id) + " was optimized and can't be drawn instanced",
+                  MESSAGE_TYPE::M_USER_ERROR);
+    return false;
+  }
+  for (auto primitive : model.primitives) {
+    vertex_set_format(model.vertex_buffer, primitive.format);
+    vertex_submit_instanced_offset(
+      model.vertex_buffer, primitive.type,
+      primitive.vertex_offset, 0, primitive.vertex_count, instances
+    );
+  }
+  return true;
+}
+
+bool d3d_model_draw_instanced(int id, int instances, int texId) {
+  texture_set(texId);
+  return d3d_model_draw_instanced(id, instances);
+}
+
 void d3d_model_primitive_begin(int id, int kind, int format) {
   enigma::Model& model = enigma::models.get(id);
   if (!model.vertex_started) {
     model.vertex_started = true;
     vertex_begin(model.vertex_buffer);
+    // the primitives of an optimized model count indices, which new ones
+    // can't be merged with
+    if (model.index_buffer != -1) {
+      enigma::model_unindex(model);
+      model.primitives.clear();
+    }
   }
   model.vertex_colored = true;
   model.current_primitive = enigma::Primitive(
@@ -519,10 +1077,114 @@ void d3d_model_save(int id, string fname) {
   //TODO: Write save code that has never been done before yet
 }
 
+bool d3d_model_save_binary(int id, string fname) {
+  enigma::Model& model = enigma::models.get(id);
+  enigma::model_end(model);
+
+  // the vertices are only in memory until the model is first drawn
+  const auto& vertexBuffer = enigma::vertexBuffers[model.vertex_buffer];
+  if (vertexBuffer->vertices.size() != size_t(vertexBuffer->getNumber())) {
+    DEBUG_MESSAGE("Model " + std::to_string(id) + " was drawn before it was saved and its vertices are no longer"
+                  " in memory", MESSAGE_TYPE::M_USER_ERROR);
+    return false;
+  }
+  if (model.index_buffer != -1 && !enigma::indexBuffers[model.index_buffer]->dirty) {
+    DEBUG_MESSAGE("Model " + std::to_string(id) + " was drawn before it was saved and its indices are no longer"
+                  " in memory", MESSAGE_TYPE::M_USER_ERROR);
+    return false;
+  }
+
+  enigma::model_binary::writer writer;
+  if (!enigma::model_binary::write(model, writer)) return false;
+  FILE_t* file = fopen_wrapper(fname.c_str(), "wb");
+  if (!file) return false;
+  const size_t written = fwrite_wrapper(writer.out.data(), 1, writer.out.size(), file);
+  fclose_wrapper(file);
+  return written == writer.out.size();
+}
+
+bool d3d_model_load_binary(int id, string fname) {
+  enigma::Model& model = enigma::models.get(id);
+  d3d_model_clear(id);
+
+  FileMapping mapping;
+  if (!fmap_wrapper(fname.c_str(), &mapping)) return false;
+  vertex_begin(model.vertex_buffer);
+  enigma::model_binary::reader reader(mapping.data, mapping.size);
+  const bool loaded = enigma::model_binary::read(model, reader);
+  funmap_wrapper(&mapping);
+
+  if (!loaded) {
+    DEBUG_MESSAGE("Binary model file is corrupt or from a newer version: " + fname, MESSAGE_TYPE::M_ERROR);
+    d3d_model_clear(id);
+    return false;
+  }
+  // the bounds came with the file, so the model is ended without finding them
+  enigma::model_freeze(model);
+  return true;
+}
+
+bool d3d_model_optimize(int id) {
+  enigma::Model& model = enigma::models.get(id);
+  enigma::model_end(model);
+
+  // like saving, this needs the vertices that are gone once it's drawn
+  const auto& vertexBuffer = enigma::vertexBuffers[model.vertex_buffer];
+  if (vertexBuffer->vertices.size() != size_t(vertexBuffer->getNumber())) {
+    DEBUG_MESSAGE("Model " + std::to_string(id) + " was drawn before it was optimized and its vertices are no longer"
+                  " in memory", MESSAGE_TYPE::M_USER_ERROR);
+    return false;
+  }
+  if (!enigma::model_optimize(model)) return false;
+  // the vertex buffer was frozen when it was ended, the new indices still
+  // have to be
+  enigma::model_freeze(model);
+  return true;
+}
+
+void d3d_model_set_auto_optimize(bool enable) {
+  enigma::modelAutoOptimize = enable;
+}
+
+bool d3d_model_get_auto_optimize() {
+  return enigma::modelAutoOptimize;
+}
+
+unsigned d3d_model_get_vertex_count(int id) {
+  const enigma::Model& model = enigma::models.get(id);
+  // an optimized model's primitive counts indices, not vertices
+  if (model.index_buffer != -1) {
+    if (model.primitives.empty() || !vertex_format_exists(model.primitives[0].format)) return 0;
+    return enigma::vertexBuffers[model.vertex_buffer]->getNumber() /
+           enigma::vertexFormats[model.primitives[0].format]->stride;
+  }
+  unsigned count = 0;
+  for (const enigma::Primitive& primitive : model.primitives) count += primitive.vertex_count;
+  return count;
+}
+
+unsigned d3d_model_get_index_count(int id) {
+  const enigma::Model& model = enigma::models.get(id);
+  if (model.index_buffer == -1) return 0;
+  unsigned count = 0;
+  for (const enigma::Primitive& primitive : model.primitives) count += primitive.vertex_count;
+  return count;
+}
+
+bool d3d_model_convert_binary(string source, string destination) {
+  const int model = d3d_model_create();
+  const bool converted = d3d_model_load(model, source) && d3d_model_save_binary(model, destination);
+  d3d_model_destroy(model);
+  return converted;
+}
+
 bool d3d_model_load(int id, string fname) {
   //TODO: this needs to be rewritten properly not using the file_text functions
   using namespace enigma_user;
 
+  if (enigma::model_binary::detect(fname))
+    return d3d_model_load_binary(id, fname);
+
   // clear the old contents first since we are loading a new model
   // this is dictated by the GMS manual
   d3d_model_clear(id);
@@ -47,10 +47,36 @@ namespace enigma_user {
   void d3d_model_clear(int id);
   void d3d_model_save(int id, std::string fname);
   bool d3d_model_load(int id, std::string fname);
+  // Binary models hold the vertices, formats and bounds exactly as they are
+  // drawn, so they load with one copy from the mapped file instead of being
+  // replayed vertex by vertex. A model can only be saved before it is first
+  // drawn, while its vertices are still in memory. d3d_model_load reads
+  // binary models as well; convert turns any model it reads into one.
+  bool d3d_model_save_binary(int id, std::string fname);
+  bool d3d_model_load_binary(int id, std::string fname);
+  bool d3d_model_convert_binary(std::string source, std::string destination);
+  // Optimizing welds the identical vertices of a model made only of triangles
+  // in one format and draws it through an index buffer, with the triangles
+  // reordered to reuse the vertices the GPU has just transformed. Like
+  // saving, it has to happen before the model is first drawn. Static models
+  // can be optimized as they are ended instead, which is off by default
+  // because it changes the order translucent triangles blend in, and an
+  // optimized model can't be drawn instanced.
+  bool d3d_model_optimize(int id);
+  void d3d_model_set_auto_optimize(bool enable);
+  bool d3d_model_get_auto_optimize();
+  // the vertices the model holds, once each after it's optimized, and the
+  // indices it's drawn with, which are only there once it's optimized
+  unsigned d3d_model_get_vertex_count(int id);
+  unsigned d3d_model_get_index_count(int id);
   void d3d_model_draw(int id);
   void d3d_model_draw(int id, gs_scalar x, gs_scalar y, gs_scalar z);
   void d3d_model_draw(int id, int texId);
   void d3d_model_draw(int id, gs_scalar x, gs_scalar y, gs_scalar z, int texId);
+  // draws the model once for each instance in a vertex_instance_format buffer,
+  // returning false for an optimized model, which can't be drawn this way
+  bool d3d_model_draw_instanced(int id, int instances);
+  bool d3d_model_draw_instanced(int id, int instances, int texId);
   void d3d_model_primitive_begin(int id, int kind, int format = -1);
   void d3d_model_primitive_end(int id);
 
@@ -57,6 +57,7 @@ class Model {
  public:
   int type; // one of the enigma_user model type constants (e.g, model_static is the default)
   int vertex_buffer; // index of the user vertex buffer this model uses to buffer its vertex data
+  int index_buffer; // index of the index buffer the model is drawn with once optimized, else -1
   Primitive current_primitive; // the current primitive being specified by the user
   bool vertex_started; // whether the user has begun specifying the model by starting a primitive
   vector<Primitive> primitives; // all primitives the user has finished specifying for this model
@@ -65,6 +66,8 @@ class Model {
   bool vertex_colored; // whether the last vertex specified color or not
   int vertex_color; // the color that was set when the last vertex was added
   gs_scalar vertex_alpha; // the alpha that was set when the last vertex was added
+  bool bounded; // whether the bounds were found, false until a non-stream model with positions is ended
+  gs_scalar bounds_min[3], bounds_max[3]; // axis aligned box around every position in the model
 
   // NOTE: vertex_buffer should always exist but not outlive the model
   // NOTE: current_primitive is not reset until the next begin call
@@ -72,10 +75,13 @@ class Model {
   // NOTE: vertex_started is true until the user attempts to draw the model
   // NOTE: vertex_colored waits until the next vertex or primitive end to add the color
   //       because GM has always specified color as the last argument on its vertex formats
+  // NOTE: the bounds are found once when the model is ended, not every time it's drawn
+  // NOTE: primitives of an indexed model count indices and their vertex_offset is the first index
 
   Model(int type = enigma_user::model_static, bool use_draw_color = false):
-    destroyed(false), type(type), vertex_buffer(-1), current_primitive(), vertex_started(false),
-    use_draw_color(use_draw_color), vertex_colored(true), vertex_color(enigma_user::c_white), vertex_alpha(1.0) {}
+    destroyed(false), type(type), vertex_buffer(-1), index_buffer(-1), current_primitive(), vertex_started(false),
+    use_draw_color(use_draw_color), vertex_colored(true), vertex_color(enigma_user::c_white), vertex_alpha(1.0),
+    bounded(false), bounds_min{0, 0, 0}, bounds_max{0, 0, 0} {}
 
   void destroy() {
     destroyed = true;
@@ -18,32 +18,86 @@
 
 #include "GSprimitives.h"
 #include "GSstdraw.h"
+#include "GScapture.h"
+#include "GSblend.h"
 #include "GSmodel.h"
+#include "GSmodel_impl.h"
 #include "GStextures.h"
+#include "GSvertex.h"
+#include "GSvertex_impl.h"
 
 #ifdef DEBUG_MODE
 #include "Widget_Systems/widgets_mandatory.h"
 #endif
 
+#include <algorithm>
+#include <vector>
+
 namespace {
 
 // the batching mode is initialized to the default here
 int draw_batch_mode = enigma_user::batch_flush_deferred;
 // whether a batch has been started but not flushed yet
 bool draw_batch_dirty = false;
+// batches drawn, and how many of them were ended early by a texture swap
+unsigned draw_batch_flushes = 0, draw_batch_texture_breaks = 0;
+// quads waiting in the quad stream; a batch holds either quads or primitives
+unsigned draw_batch_quads = 0;
+// quads per draw, which is as many as 16-bit indices can address
+const unsigned draw_quad_stream_size = 16384;
 // lazy create the batch stream that we use for combining primitives
 int draw_get_batch_stream() {
   static int draw_batch_stream = -1;
-  if (!enigma_user::d3d_model_exists(draw_batch_stream))
+  if (!enigma_user::d3d_model_exists(draw_batch_stream)) {
     draw_batch_stream = enigma_user::d3d_model_create(enigma_user::model_stream, true);
+    enigma::vertexBuffers[enigma::models.get(draw_batch_stream).vertex_buffer]->streamed = true;
+  }
   return draw_batch_stream;
 }
+// lazy create the stream that sprite quads are written into directly
+// its index buffer never changes, so it is filled once and frozen
+struct QuadStream { int vertex = -1, index = -1, format = -1; };
+const QuadStream& draw_get_quad_stream() {
+  using namespace enigma_user;
+  static QuadStream stream;
+  if (!vertex_exists(stream.vertex)) {
+    stream.vertex = vertex_create_buffer();
+    enigma::vertexBuffers[stream.vertex]->vertices.reserve(draw_quad_stream_size * 4 * 5);
+    enigma::vertexBuffers[stream.vertex]->streamed = true;
+
+    stream.index = index_create_buffer();
+    index_begin(stream.index, index_type_ushort);
+    auto& indices = enigma::indexBuffers[stream.index]->indices;
+    indices.reserve(draw_quad_stream_size * 6);
+    for (unsigned q = 0; q < draw_quad_stream_size * 4; q += 4) {
+      const uint16_t quad[] = {uint16_t(q), uint16_t(q + 1), uint16_t(q + 2), uint16_t(q), uint16_t(q + 2), uint16_t(q + 3)};
+      indices.insert(indices.end(), quad, quad + 6);
+    }
+    index_end(stream.index);
+    index_freeze(stream.index);
+
+    vertex_format_begin();
+    vertex_format_add_position();
+    vertex_format_add_textcoord();
+    vertex_format_add_color();
+    stream.format = vertex_format_end();
+  }
+  return stream;
+}
 // helper function for beginning a deferred batch to determine when texture swap occurs
 // one goal of the function is to ensure the render states are current when a batch begins
-void draw_batch_begin_deferred(int texId) {
+void draw_batch_begin_deferred(int texId, bool quads = false) {
+  // anything else has to come after the quads that were queued before it
+  if (!quads) enigma::draw_render_queue_submit();
+  // quads and primitives go to different streams, so switching between them
+  // has to draw what came before to keep everything in order
+  if (draw_batch_dirty && quads != (draw_batch_quads > 0)) {
+    enigma_user::draw_batch_flush(draw_batch_mode);
+  }
   // if we want to use a different texture, set it now
   // this marks the state as dirty only if the texture is different
   if (enigma_user::texture_get() != texId) {
+    if (draw_batch_dirty) ++draw_batch_texture_breaks;
     enigma_user::texture_set(texId);
   }
   // if the draw state is dirty, flush the new state
@@ -54,9 +108,184 @@ void draw_batch_begin_deferred(int texId) {
   }
   draw_batch_dirty = true;
 }
+// appends a quad's vertices to the quad stream, drawing what came before
+// if it is full or the quad needs a different texture or state
+void draw_batch_stream_quad(int texId, const enigma::VertexElement* quad) {
+  if (draw_batch_quads == draw_quad_stream_size)
+    enigma_user::draw_batch_flush(draw_batch_mode);
+  draw_batch_begin_deferred(texId, true);
+
+  const QuadStream& stream = draw_get_quad_stream();
+  auto& vertices = enigma::vertexBuffers[stream.vertex]->vertices;
+  if (!draw_batch_quads) enigma_user::vertex_begin(stream.vertex, stream.format);
+  vertices.insert(vertices.end(), quad, quad + 20);
+  ++draw_batch_quads;
+
+  enigma_user::draw_batch_flush(enigma_user::batch_flush_immediate);
+}
+
+// The render queue holds quads back instead of streaming them, so quads that
+// share a texture and blend mode can be drawn together even when the game
+// interleaves them with others. It is drawn whenever state it does not record
+// changes, or anything else is about to be drawn.
+int render_queue_mode = enigma_user::render_queue_off;
+// whether the queue is being drawn, so the quads go to the stream instead
+bool render_queue_submitting = false;
+// counts the depth layers drawn since the queue was last empty
+unsigned render_queue_layer = 0;
+// quads recorded since the last reset
+unsigned render_queue_recorded = 0;
+// how many of the most recent batches a quad may move ahead of to join an
+// earlier one, which bounds the cost of recording
+const size_t render_queue_lookback = 64;
+
+struct QueuedQuad {
+  // depth layer, then blend mode, then texture, so sorting by it groups
+  // the quads of a layer that can be drawn together
+  uint64_t key;
+  unsigned batch; // the batch it joined when recorded in order
+};
+struct QueuedBatch {
+  uint64_t key;
+  gs_scalar x1, y1, x2, y2; // the bounding box of its quads
+};
+std::vector<QueuedQuad> render_queue;
+std::vector<enigma::VertexElement> render_queue_vertices; // 20 for each quad
+std::vector<QueuedBatch> render_queue_batches;
+std::vector<unsigned> render_queue_order;
+
+uint64_t render_queue_key(int texId) {
+  const uint64_t layer = render_queue_mode == enigma_user::render_queue_sorted ? std::min(render_queue_layer, 0xFFFFu) : 0;
+  const uint64_t blend = (enigma::blendMode[0] & 0xF) << 4 | (enigma::blendMode[1] & 0xF);
+  return layer << 40 | blend << 32 | uint32_t(texId);
+}
+
+void render_queue_record(int texId, const enigma::VertexElement* quad) {
+  // primitives that were started before this quad have to be drawn first
+  if (draw_batch_dirty && !draw_batch_quads)
+    enigma_user::draw_batch_flush(draw_batch_mode);
+
+  QueuedQuad command;
+  command.key = render_queue_key(texId);
+  render_queue_vertices.insert(render_queue_vertices.end(), quad, quad + 20);
+  ++render_queue_recorded;
+
+  if (render_queue_mode == enigma_user::render_queue_ordered) {
+    // join the latest batch with the same texture and blend mode, unless
+    // that would move this quad behind a later batch it overlaps
+    gs_scalar x1 = quad[0].f, y1 = quad[1].f, x2 = x1, y2 = y1;
+    for (int i = 5; i < 20; i += 5) {
+      x1 = std::min(x1, quad[i].f), x2 = std::max(x2, quad[i].f);
+      y1 = std::min(y1, quad[i + 1].f), y2 = std::max(y2, quad[i + 1].f);
+    }
+    command.batch = render_queue_batches.size();
+    for (size_t i = render_queue_batches.size(), checked = 0; i-- > 0 && checked < render_queue_lookback; ++checked) {
+      QueuedBatch& batch = render_queue_batches[i];
+      if (batch.key == command.key) {
+        command.batch = i;
+        batch.x1 = std::min(batch.x1, x1), batch.y1 = std::min(batch.y1, y1);
+        batch.x2 = std::max(batch.x2, x2), batch.y2 = std::max(batch.y2, y2);
+        break;
+      }
+      if (x1 < batch.x2 && batch.x1 < x2 && y1 < batch.y2 && batch.y1 < y2) break;
+    }
+    if (command.batch == render_queue_batches.size())
+      render_queue_batches.push_back({command.key, x1, y1, x2, y2});
+  } else {
+    command.batch = 0;
+  }
+
+  render_queue.push_back(command);
+}
 
 } // anonymous namespace
 
+namespace enigma
+{
+
+void draw_batch_quad(int texId,
+                     gs_scalar x1, gs_scalar y1, gs_scalar x2, gs_scalar y2,
+                     gs_scalar x3, gs_scalar y3, gs_scalar x4, gs_scalar y4,
+                     gs_scalar tx1, gs_scalar ty1, gs_scalar tx2, gs_scalar ty2,
+                     int c1, int c2, int c3, int c4, gs_scalar alpha)
+{
+  const color_t col1 = graphics_pack_vertex_color(c1, alpha),
+    col2 = c2 == c1 ? col1 : graphics_pack_vertex_color(c2, alpha),
+    col3 = c3 == c1 ? col1 : graphics_pack_vertex_color(c3, alpha),
+    col4 = c4 == c1 ? col1 : graphics_pack_vertex_color(c4, alpha);
+  const VertexElement quad[] = {
+    x1, y1, tx1, ty1, col1,
+    x2, y2, tx2, ty1, col2,
+    x3, y3, tx2, ty2, col3,
+    x4, y4, tx1, ty2, col4
+  };
+
+  // queueing is a further deferral, so only the deferred mode does it
+  if (render_queue_mode != enigma_user::render_queue_off && !render_queue_submitting &&
+      draw_batch_mode == enigma_user::batch_flush_deferred) {
+    render_queue_record(texId, quad);
+  } else {
+    draw_batch_stream_quad(texId, quad);
+  }
+}
+
+void draw_batch_quad(int texId,
+                     gs_scalar x1, gs_scalar y1, gs_scalar x2, gs_scalar y2,
+                     gs_scalar x3, gs_scalar y3, gs_scalar x4, gs_scalar y4,
+                     gs_scalar tx1, gs_scalar ty1, gs_scalar tx2, gs_scalar ty2,
+                     int color, gs_scalar alpha)
+{
+  draw_batch_quad(texId, x1, y1, x2, y2, x3, y3, x4, y4, tx1, ty1, tx2, ty2, color, color, color, color, alpha);
+}
+
+void draw_render_queue_submit() {
+  using namespace enigma_user;
+  if (render_queue_submitting || render_queue.empty()) return;
+  render_queue_submitting = true;
+
+  // put the quads in the order they are drawn in, which keeps the order they
+  // were recorded in among quads that share a batch or a key
+  render_queue_order.resize(render_queue.size());
+  for (unsigned i = 0; i < render_queue_order.size(); ++i) render_queue_order[i] = i;
+  if (render_queue_mode == render_queue_sorted) {
+    std::stable_sort(render_queue_order.begin(), render_queue_order.end(),
+                     [](unsigned a, unsigned b) { return render_queue[a].key < render_queue[b].key; });
+  } else {
+    std::stable_sort(render_queue_order.begin(), render_queue_order.end(),
+                     [](unsigned a, unsigned b) { return render_queue[a].batch < render_queue[b].batch; });
+  }
+
+  // each quad carries its own texture and blend mode, which the stream breaks
+  // a batch on when they change; the user's are put back afterwards
+  const int texture = texture_get(), blend_src = blendMode[0], blend_dest = blendMode[1];
+  for (unsigned i : render_queue_order) {
+    const QueuedQuad& command = render_queue[i];
+    const int src = (command.key >> 36) & 0xF, dest = (command.key >> 32) & 0xF;
+    if (blendMode[0] != src || blendMode[1] != dest) {
+      draw_set_sortable_state_dirty();
+      blendMode[0] = src, blendMode[1] = dest;
+    }
+    draw_batch_stream_quad(int32_t(command.key), &render_queue_vertices[i * 20]);
+  }
+  if (blendMode[0] != blend_src || blendMode[1] != blend_dest) {
+    draw_set_sortable_state_dirty();
+    blendMode[0] = blend_src, blendMode[1] = blend_dest;
+  }
+  texture_set(texture);
+
+  render_queue.clear();
+  render_queue_vertices.clear();
+  render_queue_batches.clear();
+  render_queue_layer = 0;
+  render_queue_submitting = false;
+}
+
+void draw_render_queue_next_layer() {
+  if (!render_queue.empty()) ++render_queue_layer;
+}
+
+} // namespace enigma
+
 namespace enigma_user
 {
 
@@ -82,6 +311,9 @@ void draw_batch_flush(int kind) {
   // is not the mode of flushing we have enabled
   if (draw_batch_mode != kind) return;
 
+  // queued quads go into the batch, and all but the last of theirs are drawn
+  enigma::draw_render_queue_submit();
+
   // guard against infinite recursion in case this flush
   // leads to other state changes that trigger another flush
   if (flushing || !draw_batch_dirty) return;
@@ -98,10 +330,23 @@ void draw_batch_flush(int kind) {
     // the next batch or vertex submit to flush the new state
     bool wasStateDirty = enigma::draw_get_state_dirty();
     enigma::draw_set_state_dirty(false);
-    d3d_model_draw(draw_get_batch_stream());
+    enigma::capture_set_batched(true);
+    if (draw_batch_quads) {
+      const QuadStream& stream = draw_get_quad_stream();
+      vertex_end(stream.vertex);
+      index_submit_range(stream.index, stream.vertex, pr_trianglelist, 0, draw_batch_quads * 6);
+    } else {
+      d3d_model_draw(draw_get_batch_stream());
+    }
+    enigma::capture_set_batched(false);
     enigma::draw_set_state_dirty(wasStateDirty);
+    ++draw_batch_flushes;
+  }
+  if (draw_batch_quads) {
+    draw_batch_quads = 0;
+  } else {
+    d3d_model_clear(draw_get_batch_stream());
   }
-  d3d_model_clear(draw_get_batch_stream());
 
   flushing = false;
   draw_batch_dirty = false;
@@ -122,6 +367,32 @@ int draw_get_batch_mode() {
   return draw_batch_mode;
 }
 
+unsigned draw_batch_get_flush_count() {
+  return draw_batch_flushes;
+}
+
+unsigned draw_batch_get_texture_breaks() {
+  return draw_batch_texture_breaks;
+}
+
+unsigned draw_batch_get_queued_count() {
+  return render_queue_recorded;
+}
+
+void draw_batch_reset_stats() {
+  draw_batch_flushes = draw_batch_texture_breaks = render_queue_recorded = 0;
+}
+
+void draw_set_render_queue(int mode) {
+  // what was queued is drawn in the mode it was recorded for
+  if (render_queue_mode != mode) enigma::draw_render_queue_submit();
+  render_queue_mode = mode;
+}
+
+int draw_get_render_queue() {
+  return render_queue_mode;
+}
+
 void draw_primitive_begin(int kind, int format)
 {
   draw_batch_begin_deferred(-1);
@@ -20,6 +20,31 @@
 
 #include "Universal_System/scalar.h"
 
+namespace enigma
+{
+  // Adds a textured quad to the batch as two indexed triangles, written
+  // straight into a stream kept for quads instead of going through the
+  // primitive and vertex functions. Corners and their colors go clockwise
+  // from the top left, which gets (tx1, ty1) of the texture rectangle.
+  void draw_batch_quad(int texId,
+                       gs_scalar x1, gs_scalar y1, gs_scalar x2, gs_scalar y2,
+                       gs_scalar x3, gs_scalar y3, gs_scalar x4, gs_scalar y4,
+                       gs_scalar tx1, gs_scalar ty1, gs_scalar tx2, gs_scalar ty2,
+                       int c1, int c2, int c3, int c4, gs_scalar alpha);
+  void draw_batch_quad(int texId,
+                       gs_scalar x1, gs_scalar y1, gs_scalar x2, gs_scalar y2,
+                       gs_scalar x3, gs_scalar y3, gs_scalar x4, gs_scalar y4,
+                       gs_scalar tx1, gs_scalar ty1, gs_scalar tx2, gs_scalar ty2,
+                       int color, gs_scalar alpha);
+  // Draws the quads held in the render queue, if any, leaving the last batch
+  // of them pending like any other. Anything that changes state the queue
+  // does not record, or draws something else, calls this first.
+  void draw_render_queue_submit();
+  // Marks the start of the next depth layer, which the sorted render queue
+  // never reorders quads across.
+  void draw_render_queue_next_layer();
+}
+
 namespace enigma_user
 {
   enum {
@@ -41,6 +66,26 @@ namespace enigma_user
   void draw_set_batch_mode(int mode);
   int draw_get_batch_mode();
   void draw_batch_flush(int kind = draw_get_batch_mode());
+  // Batches drawn since the last reset, and how many of those were cut short
+  // because the next primitive used a different texture. Compare them with and
+  // without texture atlases to see what packing saves.
+  unsigned draw_batch_get_flush_count();
+  unsigned draw_batch_get_texture_breaks();
+  void draw_batch_reset_stats();
+
+  enum {
+    render_queue_off = 0,     // sprites are batched in the order they are drawn
+    render_queue_ordered = 1, // sprites join an earlier batch they can without changing what overlaps what
+    render_queue_sorted = 2,  // sprites of a depth layer are sorted by blend mode and texture, in any order
+  };
+
+  // Holds sprite quads back while the batch mode is deferred, so two sprite
+  // sheets drawn in turns cost two draws instead of one per swap. Quads
+  // recorded since the last reset, next to the flush count, show how well
+  // they merged.
+  void draw_set_render_queue(int mode);
+  int draw_get_render_queue();
+  unsigned draw_batch_get_queued_count();
   unsigned draw_primitive_count(int kind, unsigned vertex_count);
   void draw_primitive_begin(int kind, int format = -1);
   void draw_primitive_begin_texture(int kind, int texId, int format = -1);
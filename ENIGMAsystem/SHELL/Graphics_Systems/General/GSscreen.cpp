@@ -26,6 +26,7 @@
 #include "GSprimitives.h"
 #include "GSvertex.h"
 #include "GScolors.h"
+#include "GScapture.h"
 
 #include "Universal_System/nlpo2.h"
 #include "Universal_System/image_formats.h"
@@ -170,6 +171,7 @@ static inline int draw_tiles()
   enigma::load_tiles();
   for (enigma::diter dit = drawing_depths.rbegin(); dit != drawing_depths.rend(); dit++)
   {
+    enigma::draw_render_queue_next_layer();
     if (dit->second.tiles.size())
     {
       for (auto &t : tile_layer_metadata[dit->second.tiles[0].depth]) {
@@ -228,6 +230,7 @@ static inline void draw_gui()
   bool stop_loop = false;
   for (enigma::diter dit = drawing_depths.rbegin(); dit != drawing_depths.rend(); dit++)
   {
+    enigma::draw_render_queue_next_layer();
     enigma::inst_iter* push_it = enigma::instance_event_iterator;
     //loop instances
     for (enigma::instance_event_iterator = dit->second.draw_events->next; enigma::instance_event_iterator != NULL; enigma::instance_event_iterator = enigma::instance_event_iterator->next) {
@@ -331,6 +334,7 @@ void screen_init() {
 
 void screen_refresh() {
   draw_batch_flush(batch_flush_deferred);
+  enigma::capture_screen_refresh();
   enigma::ScreenRefresh();
 }
 
@@ -18,14 +18,17 @@
 #include "GScolors.h"
 #include "GScolor_macros.h"
 #include "GSsprite.h"
+#include "GSd3d.h"
 #include "GStextures.h"
 #include "GSprimitives.h"
+#include "GSvertex.h"
 
 #include "Universal_System/nlpo2.h"
 #include "Universal_System/Resources/sprites_internal.h"
 #include "Universal_System/Resources/sprites.h"
 #include "Universal_System/math_consts.h"
 
+#include <algorithm>
 #include <cmath>
 #include <cstdlib>
 #include <string>
@@ -44,7 +47,7 @@ inline gs_scalar roty(gs_scalar qx, gs_scalar qy, gs_scalar rx, gs_scalar ry) {
 namespace enigma
 {
 
-void draw_sprite_pos_raw(const Sprite& spr2d, int subimg, gs_scalar x1, gs_scalar y1, gs_scalar x2, gs_scalar y2, gs_scalar x3, gs_scalar y3, gs_scalar x4, gs_scalar y4, gs_scalar color, gs_scalar alpha)
+void draw_sprite_pos_raw(const Sprite& spr2d, int subimg, gs_scalar x1, gs_scalar y1, gs_scalar x2, gs_scalar y2, gs_scalar x3, gs_scalar y3, gs_scalar x4, gs_scalar y4, int color, gs_scalar alpha)
 {
   alpha = CLAMP_ALPHAF(alpha);
   int usi = spr2d.ModSubimage(subimg);
@@ -55,18 +58,13 @@ void draw_sprite_pos_raw(const Sprite& spr2d, int subimg, gs_scalar x1, gs_scala
     tx = texRect.x, tw = texRect.w,
     ty = texRect.y, th = texRect.h;
 
-  draw_primitive_begin_texture(pr_trianglestrip, spr2d.GetTexture(usi));
-  draw_vertex_texture_color(x1,y1, tx,    ty,    color,alpha);
-  draw_vertex_texture_color(x2,y2, tx+tw, ty,    color,alpha);
-  draw_vertex_texture_color(x4,y4, tx,    ty+th, color,alpha);
-  draw_vertex_texture_color(x3,y3, tx+tw, ty+th, color,alpha);
-  draw_primitive_end();
+  draw_batch_quad(spr2d.GetTexture(usi), x1,y1, x2,y2, x3,y3, x4,y4, tx,ty, tx+tw,ty+th, color, alpha);
 }
 
 void draw_sprite_pos_part_raw(const Sprite& spr2d, int subimg,
   gs_scalar px, gs_scalar py, gs_scalar pw, gs_scalar ph,
   gs_scalar x1, gs_scalar y1, gs_scalar x2, gs_scalar y2, gs_scalar x3, gs_scalar y3, gs_scalar x4, gs_scalar y4,
-  gs_scalar color, gs_scalar alpha
+  int color, gs_scalar alpha
 ) {
   alpha = CLAMP_ALPHAF(alpha);
   int usi = spr2d.ModSubimage(subimg);
@@ -79,12 +77,26 @@ void draw_sprite_pos_part_raw(const Sprite& spr2d, int subimg,
     tx1 = tbx + px / tbw, tx2 = tx1 + pw / tbw,
     ty1 = tby + py / tbh, ty2 = ty1 + ph / tbh;
 
-  draw_primitive_begin_texture(pr_trianglestrip, spr2d.GetTexture(usi));
-  draw_vertex_texture_color(x1,y1, tx1,ty1, color,alpha);
-  draw_vertex_texture_color(x2,y2, tx2,ty1, color,alpha);
-  draw_vertex_texture_color(x4,y4, tx1,ty2, color,alpha);
-  draw_vertex_texture_color(x3,y3, tx2,ty2, color,alpha);
-  draw_primitive_end();
+  draw_batch_quad(spr2d.GetTexture(usi), x1,y1, x2,y2, x3,y3, x4,y4, tx1,ty1, tx2,ty2, color, alpha);
+}
+
+bool draw_sprite_culled(int spr, gs_scalar x, gs_scalar y, gs_scalar xscale, gs_scalar yscale, double rot)
+{
+  if (!d3dInstanceCulling || !sprites.exists(spr)) return false;
+  const Sprite& spr2d = sprites.get(spr);
+  rot *= M_PI / -180.0;
+  gs_scalar
+    rx = cos(rot), ry = sin(rot),
+    x1 = -xscale * spr2d.xoffset, x2 = x1 + xscale * spr2d.width,
+    y1 = -yscale * spr2d.yoffset, y2 = y1 + yscale * spr2d.height;
+  // the box around the corners draw_sprite_ext would rotate the quad to
+  const gs_scalar
+    cx[4] = {rotx(x1, y1, rx, ry), rotx(x2, y1, rx, ry), rotx(x2, y2, rx, ry), rotx(x1, y2, rx, ry)},
+    cy[4] = {roty(x1, y1, rx, ry), roty(x2, y1, rx, ry), roty(x2, y2, rx, ry), roty(x1, y2, rx, ry)};
+  return frustum_cull_box(
+    x + *std::min_element(cx, cx + 4), y + *std::min_element(cy, cy + 4), 0,
+    x + *std::max_element(cx, cx + 4), y + *std::max_element(cy, cy + 4), 0
+  );
 }
 
 }
@@ -156,12 +168,12 @@ void draw_sprite_general(int spr, int subimg, gs_scalar left, gs_scalar top, gs_
     tx1 = tbx + left / tbw, tx2 = tx1 + width / tbw,
     ty1 = tby + top / tbh, ty2 = ty1 + height / tbh;
   // VD: EGM's color blending is for some reason softer and I can't figure out why
-  draw_primitive_begin_texture(pr_trianglestrip, spr2d.GetTexture(usi));
-  draw_vertex_texture_color(x + rotx(x1, y1, rx, ry), y + roty(x1, y1, rx, ry), tx1,ty1, c1,alpha);
-  draw_vertex_texture_color(x + rotx(x2, y1, rx, ry), y + roty(x2, y1, rx, ry), tx2,ty1, c2,alpha);
-  draw_vertex_texture_color(x + rotx(x1, y2, rx, ry), y + roty(x1, y2, rx, ry), tx1,ty2, c4,alpha);
-  draw_vertex_texture_color(x + rotx(x2, y2, rx, ry), y + roty(x2, y2, rx, ry), tx2,ty2, c3,alpha);
-  draw_primitive_end();
+  enigma::draw_batch_quad(spr2d.GetTexture(usi),
+    x + rotx(x1, y1, rx, ry), y + roty(x1, y1, rx, ry),
+    x + rotx(x2, y1, rx, ry), y + roty(x2, y1, rx, ry),
+    x + rotx(x2, y2, rx, ry), y + roty(x2, y2, rx, ry),
+    x + rotx(x1, y2, rx, ry), y + roty(x1, y2, rx, ry),
+    tx1,ty1, tx2,ty2, c1,c2,c3,c4, alpha);
 }
 
 void draw_sprite_stretched(int spr, int subimg, gs_scalar x, gs_scalar y, gs_scalar width, gs_scalar height, int color, gs_scalar alpha)
@@ -191,12 +203,8 @@ void draw_sprite_part_offset(int spr, int subimg, gs_scalar left, gs_scalar top,
     tbx1 = texRect.x+left/tbw, tbx2 = texRect.x+tbx1 + width/tbw,
     tby1 = texRect.y+top/tbh,  tby2 = texRect.y+tby1 + height/tbh;
 
-  draw_primitive_begin_texture(pr_trianglestrip, spr2d.GetTexture(usi));
-  draw_vertex_texture_color(xvert1,yvert1,tbx1,tby1,color,alpha);
-  draw_vertex_texture_color(xvert2,yvert1,tbx2,tby1,color,alpha);
-  draw_vertex_texture_color(xvert1,yvert2,tbx1,tby2,color,alpha);
-  draw_vertex_texture_color(xvert2,yvert2,tbx2,tby2,color,alpha);
-  draw_primitive_end();
+  enigma::draw_batch_quad(spr2d.GetTexture(usi), xvert1,yvert1, xvert2,yvert1, xvert2,yvert2, xvert1,yvert2,
+                          tbx1,tby1, tbx2,tby2, color, alpha);
 }
 
 void d3d_draw_sprite(int spr,int subimg, gs_scalar x, gs_scalar y, gs_scalar z)
@@ -236,6 +244,7 @@ void draw_sprite_padded(int spr, int subimg, gs_scalar left, gs_scalar top, gs_s
   if (h<top+bottom) y2 = y1+top+bottom, h = y2-y1;
 
   const TexRect& texRect = spr2d.GetTextureRect(usi);
+  const int texId = spr2d.GetTexture(usi);
 
   const gs_scalar midw = w-left-right, midh = h-top-bottom;
   const gs_scalar midtw = spr2d.width-left-right, midth = spr2d.height-bottom-top;
@@ -247,88 +256,64 @@ void draw_sprite_padded(int spr, int subimg, gs_scalar left, gs_scalar top, gs_s
   gs_scalar xvert1 = x1, xvert2 = xvert1 + left,
             yvert1 = y1, yvert2 = yvert1 + top;
 
-  draw_primitive_begin_texture(pr_trianglestrip, spr2d.GetTexture(usi));
-  draw_vertex_texture_color(xvert1,yvert1,tbx,tby,color,alpha);
-  draw_vertex_texture_color(xvert2,yvert1,tbx+tbl,tby,color,alpha);
-  draw_vertex_texture_color(xvert1,yvert2,tbx,tby+tbt,color,alpha);
-  draw_vertex_texture_color(xvert2,yvert2,tbx+tbl,tby+tbt,color,alpha);
+  enigma::draw_batch_quad(texId, xvert1,yvert1, xvert2,yvert1, xvert2,yvert2, xvert1,yvert2,
+                          tbx,tby, tbx+tbl,tby+tbt, color, alpha);
 
   //Draw left side
   xvert1 = x1, xvert2 = xvert1 + left,
   yvert1 = y1 + top, yvert2 = yvert1 + midh;
 
-  draw_vertex_texture_color(xvert1,yvert1,tbx,tby+tbt,color,alpha);
-  draw_vertex_texture_color(xvert2,yvert1,tbx+tbl,tby+tbt,color,alpha);
-  draw_vertex_texture_color(xvert1,yvert2,tbx,tby+tbt+tbmh,color,alpha);
-  draw_vertex_texture_color(xvert2,yvert2,tbx+tbl,tby+tbt+tbmh,color,alpha);
+  enigma::draw_batch_quad(texId, xvert1,yvert1, xvert2,yvert1, xvert2,yvert2, xvert1,yvert2,
+                          tbx,tby+tbt, tbx+tbl,tby+tbt+tbmh, color, alpha);
 
   //Draw bottom-left corner
   xvert1 = x1, xvert2 = xvert1 + left,
   yvert1 = y1 + top + midh, yvert2 = yvert1 + bottom;
 
-  draw_vertex_texture_color(xvert1,yvert1,tbx,tby+tbt+tbmh,color,alpha);
-  draw_vertex_texture_color(xvert2,yvert1,tbx+tbl,tby+tbt+tbmh,color,alpha);
-  draw_vertex_texture_color(xvert1,yvert2,tbx,tby+tbt+tbmh+tbb,color,alpha);
-  draw_vertex_texture_color(xvert2,yvert2,tbx+tbl,tby+tbt+tbmh+tbb,color,alpha);
-  draw_primitive_end();
+  enigma::draw_batch_quad(texId, xvert1,yvert1, xvert2,yvert1, xvert2,yvert2, xvert1,yvert2,
+                          tbx,tby+tbt+tbmh, tbx+tbl,tby+tbt+tbmh+tbb, color, alpha);
 
   //Draw top
   xvert1 = x1 + left, xvert2 = xvert1 + midw,
   yvert1 = y1, yvert2 = yvert1 + top;
 
-  draw_primitive_begin_texture(pr_trianglestrip, spr2d.GetTexture(usi));
-  draw_vertex_texture_color(xvert1,yvert1,tbx+tbl,tby,color,alpha);
-  draw_vertex_texture_color(xvert2,yvert1,tbx+tbl+tbmw,tby,color,alpha);
-  draw_vertex_texture_color(xvert1,yvert2,tbx+tbl,tby+tbt,color,alpha);
-  draw_vertex_texture_color(xvert2,yvert2,tbx+tbl+tbmw,tby+tbt,color,alpha);
+  enigma::draw_batch_quad(texId, xvert1,yvert1, xvert2,yvert1, xvert2,yvert2, xvert1,yvert2,
+                          tbx+tbl,tby, tbx+tbl+tbmw,tby+tbt, color, alpha);
 
   //Draw middle
   xvert1 = x1 + left, xvert2 = xvert1 + midw,
   yvert1 = y1 + top, yvert2 = yvert1 + midh;
 
-  draw_vertex_texture_color(xvert1,yvert1,tbx+tbl,tby+tbt,color,alpha);
-  draw_vertex_texture_color(xvert2,yvert1,tbx+tbl+tbmw,tby+tbt,color,alpha);
-  draw_vertex_texture_color(xvert1,yvert2,tbx+tbl,tby+tbt+tbmh,color,alpha);
-  draw_vertex_texture_color(xvert2,yvert2,tbx+tbl+tbmw,tby+tbt+tbmh,color,alpha);
+  enigma::draw_batch_quad(texId, xvert1,yvert1, xvert2,yvert1, xvert2,yvert2, xvert1,yvert2,
+                          tbx+tbl,tby+tbt, tbx+tbl+tbmw,tby+tbt+tbmh, color, alpha);
 
   //Draw bottom
   xvert1 = x1 + left, xvert2 = xvert1 + midw,
   yvert1 = y1 + midh + top, yvert2 = yvert1 + bottom;
 
-  draw_vertex_texture_color(xvert1,yvert1,tbx+tbl,tby+tbt+tbmh,color,alpha);
-  draw_vertex_texture_color(xvert2,yvert1,tbx+tbl+tbmw,tby+tbt+tbmh,color,alpha);
-  draw_vertex_texture_color(xvert1,yvert2,tbx+tbl,tby+tbt+tbmh+tbb,color,alpha);
-  draw_vertex_texture_color(xvert2,yvert2,tbx+tbl+tbmw,tby+tbt+tbmh+tbb,color,alpha);
-  draw_primitive_end();
+  enigma::draw_batch_quad(texId, xvert1,yvert1, xvert2,yvert1, xvert2,yvert2, xvert1,yvert2,
+                          tbx+tbl,tby+tbt+tbmh, tbx+tbl+tbmw,tby+tbt+tbmh+tbb, color, alpha);
 
   //Draw top-right corner
   xvert1 = x1 + midw + left, xvert2 = xvert1 + right,
   yvert1 = y1, yvert2 = yvert1 + top;
 
-  draw_primitive_begin_texture(pr_trianglestrip, spr2d.GetTexture(usi));
-  draw_vertex_texture_color(xvert1,yvert1,tbx+tbl+tbmw,tby,color,alpha);
-  draw_vertex_texture_color(xvert2,yvert1,tbx+tbl+tbmw+tbr,tby,color,alpha);
-  draw_vertex_texture_color(xvert1,yvert2,tbx+tbl+tbmw,tby+tbt,color,alpha);
-  draw_vertex_texture_color(xvert2,yvert2,tbx+tbl+tbmw+tbr,tby+tbt,color,alpha);
+  enigma::draw_batch_quad(texId, xvert1,yvert1, xvert2,yvert1, xvert2,yvert2, xvert1,yvert2,
+                          tbx+tbl+tbmw,tby, tbx+tbl+tbmw+tbr,tby+tbt, color, alpha);
 
   //Draw right side
   xvert1 = x1 + midw + left, xvert2 = xvert1 + right,
   yvert1 = y1 + top, yvert2 = yvert1 + midh;
 
-  draw_vertex_texture_color(xvert1,yvert1,tbx+tbl+tbmw,tby+tbt,color,alpha);
-  draw_vertex_texture_color(xvert2,yvert1,tbx+tbl+tbmw+tbr,tby+tbt,color,alpha);
-  draw_vertex_texture_color(xvert1,yvert2,tbx+tbl+tbmw,tby+tbt+tbmh,color,alpha);
-  draw_vertex_texture_color(xvert2,yvert2,tbx+tbl+tbmw+tbr,tby+tbt+tbmh,color,alpha);
+  enigma::draw_batch_quad(texId, xvert1,yvert1, xvert2,yvert1, xvert2,yvert2, xvert1,yvert2,
+                          tbx+tbl+tbmw,tby+tbt, tbx+tbl+tbmw+tbr,tby+tbt+tbmh, color, alpha);
 
   //Draw bottom-right corner
   xvert1 = x1 + midw + left, xvert2 = xvert1 + right,
   yvert1 = y1 + top + midh, yvert2 = yvert1 + bottom;
 
-  draw_vertex_texture_color(xvert1,yvert1,tbx+tbl+tbmw,tby+tbt+tbmh,color,alpha);
-  draw_vertex_texture_color(xvert2,yvert1,tbx+tbl+tbmw+tbr,tby+tbt+tbmh,color,alpha);
-  draw_vertex_texture_color(xvert1,yvert2,tbx+tbl+tbmw,tby+tbt+tbmh+tbb,color,alpha);
-  draw_vertex_texture_color(xvert2,yvert2,tbx+tbl+tbmw+tbr,tby+tbt+tbmh+tbb,color,alpha);
-  draw_primitive_end();
+  enigma::draw_batch_quad(texId, xvert1,yvert1, xvert2,yvert1, xvert2,yvert2, xvert1,yvert2,
+                          tbx+tbl+tbmw,tby+tbt+tbmh, tbx+tbl+tbmw+tbr,tby+tbt+tbmh+tbb, color, alpha);
 }
 
 }
@@ -354,6 +339,7 @@ void draw_sprite_tiled(int spr, int subimg, gs_scalar x, gs_scalar y, int color,
   y = ((spr2d.yoffset+y)<0?0:spr2d.height)-fmod(spr2d.yoffset+y,spr2d.height);
   
   const TexRect& texRect = spr2d.GetTextureRect(usi);
+  const int texId = spr2d.GetTexture(usi);
   
   gs_scalar
     tx = texRect.x, tw = texRect.w,
@@ -369,12 +355,8 @@ void draw_sprite_tiled(int spr, int subimg, gs_scalar x, gs_scalar y, int color,
     yvert1 = -y; yvert2 = yvert1 + spr2d.height;
     for (int c=0; c<vertil; ++c)
     {
-      draw_primitive_begin_texture(pr_trianglestrip, spr2d.GetTexture(usi));
-      draw_vertex_texture_color(xvert1,yvert1,tx,ty,color,alpha);
-      draw_vertex_texture_color(xvert2,yvert1,tx+tw,ty,color,alpha);
-      draw_vertex_texture_color(xvert1,yvert2,tx,ty+th,color,alpha);
-      draw_vertex_texture_color(xvert2,yvert2,tx+tw,ty+th,color,alpha);
-      draw_primitive_end();
+      enigma::draw_batch_quad(texId, xvert1,yvert1, xvert2,yvert1, xvert2,yvert2, xvert1,yvert2,
+                              tx,ty, tx+tw,ty+th, color, alpha);
       yvert1 = yvert2;
       yvert2 += spr2d.height;
     }
@@ -390,6 +372,7 @@ void draw_sprite_tiled_ext(int spr, int subimg, gs_scalar x, gs_scalar y, gs_sca
     int usi = spr2d.ModSubimage(subimg);
 
   const TexRect& texRect = spr2d.GetTextureRect(usi);
+  const int texId = spr2d.GetTexture(usi);
   
   const gs_scalar
     tx = texRect.x, tw = texRect.w,
@@ -409,12 +392,8 @@ void draw_sprite_tiled_ext(int spr, int subimg, gs_scalar x, gs_scalar y, gs_sca
     yvert1 = -y; yvert2 = yvert1 + height_scaled;
     for (int c=0; c<vertil; ++c)
     {
-      draw_primitive_begin_texture(pr_trianglestrip, spr2d.GetTexture(usi));
-      draw_vertex_texture_color(xvert1,yvert1,tx,ty,color,alpha);
-      draw_vertex_texture_color(xvert2,yvert1,tx+tw,ty,color,alpha);
-      draw_vertex_texture_color(xvert1,yvert2,tx,ty+th,color,alpha);
-      draw_vertex_texture_color(xvert2,yvert2,tx+tw,ty+th,color,alpha);
-      draw_primitive_end();
+      enigma::draw_batch_quad(texId, xvert1,yvert1, xvert2,yvert1, xvert2,yvert2, xvert1,yvert2,
+                              tx,ty, tx+tw,ty+th, color, alpha);
       yvert1 = yvert2;
       yvert2 += height_scaled;
     }
@@ -423,4 +402,48 @@ void draw_sprite_tiled_ext(int spr, int subimg, gs_scalar x, gs_scalar y, gs_sca
   }
 }
 
+void vertex_instance_sprite(int buffer, int spr, int subimg, gs_scalar x, gs_scalar y, gs_scalar xscale, gs_scalar yscale, double rot, int color, gs_scalar alpha)
+{
+  const Sprite& spr2d = sprites.get(spr);
+  const TexRect& texRect = spr2d.GetTextureRect(spr2d.ModSubimage(subimg));
+  rot *= M_PI / -180.0;
+
+  // the unit quad scaled to the sprite, moved to its origin and rotated
+  // about it, as in draw_sprite_ext
+  gs_scalar
+    rx = cos(rot), ry = sin(rot),
+    w = xscale * spr2d.width, h = yscale * spr2d.height,
+    x1 = -xscale * spr2d.xoffset, y1 = -yscale * spr2d.yoffset;
+  vertex_float4(buffer, rx * w, -ry * h, 0, x + rotx(x1, y1, rx, ry));
+  vertex_float4(buffer, ry * w, rx * h, 0, y + roty(x1, y1, rx, ry));
+  vertex_float4(buffer, 0, 0, 1, 0);
+  vertex_color(buffer, color, CLAMP_ALPHAF(alpha));
+  vertex_float4(buffer, texRect.x, texRect.y, texRect.w, texRect.h);
+}
+
+void draw_sprite_instanced(int spr, int subimg, int instances)
+{
+  // a unit quad that the instances place and texture
+  static int quad = -1;
+  if (!vertex_exists(quad)) {
+    vertex_format_begin();
+    vertex_format_add_position();
+    vertex_format_add_textcoord();
+    vertex_format_add_color();
+    quad = vertex_create_buffer();
+    vertex_begin(quad, vertex_format_end());
+    const gs_scalar corners[] = {0,0, 1,0, 1,1, 0,0, 1,1, 0,1};
+    for (int i = 0; i < 12; i += 2) {
+      vertex_position(quad, corners[i], corners[i + 1]);
+      vertex_texcoord(quad, corners[i], corners[i + 1]);
+      vertex_color(quad, c_white, 1);
+    }
+    vertex_end(quad);
+    vertex_freeze(quad);
+  }
+
+  const Sprite& spr2d = sprites.get(spr);
+  vertex_submit_instanced(quad, pr_trianglelist, spr2d.GetTexture(spr2d.ModSubimage(subimg)), instances);
+}
+
 }
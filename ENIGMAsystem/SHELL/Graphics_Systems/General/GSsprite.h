@@ -28,6 +28,15 @@
 #  define DEFAULT_ALPHA draw_get_alpha()
 #endif
 
+namespace enigma
+{
+
+// whether instance culling is enabled and the sprite as draw_sprite_ext would
+// draw it is outside the view, which lets the default draw event skip it
+bool draw_sprite_culled(int spr, gs_scalar x, gs_scalar y, gs_scalar xscale, gs_scalar yscale, double rot);
+
+}
+
 namespace enigma_user
 {
 
@@ -44,6 +53,13 @@ void draw_sprite_part_ext(int spr, int subimg, gs_scalar left, gs_scalar top, gs
 void draw_sprite_tiled_ext(int spr, int subimg, gs_scalar x, gs_scalar y, gs_scalar xscale, gs_scalar yscale, int color = c_white, gs_scalar alpha = DEFAULT_ALPHA);
 void draw_sprite_padded(int spr, int subimg, gs_scalar left, gs_scalar top, gs_scalar right, gs_scalar bottom, gs_scalar x1, gs_scalar y1, gs_scalar x2, gs_scalar y2, int color = c_white, gs_scalar alpha = DEFAULT_ALPHA);
 
+// writes an instance into a vertex_instance_format buffer that places the
+// subimage the way draw_sprite_ext would
+void vertex_instance_sprite(int buffer, int spr, int subimg, gs_scalar x, gs_scalar y, gs_scalar xscale = 1, gs_scalar yscale = 1, double rot = 0, int color = c_white, gs_scalar alpha = DEFAULT_ALPHA);
+// draws all of the instances with the subimage's texture in one call, so the
+// subimages written into them have to share it like they do on an atlas
+void draw_sprite_instanced(int spr, int subimg, int instances);
+
   int sprite_create_from_screen(int x, int y, int w, int h, bool removeback, bool smooth, bool preload, int xorig, int yorig);
   int sprite_create_from_screen(int x, int y, int w, int h, bool removeback, bool smooth, int xorig, int yorig);
   void sprite_add_from_screen(int id, int x, int y, int w, int h, bool removeback, bool smooth);
@@ -18,6 +18,7 @@
 
 #include "GSprimitives.h"
 #include "GSstdraw.h"
+#include "GScapture.h"
 #include "GScolors.h"
 
 #include "Universal_System/roomsystem.h"
@@ -43,7 +44,12 @@ float circleprecision=24, drawPointSize=1.0f, drawLineWidth=1.0f;
 int drawFillMode=enigma_user::rs_solid, lineStippleScale=1;
 
 // handler for when a generic rendering state has changed
-void draw_set_state_dirty(bool dirty) { drawStateDirty = dirty; }
+void draw_set_state_dirty(bool dirty) {
+  // queued quads were recorded under the state that is about to change
+  if (dirty) draw_render_queue_submit();
+  drawStateDirty = dirty;
+}
+void draw_set_sortable_state_dirty() { drawStateDirty = true; }
 bool draw_get_state_dirty() { return drawStateDirty; }
 
 } // namespace enigma
@@ -67,6 +73,7 @@ void draw_state_flush() {
   flushing = true; // we are now flushing the state
 
   enigma::graphics_state_flush();
+  if (enigma::captureRecording) enigma::capture_record_state();
   drawStateDirty = false; // state is not dirty now
 
   flushing = false; // done flushing state
@@ -32,6 +32,9 @@ extern float drawPointSize, drawLineWidth;
 extern int drawFillMode, lineStippleScale;
 
 void draw_set_state_dirty(bool dirty=true);
+// marks the state dirty for a change to what queued quads record themselves,
+// their texture, blend mode and color, which need not draw the render queue
+void draw_set_sortable_state_dirty();
 bool draw_get_state_dirty();
 
 void graphics_state_flush();
@@ -0,0 +1,81 @@
+/** This file is a part of the ENIGMA Development Environment.
+***
+*** ENIGMA is free software: you can redistribute it and/or modify it under the
+*** terms of the GNU General Public License as published by the Free Software
+*** Foundation, version 3 of the license or any later version.
+***
+*** This application and its source code is distributed AS-IS, WITHOUT ANY
+*** WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+*** FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+*** details.
+***
+*** You should have received a copy of the GNU General Public License along
+*** with this code. If not, see <http://www.gnu.org/licenses/>
+**/
+
+#include "GSstream_ring.h"
+
+#include <algorithm>
+
+namespace enigma {
+
+unsigned char* HostStreamRingStorage::map(std::size_t size) {
+  memory.resize(size);
+  return memory.data();
+}
+
+void HostStreamRingStorage::unmap() {
+  std::vector<unsigned char>().swap(memory);
+}
+
+StreamRingStorage::Fence HostStreamRingStorage::fence() {
+  pending.push_back(++next);
+  return next;
+}
+
+void HostStreamRingStorage::wait(Fence fence) {
+  auto it = std::find(pending.begin(), pending.end(), fence);
+  if (it == pending.end()) return;
+  pending.erase(it);
+  ++waited;
+}
+
+StreamRing::StreamRing(std::unique_ptr<StreamRingStorage> storage, std::size_t segment_size):
+  storage(std::move(storage)), size(segment_size) {
+  base = this->storage->map(size * segments);
+}
+
+StreamRing::~StreamRing() {
+  if (!base) return;
+  for (StreamRingStorage::Fence& fence : fences) {
+    if (fence) storage->wait(fence);
+  }
+  storage->unmap();
+}
+
+void StreamRing::next_segment() {
+  // everything reading the segment we are leaving has been issued by now
+  fences[generation % segments] = storage->fence();
+  ++generation;
+  StreamRingStorage::Fence& fence = fences[generation % segments];
+  if (fence) {
+    storage->wait(fence);
+    fence = 0;
+  }
+  head = 0;
+}
+
+unsigned char* StreamRing::allocate(std::size_t bytes, std::size_t alignment, Allocation* allocation) {
+  if (!base || bytes > size) return nullptr;
+  std::size_t offset = (head + alignment - 1) / alignment * alignment;
+  if (offset + bytes > size) {
+    next_segment();
+    offset = 0;
+  }
+  head = offset + bytes;
+  allocation->offset = (generation % segments) * size + offset;
+  allocation->generation = generation;
+  return base + allocation->offset;
+}
+
+} // namespace enigma
@@ -0,0 +1,114 @@
+/** This file is a part of the ENIGMA Development Environment.
+***
+*** ENIGMA is free software: you can redistribute it and/or modify it under the
+*** terms of the GNU General Public License as published by the Free Software
+*** Foundation, version 3 of the license or any later version.
+***
+*** This application and its source code is distributed AS-IS, WITHOUT ANY
+*** WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+*** FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+*** details.
+***
+*** You should have received a copy of the GNU General Public License along
+*** with this code. If not, see <http://www.gnu.org/licenses/>
+**/
+
+#ifdef INCLUDED_FROM_SHELLMAIN
+#  error This file includes non-ENIGMA STL headers and should not be included from SHELLmain.
+#endif
+
+#ifndef ENIGMA_GSSTREAM_RING_H
+#define ENIGMA_GSSTREAM_RING_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace enigma {
+
+// The memory behind a StreamRing: one buffer object that is mapped once for
+// its whole life, plus fences telling when the GPU has finished reading
+// what was written to it before the fence.
+class StreamRingStorage {
+ public:
+  typedef uintptr_t Fence; // 0 is never a fence
+
+  virtual ~StreamRingStorage() {}
+
+  // creates the buffer and maps all of it, returning nullptr when
+  // persistent mapping isn't available so the caller can fall back
+  virtual unsigned char* map(std::size_t size) = 0;
+  virtual void unmap() = 0;
+
+  // inserts a fence after every command issued so far
+  virtual Fence fence() = 0;
+  // blocks until the fence has passed, then releases it
+  virtual void wait(Fence fence) = 0;
+};
+
+// Host memory with fences that pass as soon as they are waited on, so the
+// ring can be used and tested without a GPU.
+class HostStreamRingStorage : public StreamRingStorage {
+ public:
+  unsigned char* map(std::size_t size) override;
+  void unmap() override;
+  Fence fence() override;
+  void wait(Fence fence) override;
+
+  std::size_t fences_pending() const { return pending.size(); }
+  std::size_t waits() const { return waited; }
+
+ private:
+  std::vector<unsigned char> memory;
+  std::vector<Fence> pending;
+  Fence next = 0;
+  std::size_t waited = 0;
+};
+
+// A persistently mapped buffer split into segments that the CPU fills in
+// turn while the GPU reads the ones before. Leaving a segment fences it and
+// entering one waits on the fence it was left with, so nothing is written
+// while the GPU may still read it and the driver never has to orphan or
+// reallocate anything.
+class StreamRing {
+ public:
+  static const unsigned segments = 3;
+
+  struct Allocation {
+    std::size_t offset = 0; // from the start of the buffer, in bytes
+    uint64_t generation = 0; // segment it was made in, counting every switch
+  };
+
+  StreamRing(std::unique_ptr<StreamRingStorage> storage, std::size_t segment_size);
+  ~StreamRing();
+
+  // whether the storage could be mapped, the ring is unusable otherwise
+  bool ready() const { return base != nullptr; }
+  std::size_t segment_size() const { return size; }
+  StreamRingStorage* get_storage() const { return storage.get(); }
+
+  // returns where size bytes may be written until the ring comes back
+  // around, or nullptr if they would not fit in one segment; all of the
+  // draws reading from earlier allocations must have been issued already
+  unsigned char* allocate(std::size_t size, std::size_t alignment, Allocation* allocation);
+
+  // whether what was written to an allocation is still there to be drawn
+  bool valid(const Allocation& allocation) const {
+    return generation - allocation.generation < segments;
+  }
+
+ private:
+  std::unique_ptr<StreamRingStorage> storage;
+  unsigned char* base = nullptr;
+  std::size_t size;
+  std::size_t head = 0; // next free byte in the current segment
+  uint64_t generation = segments; // never valid for a default Allocation
+  StreamRingStorage::Fence fences[segments] = {};
+
+  void next_segment();
+};
+
+} // namespace enigma
+
+#endif // ENIGMA_GSSTREAM_RING_H
@@ -72,8 +72,9 @@ void graphics_copy_texture(int source, int destination, int x, int y) {
 }
 
 void graphics_copy_texture_part(int source, int destination, int xoff, int yoff, int w, int h, int x, int y) {
-  unsigned sw = textures[source]->width, sh = textures[source]->height,
+  unsigned sw = w, sh = h,
            sfw = textures[source]->fullwidth, sfh = textures[source]->fullheight;
+  if (xoff < 0 || yoff < 0 || w <= 0 || h <= 0 || unsigned(xoff) >= sfw || unsigned(yoff) >= sfh) return;
   unsigned char* bitmap = graphics_copy_texture_pixels(source, &sfw, &sfh);
 
   if (xoff+sw>sfw) sw = sfw-xoff;
@@ -160,7 +161,9 @@ gs_scalar texture_get_texel_height(int texid)
 
 void texture_set_stage(int stage, int texid) {
   if (enigma::samplers[stage].texture == texid) return;
-  enigma::draw_set_state_dirty();
+  // queued quads record their own texture, which is always on the first stage
+  if (stage == 0) enigma::draw_set_sortable_state_dirty();
+  else enigma::draw_set_state_dirty();
   enigma::samplers[stage].texture = texid;
 }
 
@@ -170,7 +173,7 @@ int texture_get_stage(int stage) {
 
 void texture_reset() {
   if (enigma::samplers[0].texture == -1) return;
-  enigma::draw_set_state_dirty();
+  enigma::draw_set_sortable_state_dirty();
   enigma::samplers[0].texture = -1;
 }
 
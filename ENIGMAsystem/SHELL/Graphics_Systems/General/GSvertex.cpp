@@ -28,11 +28,15 @@
 #include "GSvertex_impl.h"
 #include "GSprimitives.h"
 #include "GStextures.h"
+#include "GScolors.h"
+#include "GScapture.h"
 
 #include "Widget_Systems/widgets_mandatory.h"
 
 #include <unordered_map>
 #include <memory>
+#include <algorithm>
+#include <cmath>
 
 namespace {
 
@@ -47,6 +51,157 @@ enigma::VertexFormat currentVertexFormat;
 
 #define RESOURCE_EXISTS(id, container) return (id >= 0 && (unsigned)id < enigma::container.size() && enigma::container[id] != nullptr);
 
+// returns the id of a logically unique vertex format, adding it if it's new
+int vertex_format_register(const enigma::VertexFormat& format) {
+  auto search = vertexFormatCache.find(format.hash);
+  if (search != vertexFormatCache.end()) return search->second;
+  const int id = enigma::vertexFormats.size();
+  enigma::vertexFormats.emplace_back(new enigma::VertexFormat(format));
+  vertexFormatCache[format.hash] = id;
+  return id;
+}
+
+// multiplies two packed colors channel by channel, which works for whatever
+// order the backend packs them in
+enigma::color_t color_modulate(enigma::color_t a, enigma::color_t b) {
+  enigma::color_t result = 0;
+  for (int shift = 0; shift < 32; shift += 8)
+    result |= ((((a >> shift) & 255) * ((b >> shift) & 255) + 127) / 255) << shift;
+  return result;
+}
+
+// the format instances of a buffer are expanded into on the CPU, which is the
+// buffer's own with 3D positions and a color added if it doesn't have one
+int instance_expanded_format(int format) {
+  using namespace enigma_user;
+
+  static std::unordered_map<int, int> expandedFormats;
+  auto search = expandedFormats.find(format);
+  if (search != expandedFormats.end()) return search->second;
+
+  enigma::VertexFormat expanded;
+  bool colored = false;
+  for (const auto& flag : enigma::vertexFormats[format]->flags) {
+    if (flag.second == vertex_usage_position && flag.first < vertex_type_float3) {
+      expanded.AddAttribute(vertex_type_float3, flag.second);
+    } else {
+      expanded.AddAttribute(flag.first, flag.second);
+    }
+    colored |= (flag.second == vertex_usage_color && flag.first == vertex_type_color);
+  }
+  if (!colored) expanded.AddAttribute(vertex_type_color, vertex_usage_color);
+  return expandedFormats[format] = vertex_format_register(expanded);
+}
+
+// writes every instance into the target buffer, doing to the vertices what
+// the default shader does when instancing in hardware, and returns how many
+// vertices each instance took
+size_t instance_expand(int target, int buffer, unsigned offset, unsigned start, unsigned count, int instances) {
+  using namespace enigma_user;
+
+  const auto& vertexBuffer = enigma::vertexBuffers[buffer];
+  const auto& vertexFormat = enigma::vertexFormats[vertexBuffer->format];
+  const auto& source = vertexBuffer->vertices;
+  const auto& instanceData = enigma::vertexBuffers[instances]->vertices;
+  const size_t stride = vertexFormat->stride;
+  const size_t first = offset / sizeof(enigma::VertexElement) + start * stride;
+  if (!stride || first >= source.size()) return 0;
+  count = std::min<size_t>(count, (source.size() - first) / stride);
+  const size_t instance_count = instanceData.size() / enigma::instance_stride;
+  if (!count || !instance_count) return 0;
+
+  const int expandedFormat = instance_expanded_format(vertexBuffer->format);
+  vertex_begin(target, expandedFormat);
+  auto& vertices = enigma::vertexBuffers[target]->vertices;
+  vertices.reserve(count * instance_count * enigma::vertexFormats[expandedFormat]->stride);
+
+  // vertices without a color of their own take the draw color like they
+  // would in the default shader
+  bool colored = false;
+  for (const auto& flag : vertexFormat->flags)
+    colored |= (flag.second == vertex_usage_color && flag.first == vertex_type_color);
+  const enigma::color_t drawColor = enigma::graphics_pack_vertex_color(draw_get_color(), draw_get_alpha());
+
+  for (size_t i = 0; i < instance_count; ++i) {
+    const enigma::VertexElement* instance = &instanceData[i * enigma::instance_stride];
+    const gs_scalar* m[3] = {&instance[0].f, &instance[4].f, &instance[8].f};
+    const enigma::color_t color = instance[12].d;
+    const gs_scalar tu = instance[13].f, tv = instance[14].f, tw = instance[15].f, th = instance[16].f;
+
+    for (size_t v = 0; v < count; ++v) {
+      const enigma::VertexElement* vertex = &source[first + v * stride];
+      bool positioned = false, normaled = false, textured = false, tinted = false;
+      for (const auto& flag : vertexFormat->flags) {
+        const size_t size = (flag.first <= vertex_type_float4) ? flag.first - vertex_type_float1 + 1 : 1;
+        if (flag.second == vertex_usage_position && !positioned) {
+          const gs_scalar x = vertex[0].f, y = size > 1 ? vertex[1].f : 0, z = size > 2 ? vertex[2].f : 0;
+          for (int r = 0; r < 3; ++r)
+            vertices.push_back(m[r][0] * x + m[r][1] * y + m[r][2] * z + m[r][3]);
+          if (size > 3) vertices.push_back(vertex[3].f);
+          positioned = true;
+        } else if (flag.second == vertex_usage_normal && size == 3 && !normaled) {
+          for (int r = 0; r < 3; ++r)
+            vertices.push_back(m[r][0] * vertex[0].f + m[r][1] * vertex[1].f + m[r][2] * vertex[2].f);
+          normaled = true;
+        } else if (flag.second == vertex_usage_textcoord && size >= 2 && !textured) {
+          vertices.push_back(tu + vertex[0].f * tw);
+          vertices.push_back(tv + vertex[1].f * th);
+          vertices.insert(vertices.end(), vertex + 2, vertex + size);
+          textured = true;
+        } else if (flag.second == vertex_usage_color && flag.first == vertex_type_color && !tinted) {
+          vertices.push_back(color_modulate(vertex[0].d, color));
+          tinted = true;
+        } else {
+          vertices.insert(vertices.end(), vertex, vertex + size);
+        }
+        vertex += size;
+      }
+      if (!colored) vertices.push_back(color_modulate(drawColor, color));
+    }
+  }
+  vertex_end(target);
+  return count;
+}
+
+// draws instances by expanding them into a stream buffer
+void instance_draw_expanded(int buffer, int primitive, unsigned offset, unsigned start, unsigned count, int instances) {
+  using namespace enigma_user;
+
+  static int stream = -1;
+  if (!vertex_exists(stream)) {
+    stream = vertex_create_buffer();
+    enigma::vertexBuffers[stream]->streamed = true;
+  }
+  count = instance_expand(stream, buffer, offset, start, count, instances);
+  if (!count) return;
+  const size_t instance_count = enigma::vertexBuffers[stream]->getNumber() / count;
+
+  // strips and fans would join one instance to the next, so those have to
+  // be drawn one instance at a time, but they still share one upload
+  if (primitive == pr_pointlist || primitive == pr_linelist || primitive == pr_trianglelist) {
+    vertex_submit_offset(stream, primitive, 0, 0, count * instance_count);
+  } else {
+    for (size_t i = 0; i < instance_count; ++i)
+      vertex_submit_offset(stream, primitive, 0, i * count, count);
+  }
+}
+
+// keeps both buffers in memory from now on so they can be expanded again,
+// complaining if they were already uploaded without being kept
+void instance_keep_in_memory(int buffer, int instances) {
+  auto& vertexBuffer = enigma::vertexBuffers[buffer];
+  auto& instanceBuffer = enigma::vertexBuffers[instances];
+  if (!vertexBuffer->shadowed && !vertexBuffer->dirty) {
+    DEBUG_MESSAGE("Vertex buffer " + enigma_user::toString(buffer) + " was uploaded before it was drawn instanced"
+                  " and has to be refilled to expand its instances", MESSAGE_TYPE::M_USER_ERROR);
+  }
+  if (!instanceBuffer->shadowed && !instanceBuffer->dirty) {
+    DEBUG_MESSAGE("Instance buffer " + enigma_user::toString(instances) + " was uploaded before it was drawn"
+                  " and has to be refilled to expand its instances", MESSAGE_TYPE::M_USER_ERROR);
+  }
+  vertexBuffer->shadowed = instanceBuffer->shadowed = true;
+}
+
 } // anonymous namespace
 
 namespace enigma {
@@ -55,6 +210,17 @@ vector<std::unique_ptr<VertexFormat>> vertexFormats;
 vector<std::unique_ptr<VertexBuffer>> vertexBuffers;
 vector<std::unique_ptr<IndexBuffer>> indexBuffers;
 
+bool color_swizzle(uint32_t from, uint32_t to, int (&order)[4]) {
+  if (from == to) return false;
+  for (int i = 0; i < 4; ++i) {
+    order[i] = -1;
+    for (int j = 0; j < 4; ++j)
+      if (((from >> (i * 8)) & 255) == ((to >> (j * 8)) & 255)) order[i] = j;
+    if (order[i] < 0) return false;
+  }
+  return true;
+}
+
 } // namespace enigma
 
 namespace enigma_user {
@@ -103,16 +269,7 @@ void vertex_format_add_custom(int type, int usage) {
 }
 
 int vertex_format_end() {
-  int id = -1;
-  auto search = vertexFormatCache.find(currentVertexFormat.hash);
-  if (search != vertexFormatCache.end()) {
-    id = search->second;
-  } else {
-    id = enigma::vertexFormats.size();
-    enigma::vertexFormats.emplace_back(new enigma::VertexFormat(currentVertexFormat));
-    vertexFormatCache[currentVertexFormat.hash] = id;
-  }
-  return id;
+  return vertex_format_register(currentVertexFormat);
 }
 
 bool vertex_format_exists(int id) {
@@ -145,6 +302,7 @@ int vertex_create_buffer_ext(unsigned size) {
 
 void vertex_delete_buffer(int buffer) {
   enigma::graphics_delete_vertex_buffer_peer(buffer);
+  if (enigma::captureHooked) enigma::capture_forget_buffer(buffer, false);
   enigma::vertexBuffers[buffer] = nullptr;
 }
 
@@ -209,6 +367,9 @@ void vertex_begin(int buffer, int format) {
   // if the vertex buffer hasn't been frozen, otherwise we just ignore it
   if (vertexBuffer->frozen) return;
   vertexBuffer->dirty = true;
+  // refilling a buffer usually puts back about as much as it had, so make
+  // room for that up front instead of growing into it
+  vertexBuffer->vertices.reserve(vertexBuffer->number);
 }
 
 void vertex_end(int buffer) {
@@ -218,51 +379,6 @@ void vertex_end(int buffer) {
   vertexBuffer->number = vertexBuffer->vertices.size();
 }
 
-void vertex_data(int buffer, const enigma::varargs& data) {
-  auto& vertexBuffer = enigma::vertexBuffers[buffer];
-  #ifdef DEBUG_MODE
-  if (!vertex_format_exists(vertexBuffer->format)) {
-    DEBUG_MESSAGE("Vertex format " + enigma_user::toString(vertexBuffer->format) +
-               " does not exist and is required for vertex_data to decode varargs", MESSAGE_TYPE::M_ERROR);
-    return;
-  }
-  #endif
-  const auto& vertexFormat = enigma::vertexFormats[vertexBuffer->format];
-  int attrIndex = 0;
-  for (int i = 0; i < data.argc;) {
-    attrIndex = attrIndex % vertexFormat->flags.size();
-    std::pair<int,int> attr = vertexFormat->flags[attrIndex++];
-    switch (attr.first) {
-      case vertex_type_float1:
-        vertex_float1(buffer, data.get(i++));
-        continue;
-      case vertex_type_float2:
-        vertex_float2(buffer, data.get(i), data.get(i + 1));
-        i += 2;
-        continue;
-      case vertex_type_float3:
-        vertex_float3(buffer, data.get(i), data.get(i + 1), data.get(i + 2));
-        i += 3;
-        continue;
-      case vertex_type_float4:
-        vertex_float4(buffer, data.get(i), data.get(i + 1), data.get(i + 2), data.get(i + 3));
-        i += 4;
-        continue;
-      case vertex_type_color:
-        vertex_argb(buffer, data.get(i++));
-        continue;
-      case vertex_type_ubyte4:
-        vertex_ubyte4(buffer, data.get(i), data.get(i + 1), data.get(i + 2), data.get(i + 3));
-        i += 4;
-        continue;
-    }
-
-    DEBUG_MESSAGE("Vertex format " + enigma_user::toString(vertexBuffer->format) +
-               " contains attribute with unknown type " + enigma_user::toString(attr.first), MESSAGE_TYPE::M_ERROR);
-    break;
-  }
-}
-
 void vertex_position(int buffer, gs_scalar x, gs_scalar y) {
   enigma::vertexBuffers[buffer]->vertices.push_back(x);
   enigma::vertexBuffers[buffer]->vertices.push_back(y);
@@ -334,6 +450,68 @@ void vertex_submit_offset(int buffer, int primitive, int texture, unsigned offse
   vertex_submit_offset(buffer, primitive, offset, start, count);
 }
 
+int vertex_instance_format() {
+  static int format = -1;
+  if (format == -1) {
+    enigma::VertexFormat instanceFormat;
+    for (int row = 0; row < 3; ++row)
+      instanceFormat.AddAttribute(vertex_type_float4, vertex_usage_textcoord);
+    instanceFormat.AddAttribute(vertex_type_color, vertex_usage_color);
+    instanceFormat.AddAttribute(vertex_type_float4, vertex_usage_textcoord);
+    format = vertex_format_register(instanceFormat);
+  }
+  return format;
+}
+
+void vertex_instance(int buffer, gs_scalar x, gs_scalar y, gs_scalar z, gs_scalar xscale, gs_scalar yscale, gs_scalar zscale,
+                     gs_scalar angle, int color, double alpha, gs_scalar u, gs_scalar v, gs_scalar uscale, gs_scalar vscale) {
+  // rotates about the z axis the same way d3d_transform_add_rotation_z does
+  const gs_scalar radians = gs_angle_to_radians(angle), c = std::cos(radians), s = std::sin(radians);
+  vertex_float4(buffer, c * xscale, s * yscale, 0, x);
+  vertex_float4(buffer, -s * xscale, c * yscale, 0, y);
+  vertex_float4(buffer, 0, 0, zscale, z);
+  vertex_color(buffer, color, alpha);
+  vertex_float4(buffer, u, v, uscale, vscale);
+}
+
+void vertex_instance_matrix(int buffer, const var& matrix, int color, double alpha,
+                            gs_scalar u, gs_scalar v, gs_scalar uscale, gs_scalar vscale) {
+  // the rows of the matrix as matrix_build lays them out
+  for (int row = 0; row < 3; ++row)
+    vertex_float4(buffer, matrix[row * 4], matrix[row * 4 + 1], matrix[row * 4 + 2], matrix[row * 4 + 3]);
+  vertex_color(buffer, color, alpha);
+  vertex_float4(buffer, u, v, uscale, vscale);
+}
+
+void vertex_submit_instanced(int buffer, int primitive, int instances) {
+  vertex_submit_instanced_offset(buffer, primitive, 0, 0, vertex_get_number(buffer), instances);
+}
+
+void vertex_submit_instanced(int buffer, int primitive, int texture, int instances) {
+  texture_set(texture);
+  vertex_submit_instanced(buffer, primitive, instances);
+}
+
+void vertex_submit_instanced_offset(int buffer, int primitive, unsigned offset, unsigned start, unsigned count, int instances) {
+  if (enigma::graphics_instancing_supported()) {
+    enigma::graphics_submit_instanced(buffer, primitive, offset, start, count, instances);
+    return;
+  }
+  instance_keep_in_memory(buffer, instances);
+  instance_draw_expanded(buffer, primitive, offset, start, count, instances);
+}
+
+unsigned vertex_instance_expand(int buffer, int instances, int target) {
+  if (target == buffer || target == instances) {
+    DEBUG_MESSAGE("Vertex buffer " + enigma_user::toString(target) + " can't be expanded into itself",
+                  MESSAGE_TYPE::M_USER_ERROR);
+    return 0;
+  }
+  instance_keep_in_memory(buffer, instances);
+  if (!instance_expand(target, buffer, 0, 0, vertex_get_number(buffer), instances)) return 0;
+  return vertex_get_number(target);
+}
+
 int index_create_buffer() {
   int id = enigma::indexBuffers.size();
   enigma::indexBuffers.push_back(std::make_unique<enigma::IndexBuffer>());
@@ -348,6 +526,7 @@ int index_create_buffer_ext(unsigned size) {
 
 void index_delete_buffer(int buffer) {
   enigma::graphics_delete_index_buffer_peer(buffer);
+  if (enigma::captureHooked) enigma::capture_forget_buffer(buffer, true);
   enigma::indexBuffers[buffer] = nullptr;
 }
 
@@ -416,7 +595,7 @@ void index_data(int buffer, const enigma::varargs& data) {
     if (indexBuffer->type == index_type_uint) {
       uint32_t ind = data.get(i);
       indexBuffer->indices.push_back(ind);
-      indexBuffer->indices.push_back(ind << 16);
+      indexBuffer->indices.push_back(ind >> 16);
     } else {
       indexBuffer->indices.push_back((uint16_t)data.get(i));
     }
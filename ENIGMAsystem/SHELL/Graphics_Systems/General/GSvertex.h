@@ -80,6 +80,11 @@ void vertex_clear(int buffer);
 void vertex_begin(int buffer, int format = -1);
 void vertex_end(int buffer);
 void vertex_data(int buffer, const enigma::varargs& data);
+// copies whole vertices of the buffer's format out of a binary buffer, from
+// the byte offset on, returning how many there were room for; every element
+// is 4 bytes, floats as IEEE singles and colors as vertex_argb takes them
+unsigned vertex_data_buffer(int buffer, int data);
+unsigned vertex_data_buffer(int buffer, int data, unsigned offset, unsigned count);
 void vertex_position(int buffer, gs_scalar x, gs_scalar y);
 void vertex_position_3d(int buffer, gs_scalar x, gs_scalar y, gs_scalar z);
 void vertex_normal(int buffer, gs_scalar nx, gs_scalar ny, gs_scalar nz);
@@ -99,6 +104,25 @@ void vertex_submit_range(int buffer, int primitive, int texture, unsigned start,
 void vertex_submit_offset(int buffer, int primitive, unsigned offset, unsigned start, unsigned count);
 void vertex_submit_offset(int buffer, int primitive, int texture, unsigned offset, unsigned start, unsigned count);
 
+// Instances draw a vertex buffer once for every instance in another vertex
+// buffer of vertex_instance_format, transforming, coloring and offsetting the
+// texture coordinates of each copy. Backends without hardware instancing, or
+// a bound shader without the instance attributes, expand them on the CPU,
+// which needs the buffer's vertices to still be in memory the first time.
+int vertex_instance_format();
+void vertex_instance(int buffer, gs_scalar x, gs_scalar y, gs_scalar z, gs_scalar xscale, gs_scalar yscale, gs_scalar zscale,
+                     gs_scalar angle, int color, double alpha,
+                     gs_scalar u = 0, gs_scalar v = 0, gs_scalar uscale = 1, gs_scalar vscale = 1);
+void vertex_instance_matrix(int buffer, const var& matrix, int color, double alpha,
+                            gs_scalar u = 0, gs_scalar v = 0, gs_scalar uscale = 1, gs_scalar vscale = 1);
+void vertex_submit_instanced(int buffer, int primitive, int instances);
+void vertex_submit_instanced(int buffer, int primitive, int texture, int instances);
+void vertex_submit_instanced_offset(int buffer, int primitive, unsigned offset, unsigned start, unsigned count, int instances);
+// writes the instances into another buffer the way they are expanded on the
+// CPU, so they can be drawn or frozen as one; returns its number of vertices,
+// or 0 with the buffer left alone if there was nothing to expand
+unsigned vertex_instance_expand(int buffer, int instances, int target);
+
 enum {
   index_type_ushort,
   index_type_uint
@@ -0,0 +1,166 @@
+/** This file is a part of the ENIGMA Development Environment.
+***
+*** ENIGMA is free software: you can redistribute it and/or modify it under the
+*** terms of the GNU General Public License as published by the Free Software
+*** Foundation, version 3 of the license or any later version.
+***
+*** This application and its source code is distributed AS-IS, WITHOUT ANY
+*** WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+*** FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+*** details.
+***
+*** You should have received a copy of the GNU General Public License along
+*** with this code. If not, see <http://www.gnu.org/licenses/>
+**/
+
+// Bulk vertex writes, which decode the buffer's format once and fill whole
+// vertices in place rather than going through the vertex functions one
+// attribute at a time. They are kept out of GSvertex.cpp so that those
+// small functions stay inlined the way they were.
+
+#include "GSvertex_impl.h"
+
+#include "Universal_System/buffers_internal.h"
+#include "Widget_Systems/widgets_mandatory.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+// repacks colors given the way vertex_argb takes them, as 0xAARRGGBB, into
+// the backend's own layout
+class ArgbRepacker {
+ public:
+  ArgbRepacker(): swizzle(enigma::color_swizzle(0xFF010203, enigma::graphics_pack_vertex_color(0x030201, 1.0), order)) {}
+
+  bool needed() const { return swizzle; }
+  enigma::color_t operator()(uint32_t argb) const { return swizzle ? enigma::color_swizzled(argb, order) : argb; }
+
+ private:
+  int order[4];
+  bool swizzle;
+};
+
+} // anonymous namespace
+
+namespace enigma_user {
+
+void vertex_data(int buffer, const enigma::varargs& data) {
+  auto& vertexBuffer = enigma::vertexBuffers[buffer];
+  #ifdef DEBUG_MODE
+  if (!vertex_format_exists(vertexBuffer->format)) {
+    DEBUG_MESSAGE("Vertex format " + enigma_user::toString(vertexBuffer->format) +
+               " does not exist and is required for vertex_data to decode varargs", MESSAGE_TYPE::M_ERROR);
+    return;
+  }
+  #endif
+  const auto& vertexFormat = enigma::vertexFormats[vertexBuffer->format];
+
+  // every attribute takes one argument per element except ubyte4, which
+  // takes four for its one element
+  size_t args = 0;
+  for (const auto& attr : vertexFormat->flags) {
+    if (attr.first > vertex_type_ubyte4) {
+      DEBUG_MESSAGE("Vertex format " + enigma_user::toString(vertexBuffer->format) +
+                 " contains attribute with unknown type " + enigma_user::toString(attr.first), MESSAGE_TYPE::M_ERROR);
+      return;
+    }
+    args += (attr.first == vertex_type_ubyte4) ? 4 : (attr.first == vertex_type_color) ? 1 : attr.first - vertex_type_float1 + 1;
+  }
+  if (!args) return;
+  const size_t count = data.argc / args;
+  #ifdef DEBUG_MODE
+  if (count * args != size_t(data.argc)) {
+    DEBUG_MESSAGE("vertex_data was given " + enigma_user::toString(data.argc % args) + " arguments past the last whole"
+                  " vertex of format " + enigma_user::toString(vertexBuffer->format), MESSAGE_TYPE::M_ERROR);
+  }
+  #endif
+
+  // make room for all of the vertices at once and fill them in place
+  const ArgbRepacker repack;
+  auto& vertices = vertexBuffer->vertices;
+  size_t element = vertices.size();
+  vertices.resize(element + count * vertexFormat->stride, gs_scalar(0));
+  int i = 0;
+  for (size_t v = 0; v < count; ++v) {
+    for (const auto& attr : vertexFormat->flags) {
+      switch (attr.first) {
+        case vertex_type_float4: vertices[element++].f = data.get(i++); // fallthrough
+        case vertex_type_float3: vertices[element++].f = data.get(i++); // fallthrough
+        case vertex_type_float2: vertices[element++].f = data.get(i++); // fallthrough
+        case vertex_type_float1: vertices[element++].f = data.get(i++); break;
+        case vertex_type_color: vertices[element++].d = repack(data.get(i++)); break;
+        case vertex_type_ubyte4: {
+          const unsigned char u1 = data.get(i), u2 = data.get(i + 1), u3 = data.get(i + 2), u4 = data.get(i + 3);
+          vertices[element++].d = (u1 << 24) | (u2 << 16) | (u3 << 8) | u4;
+          i += 4;
+          break;
+        }
+      }
+    }
+  }
+}
+
+unsigned vertex_data_buffer(int buffer, int data) {
+  get_bufferr(binbuff, data, 0);
+  const auto& vertexBuffer = enigma::vertexBuffers[buffer];
+  if (!vertex_format_exists(vertexBuffer->format)) return 0;
+  return vertex_data_buffer(buffer, data, 0, binbuff->data.size() / enigma::vertexFormats[vertexBuffer->format]->stride_size);
+}
+
+unsigned vertex_data_buffer(int buffer, int data, unsigned offset, unsigned count) {
+  get_bufferr(binbuff, data, 0);
+  auto& vertexBuffer = enigma::vertexBuffers[buffer];
+  if (!vertex_format_exists(vertexBuffer->format)) {
+    DEBUG_MESSAGE("Vertex format " + enigma_user::toString(vertexBuffer->format) +
+               " does not exist and is required for vertex_data_buffer to read vertices", MESSAGE_TYPE::M_ERROR);
+    return 0;
+  }
+  const auto& vertexFormat = enigma::vertexFormats[vertexBuffer->format];
+  const size_t stride = vertexFormat->stride, size = binbuff->data.size();
+  if (offset >= size) return 0;
+  count = std::min<size_t>(count, (size - offset) / vertexFormat->stride_size);
+  if (!count) return 0;
+
+  // every element of every type is 4 bytes, which in single precision builds
+  // are the elements themselves
+  const unsigned char* bytes = binbuff->data.data() + offset;
+  auto& vertices = vertexBuffer->vertices;
+  const size_t first = vertices.size(), elements = count * stride;
+  if (sizeof(enigma::VertexElement) == 4 && uintptr_t(bytes) % alignof(enigma::VertexElement) == 0) {
+    // one copy straight out of the buffer, without filling the room first
+    const enigma::VertexElement* source = reinterpret_cast<const enigma::VertexElement*>(bytes);
+    vertices.insert(vertices.end(), source, source + elements);
+  } else if (sizeof(enigma::VertexElement) == 4) {
+    vertices.resize(first + elements, gs_scalar(0));
+    memcpy(&vertices[first], bytes, elements * 4);
+  } else {
+    vertices.resize(first + elements, gs_scalar(0));
+    for (size_t e = 0; e < elements; ++e) {
+      float f;
+      memcpy(&f, bytes + e * 4, 4);
+      vertices[first + e].f = f;
+    }
+  }
+
+  // colors and ubyte4 are words rather than floats, and colors come the way
+  // vertex_argb takes them, so they are only touched when that isn't how
+  // the backend packs them or when they were widened above
+  const ArgbRepacker repack;
+  if (!repack.needed() && sizeof(enigma::VertexElement) == 4) return count;
+  size_t element = first;
+  for (size_t v = 0; v < count; ++v) {
+    for (const auto& attr : vertexFormat->flags) {
+      if (attr.first == vertex_type_color || attr.first == vertex_type_ubyte4) {
+        uint32_t packed;
+        memcpy(&packed, bytes + (element - first) * 4, 4);
+        vertices[element].d = (attr.first == vertex_type_color) ? repack(packed) : packed;
+      }
+      element += (attr.first <= vertex_type_float4) ? attr.first - vertex_type_float1 + 1 : 1;
+    }
+  }
+  return count;
+}
+
+} // namespace enigma_user
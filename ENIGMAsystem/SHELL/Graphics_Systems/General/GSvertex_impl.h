@@ -99,19 +99,49 @@ union VertexElement {
   VertexElement(color_t v): d(v) {}
 };
 
+// packs a color the way the backend's vertex_color stores it in a vertex
+color_t graphics_pack_vertex_color(int color, double alpha);
+
+// where each byte of a color packed in one layout goes in the other, with
+// the layouts given as their packing of the color 0x030201 at full alpha;
+// false if they are the same or either can't be told apart
+bool color_swizzle(uint32_t from, uint32_t to, int (&order)[4]);
+
+// moves the bytes of a packed color where color_swizzle said they go
+inline color_t color_swizzled(uint32_t packed, const int (&order)[4]) {
+  color_t color = 0;
+  for (int b = 0; b < 4; ++b) color |= color_t((packed >> (b * 8)) & 255) << (order[b] * 8);
+  return color;
+}
+
+// number of elements in each instance of vertex_instance_format: the rows of
+// an affine transform as three float4, the packed color and then the offset
+// and scale of the texture coordinates as a float4
+const std::size_t instance_stride = 17;
+
+// whether the backend and the bound shader can draw instances in hardware
+bool graphics_instancing_supported();
+// draws count vertices of the buffer once per instance in the instance
+// buffer, which is only called when graphics_instancing_supported
+void graphics_submit_instanced(int buffer, int primitive, unsigned offset, unsigned start, unsigned count, int instances);
+
 struct VertexBuffer {
   vector<VertexElement> vertices; // interleaved vertex elements
   bool frozen; // whether vertex_freeze has been called
   bool dynamic; // if the user wants to update the buffer infrequently
   bool dirty; // whether the user has begun specifying new vertex data
+  bool streamed; // whether the engine refills it before every draw
+  bool shadowed; // whether vertices are kept after upload to expand instances from
   int format; // index of the vertex format describing this buffer
   std::size_t number; // cached size of vertices
 
   // NOTE: dynamic does not mean updating the buffer every frame!
   // NOTE: format may not exist when this buffer is first created
   // NOTE: number is only intended to be accessed with getNumber()!
+  // NOTE: streamed contents are only drawable until the next refill,
+  //       which lets backends put them in a stream ring
 
-  VertexBuffer(): frozen(false), dynamic(false), dirty(false), format(-1), number(0) {}
+  VertexBuffer(): frozen(false), dynamic(false), dirty(false), streamed(false), shadowed(false), format(-1), number(0) {}
 
   // returns the number of vertex elements in the buffer
   int getNumber() const {
@@ -124,7 +154,9 @@ struct VertexBuffer {
   // only clear them leaving the reserved capacity
   // for future primitives to be specified
   void clearData() {
-    if (frozen) {
+    if (shadowed) {
+      // the CPU still needs these to draw instances from
+    } else if (frozen) {
       // this will give us 0 size and 0 capacity
       std::vector<enigma::VertexElement>().swap(vertices);
     } else {
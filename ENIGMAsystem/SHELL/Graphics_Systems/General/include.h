@@ -23,3 +23,4 @@
 #include "actions.h"
 #include "texture_atlas.h"
 #include "GSpolygon.h"
+#include "GScapture.h"
@@ -16,13 +16,19 @@
 **/
 
 #include <algorithm>    // std::sort
+#include <cmath>
+#include <map>
+#include <set>
 
 #include "texture_atlas.h"
 #include "texture_atlas_internal.h"
+#include "GStextures_impl.h"
 
 #include "Universal_System/Resources/backgrounds_internal.h"
 #include "Universal_System/Resources/fonts_internal.h"
 #include "Universal_System/Resources/sprites_internal.h"
+#include "Universal_System/Instances/callbacks_events.h"
+#include "Universal_System/roomsystem.h"
 
 #include "Universal_System/nlpo2.h"
 #include "Graphics_Systems/graphics_mandatory.h"
@@ -31,184 +37,284 @@
 using std::unordered_map;
 using std::vector;
 
-namespace enigma {
-  struct TextureAtlasRect{
-    unsigned int metric = 0;
-    unsigned int size = 0;
-    TextureAtlasRect(unsigned int m, unsigned int s) : metric(m), size(s) {}
-    const bool operator<(TextureAtlasRect const &rhs) const{
-      return this->size < rhs.size;
-    }
-  };
+namespace {
 
-  unordered_map<unsigned int, texture_atlas> texture_atlas_array;
-  size_t texture_atlas_idmax = 0;
+// One image to place on an atlas page: a sprite subimage, a background, or a
+// font's whole glyph texture (which is already packed, so its glyphs move as one).
+// It is the w x h rect at x, y of its texture, which may be another page;
+// tw and th are what the owner's texture coordinates are normalized to.
+struct AtlasPiece {
+  int type, id, subimage;
+  int texture, x, y, w, h;
+  gs_scalar tw, th;
+};
 
-  bool textures_pack(int ta, bool free_textures){
-    // Implement packing algorithm.
-    vector<texture_element> &textures = texture_atlas_array[ta].textures;
-    vector<enigma::rect_packer::pvrect> metrics(textures.size()); //This means every resource has only one image
-    for (unsigned int i = 0; i < textures.size(); i++){ //This adds the rest of the images
-      switch (textures[i].type){
-        case 0: { //Add all sprite subimages
-          enigma::Sprite& sspr = enigma::sprites.get(textures[i].id);
-          for (size_t s = 0; s < sspr.SubimageCount(); s++){
-            metrics.emplace_back();
-          }
-        } break;
-        case 2: { //Add font glyps
-          //We remove one as it's the font resource itself, but we only need glyps
-          metrics.erase(metrics.begin());
-          enigma::SpriteFont *fnt = &enigma::sprite_fonts[textures[i].id];
-          for (size_t g = 0; g < fnt->glyphRanges.size(); g++) {
-            enigma::fontglyphrange& fgr = fnt->glyphRanges[g];
-            for (size_t s = 0; s < fgr.glyphs.size(); s++){
-              metrics.emplace_back();
-            }
-          }
-        } break;
-        default: break; //We do nothing for the rest
-      }
+bool is_atlas_page(int texture) {
+  for (const auto& atlas : enigma::texture_atlas_array) {
+    if (atlas.second.texture == texture) return true;
+  }
+  return false;
+}
+
+AtlasPiece texture_piece(int type, int id, int subimage, int texture, const enigma::TexRect& bounds, int w, int h) {
+  const gs_scalar tw = enigma::textures[texture]->fullwidth, th = enigma::textures[texture]->fullheight;
+  return {type, id, subimage, texture, int(std::lround(bounds.x * tw)), int(std::lround(bounds.y * th)), w, h, tw, th};
+}
+
+// A font on a page covers the bounding box of its glyphs there.
+AtlasPiece font_piece(int id, const enigma::SpriteFont& fnt) {
+  if (!is_atlas_page(fnt.texture))
+    return {2, id, 0, fnt.texture, 0, 0, int(fnt.twid), int(fnt.thgt), gs_scalar(fnt.twid), gs_scalar(fnt.thgt)};
+  const gs_scalar tw = enigma::textures[fnt.texture]->fullwidth, th = enigma::textures[fnt.texture]->fullheight;
+  gs_scalar x1 = tw, y1 = th, x2 = 0, y2 = 0;
+  for (const enigma::fontglyphrange& fgr : fnt.glyphRanges) {
+    for (const enigma::fontglyph& g : fgr.glyphs) {
+      x1 = std::min(x1, g.tx * tw), y1 = std::min(y1, g.ty * th);
+      x2 = std::max(x2, g.tx2 * tw), y2 = std::max(y2, g.ty2 * th);
     }
+  }
+  const int x = std::floor(x1), y = std::floor(y1);
+  return {2, id, 0, fnt.texture, x, y, std::max(int(std::ceil(x2)) - x, 0), std::max(int(std::ceil(y2)) - y, 0), tw, th};
+}
+
+// Transparent gap kept to the right of and below each piece, so filtering at
+// a piece's edge doesn't pick up its neighbour.
+const int kAtlasGutter = 1;
 
-    unsigned int counter = 0;
-    for (unsigned int i = 0; i < textures.size(); i++){
-      // TODO: This should maybe crop the images so it's totally fit (this can be done on compile time by LGM or compiler even, but it's possible the user has loaded the image at runtime)
-      switch (textures[i].type){
-        case 0: { //Metrics all sprite subimages
-          enigma::Sprite& sspr = enigma::sprites.get(textures[i].id);
-          for (size_t s = 0; s < sspr.SubimageCount(); s++){
-            metrics[counter].w = sspr.width, metrics[counter].h = sspr.height;
-            counter++;
-          }
-        } break;
-        case 1: { //Metrics for backgrounds
-          const enigma::Background& bkg = enigma::backgrounds.get(textures[i].id);
-          metrics[counter].w = bkg.width, metrics[counter].h = bkg.height;
-          counter++;
-        } break;
-        case 2: { //Metrics for font glyps
-          enigma::SpriteFont *fnt = &enigma::sprite_fonts[textures[i].id];
-          for (size_t g = 0; g < fnt->glyphRanges.size(); g++) {
-            enigma::fontglyphrange& fgr = fnt->glyphRanges[g];
-            for (size_t s = 0; s < fgr.glyphs.size(); s++){
-              metrics[counter].w = fgr.glyphs[s].x2-fgr.glyphs[s].x, metrics[counter].h = fgr.glyphs[s].y2-fgr.glyphs[s].y;
-              counter++;
-            }
-          }
-        } break;
-        default: break; //We do nothing for the rest (there shouldn't be any "rest")
+// Sprites and backgrounds still packed in the resource module are only
+// loaded for it when load is set, otherwise they are left out and false is
+// returned, so that automatic packing doesn't undo lazy loading.
+bool collect_pieces(const enigma::texture_element& e, vector<AtlasPiece>* out, bool load) {
+  switch (e.type) {
+    case 0: {
+      if (!enigma::sprites.exists(e.id)) break;
+      const enigma::Sprite& spr = enigma::sprites[e.id];
+      if (!load && !spr.IsLoaded()) return false;
+      for (size_t s = 0; s < spr.SubimageCount(); s++) {
+        int tex = spr.GetTexture(s);
+        if (tex != -1) out->push_back(texture_piece(0, e.id, s, tex, spr.GetTextureRect(s), spr.width, spr.height));
       }
-    }
+    } break;
+    case 1: {
+      if (!enigma::backgrounds.exists(e.id)) break;
+      const enigma::Background& bkg = load ? enigma::backgrounds.get(e.id) : enigma::backgrounds[e.id];
+      if (!load && bkg.textureID == -1 && bkg.pending) return false;
+      if (bkg.textureID != -1)
+        out->push_back(texture_piece(1, e.id, 0, bkg.textureID, bkg.textureBounds, bkg.width, bkg.height));
+    } break;
+    case 2: {
+      if (!enigma::sprite_fonts.exists(e.id)) break;
+      const enigma::SpriteFont& fnt = enigma::sprite_fonts.get(e.id);
+      if (fnt.texture != -1) out->push_back(font_piece(e.id, fnt));
+    } break;
+    default: break;
+  }
+  return true;
+}
 
-    vector<TextureAtlasRect> boxes;
-    boxes.reserve(metrics.size());
-    for (unsigned int i = 0; i < metrics.size(); i++){
-      boxes.emplace_back(i,metrics[i].w * metrics[i].h);
-    }
-    std::sort(boxes.begin(), boxes.end());
+// Places pieces on a w x h page, largest first. Placed pieces get their
+// position in rects; the indices of those that did not fit are returned.
+vector<size_t> place_pieces(const vector<AtlasPiece>& pieces, vector<enigma::rect_packer::pvrect>* rects,
+                            unsigned w, unsigned h) {
+  using namespace enigma::rect_packer;
+  rects->assign(pieces.size(), pvrect());
+  vector<size_t> order(pieces.size());
+  for (size_t i = 0; i < pieces.size(); i++) {
+    order[i] = i;
+    (*rects)[i].w = pieces[i].w + kAtlasGutter;
+    (*rects)[i].h = pieces[i].h + kAtlasGutter;
+  }
+  std::sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+    return pieces[a].w * pieces[a].h > pieces[b].w * pieces[b].h;
+  });
 
-    unsigned int w = 64, h = 64; //Minimum atlas size
-    if (texture_atlas_array[ta].width > 0 && texture_atlas_array[ta].height > 0){
-      w = texture_atlas_array[ta].width, h = texture_atlas_array[ta].height;
+  vector<size_t> unplaced;
+  rectpnode plane(0, 0, w, h);
+  for (size_t i : order) {
+    if (rectpnode *node = rninsert(&plane, i, rects->data())) {
+      (*rects)[i].x = node->x, (*rects)[i].y = node->y;
+      (*rects)[i].placed = 1;
+    } else {
+      unplaced.push_back(i);
     }
-    enigma::rect_packer::rectpnode *rectplane = new enigma::rect_packer::rectpnode(0,0,w,h);
-    unsigned int max_textures = 0;
-    for (auto i = boxes.rbegin(); i != boxes.rend();){
-      unsigned int indx = (*i).metric;
-      enigma::rect_packer::rectpnode *nn = enigma::rect_packer::rninsert(rectplane, indx, &metrics.front());
-      if (nn){
-        enigma::rect_packer::rncopy(nn, &metrics.front(), indx),
-        i++;
-        max_textures++;
-      } else {
-        if (texture_atlas_array[ta].width != -1 && texture_atlas_array[ta].height != -1){
-          break; //We are already at max size
+  }
+  return unplaced;
+}
+
+// Copies a placed piece onto the page and points its owner at the new texture.
+void copy_piece(const AtlasPiece& piece, const enigma::rect_packer::pvrect& rect,
+                const enigma::texture_atlas& page) {
+  const gs_scalar pw = page.width, ph = page.height;
+  enigma::graphics_copy_texture_part(piece.texture, page.texture, piece.x, piece.y, piece.w, piece.h, rect.x, rect.y);
+
+  switch (piece.type) {
+    case 0: {
+      enigma::Sprite& spr = enigma::sprites.get(piece.id);
+      spr.SetTexture(piece.subimage, page.texture, enigma::TexRect(rect.x / pw, rect.y / ph, piece.w / pw, piece.h / ph));
+    } break;
+    case 1: {
+      enigma::Background& bkg = enigma::backgrounds.get(piece.id);
+      bkg.textureID = page.texture;
+      bkg.textureBounds = enigma::TexRect(rect.x / pw, rect.y / ph, piece.w / pw, piece.h / ph);
+      bkg.pending = enigma::PendingImage();  // The page can't be restored from the module.
+    } break;
+    case 2: {
+      enigma::SpriteFont& fnt = enigma::sprite_fonts.get(piece.id);
+      for (enigma::fontglyphrange& fgr : fnt.glyphRanges) {
+        for (enigma::fontglyph& g : fgr.glyphs) {
+          g.tx  = (rect.x - piece.x + g.tx  * piece.tw) / pw;
+          g.ty  = (rect.y - piece.y + g.ty  * piece.th) / ph;
+          g.tx2 = (rect.x - piece.x + g.tx2 * piece.tw) / pw;
+          g.ty2 = (rect.y - piece.y + g.ty2 * piece.th) / ph;
         }
-        w > h ? h <<= 1 : w <<= 1,
-        rectplane = enigma::rect_packer::expand(rectplane, w, h);
-        if (!w or !h) return false;
       }
-    }
+      fnt.texture = page.texture;
+    } break;
+    default: break;
+  }
+}
 
-    if (texture_atlas_array[ta].width == -1 || texture_atlas_array[ta].height == -1){
-      texture_atlas_array[ta].width = w;
-      texture_atlas_array[ta].height = h;
-      if (enigma::texture_atlas_array[ta].texture != -1){
-        graphics_delete_texture(texture_atlas_array[ta].texture);
-      }
-      texture_atlas_array[ta].texture = graphics_create_texture(RawImage(nullptr, w, h), false);
+// Every texture a sprite, background or font currently draws from.
+std::set<int> textures_in_use() {
+  std::set<int> used;
+  for (const auto& spr : enigma::sprites) spr.second.CollectTextures(&used);
+  for (const auto& bkg : enigma::backgrounds) {
+    if (bkg.second.textureID != -1) used.insert(bkg.second.textureID);
+  }
+  for (const auto& fnt : enigma::sprite_fonts) {
+    if (fnt.second.texture != -1) used.insert(fnt.second.texture);
+  }
+  return used;
+}
+
+// Frees the given textures, except pages and those that resources which were
+// not moved still draw from.
+void free_unused_textures(const std::set<int>& textures) {
+  if (textures.empty()) return;
+  const std::set<int> used = textures_in_use();
+  for (int tex : textures) {
+    if (!used.count(tex) && !is_atlas_page(tex)) enigma::graphics_delete_texture(tex);
+  }
+}
+
+// Copies every placed piece and returns the textures they came from; those
+// can be shared, so none may be freed until all copies are made.
+std::set<int> copy_pieces(const vector<AtlasPiece>& pieces, const vector<enigma::rect_packer::pvrect>& rects,
+                          const enigma::texture_atlas& page) {
+  std::set<int> copied;
+  for (size_t i = 0; i < pieces.size(); i++) {
+    if (rects[i].placed != 1) continue;
+    copy_piece(pieces[i], rects[i], page);
+    copied.insert(pieces[i].texture);
+  }
+  return copied;
+}
+
+// Automatic atlas mode.
+bool atlas_auto = false;
+unsigned atlas_page_size = 2048;
+std::set<std::pair<int, int>> atlas_auto_packed;  // (type, id) already on a page
+vector<int> atlas_auto_pages;
+
+// Packs the resources onto as few new fixed-size pages as it takes. Those
+// not loaded yet are left for a later room that loads them.
+void pack_auto_pages(const vector<enigma::texture_element>& elements) {
+  vector<AtlasPiece> pieces;
+  for (const enigma::texture_element& e : elements) {
+    if (atlas_auto_packed.count({e.type, e.id})) continue;
+    if (collect_pieces(e, &pieces, false)) atlas_auto_packed.insert({e.type, e.id});
+  }
+
+  // Anything bigger than a page keeps its own texture.
+  const int max_piece = int(atlas_page_size) - kAtlasGutter;
+  pieces.erase(std::remove_if(pieces.begin(), pieces.end(), [&](const AtlasPiece& p) {
+    return p.w > max_piece || p.h > max_piece;
+  }), pieces.end());
+
+  while (!pieces.empty()) {
+    vector<enigma::rect_packer::pvrect> rects;
+    vector<size_t> unplaced = place_pieces(pieces, &rects, atlas_page_size, atlas_page_size);
+
+    int ta = enigma_user::texture_atlas_create(atlas_page_size, atlas_page_size);
+    const enigma::texture_atlas& page = enigma::texture_atlas_array[ta];
+    atlas_auto_pages.push_back(ta);
+    free_unused_textures(copy_pieces(pieces, rects, page));
+
+    vector<AtlasPiece> rest;
+    for (size_t i : unplaced) rest.push_back(pieces[i]);
+    pieces.swap(rest);
+  }
+}
+
+vector<enigma::texture_element> room_elements(const enigma::roomassets& group) {
+  vector<enigma::texture_element> elements;
+  for (int id : group.sprites) elements.emplace_back(id, 0);
+  for (int id : group.backgrounds) elements.emplace_back(id, 1);
+  for (int id : group.fonts) elements.emplace_back(id, 2);
+  return elements;
+}
+
+// Resources used by more than one room go on shared pages when the mode is
+// switched on, if they are loaded by then; the rest are packed per room as
+// each room is entered and loads them, so a room's pages hold what is drawn
+// together.
+void pack_shared_pages() {
+  std::map<std::pair<int, int>, int> uses;
+  for (int i = 0; i < enigma::room_loadtimecount; i++) {
+    for (const enigma::texture_element& e : room_elements(enigma::roomorder[i]->assets)) uses[{e.type, e.id}]++;
+  }
+  vector<enigma::texture_element> shared;
+  for (const auto& use : uses) {
+    if (use.second > 1) shared.emplace_back(use.first.second, use.first.first);
+  }
+  pack_auto_pages(shared);
+}
+
+void pack_room_pages() {
+  const int room = (int)enigma_user::room.rval.d;
+  if (!atlas_auto || !enigma_user::room_exists(room)) return;
+  pack_auto_pages(room_elements(enigma::roomdata[room]->assets));
+}
+
+}  // namespace
+
+namespace enigma {
+  unordered_map<unsigned int, texture_atlas> texture_atlas_array;
+  size_t texture_atlas_idmax = 0;
+
+  bool textures_pack(int ta, bool free_textures){
+    texture_atlas& atlas = texture_atlas_array[ta];
+    vector<AtlasPiece> pieces;
+    for (const texture_element& e : atlas.textures) collect_pieces(e, &pieces, true);
+
+    const bool fixed_size = atlas.width != -1 && atlas.height != -1;
+    unsigned int w = 64, h = 64; //Minimum atlas size
+    if (fixed_size) w = atlas.width, h = atlas.height;
+
+    // Grow a page to fit everything, unless its size was given.
+    vector<rect_packer::pvrect> rects;
+    while (!place_pieces(pieces, &rects, w, h).empty()) {
+      if (fixed_size) return false;
+      w > h ? h <<= 1 : w <<= 1;
+      if (w > 16384 || h > 16384) return false;
     }
 
-    counter = 0;
-    for (unsigned int i = 0; i < textures.size(); i++){
-      switch (textures[i].type){
-        case 0: { //Copy textures for all sprite subimages
-          enigma::Sprite& sspr = enigma::sprites.get(textures[i].id);
-          for (size_t s = 0; s < sspr.SubimageCount(); s++){
-            enigma::graphics_copy_texture(sspr.GetTexture(s), enigma::texture_atlas_array[ta].texture, metrics[counter].x, metrics[counter].y);
-            if (free_textures == true){
-              enigma::graphics_delete_texture(sspr.GetTexture(s));
-            }
-            sspr.SetTexture(s,
-              enigma::texture_atlas_array[ta].texture,
-              TexRect{(gs_scalar)metrics[counter].x/(gs_scalar)(enigma::texture_atlas_array[ta].width),
-                  (gs_scalar)metrics[counter].y/(gs_scalar)(enigma::texture_atlas_array[ta].height),
-                  (gs_scalar)sspr.width/(gs_scalar)(enigma::texture_atlas_array[ta].width),
-                  (gs_scalar)sspr.height/(gs_scalar)(enigma::texture_atlas_array[ta].height)
-              });
-            counter++;
-            if (counter > max_textures) { return false; }
-          }
-        } break;
-        case 1: { //Copy textures for all the backgrounds
-          enigma::Background& bkg = enigma::backgrounds.get(textures[i].id);
-          enigma::graphics_copy_texture(bkg.textureID, enigma::texture_atlas_array[ta].texture, metrics[counter].x, metrics[counter].y);
-          if (free_textures == true){
-            enigma::graphics_delete_texture(bkg.textureID);
-          }
-          bkg.textureID = enigma::texture_atlas_array[ta].texture;
-          enigma::TexRect& tr = bkg.textureBounds;
-          tr.x = (gs_scalar)metrics[counter].x/(gs_scalar)(enigma::texture_atlas_array[ta].width);
-          tr.y = (gs_scalar)metrics[counter].y/(gs_scalar)(enigma::texture_atlas_array[ta].height);
-          tr.w = (gs_scalar)bkg.width/(gs_scalar)(enigma::texture_atlas_array[ta].width);
-          tr.h = (gs_scalar)bkg.height/(gs_scalar)(enigma::texture_atlas_array[ta].height);
-
-          counter++;
-          if (counter > max_textures) { return false; }
-        } break;
-        case 2: { //Copy textures for all font glyps
-          ///This sometimes draws cut of letters - need to investigate!
-          enigma::SpriteFont *fnt = &enigma::sprite_fonts[textures[i].id];
-          for (size_t g = 0; g < fnt->glyphRanges.size(); g++) {
-            enigma::fontglyphrange& fgr = fnt->glyphRanges[g];
-            for (size_t s = 0; s < fgr.glyphs.size(); s++){
-              gs_scalar tix, tiy; //Calculate texture position in image space (pixels) instead of normalized 0-1. We sadly don't hold this information, but maybe we should
-              tix = (gs_scalar)fgr.glyphs[s].tx*(gs_scalar)fnt->twid;
-              tiy = (gs_scalar)fgr.glyphs[s].ty*(gs_scalar)fnt->thgt;
-
-              int gw = fgr.glyphs[s].x2-fgr.glyphs[s].x;
-              int gh = fgr.glyphs[s].y2-fgr.glyphs[s].y;
-
-              enigma::graphics_copy_texture_part(fnt->texture, enigma::texture_atlas_array[ta].texture, tix, tiy, gw, gh, metrics[counter].x, metrics[counter].y);
-
-              fgr.glyphs[s].tx = (gs_scalar)metrics[counter].x/(gs_scalar)(enigma::texture_atlas_array[ta].width);
-              fgr.glyphs[s].ty = (gs_scalar)metrics[counter].y/(gs_scalar)(enigma::texture_atlas_array[ta].height);
-              fgr.glyphs[s].tx2 = (gs_scalar)(metrics[counter].x+gw)/(gs_scalar)(enigma::texture_atlas_array[ta].width);
-              fgr.glyphs[s].ty2 = (gs_scalar)(metrics[counter].y+gh)/(gs_scalar)(enigma::texture_atlas_array[ta].height);
-
-              counter++;
-              if (counter > max_textures) { return false; }
-            }
-          }
-          if (free_textures == true){
-            enigma::graphics_delete_texture(fnt->texture);
-          }
-          fnt->texture = enigma::texture_atlas_array[ta].texture;
-        } break;
-        default: break; //We do nothing for the rest
-      }
+    // Pieces may come from this atlas's own page, so it is replaced rather
+    // than drawn over, and only freed once nothing draws from it.
+    const int old_texture = atlas.texture;
+    const bool repacking = std::any_of(pieces.begin(), pieces.end(), [&](const AtlasPiece& p) {
+      return p.texture == old_texture;
+    });
+    if (!fixed_size || repacking){
+      atlas.width = w;
+      atlas.height = h;
+      atlas.texture = graphics_create_texture(RawImage(nullptr, w, h), false);
     }
+
+    std::set<int> sources = copy_pieces(pieces, rects, atlas);
+    if (!free_textures) sources.clear();
+    if (old_texture != -1) sources.insert(old_texture);
+    free_unused_textures(sources);
     return true;
   }
 }
@@ -249,6 +355,43 @@ namespace enigma_user {
     enigma::texture_atlas_array.erase(id);
   }
 
+  void texture_atlas_pack_begin(int ta){
+    enigma::texture_atlas_array[ta].textures.clear();
+  }
+
+  void texture_atlas_pack_sprite(int ta, int spr){
+    enigma::texture_atlas_array[ta].textures.emplace_back(spr, 0);
+  }
+
+  void texture_atlas_pack_background(int ta, int bkg){
+    enigma::texture_atlas_array[ta].textures.emplace_back(bkg, 1);
+  }
+
+  void texture_atlas_pack_font(int ta, int fnt){
+    enigma::texture_atlas_array[ta].textures.emplace_back(fnt, 2);
+  }
+
+  bool texture_atlas_pack_end(int ta, bool free_textures){
+    return enigma::textures_pack(ta, free_textures);
+  }
+
+  void texture_atlas_set_auto(bool enable, int page_size){
+    const bool was_enabled = atlas_auto;
+    atlas_auto = enable;
+    atlas_page_size = enigma::nlpo2(page_size);
+    if (enable && !was_enabled){
+      static bool registered = false;
+      if (!registered) enigma::register_callback_room_start(pack_room_pages);
+      registered = true;
+      pack_shared_pages();
+      pack_room_pages();
+    }
+  }
+
+  int texture_atlas_auto_page_count(){
+    return atlas_auto_pages.size();
+  }
+
   //Manually add sprite at position (NOT RECOMMENDED)
   void texture_atlas_add_sprite_position(int ta, int sprid, int subimg, int x, int y, bool free_texture){
     ///TODO: NEEDS ERROR CHECKING
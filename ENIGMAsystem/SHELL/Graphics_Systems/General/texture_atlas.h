@@ -22,11 +22,18 @@ namespace enigma_user {
 int texture_atlas_create(int w = -1, int h = -1);
 //void texture_atlas_add_sprite(int tp, int spr);
 void texture_atlas_add_sprite_position(int tp, int spr, int subimg, int x, int y, bool free_texture = true);
-inline void texture_atlas_pack_begin(int tp);
-inline void texture_atlas_pack_sprite(int tp, int spr);
-inline void texture_atlas_pack_background(int tp, int bkg);
-inline void texture_atlas_pack_font(int tp, int fnt);
-inline bool texture_atlas_pack_end(int tp);
+void texture_atlas_pack_begin(int tp);
+void texture_atlas_pack_sprite(int tp, int spr);
+void texture_atlas_pack_background(int tp, int bkg);
+void texture_atlas_pack_font(int tp, int fnt);
+bool texture_atlas_pack_end(int tp, bool free_textures = true);
+/// Automatic mode: resources used by several rooms are packed onto shared
+/// pages right away, and the rest onto per-room pages as each room starts.
+/// Only images that are already loaded are packed, so lazily loaded ones wait
+/// for the room that uses them. Packed images stay resident; they are no
+/// longer restored from the module.
+void texture_atlas_set_auto(bool enable, int page_size = 2048);
+int texture_atlas_auto_page_count();
 }  //namespace enigma_user
 
 #endif
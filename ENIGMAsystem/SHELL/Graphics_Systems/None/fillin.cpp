@@ -20,6 +20,7 @@
 #include "Graphics_Systems/General/GStextures.h"
 #include "Graphics_Systems/General/GStiles.h"
 #include "Graphics_Systems/General/GSvertex.h"
+#include "Graphics_Systems/General/GSvertex_impl.h"
 #include "Graphics_Systems/General/GSsurface.h"
 #include "Graphics_Systems/General/GSstdraw.h"
 #include "Graphics_Systems/General/GSsprite.h"
@@ -70,9 +71,12 @@ namespace enigma
 
 	void graphics_delete_vertex_buffer_peer(int buffer) {}
 	void graphics_delete_index_buffer_peer(int buffer) {}
+	color_t graphics_pack_vertex_color(int color, double alpha) { return 0; }
 	void graphics_replace_texture_alpha_from_texture(int, int) {}
 	int graphics_duplicate_texture(int, bool) { return -1; }
 
+	bool draw_sprite_culled(int, gs_scalar, gs_scalar, gs_scalar, gs_scalar, double) { return false; }
+
 	void scene_begin() {}
 	void scene_end() {}
 	void delete_tiles() {}
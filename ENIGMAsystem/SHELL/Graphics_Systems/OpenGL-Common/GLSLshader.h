@@ -121,6 +121,7 @@ namespace enigma {
         GLint uni_fogStart;
         GLint uni_fogRange;
         GLint uni_alphaTestEnable;
+        GLint uni_instancingEnable;
 
         GLint uni_color;
         GLint uni_alphaTest;
@@ -158,10 +158,22 @@ in vec3 in_Normal;           // (x,y,z)
 in vec4 in_Color;            // (r,g,b,a)
 in vec2 in_TextureCoord;     // (u,v)
 
+// per instance when en_InstancingEnabled
+in vec4 in_InstanceTransform0; // rows of an affine transform
+in vec4 in_InstanceTransform1;
+in vec4 in_InstanceTransform2;
+in vec4 in_InstanceColor;
+in vec4 in_InstanceTextureRect; // offset and scale of the texture coordinates
+
 out vec2 v_TextureCoord;
 out vec4 v_Color;
 uniform int en_ActiveLights;
 uniform bool en_ColorEnabled;
+uniform bool en_InstancingEnabled;
+
+// the vertex after the instance transform, if any
+vec3 vertexPosition;
+vec3 vertexNormal;
 
 uniform bool en_LightingEnabled;
 uniform bool en_VS_FogEnabled;
@@ -194,8 +206,8 @@ uniform MaterialInfo Material;
 
 void getEyeSpace( inout vec3 norm, inout vec4 position )
 {
-  norm = normalize( normalMatrix * in_Normal );
-  position = modelViewMatrix * vec4(in_Position, 1.0);
+  norm = normalize( normalMatrix * vertexNormal );
+  position = modelViewMatrix * vec4(vertexPosition, 1.0);
 }
 
 vec4 phongModel( in vec3 norm, in vec4 position )
@@ -234,10 +246,20 @@ float linearstep(float A, float B, float X) {
 
 void main()
 {
+  vertexPosition = in_Position;
+  vertexNormal = in_Normal;
+  vec2 textureCoord = in_TextureCoord;
   vec4 iColor = en_BoundColor;
   if (en_ColorEnabled == true){
     iColor = in_Color;
   }
+  if (en_InstancingEnabled == true){
+    vec4 position = vec4(vertexPosition, 1.0);
+    vertexPosition = vec3(dot(in_InstanceTransform0, position), dot(in_InstanceTransform1, position), dot(in_InstanceTransform2, position));
+    vertexNormal = vec3(dot(in_InstanceTransform0.xyz, vertexNormal), dot(in_InstanceTransform1.xyz, vertexNormal), dot(in_InstanceTransform2.xyz, vertexNormal));
+    iColor *= in_InstanceColor;
+    textureCoord = in_InstanceTextureRect.xy + textureCoord * in_InstanceTextureRect.zw;
+  }
   if (en_LightingEnabled == true){
     vec3 eyeNorm;
     vec4 eyePosition;
@@ -248,14 +270,14 @@ void main()
   }
 
   if (en_VS_FogEnabled == true) {
-    vec4 eyePosition = (modelViewMatrix * vec4(in_Position.xyz, 1.0));
+    vec4 eyePosition = (modelViewMatrix * vec4(vertexPosition, 1.0));
     float fogAmount = linearstep(en_FogStart, en_RcpFogRange, abs(eyePosition.z));
     v_Color = mix(v_Color, en_FogColor, fogAmount);
   }
 
-  gl_Position = modelViewProjectionMatrix * vec4( in_Position.xyz, 1.0);
+  gl_Position = modelViewProjectionMatrix * vec4( vertexPosition, 1.0);
 
-  v_TextureCoord = in_TextureCoord;
+  v_TextureCoord = textureCoord;
 }
             )CODE";
   }
@@ -400,6 +422,7 @@ void main()
     shaderprograms[prog_id].uni_fogStart = enigma_user::glsl_get_uniform_location(prog_id, "en_FogStart");
     shaderprograms[prog_id].uni_fogRange = enigma_user::glsl_get_uniform_location(prog_id, "en_RcpFogRange");
     shaderprograms[prog_id].uni_alphaTestEnable = enigma_user::glsl_get_uniform_location(prog_id, "en_AlphaTestEnabled");
+    shaderprograms[prog_id].uni_instancingEnable = enigma_user::glsl_get_uniform_location(prog_id, "en_InstancingEnabled");
 
     shaderprograms[prog_id].uni_alphaTest = enigma_user::glsl_get_uniform_location(prog_id, "en_AlphaTestValue");
     shaderprograms[prog_id].uni_color = enigma_user::glsl_get_uniform_location(prog_id, "en_BoundColor");
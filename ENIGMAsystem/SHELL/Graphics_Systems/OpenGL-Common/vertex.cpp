@@ -20,6 +20,7 @@
 #include "profiler.h"
 #include "shader.h"
 #include "GLSLshader.h"
+#include "version.h"
 
 #include "OpenGLHeaders.h"
 #include "Graphics_Systems/General/GSvertex_impl.h"
@@ -27,8 +28,11 @@
 #include "Graphics_Systems/General/GScolors.h"
 #include "Graphics_Systems/General/GScolor_macros.h"
 #include "Graphics_Systems/General/GSstdraw.h"
+#include "Graphics_Systems/General/GScapture.h"
+#include "Graphics_Systems/General/GSstream_ring.h"
 
 #include <map>
+#include <string.h> // for memcpy
 
 using std::map;
 
@@ -41,6 +45,67 @@ GLenum primitive_types[] = { 0, GL_POINTS, GL_LINES, GL_LINE_STRIP, GL_TRIANGLES
 
 map<int, GLuint> vertexBufferPeers;
 map<int, GLuint> indexBufferPeers;
+// where the streamed vertex buffers were last written in the stream ring
+map<int, enigma::StreamRing::Allocation> vertexBufferStreams;
+
+// big enough for a full quad stream, with three of them in the ring
+const size_t stream_ring_segment_size = 4 << 20;
+
+#ifdef GL_MAP_PERSISTENT_BIT
+// a buffer object with immutable storage that stays mapped for writing,
+// coherently so that nothing has to be flushed before drawing from it
+class GLStreamRingStorage : public enigma::StreamRingStorage {
+ public:
+  GLuint buffer = 0;
+
+  unsigned char* map(size_t size) override {
+    if (!GLEW_ARB_buffer_storage) return nullptr;
+    const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    glGenBuffers(1, &buffer);
+    bind_array_buffer(buffer);
+    glBufferStorage(GL_ARRAY_BUFFER, size, NULL, flags);
+    return static_cast<unsigned char*>(glMapBufferRange(GL_ARRAY_BUFFER, 0, size, flags));
+  }
+
+  void unmap() override {
+    bind_array_buffer(buffer);
+    glUnmapBuffer(GL_ARRAY_BUFFER);
+    glDeleteBuffers(1, &buffer);
+    enigma::bound_vbo = 0;
+  }
+
+  Fence fence() override {
+    return reinterpret_cast<Fence>(glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0));
+  }
+
+  void wait(Fence fence) override {
+    GLsync sync = reinterpret_cast<GLsync>(fence);
+    while (glClientWaitSync(sync, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000) == GL_TIMEOUT_EXPIRED);
+    glDeleteSync(sync);
+  }
+};
+#endif
+
+// lazy create the stream ring, which lives as long as the context does;
+// returns null when persistent mapping isn't supported
+enigma::StreamRing* get_stream_ring(GLuint* buffer) {
+#ifdef GL_MAP_PERSISTENT_BIT
+  static enigma::StreamRing* ring = nullptr;
+  static bool tried = false;
+  if (!tried) {
+    tried = true;
+    ring = new enigma::StreamRing(std::make_unique<GLStreamRingStorage>(), stream_ring_segment_size);
+    if (!ring->ready()) {
+      delete ring;
+      ring = nullptr;
+    }
+  }
+  if (ring) *buffer = static_cast<GLStreamRingStorage*>(ring->get_storage())->buffer;
+  return ring;
+#else
+  return nullptr;
+#endif
+}
 
 } // anonymous namespace
 
@@ -49,6 +114,7 @@ namespace enigma {
 void graphics_delete_vertex_buffer_peer(int buffer) {
   glDeleteBuffers(1, &vertexBufferPeers[buffer]);
   vertexBufferPeers.erase(buffer);
+  vertexBufferStreams.erase(buffer);
 }
 
 void graphics_delete_index_buffer_peer(int buffer) {
@@ -56,6 +122,10 @@ void graphics_delete_index_buffer_peer(int buffer) {
   indexBufferPeers.erase(buffer);
 }
 
+color_t graphics_pack_vertex_color(int color, double alpha) {
+  return color + (CLAMP_ALPHA(alpha) << 24);
+}
+
 static inline int graphics_find_attribute_location(std::string name, int usageIndex) {
   int location = -1;
   if (usageIndex == 0) {
@@ -67,7 +137,46 @@ static inline int graphics_find_attribute_location(std::string name, int usageIn
   return location;
 }
 
-void graphics_prepare_buffer(const int buffer, const bool isIndex) {
+// copies a streamed vertex buffer into the stream ring instead of having the
+// driver reallocate its own buffer object, returning false when it has to
+// go through its peer anyway
+static bool graphics_prepare_stream_buffer(const int buffer, size_t* offset) {
+  GLuint ringBuffer;
+  StreamRing* ring = get_stream_ring(&ringBuffer);
+  if (!ring) return false;
+
+  auto& vertexBuffer = vertexBuffers[buffer];
+  if (vertexBuffer->dirty) {
+    const size_t size = enigma_user::vertex_get_buffer_size(buffer);
+    StreamRing::Allocation allocation;
+    unsigned char* data = ring->allocate(size, 16, &allocation);
+    if (!data) {
+      vertexBufferStreams.erase(buffer);
+      return false;
+    }
+    memcpy(data, vertexBuffer->vertices.data(), size);
+    vertexBuffer->clearData();
+    vertexBufferStreams[buffer] = allocation;
+  }
+
+  auto it = vertexBufferStreams.find(buffer);
+  if (it == vertexBufferStreams.end()) return false;
+  if (!ring->valid(it->second)) {
+    vertexBufferStreams.erase(it);
+    return false;
+  }
+  bind_array_buffer(ringBuffer);
+  *offset = it->second.offset;
+  return true;
+}
+
+// binds the buffer's peer, first updating it if the buffer is dirty, and
+// returns the offset of the buffer's contents in what was bound
+size_t graphics_prepare_buffer(const int buffer, const bool isIndex) {
+  size_t offset = 0;
+  if (!isIndex && vertexBuffers[buffer]->streamed && graphics_prepare_stream_buffer(buffer, &offset))
+    return offset;
+
   const bool dirty = isIndex ? indexBuffers[buffer]->dirty : vertexBuffers[buffer]->dirty;
   const bool frozen = isIndex ? indexBuffers[buffer]->frozen : vertexBuffers[buffer]->frozen;
   const bool dynamic = isIndex ? indexBuffers[buffer]->dynamic : vertexBuffers[buffer]->dynamic;
@@ -83,7 +192,7 @@ void graphics_prepare_buffer(const int buffer, const bool isIndex) {
     } else {
       bind_array_buffer(it->second);
     }
-    return;
+    return 0;
   }
 
   size_t size = isIndex ? enigma_user::index_get_buffer_size(buffer) : enigma_user::vertex_get_buffer_size(buffer);
@@ -116,6 +225,7 @@ void graphics_prepare_buffer(const int buffer, const bool isIndex) {
   } else {
     vertexBuffers[buffer]->clearData();
   }
+  return 0;
 }
 
 void graphics_apply_vertex_format(int format, size_t offset) {
@@ -194,6 +304,65 @@ void graphics_apply_vertex_format(int format, size_t offset) {
   glsl_uniformi_internal(shaderprograms[bound_shader].uni_colorEnable, useColors);
 }
 
+// points the default shader's instance attributes at the bound buffer so
+// that they advance once per instance, or back to once per vertex with a
+// divisor of 0 so that other shaders can use the same locations
+static void graphics_apply_instance_format(size_t offset, GLuint divisor) {
+#if defined(GL_VERSION_3_3) || defined(GL_ES_VERSION_3_0)
+  static const char* names[] = {
+    "in_InstanceTransform0", "in_InstanceTransform1", "in_InstanceTransform2", "in_InstanceColor", "in_InstanceTextureRect"
+  };
+  const size_t stride = instance_stride * sizeof(VertexElement);
+  for (int i = 0; i < 5; ++i) {
+    const int location = enigma_user::glsl_get_attribute_location(bound_shader, names[i]);
+    if (location == -1) continue;
+    if (divisor) {
+      const bool color = (i == 3);
+      glsl_attribute_enable_internal(location, true);
+      glsl_attribute_set_internal(location, 4, color ? GL_UNSIGNED_BYTE : GL_FLOAT, color, stride, offset);
+    }
+    glVertexAttribDivisor(location, divisor);
+    offset += (i == 3 ? 1 : 4) * sizeof(VertexElement);
+  }
+#endif
+}
+
+bool graphics_instancing_supported() {
+#if defined(GL_VERSION_3_3) || defined(GL_ES_VERSION_3_0)
+  return gl_major >= 3 && shaderprograms[bound_shader].uni_instancingEnable != -1;
+#else
+  return false;
+#endif
+}
+
+void graphics_submit_instanced(int buffer, int primitive, unsigned offset, unsigned start, unsigned count, int instances) {
+#if defined(GL_VERSION_3_3) || defined(GL_ES_VERSION_3_0)
+  enigma_user::draw_state_flush();
+  capture_draw_instanced(buffer, primitive, offset, start, count, instances);
+
+  const auto& vertexBuffer = vertexBuffers[buffer];
+  const GLsizei instance_count = enigma_user::vertex_get_buffer_size(instances) / (instance_stride * sizeof(VertexElement));
+
+  #ifdef DEBUG_MODE
+  enigma::GPUProfilerBatch& vbd = enigma::gpuprof.add_drawcall();
+  ++vbd.drawcalls;
+  #endif
+
+  // attribute pointers capture the buffer bound when they are set, so each
+  // buffer's attributes are set right after it is bound
+  const size_t base = graphics_prepare_buffer(buffer, false);
+  graphics_apply_vertex_format(vertexBuffer->format, base + offset);
+  const size_t instance_base = graphics_prepare_buffer(instances, false);
+  graphics_apply_instance_format(instance_base, 1);
+  glsl_uniformi_internal(shaderprograms[bound_shader].uni_instancingEnable, 1);
+
+  glDrawArraysInstanced(primitive_types[primitive], start, count, instance_count);
+
+  glsl_uniformi_internal(shaderprograms[bound_shader].uni_instancingEnable, 0);
+  graphics_apply_instance_format(0, 0);
+#endif
+}
+
 } // namespace enigma
 
 namespace enigma_user {
@@ -204,12 +373,12 @@ void vertex_argb(int buffer, unsigned argb) {
 }
 
 void vertex_color(int buffer, int color, double alpha) {
-  enigma::color_t finalcol = color + (CLAMP_ALPHA(alpha) << 24);
-  enigma::vertexBuffers[buffer]->vertices.push_back(finalcol);
+  enigma::vertexBuffers[buffer]->vertices.push_back(enigma::graphics_pack_vertex_color(color, alpha));
 }
 
 void vertex_submit_offset(int buffer, int primitive, unsigned offset, unsigned start, unsigned count) {
   draw_state_flush();
+  enigma::capture_draw(buffer, primitive, offset, start, count);
 
   const auto& vertexBuffer = enigma::vertexBuffers[buffer];
 
@@ -218,14 +387,15 @@ void vertex_submit_offset(int buffer, int primitive, unsigned offset, unsigned s
   ++vbd.drawcalls;
   #endif
 
-  enigma::graphics_prepare_buffer(buffer, false);
-  enigma::graphics_apply_vertex_format(vertexBuffer->format, offset);
+  const size_t base = enigma::graphics_prepare_buffer(buffer, false);
+  enigma::graphics_apply_vertex_format(vertexBuffer->format, base + offset);
 
 	glDrawArrays(primitive_types[primitive], start, count);
 }
 
 void index_submit_range(int buffer, int vertex, int primitive, unsigned start, unsigned count) {
   draw_state_flush();
+  enigma::capture_draw_indexed(buffer, vertex, primitive, start, count);
 
   const auto& vertexBuffer = enigma::vertexBuffers[vertex];
   const auto& indexBuffer = enigma::indexBuffers[buffer];
@@ -235,9 +405,9 @@ void index_submit_range(int buffer, int vertex, int primitive, unsigned start, u
   ++vbd.drawcalls;
   #endif
 
-  enigma::graphics_prepare_buffer(vertex, false);
+  const size_t base = enigma::graphics_prepare_buffer(vertex, false);
   enigma::graphics_prepare_buffer(buffer, true);
-  enigma::graphics_apply_vertex_format(vertexBuffer->format, 0);
+  enigma::graphics_apply_vertex_format(vertexBuffer->format, base);
 
   GLenum indexType = GL_UNSIGNED_SHORT;
   if (indexBuffer->type == index_type_uint) {
@@ -24,6 +24,7 @@
 #include "Graphics_Systems/General/GSprimitives.h"
 #include "Graphics_Systems/General/GScolor_macros.h"
 #include "Graphics_Systems/General/GSstdraw.h"
+#include "Graphics_Systems/General/GScapture.h"
 
 #include <map>
 using std::map;
@@ -138,6 +139,18 @@ void graphics_delete_index_buffer_peer(int buffer) {
   }
 }
 
+color_t graphics_pack_vertex_color(int color, double alpha) {
+  return color + (CLAMP_ALPHA(alpha) << 24);
+}
+
+// the fixed function pipeline has nowhere to apply per-instance attributes,
+// so instances are always expanded on the CPU
+bool graphics_instancing_supported() {
+  return false;
+}
+
+void graphics_submit_instanced(int buffer, int primitive, unsigned offset, unsigned start, unsigned count, int instances) {}
+
 GLvoid* graphics_prepare_buffer(const int buffer, const bool isIndex) {
   if (vbo_is_supported) {
     graphics_prepare_buffer_peer(buffer, isIndex);
@@ -253,12 +266,12 @@ void vertex_argb(int buffer, unsigned argb) {
 }
 
 void vertex_color(int buffer, int color, double alpha) {
-  enigma::color_t finalcol = color + (CLAMP_ALPHA(alpha) << 24);
-  enigma::vertexBuffers[buffer]->vertices.push_back(finalcol);
+  enigma::vertexBuffers[buffer]->vertices.push_back(enigma::graphics_pack_vertex_color(color, alpha));
 }
 
 void vertex_submit_offset(int buffer, int primitive, unsigned offset, unsigned start, unsigned count) {
   draw_state_flush();
+  enigma::capture_draw(buffer, primitive, offset, start, count);
 
   const auto& vertexBuffer = enigma::vertexBuffers[buffer];
 
@@ -272,6 +285,7 @@ void vertex_submit_offset(int buffer, int primitive, unsigned offset, unsigned s
 
 void index_submit_range(int buffer, int vertex, int primitive, unsigned start, unsigned count) {
   draw_state_flush();
+  enigma::capture_draw_indexed(buffer, vertex, primitive, start, count);
 
   const auto& vertexBuffer = enigma::vertexBuffers[vertex];
   const auto& indexBuffer = enigma::indexBuffers[buffer];
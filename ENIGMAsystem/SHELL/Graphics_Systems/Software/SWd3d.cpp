@@ -0,0 +1,79 @@
+/** This file is a part of the ENIGMA Development Environment.
+***
+*** ENIGMA is free software: you can redistribute it and/or modify it under the
+*** terms of the GNU General Public License as published by the Free Software
+*** Foundation, version 3 of the license or any later version.
+***
+*** This application and its source code is distributed AS-IS, WITHOUT ANY
+*** WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+*** FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+*** details.
+***
+*** You should have received a copy of the GNU General Public License along
+*** with this code. If not, see <http://www.gnu.org/licenses/>
+**/
+
+#include "SWraster.h"
+#include "Graphics_Systems/General/GSd3d.h"
+#include "Graphics_Systems/General/GStextures.h"
+#include "Graphics_Systems/General/GSblend.h"
+#include "Graphics_Systems/General/GSstdraw.h"
+#include "Graphics_Systems/General/GScolors.h"
+#include "Graphics_Systems/General/GSprimitives.h"
+#include "Graphics_Systems/General/GSmatrix_impl.h"
+
+using namespace enigma::software;
+
+namespace enigma {
+
+// Lighting, fog and stencil state are not carried over; the software
+// rasterizer draws unlit, unfogged and without a stencil buffer.
+void graphics_state_flush() {
+  const glm::mat4 mvp = projection * view * world;
+  for (int c = 0; c < 4; ++c)
+    for (int r = 0; r < 4; ++r)
+      state.mvp[c * 4 + r] = mvp[c][r];
+  state.perspective = !(state.mvp[3] == 0 && state.mvp[7] == 0 && state.mvp[11] == 0 && state.mvp[15] == 1);
+
+  const Sampler& sampler = samplers[0];
+  state.texture = sampler.texture;
+  state.wrapu = sampler.wrapu, state.wrapv = sampler.wrapv;
+  state.interpolate = sampler.interpolate;
+
+  state.blend = alphaBlend;
+  state.blendsrc = blendMode[0], state.blenddst = blendMode[1];
+  state.alphatest = alphaTest;
+  state.alpharef = alphaTestRef;
+
+  state.depthtest = d3dHidden;
+  state.depthwrite = d3dZWriteEnable;
+  state.depthfunc = d3dDepthOperator;
+  state.culling = d3dCulling;
+  state.fillmode = drawFillMode;
+  state.pointsize = drawPointSize;
+
+  state.writemask = (colorWriteEnable[0] ? 0x00FF0000 : 0) | (colorWriteEnable[1] ? 0x0000FF00 : 0) |
+                    (colorWriteEnable[2] ? 0x000000FF : 0) | (colorWriteEnable[3] ? 0xFF000000 : 0);
+}
+
+} // namespace enigma
+
+namespace enigma_user {
+
+void d3d_clear_depth(double value) {
+  draw_batch_flush(batch_flush_deferred);
+  clear_depth(value);
+}
+
+void d3d_stencil_clear_value(int value) {}
+
+void d3d_stencil_clear() {}
+
+void d3d_set_software_vertex_processing(bool software) {}
+
+void d3d_enable_scissor_test(bool enable) {
+  draw_batch_flush(batch_flush_deferred);
+  state.scissor = enable;
+}
+
+} // namespace enigma_user
@@ -0,0 +1,48 @@
+/** This file is a part of the ENIGMA Development Environment.
+***
+*** ENIGMA is free software: you can redistribute it and/or modify it under the
+*** terms of the GNU General Public License as published by the Free Software
+*** Foundation, version 3 of the license or any later version.
+***
+*** This application and its source code is distributed AS-IS, WITHOUT ANY
+*** WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+*** FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+*** details.
+***
+*** You should have received a copy of the GNU General Public License along
+*** with this code. If not, see <http://www.gnu.org/licenses/>
+**/
+
+#include "SWraster.h"
+#include "Graphics_Systems/General/GSstdraw.h"
+#include "Graphics_Systems/General/GSprimitives.h"
+#include "Graphics_Systems/General/GScolors.h"
+#include "Graphics_Systems/General/GScolor_macros.h"
+
+using namespace enigma::software;
+
+namespace enigma_user {
+
+void draw_clear_alpha(int col, float alpha)
+{
+  draw_batch_flush(batch_flush_deferred);
+  clear_color((uint32_t(CLAMP_ALPHA(alpha)) << 24) | (COL_GET_R(col) << 16) | (COL_GET_G(col) << 8) | COL_GET_B(col));
+}
+
+void draw_clear(int col)
+{
+  draw_batch_flush(batch_flush_deferred);
+  clear_color(0xFF000000 | (COL_GET_R(col) << 16) | (COL_GET_G(col) << 8) | COL_GET_B(col));
+}
+
+int draw_get_msaa_maxlevel()
+{
+  return 0;
+}
+
+bool draw_get_msaa_supported()
+{
+  return false;
+}
+
+} // namespace enigma_user
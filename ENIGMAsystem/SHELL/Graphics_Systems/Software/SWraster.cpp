@@ -0,0 +1,611 @@
+/** This file is a part of the ENIGMA Development Environment.
+***
+*** ENIGMA is free software: you can redistribute it and/or modify it under the
+*** terms of the GNU General Public License as published by the Free Software
+*** Foundation, version 3 of the license or any later version.
+***
+*** This application and its source code is distributed AS-IS, WITHOUT ANY
+*** WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+*** FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+*** details.
+***
+*** You should have received a copy of the GNU General Public License along
+*** with this code. If not, see <http://www.gnu.org/licenses/>
+**/
+
+#include "SWraster.h"
+#include "SWtextures_impl.h"
+#include "Graphics_Systems/General/GSprimitives.h"
+#include "Graphics_Systems/General/GSstdraw.h"
+#include "Graphics_Systems/General/GSblend.h"
+#include "Graphics_Systems/General/GSd3d.h"
+
+#include "Universal_System/worker_pool.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+using std::min;
+using std::max;
+
+namespace enigma {
+namespace software {
+
+RenderState state;
+float viewport_x = 0, viewport_y = 0, viewport_w = 0, viewport_h = 0;
+
+} // namespace software
+} // namespace enigma
+
+using namespace enigma::software;
+
+namespace {
+
+// Triangles are binned into square tiles of the target, then the tiles are
+// filled in parallel. Each tile draws its triangles in submission order, so
+// the result does not depend on the number of threads.
+const int kTileSize = 64;
+const int kSubpixel = 256; // coverage is computed in 1/256ths of a pixel
+const float kGuardBand = 4; // viewports beyond the edge we rasterize instead of clipping
+const int kPlanes = 6, kMaxClipVertices = 3 + kPlanes;
+const size_t kMaxBinned = 1 << 16; // triangles held before filling early
+
+enum { ATTR_Z, ATTR_RW, ATTR_U, ATTR_V, ATTR_R, ATTR_G, ATTR_B, ATTR_A, ATTR_COUNT };
+
+struct Bounds {
+  int x1, y1, x2, y2; // x2 and y2 are exclusive
+  bool empty() const { return x1 >= x2 || y1 >= y2; }
+};
+
+Bounds intersect(const Bounds& a, const Bounds& b) {
+  return { max(a.x1, b.x1), max(a.y1, b.y1), min(a.x2, b.x2), min(a.y2, b.y2) };
+}
+
+// a vertex in pixels; attributes but depth and rw are premultiplied by rw
+struct ScreenVertex {
+  float x, y;
+  float attr[ATTR_COUNT];
+};
+
+// everything a tile needs to fill one triangle
+struct Triangle {
+  // edge functions at pixel centers, A*x + B*y + C >= 0 inside
+  int64_t A[3], B[3], C[3];
+  Bounds box;
+  // attribute planes relative to the center of the box's top-left pixel
+  float base[ATTR_COUNT], dx[ATTR_COUNT], dy[ATTR_COUNT];
+};
+
+// the state of one draw call resolved for the pixel loops
+struct Shader {
+  RenderTarget target;
+  float* depth; // the target's depth buffer if depth testing
+  Bounds clip;
+  float viewport[4];
+  const uint32_t* texels;
+  int texwidth, texheight;
+  RenderState rs; // a copy, so pixel writes cannot alias it in the loops
+};
+
+std::vector<Triangle> triangles;
+std::vector<std::vector<uint32_t> > tiles;
+std::vector<int> active_tiles;
+
+inline int64_t floor_div(int64_t a, int64_t b) {
+  return a >= 0 ? a / b : -((-a + b - 1) / b);
+}
+
+inline int64_t ceil_div(int64_t a, int64_t b) {
+  return -floor_div(-a, b);
+}
+
+inline uint32_t mul255(uint32_t a, uint32_t b) {
+  const uint32_t t = a * b + 128;
+  return (t + (t >> 8)) >> 8;
+}
+
+// scales the red and blue (or alpha and green, shifted down) bytes of a word
+// by a factor from 0 to 255 at once
+inline uint32_t mul255_pair(uint32_t pair, uint32_t factor) {
+  const uint32_t t = (pair & 0x00FF00FF) * factor + 0x00800080;
+  return ((t + ((t >> 8) & 0x00FF00FF)) >> 8) & 0x00FF00FF;
+}
+
+inline uint32_t channel(uint32_t argb, int shift) {
+  return (argb >> shift) & 255;
+}
+
+inline uint32_t to_byte(float value) {
+  return value <= 0 ? 0 : (value >= 255 ? 255 : uint32_t(value + 0.5f));
+}
+
+inline float clamp_coord(float value) {
+  // keeps float to int conversions defined for wild coordinates and NaN
+  return value > -1e8f ? (value < 1e8f ? value : 1e8f) : -1e8f;
+}
+
+inline float clamp_screen(float value) {
+  // bounds pixel positions so the fixed point edge functions cannot overflow
+  return value > -1e6f ? (value < 1e6f ? value : 1e6f) : -1e6f;
+}
+
+inline int floor_int(float value) {
+  // std::floor is a library call without SSE4.1 and this is the hot path
+  const int i = int(value);
+  return i - (value < i);
+}
+
+inline int texel_index(int i, int size, bool wrap) {
+  if (wrap) {
+    i %= size;
+    return i < 0 ? i + size : i;
+  }
+  return i < 0 ? 0 : (i >= size ? size - 1 : i);
+}
+
+uint32_t sample(const Shader& sh, float u, float v) {
+  const int w = sh.texwidth, h = sh.texheight;
+  if (!sh.rs.interpolate) {
+    const int x = texel_index(floor_int(clamp_coord(u * w)), w, sh.rs.wrapu),
+              y = texel_index(floor_int(clamp_coord(v * h)), h, sh.rs.wrapv);
+    return sh.texels[size_t(y) * w + x];
+  }
+
+  const float fu = clamp_coord(u * w - 0.5f), fv = clamp_coord(v * h - 0.5f);
+  const int lu = floor_int(fu), lv = floor_int(fv);
+  const uint32_t wx = uint32_t((fu - lu) * 256), wy = uint32_t((fv - lv) * 256);
+  const int x0 = texel_index(lu, w, sh.rs.wrapu), x1 = texel_index(lu + 1, w, sh.rs.wrapu),
+            y0 = texel_index(lv, h, sh.rs.wrapv), y1 = texel_index(lv + 1, h, sh.rs.wrapv);
+  const uint32_t c00 = sh.texels[size_t(y0) * w + x0], c10 = sh.texels[size_t(y0) * w + x1],
+                 c01 = sh.texels[size_t(y1) * w + x0], c11 = sh.texels[size_t(y1) * w + x1];
+  uint32_t out = 0;
+  for (int shift = 0; shift < 32; shift += 8) {
+    const uint32_t top = channel(c00, shift) * (256 - wx) + channel(c10, shift) * wx,
+                   bottom = channel(c01, shift) * (256 - wx) + channel(c11, shift) * wx;
+    out |= ((top * (256 - wy) + bottom * wy) >> 16) << shift;
+  }
+  return out;
+}
+
+inline uint32_t modulate(uint32_t a, uint32_t b) {
+  return mul255(a >> 24, b >> 24) << 24 | mul255(channel(a, 16), channel(b, 16)) << 16 |
+         mul255(channel(a, 8), channel(b, 8)) << 8 | mul255(a & 255, b & 255);
+}
+
+inline uint32_t blend_factor(int mode, int shift, uint32_t src, uint32_t dst) {
+  using namespace enigma_user;
+  const uint32_t sa = src >> 24, da = dst >> 24;
+  switch (mode) {
+    case bm_zero: return 0;
+    case bm_one: return 255;
+    case bm_src_color: return channel(src, shift);
+    case bm_inv_src_color: return 255 - channel(src, shift);
+    case bm_src_alpha: return sa;
+    case bm_inv_src_alpha: return 255 - sa;
+    case bm_dest_alpha: return da;
+    case bm_inv_dest_alpha: return 255 - da;
+    case bm_dest_color: return channel(dst, shift);
+    case bm_inv_dest_color: return 255 - channel(dst, shift);
+    case bm_src_alpha_sat: return shift == 24 ? 255 : min(sa, 255 - da);
+  }
+  return 255;
+}
+
+uint32_t blend(const Shader& sh, uint32_t src, uint32_t dst) {
+  // the usual alpha blend is exact for opaque and clear pixels
+  if (sh.rs.blendsrc == enigma_user::bm_src_alpha && sh.rs.blenddst == enigma_user::bm_inv_src_alpha) {
+    const uint32_t sa = src >> 24;
+    if (sa == 255) return src;
+    if (sa == 0) return dst;
+    return (mul255_pair(src, sa) + mul255_pair(dst, 255 - sa)) |
+           (mul255_pair(src >> 8, sa) + mul255_pair(dst >> 8, 255 - sa)) << 8;
+  }
+  uint32_t out = 0;
+  for (int shift = 0; shift < 32; shift += 8) {
+    const uint32_t value = mul255(channel(src, shift), blend_factor(sh.rs.blendsrc, shift, src, dst)) +
+                           mul255(channel(dst, shift), blend_factor(sh.rs.blenddst, shift, src, dst));
+    out |= min<uint32_t>(value, 255) << shift;
+  }
+  return out;
+}
+
+inline bool depth_pass(const Shader& sh, float z, float stored) {
+  using namespace enigma_user;
+  switch (sh.rs.depthfunc) {
+    case rs_never: return false;
+    case rs_less: return z < stored;
+    case rs_equal: return z == stored;
+    case rs_lequal: return z <= stored;
+    case rs_greater: return z > stored;
+    case rs_notequal: return z != stored;
+    case rs_gequal: return z >= stored;
+  }
+  return true;
+}
+
+// textures, tests, blends and writes one pixel of the given vertex color
+inline void write_fragment(const Shader& sh, uint32_t color, float u, float v, float z,
+                           uint32_t* pixel, float* depth) {
+  if (sh.texels) {
+    const uint32_t texel = sample(sh, u, v);
+    color = color == 0xFFFFFFFF ? texel : modulate(color, texel);
+  }
+  if (sh.rs.alphatest && (color >> 24) <= sh.rs.alpharef) return;
+  if (depth) {
+    if (!depth_pass(sh, z, *depth)) return;
+    if (sh.rs.depthwrite) *depth = z;
+  }
+  if (sh.rs.blend) color = blend(sh, color, *pixel);
+  *pixel = (color & sh.rs.writemask) | (*pixel & ~sh.rs.writemask);
+}
+
+inline uint32_t attr_color(const float* attr, float w) {
+  return to_byte(attr[ATTR_A] * w) << 24 | to_byte(attr[ATTR_R] * w) << 16 |
+         to_byte(attr[ATTR_G] * w) << 8 | to_byte(attr[ATTR_B] * w);
+}
+
+inline void shade(const Shader& sh, const float* attr, uint32_t* pixel, float* depth) {
+  const float w = sh.rs.perspective ? 1 / attr[ATTR_RW] : 1;
+  write_fragment(sh, attr_color(attr, w), attr[ATTR_U] * w, attr[ATTR_V] * w, attr[ATTR_Z], pixel, depth);
+}
+
+inline void shade_at(const Shader& sh, int x, int y, const float* attr) {
+  const size_t i = size_t(y) * sh.target.width + x;
+  shade(sh, attr, sh.target.color + i, sh.depth ? sh.depth + i : nullptr);
+}
+
+float plane_distance(const ClipVertex& v, int plane) {
+  switch (plane) {
+    case 0: return v.w + v.z; // near
+    case 1: return v.w - v.z; // far
+    case 2: return kGuardBand * v.w + v.x;
+    case 3: return kGuardBand * v.w - v.x;
+    case 4: return kGuardBand * v.w + v.y;
+    default: return kGuardBand * v.w - v.y;
+  }
+}
+
+int outcode(const ClipVertex& v) {
+  int code = 0;
+  for (int p = 0; p < kPlanes; ++p)
+    if (plane_distance(v, p) < 0) code |= 1 << p;
+  return code;
+}
+
+ClipVertex lerp(const ClipVertex& a, const ClipVertex& b, float t) {
+  return {
+    a.x + (b.x - a.x) * t, a.y + (b.y - a.y) * t, a.z + (b.z - a.z) * t, a.w + (b.w - a.w) * t,
+    a.u + (b.u - a.u) * t, a.v + (b.v - a.v) * t,
+    a.r + (b.r - a.r) * t, a.g + (b.g - a.g) * t, a.b + (b.b - a.b) * t, a.a + (b.a - a.a) * t
+  };
+}
+
+// Sutherland-Hodgman against the planes set in mask; returns the new count
+int clip_polygon(ClipVertex* poly, int count, int mask) {
+  ClipVertex out[kMaxClipVertices];
+  for (int p = 0; p < kPlanes && count >= 3; ++p) {
+    if (!(mask & (1 << p))) continue;
+    int n = 0;
+    for (int i = 0; i < count; ++i) {
+      const ClipVertex &a = poly[i], &b = poly[(i + 1) % count];
+      const float da = plane_distance(a, p), db = plane_distance(b, p);
+      if (da >= 0) out[n++] = a;
+      if ((da >= 0) != (db >= 0)) out[n++] = lerp(a, b, da / (da - db));
+    }
+    std::copy(out, out + n, poly);
+    count = n;
+  }
+  return count;
+}
+
+ScreenVertex to_screen(const Shader& sh, const ClipVertex& v) {
+  const float rw = 1 / v.w;
+  ScreenVertex s;
+  s.x = clamp_screen(sh.viewport[0] + (v.x * rw + 1) * 0.5f * sh.viewport[2]);
+  s.y = clamp_screen(sh.viewport[1] + (1 - v.y * rw) * 0.5f * sh.viewport[3]);
+  s.attr[ATTR_Z] = min(max((v.z * rw + 1) * 0.5f, 0.0f), 1.0f);
+  s.attr[ATTR_RW] = rw;
+  s.attr[ATTR_U] = v.u * rw;
+  s.attr[ATTR_V] = v.v * rw;
+  s.attr[ATTR_R] = v.r * rw;
+  s.attr[ATTR_G] = v.g * rw;
+  s.attr[ATTR_B] = v.b * rw;
+  s.attr[ATTR_A] = v.a * rw;
+  return s;
+}
+
+void raster_point(const Shader& sh, const ScreenVertex& s) {
+  const int size = max(1, int(sh.rs.pointsize + 0.5f));
+  const int x1 = int(std::floor(s.x - size * 0.5f + 0.5f)), y1 = int(std::floor(s.y - size * 0.5f + 0.5f));
+  const Bounds r = intersect({x1, y1, x1 + size, y1 + size}, sh.clip);
+  for (int y = r.y1; y < r.y2; ++y)
+    for (int x = r.x1; x < r.x2; ++x)
+      shade_at(sh, x, y, s.attr);
+}
+
+// a DDA that leaves off the last pixel so strips do not draw joints twice
+void raster_line(const Shader& sh, const ScreenVertex& a, const ScreenVertex& b) {
+  const float dx = b.x - a.x, dy = b.y - a.y;
+  const int steps = int(std::ceil(max(std::fabs(dx), std::fabs(dy))));
+  float attr[ATTR_COUNT];
+  for (int i = 0; i < steps; ++i) {
+    const float t = float(i) / steps;
+    const int x = int(std::floor(a.x + dx * t)), y = int(std::floor(a.y + dy * t));
+    if (x < sh.clip.x1 || x >= sh.clip.x2 || y < sh.clip.y1 || y >= sh.clip.y2) continue;
+    for (int k = 0; k < ATTR_COUNT; ++k) attr[k] = a.attr[k] + (b.attr[k] - a.attr[k]) * t;
+    shade_at(sh, x, y, attr);
+  }
+}
+
+void add_point(const Shader& sh, const ClipVertex& v) {
+  if (outcode(v) & 3) return; // outside the near or far plane
+  raster_point(sh, to_screen(sh, v));
+}
+
+void add_line(const Shader& sh, const ClipVertex& a, const ClipVertex& b) {
+  float t0 = 0, t1 = 1;
+  for (int p = 0; p < kPlanes; ++p) {
+    const float da = plane_distance(a, p), db = plane_distance(b, p);
+    if (da < 0 && db < 0) return;
+    if (da < 0) t0 = max(t0, da / (da - db));
+    else if (db < 0) t1 = min(t1, da / (da - db));
+  }
+  if (t0 > t1) return;
+  raster_line(sh, to_screen(sh, lerp(a, b, t0)), to_screen(sh, lerp(a, b, t1)));
+}
+
+void fill_triangles(const Shader& sh);
+
+// culls, then turns a screen space triangle into edge functions and planes
+void setup_triangle(const Shader& sh, const ScreenVertex* v0, const ScreenVertex* v1, const ScreenVertex* v2) {
+  int64_t X[3] = { llround(v0->x * kSubpixel), llround(v1->x * kSubpixel), llround(v2->x * kSubpixel) },
+          Y[3] = { llround(v0->y * kSubpixel), llround(v1->y * kSubpixel), llround(v2->y * kSubpixel) };
+
+  // positive area is clockwise on screen, since y points down
+  int64_t area = (X[1] - X[0]) * (Y[2] - Y[0]) - (X[2] - X[0]) * (Y[1] - Y[0]);
+  if (area == 0) return;
+  if (sh.rs.culling == enigma_user::rs_cw && area < 0) return;
+  if (sh.rs.culling == enigma_user::rs_ccw && area > 0) return;
+  if (area < 0) {
+    std::swap(v1, v2), std::swap(X[1], X[2]), std::swap(Y[1], Y[2]);
+    area = -area;
+  }
+
+  Triangle t;
+  t.box = intersect({
+    int(floor_div(min({X[0], X[1], X[2]}), kSubpixel)), int(floor_div(min({Y[0], Y[1], Y[2]}), kSubpixel)),
+    int(floor_div(max({X[0], X[1], X[2]}), kSubpixel)) + 1, int(floor_div(max({Y[0], Y[1], Y[2]}), kSubpixel)) + 1
+  }, sh.clip);
+  if (t.box.empty()) return;
+
+  for (int i = 0; i < 3; ++i) {
+    const int j = (i + 1) % 3;
+    const int64_t dx = X[j] - X[i], dy = Y[j] - Y[i];
+    // pixels on a shared edge belong to the triangle it is a top or left edge of
+    const bool top_left = dy < 0 || (dy == 0 && dx > 0);
+    t.A[i] = -dy * kSubpixel;
+    t.B[i] = dx * kSubpixel;
+    t.C[i] = dx * (kSubpixel / 2 - Y[i]) - dy * (kSubpixel / 2 - X[i]) - (top_left ? 0 : 1);
+  }
+
+  const double x0 = double(X[0]) / kSubpixel, y0 = double(Y[0]) / kSubpixel,
+               x1 = double(X[1]) / kSubpixel - x0, y1 = double(Y[1]) / kSubpixel - y0,
+               x2 = double(X[2]) / kSubpixel - x0, y2 = double(Y[2]) / kSubpixel - y0,
+               area_px = double(area) / kSubpixel / kSubpixel,
+               ox = t.box.x1 + 0.5 - x0, oy = t.box.y1 + 0.5 - y0;
+  for (int k = 0; k < ATTR_COUNT; ++k) {
+    const double a0 = v0->attr[k], a1 = v1->attr[k] - a0, a2 = v2->attr[k] - a0;
+    const double dx = (a1 * y2 - a2 * y1) / area_px, dy = (a2 * x1 - a1 * x2) / area_px;
+    t.base[k] = float(a0 + dx * ox + dy * oy);
+    t.dx[k] = float(dx);
+    t.dy[k] = float(dy);
+  }
+
+  triangles.push_back(t);
+  if (triangles.size() >= kMaxBinned) fill_triangles(sh);
+}
+
+void add_triangle(const Shader& sh, const ClipVertex& a, const ClipVertex& b, const ClipVertex& c) {
+  const int ca = outcode(a), cb = outcode(b), cc = outcode(c);
+  if (ca & cb & cc) return; // entirely outside one plane
+
+  ClipVertex poly[kMaxClipVertices] = { a, b, c };
+  int count = 3;
+  if (ca | cb | cc) count = clip_polygon(poly, count, ca | cb | cc);
+  if (count < 3) return;
+
+  ScreenVertex screen[kMaxClipVertices];
+  for (int i = 0; i < count; ++i) screen[i] = to_screen(sh, poly[i]);
+
+  if (sh.rs.fillmode != enigma_user::rs_solid) {
+    // wireframe and point modes still cull by the winding of the whole polygon
+    double area = 0;
+    for (int i = 0; i < count; ++i) {
+      const ScreenVertex &p = screen[i], &q = screen[(i + 1) % count];
+      area += double(p.x) * q.y - double(q.x) * p.y;
+    }
+    if (sh.rs.culling == enigma_user::rs_cw && area < 0) return;
+    if (sh.rs.culling == enigma_user::rs_ccw && area > 0) return;
+    for (int i = 0; i < count; ++i) {
+      if (sh.rs.fillmode == enigma_user::rs_point) raster_point(sh, screen[i]);
+      else raster_line(sh, screen[i], screen[(i + 1) % count]);
+    }
+    return;
+  }
+
+  for (int i = 1; i + 1 < count; ++i)
+    setup_triangle(sh, &screen[0], &screen[i], &screen[i + 1]);
+}
+
+void raster_triangle(const Shader& shader, const Triangle& t, const Bounds& r) {
+  // a local copy lets the compiler keep the state in registers across pixels
+  const Shader sh = shader;
+  float attr[ATTR_COUNT];
+
+  // without perspective a color that does not vary can be packed just once
+  bool flat = !sh.rs.perspective;
+  for (int k = ATTR_R; k <= ATTR_A && flat; ++k) flat = t.dx[k] == 0 && t.dy[k] == 0;
+  const uint32_t color = flat ? attr_color(t.base, 1) : 0;
+  for (int y = r.y1; y < r.y2; ++y) {
+    // solve each edge function for the span of this row inside the triangle
+    int64_t xl = r.x1, xr = r.x2;
+    for (int e = 0; e < 3; ++e) {
+      const int64_t row = t.B[e] * y + t.C[e];
+      if (t.A[e] > 0) xl = max(xl, ceil_div(-row, t.A[e]));
+      else if (t.A[e] < 0) xr = min(xr, floor_div(row, -t.A[e]) + 1);
+      else if (row < 0) xr = r.x1;
+    }
+    if (xl >= xr) continue;
+
+    const float fx = float(xl - t.box.x1), fy = float(y - t.box.y1);
+    for (int k = 0; k < ATTR_COUNT; ++k) attr[k] = t.base[k] + t.dx[k] * fx + t.dy[k] * fy;
+
+    const size_t row = size_t(y) * sh.target.width;
+    uint32_t* pixel = sh.target.color + row;
+    float* depth = sh.depth ? sh.depth + row : nullptr;
+    if (flat) {
+      // sprites and untextured shapes: only the texture coordinates and depth vary
+      float u = attr[ATTR_U], v = attr[ATTR_V], z = attr[ATTR_Z];
+      for (int64_t x = xl; x < xr; ++x, u += t.dx[ATTR_U], v += t.dx[ATTR_V], z += t.dx[ATTR_Z])
+        write_fragment(sh, color, u, v, z, pixel + x, depth ? depth + x : nullptr);
+      continue;
+    }
+    for (int64_t x = xl; x < xr; ++x) {
+      shade(sh, attr, pixel + x, depth ? depth + x : nullptr);
+      for (int k = 0; k < ATTR_COUNT; ++k) attr[k] += t.dx[k];
+    }
+  }
+}
+
+void fill_triangles(const Shader& sh) {
+  if (triangles.empty()) return;
+
+  const int columns = (sh.target.width + kTileSize - 1) / kTileSize,
+            rows = (sh.target.height + kTileSize - 1) / kTileSize;
+  if (tiles.size() < size_t(columns) * rows) tiles.resize(size_t(columns) * rows);
+  for (uint32_t i = 0; i < triangles.size(); ++i) {
+    const Bounds& box = triangles[i].box;
+    for (int ty = box.y1 / kTileSize; ty <= (box.y2 - 1) / kTileSize; ++ty) {
+      for (int tx = box.x1 / kTileSize; tx <= (box.x2 - 1) / kTileSize; ++tx) {
+        std::vector<uint32_t>& tile = tiles[ty * columns + tx];
+        if (tile.empty()) active_tiles.push_back(ty * columns + tx);
+        tile.push_back(i);
+      }
+    }
+  }
+
+  auto fill_tile = [&sh, columns](size_t n) {
+    const int index = active_tiles[n], x = index % columns * kTileSize, y = index / columns * kTileSize;
+    const Bounds area = { x, y, x + kTileSize, y + kTileSize };
+    for (uint32_t i : tiles[index]) {
+      const Triangle& t = triangles[i];
+      raster_triangle(sh, t, intersect(t.box, area));
+    }
+  };
+  if (active_tiles.size() == 1 || enigma::worker_count() == 0) {
+    for (size_t n = 0; n < active_tiles.size(); ++n) fill_tile(n);
+  } else {
+    enigma::parallel_for(active_tiles.size(), fill_tile);
+  }
+
+  for (int index : active_tiles) tiles[index].clear();
+  active_tiles.clear();
+  triangles.clear();
+}
+
+Bounds viewport_rect(const RenderTarget& target) {
+  const Bounds whole = { 0, 0, target.width, target.height };
+  if (viewport_w <= 0 || viewport_h <= 0) return whole;
+  return intersect(whole, {
+    int(std::lround(viewport_x)), int(std::lround(viewport_y)),
+    int(std::lround(viewport_x + viewport_w)), int(std::lround(viewport_y + viewport_h))
+  });
+}
+
+} // anonymous namespace
+
+namespace enigma {
+namespace software {
+
+void draw_primitives(int primitive, const ClipVertex* vertices, size_t vertex_count,
+                     const uint32_t* indices, size_t count) {
+  Shader sh;
+  sh.rs = state;
+  sh.target = bound_target();
+  if (!sh.target.color) return;
+  sh.clip = viewport_rect(sh.target);
+  if (sh.clip.empty()) return;
+  sh.depth = state.depthtest ? sh.target.depth : nullptr;
+
+  const bool whole = viewport_w <= 0 || viewport_h <= 0;
+  sh.viewport[0] = whole ? 0 : viewport_x;
+  sh.viewport[1] = whole ? 0 : viewport_y;
+  sh.viewport[2] = whole ? sh.target.width : viewport_w;
+  sh.viewport[3] = whole ? sh.target.height : viewport_h;
+
+  const SWTexture* texture = get_texture_peer(state.texture);
+  sh.texels = (texture && !texture->pixels.empty()) ? texture->pixels.data() : nullptr;
+  sh.texwidth = texture ? texture->fullwidth : 0;
+  sh.texheight = texture ? texture->fullheight : 0;
+
+  // fetches the k-th vertex of the draw, or null if its index is out of range
+  auto vertex = [=](size_t k) -> const ClipVertex* {
+    const size_t i = indices ? indices[k] : k;
+    return i < vertex_count ? vertices + i : nullptr;
+  };
+
+  using namespace enigma_user;
+  switch (primitive) {
+    case pr_pointlist:
+      for (size_t k = 0; k < count; ++k)
+        if (const ClipVertex* v = vertex(k)) add_point(sh, *v);
+      break;
+    case pr_linelist:
+    case pr_linestrip:
+      for (size_t k = 0; k + 1 < count; k += (primitive == pr_linelist ? 2 : 1)) {
+        const ClipVertex *a = vertex(k), *b = vertex(k + 1);
+        if (a && b) add_line(sh, *a, *b);
+      }
+      break;
+    case pr_trianglelist:
+    case pr_trianglestrip:
+    case pr_trianglefan:
+      for (size_t k = 0; k + 2 < count; k += (primitive == pr_trianglelist ? 3 : 1)) {
+        const ClipVertex *a = vertex(primitive == pr_trianglefan ? 0 : k), *b = vertex(k + 1), *c = vertex(k + 2);
+        // every other triangle of a strip is wound backwards
+        if (primitive == pr_trianglestrip && (k & 1)) std::swap(a, b);
+        if (a && b && c) add_triangle(sh, *a, *b, *c);
+      }
+      break;
+  }
+  fill_triangles(sh);
+}
+
+void clear_color(uint32_t argb) {
+  const RenderTarget target = bound_target();
+  if (!target.color) return;
+  const Bounds r = state.scissor ? viewport_rect(target) : Bounds{ 0, 0, target.width, target.height };
+  const uint32_t mask = state.writemask;
+  for (int y = r.y1; y < r.y2; ++y) {
+    uint32_t* row = target.color + size_t(y) * target.width;
+    if (mask == 0xFFFFFFFF) {
+      std::fill(row + r.x1, row + r.x2, argb);
+    } else {
+      for (int x = r.x1; x < r.x2; ++x) row[x] = (argb & mask) | (row[x] & ~mask);
+    }
+  }
+}
+
+void clear_depth(float value) {
+  const RenderTarget target = bound_target();
+  if (!target.depth) return;
+  const Bounds r = state.scissor ? viewport_rect(target) : Bounds{ 0, 0, target.width, target.height };
+  for (int y = r.y1; y < r.y2; ++y) {
+    float* row = target.depth + size_t(y) * target.width;
+    std::fill(row + r.x1, row + r.x2, value);
+  }
+}
+
+} // namespace software
+} // namespace enigma
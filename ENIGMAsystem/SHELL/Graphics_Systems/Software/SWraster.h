@@ -0,0 +1,85 @@
+/** This file is a part of the ENIGMA Development Environment.
+***
+*** ENIGMA is free software: you can redistribute it and/or modify it under the
+*** terms of the GNU General Public License as published by the Free Software
+*** Foundation, version 3 of the license or any later version.
+***
+*** This application and its source code is distributed AS-IS, WITHOUT ANY
+*** WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+*** FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+*** details.
+***
+*** You should have received a copy of the GNU General Public License along
+*** with this code. If not, see <http://www.gnu.org/licenses/>
+**/
+
+#ifdef INCLUDED_FROM_SHELLMAIN
+#  error This file includes non-ENIGMA STL headers and should not be included from SHELLmain.
+#endif
+
+#ifndef ENIGMA_SW_RASTER_H
+#define ENIGMA_SW_RASTER_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace enigma {
+namespace software {
+
+// a vertex after the world-view-projection transform, still in clip space
+struct ClipVertex {
+  float x, y, z, w;
+  float u, v;
+  float r, g, b, a; // 0 to 255
+};
+
+// the pixels a draw lands in, either the screen's or a surface's texture;
+// color is ARGB in native words, which is BGRA in memory like RawImage
+struct RenderTarget {
+  uint32_t* color;
+  float* depth; // nullptr if the target has no depth buffer
+  int width, height;
+};
+
+// pipeline state captured by graphics_state_flush
+struct RenderState {
+  float mvp[16] = {1,0,0,0, 0,1,0,0, 0,0,1,0, 0,0,0,1}; // column-major like glm
+  bool perspective = false; // false when w is always 1 so the divide can be skipped
+  int texture = -1;
+  bool wrapu = false, wrapv = false, interpolate = false;
+  bool blend = true, alphatest = false;
+  int blendsrc = 5, blenddst = 6; // bm_src_alpha, bm_inv_src_alpha
+  unsigned char alpharef = 0;
+  bool depthtest = false, depthwrite = true;
+  int depthfunc = 3; // rs_lequal
+  int culling = 0, fillmode = 2; // rs_none, rs_solid
+  float pointsize = 1;
+  uint32_t writemask = 0xFFFFFFFF;
+  bool scissor = true; // restricts clears to the viewport like GL's scissor test
+};
+
+extern RenderState state;
+
+// viewport of the bound target; an empty one means the whole target,
+// which is what we get on platforms without a window
+extern float viewport_x, viewport_y, viewport_w, viewport_h;
+
+// the screen's buffers, resized to the window region if it has changed
+RenderTarget screen_target();
+
+// the screen when no surface is bound, else the bound surface
+RenderTarget bound_target();
+
+// rasterizes count vertices (or indices, if not null) as the given
+// primitive type into the bound target, returning once all are drawn
+void draw_primitives(int primitive, const ClipVertex* vertices, size_t vertex_count,
+                     const uint32_t* indices, size_t count);
+
+// fills the bound target, restricted to the viewport when scissoring
+void clear_color(uint32_t argb);
+void clear_depth(float value);
+
+} // namespace software
+} // namespace enigma
+
+#endif // ENIGMA_SW_RASTER_H
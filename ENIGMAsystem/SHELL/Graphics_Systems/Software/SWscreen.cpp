@@ -0,0 +1,97 @@
+/** This file is a part of the ENIGMA Development Environment.
+***
+*** ENIGMA is free software: you can redistribute it and/or modify it under the
+*** terms of the GNU General Public License as published by the Free Software
+*** Foundation, version 3 of the license or any later version.
+***
+*** This application and its source code is distributed AS-IS, WITHOUT ANY
+*** WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+*** FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+*** details.
+***
+*** You should have received a copy of the GNU General Public License along
+*** with this code. If not, see <http://www.gnu.org/licenses/>
+**/
+
+#include "SWraster.h"
+#include "Graphics_Systems/graphics_mandatory.h"
+#include "Graphics_Systems/General/GSscreen.h"
+#include "Graphics_Systems/General/GSprimitives.h"
+
+#include "Platforms/General/PFwindow.h"
+#include "Universal_System/roomsystem.h" // Room dimensions.
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#include <string.h> // for memcpy
+
+using namespace enigma::software;
+
+namespace {
+
+// the screen is sized to the window region, or to the room when there is
+// no display for the platform to fit a region to
+std::vector<uint32_t> screen_color;
+std::vector<float> screen_depth;
+int screen_width = 0, screen_height = 0;
+
+} // anonymous namespace
+
+namespace enigma {
+namespace software {
+
+RenderTarget screen_target() {
+  int width = enigma_user::window_get_region_width(), height = enigma_user::window_get_region_height();
+  if (width <= 0 || height <= 0) {
+    width = std::max(1, enigma_user::room_width);
+    height = std::max(1, enigma_user::room_height);
+  }
+  if (width != screen_width || height != screen_height) {
+    screen_width = width, screen_height = height;
+    screen_color.assign(size_t(width) * height, 0xFF000000);
+    screen_depth.assign(size_t(width) * height, 1.0f);
+  }
+  return { screen_color.data(), screen_depth.data(), width, height };
+}
+
+} // namespace software
+
+void scene_begin() {}
+
+void scene_end() {}
+
+void graphics_set_viewport(float x, float y, float width, float height) {
+  // without a display the region scaling can leave us NaN or nothing,
+  // so we fall back to drawing on the whole screen
+  if (!std::isfinite(x) || !std::isfinite(y) || !(width > 0) || !(height > 0) ||
+      !std::isfinite(width) || !std::isfinite(height)) {
+    x = y = width = height = 0;
+  }
+  viewport_x = x, viewport_y = y;
+  viewport_w = width, viewport_h = height;
+}
+
+unsigned char* graphics_copy_screen_pixels(int x, int y, int width, int height, bool* flipped) {
+  if (flipped) *flipped = false;
+
+  const RenderTarget screen = screen_target();
+  if (width < 0) width = 0;
+  if (height < 0) height = 0;
+  // like glReadPixels, whatever lies off the screen reads back as zero
+  unsigned char* ret = new unsigned char[size_t(width)*height*4]();
+  const int x1 = std::max(x, 0), x2 = std::min(x + width, screen.width),
+            y1 = std::max(y, 0), y2 = std::min(y + height, screen.height);
+  for (int i = y1; i < y2 && x1 < x2; ++i) {
+    memcpy(ret + (size_t(i - y) * width + (x1 - x)) * 4, screen.color + size_t(i) * screen.width + x1, (x2 - x1) * 4);
+  }
+  return ret;
+}
+
+unsigned char* graphics_copy_screen_pixels(unsigned* fullwidth, unsigned* fullheight, bool* flipped) {
+  const RenderTarget screen = screen_target();
+  *fullwidth = screen.width, *fullheight = screen.height;
+  return graphics_copy_screen_pixels(0, 0, screen.width, screen.height, flipped);
+}
+
+} // namespace enigma
@@ -0,0 +1,113 @@
+/** This file is a part of the ENIGMA Development Environment.
+***
+*** ENIGMA is free software: you can redistribute it and/or modify it under the
+*** terms of the GNU General Public License as published by the Free Software
+*** Foundation, version 3 of the license or any later version.
+***
+*** This application and its source code is distributed AS-IS, WITHOUT ANY
+*** WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+*** FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+*** details.
+***
+*** You should have received a copy of the GNU General Public License along
+*** with this code. If not, see <http://www.gnu.org/licenses/>
+**/
+
+#include "SWsurface_impl.h"
+#include "SWtextures_impl.h"
+#include "SWraster.h"
+#include "Graphics_Systems/graphics_mandatory.h"
+#include "Graphics_Systems/General/GSsurface.h"
+#include "Graphics_Systems/General/GSprimitives.h"
+#include "Graphics_Systems/General/GSmatrix.h"
+#include "Universal_System/image_formats.h"
+
+using namespace enigma::software;
+
+namespace {
+
+int bound_surface = -1;
+float screen_viewport[4] = {0, 0, 0, 0}; // restored when drawing goes back to the screen
+
+} // anonymous namespace
+
+namespace enigma {
+namespace software {
+
+RenderTarget bound_target() {
+  if (bound_surface < 0) return screen_target();
+  Surface& surface = *static_cast<Surface*>(surfaces[bound_surface]);
+  SWTexture* texture = get_texture_peer(surface.texture);
+  if (!texture || texture->pixels.empty()) return { nullptr, nullptr, 0, 0 };
+  return {
+    texture->pixels.data(), surface.depth.empty() ? nullptr : surface.depth.data(),
+    int(texture->fullwidth), int(texture->fullheight)
+  };
+}
+
+} // namespace software
+} // namespace enigma
+
+namespace enigma_user {
+
+bool surface_is_supported()
+{
+  return true;
+}
+
+int surface_create(int width, int height, bool depthbuffer, bool, bool)
+{
+  enigma::Surface* surface = new enigma::Surface();
+  surface->texture = enigma::graphics_create_texture(enigma::RawImage(nullptr, width, height), false);
+  surface->width = width; surface->height = height;
+  if (depthbuffer) surface->depth.assign(size_t(width) * height, 1.0f);
+  enigma::surfaces.push_back(surface);
+  return enigma::surfaces.size() - 1;
+}
+
+int surface_create_msaa(int width, int height, int levels)
+{
+  return surface_create(width, height, true, false, false);
+}
+
+void surface_set_target(int id)
+{
+  draw_batch_flush(batch_flush_deferred);
+
+  get_surface(surface,id);
+  if (bound_surface < 0) {
+    screen_viewport[0] = viewport_x, screen_viewport[1] = viewport_y;
+    screen_viewport[2] = viewport_w, screen_viewport[3] = viewport_h;
+  }
+  bound_surface = id;
+  viewport_x = viewport_y = 0;
+  viewport_w = surface.width, viewport_h = surface.height;
+
+  d3d_set_projection_ortho(0, 0, surface.width, surface.height, 0);
+}
+
+void surface_reset_target()
+{
+  draw_batch_flush(batch_flush_deferred);
+
+  if (bound_surface < 0) return;
+  bound_surface = -1;
+  viewport_x = screen_viewport[0], viewport_y = screen_viewport[1];
+  viewport_w = screen_viewport[2], viewport_h = screen_viewport[3];
+}
+
+int surface_get_target()
+{
+  return bound_surface;
+}
+
+void surface_free(int id)
+{
+  get_surface(surf,id);
+  if (bound_surface == id) surface_reset_target();
+  enigma::graphics_delete_texture(surf.texture);
+  delete enigma::surfaces[id];
+  enigma::surfaces[id] = nullptr;
+}
+
+}
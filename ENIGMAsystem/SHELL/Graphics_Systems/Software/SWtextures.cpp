@@ -0,0 +1,103 @@
+/** This file is a part of the ENIGMA Development Environment.
+***
+*** ENIGMA is free software: you can redistribute it and/or modify it under the
+*** terms of the GNU General Public License as published by the Free Software
+*** Foundation, version 3 of the license or any later version.
+***
+*** This application and its source code is distributed AS-IS, WITHOUT ANY
+*** WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+*** FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+*** details.
+***
+*** You should have received a copy of the GNU General Public License along
+*** with this code. If not, see <http://www.gnu.org/licenses/>
+**/
+
+#include "SWtextures_impl.h"
+#include "Graphics_Systems/graphics_mandatory.h"
+#include "Graphics_Systems/General/GStextures.h"
+#include "Graphics_Systems/General/GSprimitives.h"
+#include "Universal_System/image_formats.h"
+
+#include <string.h> // for memcpy
+
+namespace enigma {
+
+SWTexture* get_texture_peer(int texid) {
+  return (size_t(texid) >= textures.size() || texid < 0) ? nullptr : static_cast<SWTexture*>(textures[texid].get());
+}
+
+// Textures keep their exact size since nothing here needs powers of two.
+// Without pixel data they start out transparent black.
+int graphics_create_texture(const RawImage& img, bool mipmap, unsigned* fullwidth, unsigned* fullheight)
+{
+  const int id = textures.size();
+  auto texture = std::make_unique<SWTexture>();
+  texture->width = texture->fullwidth = img.w;
+  texture->height = texture->fullheight = img.h;
+  texture->pixels.resize(size_t(img.w) * img.h);
+  if (img.pxdata != nullptr) memcpy(texture->pixels.data(), img.pxdata, texture->pixels.size() * 4);
+  textures.push_back(std::move(texture));
+
+  if (fullwidth) *fullwidth = img.w;
+  if (fullheight) *fullheight = img.h;
+  return id;
+}
+
+void graphics_delete_texture(int texid) {
+  if (SWTexture* texture = get_texture_peer(texid))
+    vector<uint32_t>().swap(texture->pixels);
+}
+
+unsigned char* graphics_copy_texture_pixels(int texture, int x, int y, int width, int height) {
+  const SWTexture* swtex = get_texture_peer(texture);
+  unsigned char* ret = new unsigned char[width*height*4];
+  for (int i = 0; i < height; ++i) {
+    memcpy(ret + i * width * 4, swtex->pixels.data() + size_t(y + i) * swtex->fullwidth + x, width * 4);
+  }
+  return ret;
+}
+
+unsigned char* graphics_copy_texture_pixels(int texture, unsigned* fullwidth, unsigned* fullheight) {
+  const SWTexture* swtex = get_texture_peer(texture);
+  const unsigned fw = swtex->fullwidth, fh = swtex->fullheight;
+  *fullwidth = fw, *fullheight = fh;
+  return graphics_copy_texture_pixels(texture, 0, 0, fw, fh);
+}
+
+void graphics_push_texture_pixels(int texture, int x, int y, int width, int height, unsigned char* pxdata) {
+  SWTexture* swtex = get_texture_peer(texture);
+  for (int i = 0; i < height; ++i) {
+    memcpy(swtex->pixels.data() + size_t(y + i) * swtex->fullwidth + x, pxdata + i * width * 4, width * 4);
+  }
+}
+
+void graphics_push_texture_pixels(int texture, int width, int height, unsigned char* pxdata) {
+  graphics_push_texture_pixels(texture, 0, 0, width, height, pxdata);
+}
+
+} // namespace enigma
+
+namespace enigma_user {
+
+void texture_set_priority(int texid, double prio)
+{
+  // nothing to page in or out of video memory
+}
+
+bool texture_mipmapping_supported()
+{
+  return false;
+}
+
+bool texture_anisotropy_supported()
+{
+  return false;
+}
+
+float texture_anisotropy_maxlevel()
+{
+  return 0;
+}
+
+} // namespace enigma_user
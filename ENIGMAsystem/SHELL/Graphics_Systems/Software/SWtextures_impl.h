@@ -0,0 +1,37 @@
+/** This file is a part of the ENIGMA Development Environment.
+***
+*** ENIGMA is free software: you can redistribute it and/or modify it under the
+*** terms of the GNU General Public License as published by the Free Software
+*** Foundation, version 3 of the license or any later version.
+***
+*** This application and its source code is distributed AS-IS, WITHOUT ANY
+*** WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+*** FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+*** details.
+***
+*** You should have received a copy of the GNU General Public License along
+*** with this code. If not, see <http://www.gnu.org/licenses/>
+**/
+
+#ifdef INCLUDED_FROM_SHELLMAIN
+#  error This file includes non-ENIGMA STL headers and should not be included from SHELLmain.
+#endif
+
+#ifndef ENIGMA_SW_TEXTURES_IMPL_H
+#define ENIGMA_SW_TEXTURES_IMPL_H
+
+#include "Graphics_Systems/General/GStextures_impl.h"
+
+#include <cstdint>
+
+namespace enigma {
+
+struct SWTexture : Texture {
+  vector<uint32_t> pixels; // fullwidth * fullheight ARGB words, top row first
+};
+
+SWTexture* get_texture_peer(int texid);
+
+} // namespace enigma
+
+#endif // ENIGMA_SW_TEXTURES_IMPL_H
@@ -0,0 +1,201 @@
+/** This file is a part of the ENIGMA Development Environment.
+***
+*** ENIGMA is free software: you can redistribute it and/or modify it under the
+*** terms of the GNU General Public License as published by the Free Software
+*** Foundation, version 3 of the license or any later version.
+***
+*** This application and its source code is distributed AS-IS, WITHOUT ANY
+*** WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+*** FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+*** details.
+***
+*** You should have received a copy of the GNU General Public License along
+*** with this code. If not, see <http://www.gnu.org/licenses/>
+**/
+
+#include "SWraster.h"
+#include "Graphics_Systems/General/GSvertex_impl.h"
+#include "Graphics_Systems/General/GSprimitives.h"
+#include "Graphics_Systems/General/GScolor_macros.h"
+#include "Graphics_Systems/General/GSstdraw.h"
+#include "Graphics_Systems/General/GScapture.h"
+
+#include <algorithm>
+#include <map>
+using std::map;
+
+using namespace enigma::software;
+
+namespace {
+
+// the "peers" are our own copies of the user's buffers, taken when they are
+// dirty just like a hardware backend would upload them
+map<int, vector<enigma::VertexElement> > vertexBufferPeers;
+map<int, vector<uint32_t> > indexBufferPeers;
+
+vector<ClipVertex> transformed;
+
+// transforms count vertices from the given one into clip space, stopping
+// early at the end of the buffer; attributes the format lacks default to
+// white and the texture's top-left corner
+void transform_vertices(int format, const vector<enigma::VertexElement>& elements, size_t first_element,
+                        size_t first, size_t count) {
+  using namespace enigma_user;
+
+  transformed.clear();
+  if (!vertex_format_exists(format)) return;
+  const auto& vertexFormat = enigma::vertexFormats[format];
+  const size_t stride = vertexFormat->stride;
+  if (!stride) return;
+
+  int position = -1, color = -1, texcoord = -1;
+  size_t position_size = 0, offset = 0;
+  for (const auto& flag : vertexFormat->flags) {
+    const size_t size = (flag.first <= vertex_type_float4) ? flag.first - vertex_type_float1 + 1 : 1;
+    if (flag.second == vertex_usage_position && position < 0) {
+      position = offset, position_size = size;
+    } else if (flag.second == vertex_usage_color && color < 0 && flag.first == vertex_type_color) {
+      color = offset;
+    } else if (flag.second == vertex_usage_textcoord && texcoord < 0 && size >= 2) {
+      texcoord = offset;
+    }
+    offset += size;
+  }
+  if (position < 0) return;
+
+  const size_t available = elements.size() > first_element ? (elements.size() - first_element) / stride : 0;
+  if (first >= available) return;
+  count = std::min(count, available - first);
+
+  transformed.resize(count);
+  const float* m = state.mvp;
+  const enigma::VertexElement* vertex = elements.data() + first_element + first * stride;
+  for (size_t i = 0; i < count; ++i, vertex += stride) {
+    const float x = vertex[position].f,
+                y = position_size > 1 ? vertex[position + 1].f : 0,
+                z = position_size > 2 ? vertex[position + 2].f : 0;
+    ClipVertex& out = transformed[i];
+    out.x = m[0] * x + m[4] * y + m[8] * z + m[12];
+    out.y = m[1] * x + m[5] * y + m[9] * z + m[13];
+    out.z = m[2] * x + m[6] * y + m[10] * z + m[14];
+    out.w = m[3] * x + m[7] * y + m[11] * z + m[15];
+    if (texcoord >= 0) {
+      out.u = vertex[texcoord].f, out.v = vertex[texcoord + 1].f;
+    } else {
+      out.u = out.v = 0;
+    }
+    if (color >= 0) {
+      const uint32_t argb = vertex[color].d;
+      out.a = argb >> 24, out.r = (argb >> 16) & 255, out.g = (argb >> 8) & 255, out.b = argb & 255;
+    } else {
+      out.a = out.r = out.g = out.b = 255;
+    }
+  }
+}
+
+} // anonymous namespace
+
+namespace enigma {
+
+void graphics_delete_vertex_buffer_peer(int buffer) {
+  vertexBufferPeers.erase(buffer);
+}
+
+void graphics_delete_index_buffer_peer(int buffer) {
+  indexBufferPeers.erase(buffer);
+}
+
+color_t graphics_pack_vertex_color(int color, double alpha) {
+  return (uint32_t(CLAMP_ALPHA(alpha)) << 24) | (COL_GET_R(color) << 16) | (COL_GET_G(color) << 8) | COL_GET_B(color);
+}
+
+// instances are expanded on the CPU either way, which is what the General
+// fallback already does
+bool graphics_instancing_supported() {
+  return false;
+}
+
+void graphics_submit_instanced(int buffer, int primitive, unsigned offset, unsigned start, unsigned count, int instances) {}
+
+void graphics_prepare_vertex_buffer(const int buffer) {
+  auto& vertexBuffer = enigma::vertexBuffers[buffer];
+
+  // if the contents of the vertex buffer are dirty then we need to update
+  // our copy of it
+  if (!vertexBuffer->dirty) return;
+
+  // swapping hands the user's buffer our old storage, so stream buffers
+  // keep their capacity instead of reallocating every frame, unless the
+  // buffer keeps its vertices for instancing and has to be copied
+  if (vertexBuffer->shadowed) {
+    vertexBufferPeers[buffer] = vertexBuffer->vertices;
+  } else {
+    vertexBufferPeers[buffer].swap(vertexBuffer->vertices);
+  }
+  vertexBuffer->clearData();
+}
+
+void graphics_prepare_index_buffer(const int buffer) {
+  auto& indexBuffer = enigma::indexBuffers[buffer];
+
+  // if the contents of the index buffer are dirty then we need to update
+  // our copy of it
+  if (!indexBuffer->dirty) return;
+
+  // widen the indices once here so drawing never has to check their type
+  vector<uint32_t>& peer = indexBufferPeers[buffer];
+  const vector<uint16_t>& indices = indexBuffer->indices;
+  peer.clear();
+  if (indexBuffer->type == enigma_user::index_type_uint) {
+    for (size_t i = 0; i + 1 < indices.size(); i += 2)
+      peer.push_back(indices[i] | (uint32_t(indices[i + 1]) << 16));
+  } else {
+    peer.assign(indices.begin(), indices.end());
+  }
+
+  indexBuffer->clearData();
+}
+
+} // namespace enigma
+
+namespace enigma_user {
+
+void vertex_argb(int buffer, unsigned argb) {
+  enigma::vertexBuffers[buffer]->vertices.push_back(argb);
+}
+
+void vertex_color(int buffer, int color, double alpha) {
+  enigma::vertexBuffers[buffer]->vertices.push_back(enigma::graphics_pack_vertex_color(color, alpha));
+}
+
+void vertex_submit_offset(int buffer, int primitive, unsigned offset, unsigned start, unsigned count) {
+  draw_state_flush();
+  enigma::capture_draw(buffer, primitive, offset, start, count);
+
+  const auto& vertexBuffer = enigma::vertexBuffers[buffer];
+
+  enigma::graphics_prepare_vertex_buffer(buffer);
+
+  transform_vertices(vertexBuffer->format, vertexBufferPeers[buffer],
+                     offset / sizeof(enigma::VertexElement), start, count);
+  draw_primitives(primitive, transformed.data(), transformed.size(), nullptr, transformed.size());
+}
+
+void index_submit_range(int buffer, int vertex, int primitive, unsigned start, unsigned count) {
+  draw_state_flush();
+  enigma::capture_draw_indexed(buffer, vertex, primitive, start, count);
+
+  const auto& vertexBuffer = enigma::vertexBuffers[vertex];
+
+  enigma::graphics_prepare_vertex_buffer(vertex);
+  enigma::graphics_prepare_index_buffer(buffer);
+
+  const vector<uint32_t>& indices = indexBufferPeers[buffer];
+  if (start >= indices.size()) return;
+  count = std::min<size_t>(count, indices.size() - start);
+
+  transform_vertices(vertexBuffer->format, vertexBufferPeers[vertex], 0, 0, vertexBufferPeers[vertex].size());
+  draw_primitives(primitive, transformed.data(), transformed.size(), indices.data() + start, count);
+}
+
+} // namespace enigma_user
@@ -0,0 +1,3 @@
+#include "SoftwareStd.h"
+#include "Info/graphics_info.h"
+#include "Graphics_Systems/General/include.h"
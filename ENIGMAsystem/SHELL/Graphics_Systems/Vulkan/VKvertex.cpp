@@ -46,6 +46,18 @@ void graphics_delete_index_buffer_peer(int buffer) {
 
 }
 
+color_t graphics_pack_vertex_color(int color, double alpha) {
+  return 0;
+}
+
+bool graphics_instancing_supported() {
+  return false;
+}
+
+void graphics_submit_instanced(int buffer, int primitive, unsigned offset, unsigned start, unsigned count, int instances) {
+
+}
+
 } // namespace enigma
 
 namespace enigma_user {
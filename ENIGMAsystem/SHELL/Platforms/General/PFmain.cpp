@@ -7,6 +7,7 @@
 #include "Universal_System/roomsystem.h"
 #include "Universal_System/mathnc.h" // enigma_user::clamp
 
+#include "PFtasks.h"
 #include "Universal_System/Extensions/Steamworks/steamworks.h"
 
 #include <chrono> // std::chrono::microseconds
@@ -173,20 +174,26 @@ int updateTimer() {
 }
 
 void fireEventsFromQueue() {
-  // Acquire lock and release it when out of scope of fireEventsFromQueue().
-  std::lock_guard<std::mutex> guard(posted_async_events_mutex);
-  while (!posted_async_events.empty()) {
-    enigma_user::ds_map_clear(enigma_user::async_load);
-
-    std::map<std::string, variant> event = posted_async_events.front();
-
-    posted_async_events.pop();
+  for (;;) {
+    std::map<std::string, variant> event;
+    {
+      // Not held while the event runs, which may wait on a task that posts.
+      std::lock_guard<std::mutex> guard(posted_async_events_mutex);
+      if (posted_async_events.empty()) break;
+      event = posted_async_events.front();
+      posted_async_events.pop();
+    }
 
+    enigma_user::ds_map_clear(enigma_user::async_load);
     for (auto& [key, value] : event) {
       enigma_user::ds_map_add(enigma_user::async_load, key, value);
     }
 
-    enigma::fireSteamworksEvent();
+    if (event["event_type"] == "task_complete") {
+      enigma::fireTaskEvent();
+    } else {
+      enigma::fireSteamworksEvent();
+    }
   }
 }
 
@@ -243,7 +250,7 @@ int enigma_main(int argc, char** argv) {
 
 namespace enigma_user {
 
-int async_load;
+uint64_t async_load;
 
 const int os_browser = browser_not_a_browser;
 std::string working_directory = "";
@@ -20,6 +20,7 @@
 #ifndef ENIGMA_PLATFORM_MAIN
 #define ENIGMA_PLATFORM_MAIN
 
+#include <cstdint>
 #include <map>
 #include <mutex>
 #include <queue>
@@ -90,7 +91,7 @@ extern unsigned long current_time;
  *        contain the data that will be sent to the game.
  * 
  */
-extern int async_load;
+extern uint64_t async_load;
 
 void sleep(int ms);
 unsigned long get_timer();  // number of microseconds since the game started
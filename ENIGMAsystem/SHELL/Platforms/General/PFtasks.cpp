@@ -0,0 +1,134 @@
+/** This file is a part of the ENIGMA Development Environment.
+***
+*** ENIGMA is free software: you can redistribute it and/or modify it under the
+*** terms of the GNU General Public License as published by the Free Software
+*** Foundation, version 3 of the license or any later version.
+***
+*** This application and its source code is distributed AS-IS, WITHOUT ANY
+*** WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+*** FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+*** details.
+***
+*** You should have received a copy of the GNU General Public License along
+*** with this code. If not, see <http://www.gnu.org/licenses/>
+**/
+
+#include "PFtasks.h"
+#include "PFmain.h"
+
+#include "Universal_System/Instances/instance_system.h"
+#include "Universal_System/Object_Tiers/object.h"
+#include "Universal_System/Resources/resource_data.h" //script_execute
+#include "Universal_System/worker_pool.h"
+#include "Widget_Systems/widgets_mandatory.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+
+namespace {
+
+struct task_state {
+  std::atomic<bool> done{false};
+  variant ret;
+  std::mutex mutex;
+  std::condition_variable finished;
+};
+
+// Tasks may be created from other tasks, so the handles are shared with workers.
+std::deque<std::shared_ptr<task_state>> tasks;
+std::mutex tasks_mutex;
+
+std::shared_ptr<task_state> get_task(int task) {
+  {
+    std::lock_guard<std::mutex> lock(tasks_mutex);
+    if (task >= 0 && size_t(task) < tasks.size() && tasks[task]) return tasks[task];
+  }
+  DEBUG_MESSAGE("Task " + std::to_string(task) + " does not exist", MESSAGE_TYPE::M_USER_ERROR);
+  return nullptr;
+}
+
+} //namespace
+
+namespace enigma {
+
+void fireTaskEvent() {
+  instance_event_iterator = &dummy_event_iterator;
+  for (iterator it = instance_list_first(); it; ++it) {
+    it->myevent_task();
+  }
+}
+
+} //namespace enigma
+
+namespace enigma_user {
+
+int task_create_script(int scr, variant arg0, variant arg1, variant arg2, variant arg3, variant arg4, variant arg5, variant arg6, variant arg7) {
+  std::shared_ptr<task_state> state = std::make_shared<task_state>();
+  int id;
+  {
+    std::lock_guard<std::mutex> lock(tasks_mutex);
+    id = tasks.size();
+    tasks.push_back(state);
+  }
+  enigma::worker_submit([=] {
+    state->ret = script_execute(scr, arg0, arg1, arg2, arg3, arg4, arg5, arg6, arg7);
+    const std::map<std::string, variant> event = {
+        {"id", id},
+        {"event_type", "task_complete"},
+        {"status", 1},
+        {"result", state->ret}};
+    {
+      std::lock_guard<std::mutex> lock(state->mutex);
+      state->done = true;
+    }
+    state->finished.notify_all();
+    // Waiters are woken first; the event only runs on a later frame.
+    std::lock_guard<std::mutex> guard(enigma::posted_async_events_mutex);
+    enigma::posted_async_events.push(event);
+  });
+  return id;
+}
+
+bool task_exists(int task) {
+  std::lock_guard<std::mutex> lock(tasks_mutex);
+  return task >= 0 && size_t(task) < tasks.size() && tasks[task];
+}
+
+bool task_get_finished(int task) {
+  std::shared_ptr<task_state> state = get_task(task);
+  return state && state->done;
+}
+
+variant task_get_return(int task) {
+  std::shared_ptr<task_state> state = get_task(task);
+  return state && state->done ? state->ret : variant();
+}
+
+variant task_wait(int task) {
+  std::shared_ptr<task_state> state = get_task(task);
+  if (!state) return variant();
+  while (!state->done) {
+    if (enigma::worker_help()) continue;
+    std::unique_lock<std::mutex> lock(state->mutex);
+    state->finished.wait(lock, [&state] { return state->done.load(); });
+  }
+  return state->ret;
+}
+
+void task_delete(int task) {
+  if (!get_task(task)) return;
+  std::lock_guard<std::mutex> lock(tasks_mutex);
+  tasks[task].reset();
+}
+
+void script_parallel_for(int scr, int first, int last, variant arg0, variant arg1, variant arg2, variant arg3, variant arg4, variant arg5, variant arg6) {
+  if (last <= first) return;
+  enigma::parallel_for(last - first, [&](size_t i) {
+    script_execute(scr, first + int(i), arg0, arg1, arg2, arg3, arg4, arg5, arg6);
+  });
+}
+
+} //namespace enigma_user
@@ -0,0 +1,48 @@
+/** This file is a part of the ENIGMA Development Environment.
+***
+*** ENIGMA is free software: you can redistribute it and/or modify it under the
+*** terms of the GNU General Public License as published by the Free Software
+*** Foundation, version 3 of the license or any later version.
+***
+*** This application and its source code is distributed AS-IS, WITHOUT ANY
+*** WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+*** FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+*** details.
+***
+*** You should have received a copy of the GNU General Public License along
+*** with this code. If not, see <http://www.gnu.org/licenses/>
+**/
+
+#ifndef ENIGMA_PLATFORM_TASKS_H
+#define ENIGMA_PLATFORM_TASKS_H
+
+#include "Universal_System/var4.h"
+
+// Tasks run scripts on the runtime's worker pool rather than on threads of
+// their own. Scripts run this way must be pure: they may use their arguments
+// and local variables, but not instances, globals, resources or graphics.
+namespace enigma_user {
+  // Queues scr(arg0, ...) to run in the background and returns a handle to
+  // it. When the script returns, the Task event of every instance runs with
+  // async_load holding "event_type" = "task_complete", "id" and "result".
+  int task_create_script(int scr, variant arg0 = 0, variant arg1 = 0, variant arg2 = 0, variant arg3 = 0, variant arg4 = 0, variant arg5 = 0, variant arg6 = 0, variant arg7 = 0);
+  bool task_exists(int task);
+  bool task_get_finished(int task);
+  variant task_get_return(int task);
+  // Blocks until the task has finished and returns its result, running
+  // other queued tasks in the meantime.
+  variant task_wait(int task);
+  // Forgets the handle; a task still running finishes and posts its event.
+  void task_delete(int task);
+
+  // Calls scr(i, arg0, ...) for every i from first up to, but not including,
+  // last, spread across the worker pool. Returns when every call has.
+  void script_parallel_for(int scr, int first, int last, variant arg0 = 0, variant arg1 = 0, variant arg2 = 0, variant arg3 = 0, variant arg4 = 0, variant arg5 = 0, variant arg6 = 0);
+} //namespace enigma_user
+
+namespace enigma {
+  // Runs the Task event of every instance, for the completion in async_load.
+  void fireTaskEvent();
+} //namespace enigma
+
+#endif //ENIGMA_PLATFORM_TASKS_H
@@ -34,6 +34,18 @@ int feof_wrapper(FILE_t* context);
 int64_t ftell_wrapper(FILE_t* context);
 size_t fwrite_wrapper(const void *ptr, size_t size, size_t count, FILE_t* context);
 
+/// Read-only view of a whole file. Backed by the OS page cache where the
+/// platform supports memory mapping, or by a heap copy of the file otherwise.
+/// A copy-on-write view may be written through; the changes stay private to
+/// the view and never reach the file.
+struct FileMapping {
+  const unsigned char* data = nullptr;
+  size_t size = 0;
+  void* handle = nullptr;  // Platform specific; owned by the wrapper.
+};
+bool fmap_wrapper(const char* fname, FileMapping* mapping, bool copy_on_write = false);
+void funmap_wrapper(FileMapping* mapping);
+
 #include <string>
 
 namespace enigma_user {
@@ -60,6 +72,8 @@ size_t file_bin_position(int fileid);
 void file_bin_seek(int fileid, size_t pos);
 void file_bin_write_byte(int fileid, unsigned char byte);
 int file_bin_read_byte(int fileid);
+size_t file_bin_read_buffer(int fileid, int buffer, size_t offset, size_t size);
+size_t file_bin_write_buffer(int fileid, int buffer, size_t offset, size_t size);
 
 } //namespace enigma_user
 
@@ -1,5 +1,14 @@
 #include "Platforms/General/fileio.h"
 
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 size_t fread_wrapper(void* ptr, size_t size, size_t maxnum, FILE_t* context) { 
   return fread(ptr, size, maxnum, context);
 }
@@ -43,3 +52,62 @@ int64_t ftell_wrapper(FILE_t* context) {
 size_t fwrite_wrapper(const void *ptr, size_t size, size_t count, FILE_t* context) {
   return fwrite(ptr, size, count, context);
 }
+
+#ifdef _WIN32
+
+bool fmap_wrapper(const char* fname, FileMapping* mapping, bool copy_on_write) {
+  HANDLE file = CreateFileA(fname, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                            FILE_ATTRIBUTE_NORMAL, nullptr);
+  if (file == INVALID_HANDLE_VALUE) return false;
+  LARGE_INTEGER size;
+  if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+    CloseHandle(file);
+    return false;
+  }
+  HANDLE view = CreateFileMappingA(file, nullptr, copy_on_write ? PAGE_WRITECOPY : PAGE_READONLY, 0, 0, nullptr);
+  CloseHandle(file);
+  if (!view) return false;
+  void* data = MapViewOfFile(view, copy_on_write ? FILE_MAP_COPY : FILE_MAP_READ, 0, 0, 0);
+  if (!data) {
+    CloseHandle(view);
+    return false;
+  }
+  mapping->data = static_cast<const unsigned char*>(data);
+  mapping->size = size.QuadPart;
+  mapping->handle = view;
+  return true;
+}
+
+void funmap_wrapper(FileMapping* mapping) {
+  if (!mapping->data) return;
+  UnmapViewOfFile(mapping->data);
+  CloseHandle(mapping->handle);
+  *mapping = FileMapping();
+}
+
+#else
+
+bool fmap_wrapper(const char* fname, FileMapping* mapping, bool copy_on_write) {
+  int fd = open(fname, O_RDONLY);
+  if (fd < 0) return false;
+  struct stat st;
+  if (fstat(fd, &st) || st.st_size == 0) {
+    close(fd);
+    return false;
+  }
+  void* data = mmap(nullptr, st.st_size, copy_on_write ? PROT_READ | PROT_WRITE : PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (data == MAP_FAILED) return false;
+  mapping->data = static_cast<const unsigned char*>(data);
+  mapping->size = st.st_size;
+  mapping->handle = nullptr;
+  return true;
+}
+
+void funmap_wrapper(FileMapping* mapping) {
+  if (!mapping->data) return;
+  munmap(const_cast<unsigned char*>(mapping->data), mapping->size);
+  *mapping = FileMapping();
+}
+
+#endif
@@ -7,6 +7,7 @@
 #include "PFmain.h"
 #include "PFwindow.h"
 #include "PFthreads.h"
+#include "PFtasks.h"
 #include "PFfilemanip.h"
 #include "PFexternals.h"
 #include "PFsystem.h"
@@ -50,3 +50,32 @@ int64_t ftell_wrapper(FILE_t* context) {
 size_t fwrite_wrapper(const void *ptr, size_t size, size_t count, FILE_t* context) {
   return SDL_RWwrite(context, ptr, size, count);
 }
+
+// SDL_RWops may be backed by an Android asset or an archive, neither of which
+// can be mapped, so the "mapping" is a heap copy of the whole file. That copy
+// is always safe to write, so copy_on_write needs no special handling.
+bool fmap_wrapper(const char* fname, FileMapping* mapping, bool /*copy_on_write*/) {
+  SDL_RWops* file = SDL_RWFromFile(fname, "rb");
+  if (!file) return false;
+  Sint64 size = SDL_RWsize(file);
+  if (size <= 0) {
+    SDL_RWclose(file);
+    return false;
+  }
+  unsigned char* data = new unsigned char[size];
+  if (SDL_RWread(file, data, 1, size) != size_t(size)) {
+    delete[] data;
+    SDL_RWclose(file);
+    return false;
+  }
+  SDL_RWclose(file);
+  mapping->data = data;
+  mapping->size = size;
+  mapping->handle = data;
+  return true;
+}
+
+void funmap_wrapper(FileMapping* mapping) {
+  delete[] static_cast<unsigned char*>(mapping->handle);
+  *mapping = FileMapping();
+}
@@ -104,7 +104,6 @@ void extension_async_init() {
 } // namespace enigma
 
 namespace enigma_user {
-  unsigned async_load = -1;
 
   int show_message_async(string str) {
     auto fnc = [=] {
@@ -18,6 +18,7 @@
 #ifndef ENIGMA_ASYNCDIALOG_H
 #define ENIGMA_ASYNCDIALOG_H
 
+#include <cstdint>
 #include <string>
 using std::string;
 
@@ -28,7 +29,7 @@ void extension_async_init();
 } // namespace enigma
 
 namespace enigma_user {
-  extern unsigned async_load;
+  extern uint64_t async_load;
 
   int show_message_async(string str);
   int show_question_async(string str);
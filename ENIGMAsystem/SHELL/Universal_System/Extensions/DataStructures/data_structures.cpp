@@ -39,16 +39,17 @@
 
 #include <floatcomp.h>
 
-using namespace std;
+#include "ds_binary.h"
+#include "ds_registry.h"
+#include "variant_grid.h"
+#include "variant_map.h"
 
-#include "include.h"
+#include "Universal_System/Resources/resource_data.h" //script_execute
+#include "Universal_System/worker_pool.h"
 
-template<typename T> static inline T maxv(T a, T b) { return (a > b) ? a : b; }
-template<typename T> static inline T minv(T a, T b) { return (a < b) ? a : b; }
+using namespace std;
 
-template<typename t> bool tequal(t v1, t v2) { return v1 == v2; }
-template<> bool tequal(float v1, float v2)   { return fequal(v1, v2); }
-template<> bool tequal(double v1, double v2) { return fequal(v1, v2); }
+#include "include.h"
 
 template<class RandomIt>
 void mt_random_shuffle(RandomIt first, RandomIt last) {
@@ -57,666 +58,257 @@ void mt_random_shuffle(RandomIt first, RandomIt last) {
   std::shuffle(first, last, g);
 }
 
-template <typename t>
-class grid
-{
-    unsigned int xgrid, ygrid;
-    t *grid_array;
-
-    public:
-    grid() {}
-    grid(const unsigned int w, const unsigned int h) {
-      ygrid = h; xgrid = w; grid_array = new t[w*h];
-    }
-    ~grid() {}
-
-    void destroy()
-    {
-        delete[] grid_array;
-    }
-    void clear(const t val)
-    {
-        for (unsigned i = 0; i < ygrid; i++)
-            for (unsigned ii = 0; ii < xgrid; ii++)
-                grid_array[i * xgrid + ii] = val;
-    }
-    void resize(unsigned w, unsigned h)
-    {
-        grid<variant> temp(w, h);
-        const unsigned int wm = minv(xgrid, w), hm = minv(ygrid, h);
-        for (unsigned i = 0; i < hm; i++)
-            for (unsigned ii = 0; ii < wm; ii++)
-                temp.grid_array[i * w + ii] = grid_array[i * xgrid + ii];
-        delete[] grid_array;
-        (*this) = temp;
-    }
-    void copy(const grid& copy_id)
-    {
-        delete[] grid_array;
-        grid_array = new t[copy_id.ygrid*copy_id.xgrid];
-        xgrid = copy_id.xgrid;
-        ygrid = copy_id.ygrid;
-        for (unsigned i = 0; i < ygrid; i++)
-            for (unsigned ii = 0; ii < xgrid; ii++)
-                grid_array[i * xgrid + ii] = copy_id.grid_array[i * copy_id.xgrid + ii];
-    }
-    unsigned int width()
-    {
-        return xgrid;
-    }
-    unsigned int height()
-    {
-        return ygrid;
-    }
-    void insert(const unsigned int x, const unsigned int y, const t val)
-    {
-        if (x < xgrid && y < ygrid)
-            grid_array[y * xgrid + x] = val;
-    }
-    void add(const unsigned int x, const unsigned int y, const t val)
-    {
-        if (x < xgrid && y < ygrid)
-            grid_array[y * xgrid + x] += val;
-    }
-    void multiply(const unsigned int x, const unsigned int y, const double val)
-    {
-        if (x < xgrid && y < ygrid)
-            grid_array[y * xgrid + x] *= val;
-    }
-    void insert_region(const unsigned int x1, const unsigned int y1, unsigned int x2, const unsigned int y2, const t val)
-    {
-       const int tx1 = minv(x1, x2),  ty1 = minv(y1, y2), tx2 = maxv(x1, x2), ty2 = maxv(y1, y2), xd = xgrid - tx1, yd = ygrid - ty1;
-       if (xd > 0 && yd > 0)
-       {
-           const int px1 = maxv(tx1, 0), py1 = maxv(ty1, 0), px2 = minv(tx2 + 1, (int)xgrid), py2 = minv(ty2 + 1, (int)ygrid);
-           for (int i = py1; i < py2; i++)
-               for (int ii = px1; ii < px2; ii++)
-                   grid_array[i * xgrid + ii] = val;
-       }
-    }
-    void add_region(const unsigned int x1, const unsigned int y1, unsigned int x2, const unsigned int y2, const t val)
-    {
-       const int tx1 = minv(x1, x2),  ty1 = minv(y1, y2), tx2 = maxv(x1, x2), ty2 = maxv(y1, y2), xd = xgrid - tx1, yd = ygrid - ty1;
-       if (xd > 0 && yd > 0)
-       {
-           const int px1 = maxv(tx1, 0), py1 = maxv(ty1, 0), px2 = minv(tx2 + 1, (int)xgrid), py2 = minv(ty2 + 1, (int)ygrid);
-           for (int i = py1; i < py2; i++)
-               for (int ii = px1; ii < px2; ii++)
-                   grid_array[i * xgrid + ii] += val;
-       }
-    }
-    void multiply_region(const unsigned int x1, const unsigned int y1, unsigned int x2, const unsigned int y2, const double val)
-    {
-       const int tx1 = minv(x1, x2),  ty1 = minv(y1, y2), tx2 = maxv(x1, x2), ty2 = maxv(y1, y2), xd = xgrid - tx1, yd = ygrid - ty1;
-       if (xd > 0 && yd > 0)
-       {
-           const int px1 = maxv(tx1, 0), py1 = maxv(ty1, 0), px2 = minv(tx2 + 1, (int)xgrid), py2 = minv(ty2 + 1, (int)ygrid);
-           for (int i = py1; i < py2; i++)
-               for (int ii = px1; ii < px2; ii++)
-                   grid_array[i * xgrid + ii] *= val;
-       }
-    }
-    void insert_disk(const double x, const double y, const double r, const t val)
-    {
-        const double rr = r*r;
-        const int tx1 = int(x - r), ty1 = int(y - r), tx2 = int(x + r + 1), ty2 = int(y + r + 1);
-        if (tx2 >= 0 && ty2 >=0 && tx1 < int(xgrid) && ty1 < int(ygrid))
-        {
-            const int px1 = maxv(tx1, 0), py1 = maxv(ty1, 0), px2 = minv(tx2, (int)xgrid), py2 = minv(ty2, (int)ygrid);
-            for (int i = py1; i < py2; i++)
-                for (int ii = px1; ii < px2; ii++)
-                    if ((x - ii)*(x - ii) + (y - i)*(y - i) <= rr)
-                        grid_array[i * xgrid + ii] = val;
-        }
-    }
-    void add_disk(const double x, const double y, const double r, const t val)
-    {
-        const double rr = r*r;
-        const int tx1 = int(x - r), ty1 = int(y - r), tx2 = int(x + r + 1), ty2 = int(y + r + 1);
-        if (tx2 >= 0 && ty2 >=0 && tx1 < int(xgrid) && ty1 < int(ygrid))
-        {
-            const int px1 = maxv(tx1, 0), py1 = maxv(ty1, 0), px2 = minv(tx2, (int)xgrid), py2 = minv(ty2, (int)ygrid);
-            for (int i = py1; i < py2; i++)
-                for (int ii = px1; ii < px2; ii++)
-                    if ((x - ii)*(x - ii) + (y - i)*(y - i) <= rr)
-                        grid_array[i * xgrid + ii] += val;
-        }
-    }
-    void multiply_disk(const double x, const double y, const double r, const double val)
-    {
-        const double rr = r*r;
-        const int tx1 = int(x - r), ty1 = int(y - r), tx2 = int(x + r + 1), ty2 = int(y + r + 1);
-        if (tx2 >= 0 && ty2 >=0 && tx1 < int(xgrid) && ty1 < int(ygrid))
-        {
-            const int px1 = maxv(tx1, 0), py1 = maxv(ty1, 0), px2 = minv(tx2, (int)xgrid), py2 = minv(ty2, (int)ygrid);
-            for (int i = py1; i < py2; i++)
-                for (int ii = px1; ii < px2; ii++)
-                    if ((x - ii)*(x - ii) + (y - i)*(y - i) <= rr)
-                        grid_array[i * xgrid + ii] *= val;
-        }
-    }
-    void insert_grid_region(const grid& source_id, const unsigned int sx1, const unsigned int sy1, const unsigned int sx2, const unsigned int sy2, const unsigned int x, const unsigned int y)
-    {
-        if (x < xgrid && y < ygrid)
-        {
-            const int tx1 = minv(sx1, sx2),  ty1 = minv(sy1, sy2), tx2 = maxv(sx1, sx2), ty2 = maxv(sy1, sy2), xd = source_id.xgrid - tx1, yd = source_id.ygrid - ty1;
-            if (xd > 0 && yd > 0)
-            {
-                const int upx = minv(tx2 - tx1 + 1, minv(int(xgrid - x), xd)), upy = minv(ty2 - ty1 + 1, minv(int(ygrid - y), yd));
-                for (int i = 0; i < upy; i++)
-                    for (int ii = 0; ii < upx; ii++)
-                        grid_array[(y + i)*xgrid + (x + ii)] = source_id.grid_array[(ty1 + i)*source_id.xgrid + (tx1 + ii)];
-            }
-        }
-    }
-    void add_grid_region(const grid& source_id, const unsigned int sx1, const unsigned int sy1, const unsigned int sx2, const unsigned int sy2, const unsigned int x, const unsigned int y)
-    {
-        if (x < xgrid && y < ygrid)
-        {
-            const int tx1 = minv(sx1, sx2),  ty1 = minv(sy1, sy2), tx2 = maxv(sx1, sx2), ty2 = maxv(sy1, sy2), xd = source_id.xgrid - tx1, yd = source_id.ygrid - ty1;
-            if (xd > 0 && yd > 0)
-            {
-                const int upx = minv(tx2 - tx1 + 1, minv(int(xgrid - x), xd)), upy = minv(ty2 - ty1 + 1, minv(int(ygrid - y), yd));
-                for (int i = 0; i < upy; i++)
-                    for (int ii = 0; ii < upx; ii++)
-                        grid_array[(y + i)*xgrid + (x + ii)] += source_id.grid_array[(ty1 + i)*source_id.xgrid + (tx1 + ii)];
-            }
-        }
-    }
-    void multiply_grid_region(const grid& source_id, const unsigned int sx1, const unsigned int sy1, const unsigned int sx2, const unsigned int sy2, const unsigned int x, const unsigned int y)
-    {
-        if (x < xgrid && y < ygrid)
-        {
-            const int tx1 = minv(sx1, sx2),  ty1 = minv(sy1, sy2), tx2 = maxv(sx1, sx2), ty2 = maxv(sy1, sy2), xd = source_id.xgrid - tx1, yd = source_id.ygrid - ty1;
-            if (xd > 0 && yd > 0)
-            {
-                const int upx = minv(tx2 - tx1 + 1, minv(int(xgrid - x), xd)), upy = minv(ty2 - ty1 + 1, minv(int(ygrid - y), yd));
-                for (int i = 0; i < upy; i++)
-                    for (int ii = 0; ii < upx; ii++)
-                        grid_array[(y + i)*xgrid + (x + ii)] *= source_id.grid_array[(ty1 + i)*source_id.xgrid + (tx1 + ii)];
-            }
-        }
-    }
-
-    t find(unsigned int x, unsigned int y)
-    {
-        return (grid_array[y * xgrid + x]);
-    }
-    t find_region_sum(unsigned int x1, unsigned int y1, unsigned int x2, unsigned int y2)
-    {
-       const int tx1 = minv(x1, x2),  ty1 = minv(y1, y2), tx2 = maxv(x1, x2), ty2 = maxv(y1, y2), xd = xgrid - tx1, yd = ygrid - ty1;
-       if (xd > 0 && yd > 0)
-       {
-           const int px1 = maxv(tx1, 0), py1 = maxv(ty1, 0), px2 = minv(tx2 + 1, (int)xgrid), py2 = minv(ty2 + 1, (int)ygrid);
-           variant sum = 0;
-           for (int i = py1; i < py2; i++)
-               for (int ii = px1; ii < px2; ii++)
-                   sum += grid_array[i * xgrid + ii];
-           return sum;
-       }
-       return t();
-    }
-    t find_region_max(unsigned int x1, unsigned int y1, unsigned int x2, unsigned int y2)
-    {
-       const int tx1 = minv(x1, x2),  ty1 = minv(y1, y2), tx2 = maxv(x1, x2), ty2 = maxv(y1, y2), xd = xgrid - tx1, yd = ygrid - ty1;
-       t val_check;
-       if (xd > 0 && yd > 0)
-       {
-           const int px1 = maxv(tx1, 0), py1 = maxv(ty1, 0), px2 = minv(tx2 + 1, (int)xgrid), py2 = minv(ty2 + 1, (int)ygrid);
-           t max_check = grid_array[py1 * xgrid + px1];
-           for (int i = py1; i < py2; i++)
-               for (int ii = px1; ii < px2; ii++)
-               {
-                   val_check = grid_array[i * xgrid + ii];
-                   if (val_check > max_check)
-                       max_check = val_check;
-               }
-           return max_check;
-       }
-       return t();
-    }
-    t find_region_min(unsigned int x1, unsigned int y1, unsigned int x2, unsigned int y2)
-    {
-       const int tx1 = minv(x1, x2),  ty1 = minv(y1, y2), tx2 = maxv(x1, x2), ty2 = maxv(y1, y2), xd = xgrid - tx1, yd = ygrid - ty1;
-       t val_check;
-       if (xd > 0 && yd > 0)
-       {
-           const int px1 = maxv(tx1, 0), py1 = maxv(ty1, 0), px2 = minv(tx2 + 1, (int)xgrid), py2 = minv(ty2 + 1, (int)ygrid);
-           t min_check = grid_array[py1 * xgrid + px1];
-           for (int i = py1; i < py2; i++)
-               for (int ii = px1; ii < px2; ii++)
-               {
-                   val_check = grid_array[i * xgrid + ii];
-                   if (val_check < min_check)
-                       min_check = val_check;
-               }
-           return min_check;
-       }
-       return t();
-    }
-    t find_region_mean(unsigned int x1, unsigned int y1, unsigned int x2, unsigned int y2)
-    {
-       const int tx1 = minv(x1, x2),  ty1 = minv(y1, y2), tx2 = maxv(x1, x2), ty2 = maxv(y1, y2), xd = xgrid - tx1, yd = ygrid - ty1;
-       if (xd > 0 && yd > 0)
-       {
-           const int px1 = maxv(tx1, 0), py1 = maxv(ty1, 0), px2 = minv(tx2 + 1, (int)xgrid), py2 = minv(ty2 + 1, (int)ygrid);
-           t sum = 0;
-           for (int i = py1; i < py2; i++)
-               for (int ii = px1; ii < px2; ii++)
-                   sum += grid_array[i * xgrid + ii];
-           const double region_size = (py2 - py1)*(px2 - px1);
-           return sum/region_size;
-       }
-       return t();
-    }
-    t find_disk_sum(const double x, const double y, const double r)
-    {
-        const double rr = r*r;
-        const int tx1 = int(x - r), ty1 = int(y - r), tx2 = int(x + r + 1), ty2 = int(y + r + 1);
-        if (tx2 >= 0 && ty2 >=0 && tx1 < int(xgrid) && ty1 < int(ygrid))
-        {
-            const int px1 = maxv(tx1, 0), py1 = maxv(ty1, 0), px2 = minv(tx2, (int)xgrid), py2 = minv(ty2, (int)ygrid);
-            t sum = t();
-            for (int i = py1; i < py2; i++)
-                for (int ii = px1; ii < px2; ii++)
-                    if ((x - ii)*(x - ii) + (y - i)*(y - i) <= rr)
-                        sum += grid_array[i * xgrid + ii];
-            return sum;
-        }
-        return t();
-    }
-    t find_disk_max(const double x, const double y, const double r)
-    {
-        const double rr = r*r;
-        const int tx1 = int(x - r), ty1 = int(y - r), tx2 = int(x + r + 1), ty2 = int(y + r + 1);
-        if (tx2 >= 0 && ty2 >=0 && tx1 < int(xgrid) && ty1 < int(ygrid))
-        {
-            const int px1 = maxv(tx1, 0), py1 = maxv(ty1, 0), px2 = minv(tx2, (int)xgrid), py2 = minv(ty2, (int)ygrid);
-            t max_check = grid_array[py1 * xgrid + px1];
-            for (int i = py1; i < py2; i++)
-                for (int ii = px1; ii < px2; ii++)
-                    if ((x - ii)*(x - ii) + (y - i)*(y - i) <= rr)
-                    {
-                        const double val_check = grid_array[i * xgrid + ii];
-                        if (val_check > max_check)
-                            max_check = val_check;
-                    }
-            return max_check;
-        }
-        return t();
-    }
-    t find_disk_min(const double x, const double y, const double r)
-    {
-        const double rr = r*r;
-        const int tx1 = int(x - r), ty1 = int(y - r), tx2 = int(x + r + 1), ty2 = int(y + r + 1);
-        if (tx2 >= 0 && ty2 >=0 && tx1 < int(xgrid) && ty1 < int(ygrid))
-        {
-            const int px1 = maxv(tx1, 0), py1 = maxv(ty1, 0), px2 = minv(tx2, (int)xgrid), py2 = minv(ty2, (int)ygrid);
-            t min_check = grid_array[lrint(y) * xgrid + lrint(x)];
-            for (int i = py1; i < py2; i++)
-                for (int ii = px1; ii < px2; ii++)
-                    if ((x - ii)*(x - ii) + (y - i)*(y - i) <= rr)
-                    {
-                        const double val_check = grid_array[i * xgrid + ii];
-                        if (val_check < min_check)
-                            min_check = val_check;
-                    }
-            return min_check;
-        }
-        return t();
-    }
-    t find_disk_mean(const double x, const double y, const double r)
-    {
-        const double rr = r*r;
-        const int tx1 = int(x - r), ty1 = int(y - r), tx2 = int(x + r + 1), ty2 = int(y + r + 1);
-        if (tx2 >= 0 && ty2 >=0 && tx1 < int(xgrid) && ty1 < int(ygrid))
-        {
-            const int px1 = maxv(tx1, 0), py1 = maxv(ty1, 0), px2 = minv(tx2, (int)xgrid), py2 = minv(ty2, (int)ygrid);
-            t sum = t();
-            double region_size = 0;
-            for (int i = py1; i < py2; i++)
-                for (int ii = px1; ii < px2; ii++)
-                    if ((x - ii)*(x - ii) + (y - i)*(y - i) <= rr)
-                    {
-                        sum += grid_array[i * xgrid + ii];
-                        ++region_size;
-                    }
-           return sum/region_size;
-        }
-        return t();
-    }
-    bool value_region_exists(unsigned int x1, unsigned int y1, unsigned int x2, unsigned int y2, const t val)
-    {
-       const int tx1 = minv(x1, x2),  ty1 = minv(y1, y2), tx2 = maxv(x1, x2), ty2 = maxv(y1, y2), xd = xgrid - tx1, yd = ygrid - ty1;
-       if (xd > 0 && yd > 0)
-       {
-           const int px1 = maxv(tx1, 0), py1 = maxv(ty1, 0), px2 = minv(tx2 + 1, (int)xgrid), py2 = minv(ty2 + 1, (int)ygrid);
-           for (int i = py1; i < py2; i++)
-               for (int ii = px1; ii < px2; ii++)
-                   if (tequal(grid_array[i * xgrid + ii], val))
-                       return true;
-       }
-       return false;
-    }
-    int value_region_x(unsigned int x1, unsigned int y1, unsigned int x2, unsigned int y2, const t val)
-    {
-       const int tx1 = minv(x1, x2),  ty1 = minv(y1, y2), tx2 = maxv(x1, x2), ty2 = maxv(y1, y2), xd = xgrid - tx1, yd = ygrid - ty1;
-       if (xd > 0 && yd > 0)
-       {
-           const int px1 = maxv(tx1, 0), py1 = maxv(ty1, 0), px2 = minv(tx2 + 1, (int)xgrid), py2 = minv(ty2 + 1, (int)ygrid);
-           for (int i = py1; i < py2; i++)
-               for (int ii = px1; ii < px2; ii++)
-                   if (tequal(grid_array[i * xgrid + ii], val))
-                      return ii;
-       }
-       return 0;
-    }
-    int value_region_y(unsigned int x1, unsigned int y1, unsigned int x2, unsigned int y2, const t val)
-    {
-       const int tx1 = minv(x1, x2),  ty1 = minv(y1, y2), tx2 = maxv(x1, x2), ty2 = maxv(y1, y2), xd = xgrid - tx1, yd = ygrid - ty1;
-       if (xd > 0 && yd > 0)
-       {
-           const int px1 = maxv(tx1, 0), py1 = maxv(ty1, 0), px2 = minv(tx2 + 1, (int)xgrid), py2 = minv(ty2 + 1, (int)ygrid);
-           for (int i = py1; i < py2; i++)
-               for (int ii = px1; ii < px2; ii++)
-                   if (tequal(grid_array[i * xgrid + ii], val))
-                       return i;
-       }
-       return 0;
-    }
-    bool value_disk_exists(const double x, const double y, const double r, const t val)
-    {
-        const double rr = r*r;
-        const int tx1 = int(x - r), ty1 = int(y - r), tx2 = int(x + r + 1), ty2 = int(y + r + 1);
-        if (tx2 >= 0 && ty2 >=0 && tx1 < int(xgrid) && ty1 < int(ygrid))
-        {
-            const int px1 = maxv(tx1, 0), py1 = maxv(ty1, 0), px2 = minv(tx2, (int)xgrid), py2 = minv(ty2, (int)ygrid);
-            for (int i = py1; i < py2; i++)
-                for (int ii = px1; ii < px2; ii++)
-                    if ((x - ii)*(x - ii) + (y - i)*(y - i) <= rr)
-                        if (tequal(grid_array[i * xgrid + ii], val))
-                            return true;
-        }
-        return false;
-    }
-    int value_disk_x(const double x, const double y, const double r, const t val)
-    {
-        const double rr = r*r;
-        const int tx1 = int(x - r), ty1 = int(y - r), tx2 = int(x + r + 1), ty2 = int(y + r + 1);
-        if (tx2 >= 0 && ty2 >=0 && tx1 < int(xgrid) && ty1 < int(ygrid))
-        {
-            const int px1 = maxv(tx1, 0), py1 = maxv(ty1, 0), px2 = minv(tx2, (int)xgrid), py2 = minv(ty2, (int)ygrid);
-            for (int i = py1; i < py2; i++)
-                for (int ii = px1; ii < px2; ii++)
-                    if ((x - ii)*(x - ii) + (y - i)*(y - i) <= rr)
-                        if (tequal(grid_array[i * xgrid + ii], val))
-                            return i;
-        }
-        return 0;
-    }
-    int value_disk_y(const double x, const double y, const double r, const t val)
-    {
-        const double rr = r*r;
-        const int tx1 = int(x - r), ty1 = int(y - r), tx2 = int(x + r + 1), ty2 = int(y + r + 1);
-        if (tx2 >= 0 && ty2 >=0 && tx1 < int(xgrid) && ty1 < int(ygrid))
-        {
-            const int px1 = maxv(tx1, 0), py1 = maxv(ty1, 0), px2 = minv(tx2, (int)xgrid), py2 = minv(ty2, (int)ygrid);
-            for (int i = py1; i < py2; i++)
-                for (int ii = px1; ii < px2; ii++)
-                    if ((x - ii)*(x - ii) + (y - i)*(y - i) <= rr)
-                        if (tequal(grid_array[i * xgrid + ii], val))
-                            return ii;
-        }
-        return 0;
-    }
-    void shuffle()
-    {
-        mt_random_shuffle(grid_array, grid_array + (xgrid*ygrid - 1));
-    }
-};
-
 /* ds_grids */
 
-static map<unsigned int, grid<variant> > ds_grids;
-static unsigned int ds_grids_maxid = 0;
+static enigma::ds_registry<enigma::variant_grid> ds_grids("grid");
 
 namespace enigma_user
 {
 
-unsigned int ds_grid_create(const unsigned int w, const unsigned int h)
+uint64_t ds_grid_create(const unsigned int w, const unsigned int h)
 {
   //Creates a new grid. The function returns an integer as an id that must be used in all other functions to access the particular grid.
-  pair<map<unsigned int, grid<variant> >::iterator, bool> ins = ds_grids.insert(pair<unsigned int, grid<variant> >(ds_grids_maxid++, grid<variant>(w, h)));
-  ins.first->second.clear(0);
-  return ds_grids_maxid-1;
+  return ds_grids.create(enigma::variant_grid(w, h));
 }
 
-void ds_grid_destroy(const unsigned int id)
+void ds_grid_destroy(const uint64_t id)
 {
   //Destroys the grid
-  ds_grids[id].destroy();
-  ds_grids.erase(ds_grids.find(id));
+  ds_grids.destroy(id);
 }
 
-void ds_grid_clear(const unsigned int id, const variant val)
+void ds_grid_clear(const uint64_t id, const variant val)
 {
   //Clears the grid with the given id, to the indicated value
   ds_grids[id].clear(val);
 }
 
-void ds_grid_copy(const unsigned int id, const unsigned int source)
+void ds_grid_copy(const uint64_t id, const uint64_t source)
 {
   //Copies the source grid onto the grid
-  ds_grids[id].copy(ds_grids[source]);
+  if (id != source) ds_grids[id].copy(ds_grids[source]);
 }
 
-void ds_grid_resize(const unsigned int id, const unsigned int w, const unsigned int h)
+void ds_grid_resize(const uint64_t id, const unsigned int w, const unsigned int h)
 {
   ds_grids[id].resize(w, h);
 }
 
-unsigned int ds_grid_width(const unsigned int id)
+unsigned int ds_grid_width(const uint64_t id)
 {
   //Returns the width of the grid
   return ds_grids[id].width();
 }
 
-unsigned int ds_grid_height(const unsigned int id)
+unsigned int ds_grid_height(const uint64_t id)
 {
   //Returns the height of the grid
   return ds_grids[id].height();
 }
 
-void ds_grid_set(const unsigned int id, const unsigned int x, const unsigned int y, const variant val)
+void ds_grid_set(const uint64_t id, const unsigned int x, const unsigned int y, const variant val)
 {
   //Sets the indicated cell in the grid with the given id, to the indicated value
   ds_grids[id].insert(x, y, val);
 }
 
-void ds_grid_add(const unsigned int id, const unsigned int x, const unsigned int y, const variant val)
+void ds_grid_add(const uint64_t id, const unsigned int x, const unsigned int y, const variant val)
 {
   //Add the value to the cell in the region in the grid with the given id. For strings this corresponds to concatenation
   ds_grids[id].add(x, y, val);
 }
 
-void ds_grid_multiply(const unsigned int id, const unsigned int x, const unsigned int y, const double val)
+void ds_grid_multiply(const uint64_t id, const unsigned int x, const unsigned int y, const double val)
 {
   //Multiplies the value to the cells in the region in the grid with the given id
   ds_grids[id].multiply(x, y, val);
 }
 
-void ds_grid_set_region(const unsigned int id, const unsigned int x1, const unsigned int y1, const unsigned int x2, const unsigned int y2, const variant val)
+void ds_grid_set_region(const uint64_t id, const unsigned int x1, const unsigned int y1, const unsigned int x2, const unsigned int y2, const variant val)
 {
   //Sets the all cells in the region in the grid with the given id, to the indicated value
   ds_grids[id].insert_region(x1, y1, x2, y2, val);
 }
 
-void ds_grid_add_region(const unsigned int id, const unsigned int x1, const unsigned int y1, const unsigned int x2, const unsigned int y2, const variant val)
+void ds_grid_add_region(const uint64_t id, const unsigned int x1, const unsigned int y1, const unsigned int x2, const unsigned int y2, const variant val)
 {
   //Add the value to the cell in the region in the grid with the given id.
   ds_grids[id].add_region(x1, y1, x2, y2, val);
 }
 
-void ds_grid_multiply_region(const unsigned int id, const unsigned int x1, const unsigned int y1, const unsigned int x2, const unsigned int y2, const double val)
+void ds_grid_multiply_region(const uint64_t id, const unsigned int x1, const unsigned int y1, const unsigned int x2, const unsigned int y2, const double val)
 {
   //Multiplies the value to the cells in the region in the grid with the given id. Is only valid for numbers
   ds_grids[id].multiply_region(x1, y1, x2, y2, val);
 }
 
-void ds_grid_set_disk(const unsigned int id, const double x, const double y, const double r, const variant val)
+void ds_grid_set_disk(const uint64_t id, const double x, const double y, const double r, const variant val)
 {
   //Sets all cells in the disk with center (xm,ym) and radius r
   ds_grids[id].insert_disk(x, y, r, val);
 }
 
-void ds_grid_add_disk(const unsigned int id, const double x, const double y, const double r, const variant val)
+void ds_grid_add_disk(const uint64_t id, const double x, const double y, const double r, const variant val)
 {
   //Add the value to all cells in the disk with center (xm,ym) and radius r
   ds_grids[id].add_disk(x, y, r, val);
 }
 
-void ds_grid_multiply_disk(const unsigned int id, const double x, const double y, const double r, const double val)
+void ds_grid_multiply_disk(const uint64_t id, const double x, const double y, const double r, const double val)
 {
   //Multiply the value to all cells in the disk with center (xm,ym) and radius r
   ds_grids[id].multiply_disk(x, y, r, val);
 }
 
-void ds_grid_set_grid_region(const unsigned int id, const unsigned int source, const unsigned int x1, const unsigned int y1, const unsigned int x2, const unsigned int y2, const unsigned int xpos, const unsigned int ypos)
+void ds_grid_set_grid_region(const uint64_t id, const uint64_t source, const unsigned int x1, const unsigned int y1, const unsigned int x2, const unsigned int y2, const unsigned int xpos, const unsigned int ypos)
 {
   //Copies the contents of the cells in the region in grid source to grid id. xpos and ypos indicate the place where the region must be placed in the grid
   ds_grids[id].insert_grid_region(ds_grids[source], x1, y1, x2, y2, xpos, ypos);
 }
 
-void ds_grid_add_grid_region(const unsigned int id, const unsigned int source, const unsigned int x1, const unsigned int y1, const unsigned int x2, const unsigned int y2, const unsigned int xpos, const unsigned int ypos)
+void ds_grid_add_grid_region(const uint64_t id, const uint64_t source, const unsigned int x1, const unsigned int y1, const unsigned int x2, const unsigned int y2, const unsigned int xpos, const unsigned int ypos)
 {
   //Adds the contents of the cells in the region in grid source to grid id. xpos and ypos indicate the place where the region must be added in the grid
   ds_grids[id].add_grid_region(ds_grids[source], x1, y1, x2, y2, xpos, ypos);
 }
 
-void ds_grid_multiply_grid_region(const unsigned int id, const unsigned int source, const unsigned int x1, const unsigned int y1, const unsigned int x2, const unsigned int y2, const unsigned int xpos, const unsigned int ypos)
+void ds_grid_multiply_grid_region(const uint64_t id, const uint64_t source, const unsigned int x1, const unsigned int y1, const unsigned int x2, const unsigned int y2, const unsigned int xpos, const unsigned int ypos)
 {
   //Multiplies the contents of the cells in the region in grid source to grid id. xpos and ypos indicate the place where the region must be multiplied in the grid
   ds_grids[id].multiply_grid_region(ds_grids[source], x1, y1, x2, y2, xpos, ypos);
 }
 
-variant ds_grid_get(const unsigned int id, const unsigned int x, const unsigned int y)
+void ds_grid_set_script(const uint64_t id, const int scr, variant arg0, variant arg1, variant arg2, variant arg3, variant arg4, variant arg5)
+{
+  //Sets every cell to scr(x, y, arg0, ...), running rows on the worker pool. The script must be pure,
+  //so results are gathered first and stored from this thread
+  const unsigned w = ds_grids[id].width(), h = ds_grids[id].height();
+  vector<variant> cells(size_t(w) * h);
+  enigma::parallel_for(h, [&](size_t y) {
+    for (unsigned x = 0; x < w; x++)
+      cells[y * w + x] = script_execute(scr, x, y, arg0, arg1, arg2, arg3, arg4, arg5);
+  });
+  for (unsigned y = 0; y < h; y++)
+    for (unsigned x = 0; x < w; x++)
+      ds_grids[id].insert(x, y, cells[size_t(y) * w + x]);
+}
+
+variant ds_grid_get(const uint64_t id, const unsigned int x, const unsigned int y)
 {
   //Returns the value of the indicated cell in the grid with the given id
   return ((x < ds_grids[id].width() && y < ds_grids[id].height()) ? ds_grids[id].find(x, y) : variant());
 }
 
-variant ds_grid_get_sum(const unsigned int id, const unsigned int x1, const unsigned int y1, const unsigned int x2, const unsigned int y2)
+variant ds_grid_get_sum(const uint64_t id, const unsigned int x1, const unsigned int y1, const unsigned int x2, const unsigned int y2)
 {
   //Returns the sum of the values of the cells in the region in the grid with the given id
   return (((x1 < ds_grids[id].width() || x2 < ds_grids[id].width()) && (y1 < ds_grids[id].height() || y2 < ds_grids[id].height())) ? ds_grids[id].find_region_sum(x1, y1, x2, y2) : variant());
 }
 
-variant ds_grid_get_max(const unsigned int id, const unsigned int x1, const unsigned int y1, const unsigned int x2, const unsigned int y2)
+variant ds_grid_get_max(const uint64_t id, const unsigned int x1, const unsigned int y1, const unsigned int x2, const unsigned int y2)
 {
   //Returns the max of the values of the cells in the region in the grid with the given id
   return (((x1 < ds_grids[id].width() || x2 < ds_grids[id].width()) && (y1 < ds_grids[id].height() || y2 < ds_grids[id].height())) ? ds_grids[id].find_region_max(x1, y1, x2, y2) : variant());
 }
 
-variant ds_grid_get_min(const unsigned int id, const unsigned int x1, const unsigned int y1, const unsigned int x2, const unsigned int y2)
+variant ds_grid_get_min(const uint64_t id, const unsigned int x1, const unsigned int y1, const unsigned int x2, const unsigned int y2)
 {
   //Returns the min of the values of the cells in the region in the grid with the given id
   return (((x1 < ds_grids[id].width() || x2 < ds_grids[id].width()) && (y1 < ds_grids[id].height() || y2 < ds_grids[id].height())) ? ds_grids[id].find_region_min(x1, y1, x2, y2) : variant());
 }
 
-variant ds_grid_get_mean(const unsigned int id, const unsigned int x1, const unsigned int y1, const unsigned int x2, const unsigned int y2)
+variant ds_grid_get_mean(const uint64_t id, const unsigned int x1, const unsigned int y1, const unsigned int x2, const unsigned int y2)
 {
   //Returns the mean of the values of the cells in the region in the grid with the given id
   return (((x1 < ds_grids[id].width() || x2 < ds_grids[id].width()) && (y1 < ds_grids[id].height() || y2 < ds_grids[id].height())) ? ds_grids[id].find_region_mean(x1, y1, x2, y2) : variant());
 }
 
-variant ds_grid_get_disk_sum(const unsigned int id, const double x, const double y, const double r)
+variant ds_grid_get_disk_sum(const uint64_t id, const double x, const double y, const double r)
 {
   //Returns the sum of the values of the cells in the disk
   return (ds_grids[id].find_disk_sum(x, y, r));
 }
 
-variant ds_grid_get_disk_max(const unsigned int id, const double x, const double y, const double r)
+variant ds_grid_get_disk_max(const uint64_t id, const double x, const double y, const double r)
 {
   //Returns the max of the values of the cells in the disk.
   return (ds_grids[id].find_disk_max(x, y, r));
 }
 
-variant ds_grid_get_disk_min(const unsigned int id, const double x, const double y, const double r)
+variant ds_grid_get_disk_min(const uint64_t id, const double x, const double y, const double r)
 {
   //Returns the min of the values of the cells in the disk.
   return (ds_grids[id].find_disk_min(x, y, r));
 }
 
-variant ds_grid_get_disk_mean(const unsigned int id, const double x, const double y, const double r)
+variant ds_grid_get_disk_mean(const uint64_t id, const double x, const double y, const double r)
 {
   //Returns the mean of the values of the cells in the disk
   return (ds_grids[id].find_disk_mean(x, y, r));
 }
 
-bool ds_grid_value_exists(const unsigned int id, const unsigned int x1, const unsigned int y1, const unsigned int x2, const unsigned int y2, const variant val)
+bool ds_grid_value_exists(const uint64_t id, const unsigned int x1, const unsigned int y1, const unsigned int x2, const unsigned int y2, const variant val)
 {
   //Returns whether the value appears somewhere in the region
   return (((x1 < ds_grids[id].width() || x2 < ds_grids[id].width()) && (y1 < ds_grids[id].height() || y2 < ds_grids[id].height())) ? ds_grids[id].value_region_exists(x1, y1, x2, y2, val) : false);
 }
 
-int ds_grid_value_x(const unsigned int id, const unsigned int x1, const unsigned int y1, const unsigned int x2, const unsigned int y2, const variant val)
+int ds_grid_value_x(const uint64_t id, const unsigned int x1, const unsigned int y1, const unsigned int x2, const unsigned int y2, const variant val)
 {
   //Returns the x-coordinate of the cell in which the value appears in the region
   return (((x1 < ds_grids[id].width() || x2 < ds_grids[id].width()) && (y1 < ds_grids[id].height() || y2 < ds_grids[id].height())) ? ds_grids[id].value_region_x(x1, y1, x2, y2, val) : 0);
 }
 
-int ds_grid_value_y(const unsigned int id, const unsigned int x1, const unsigned int y1, const unsigned int x2, const unsigned int y2, const variant val)
+int ds_grid_value_y(const uint64_t id, const unsigned int x1, const unsigned int y1, const unsigned int x2, const unsigned int y2, const variant val)
 {
   //Returns the y-coordinate of the cell in which the value appears in the region
   return (((x1 < ds_grids[id].width() || x2 < ds_grids[id].width()) && (y1 < ds_grids[id].height() || y2 < ds_grids[id].height())) ? ds_grids[id].value_region_y(x1, y1, x2, y2, val) : 0);
 }
 
-bool ds_grid_value_disk_exists(const unsigned int id, const double x, const double y, const double r, const variant val)
+bool ds_grid_value_disk_exists(const uint64_t id, const double x, const double y, const double r, const variant val)
 {
   //Returns whether the value appears somewhere in the disk
   return (ds_grids[id].value_disk_exists(x, y, r, val));
 }
 
-bool ds_grid_value_disk_x(const unsigned int id, const double x, const double y, const double r, const variant val)
+bool ds_grid_value_disk_x(const uint64_t id, const double x, const double y, const double r, const variant val)
 {
   //Returns the x-coordinate of the cell in which the value appears in the disk
   return (ds_grids[id].value_disk_x(x, y, r, val));
 }
 
-bool ds_grid_value_disk_y(const unsigned int id, const double x, const double y, const double r, const variant val)
+bool ds_grid_value_disk_y(const uint64_t id, const double x, const double y, const double r, const variant val)
 {
   //Returns the y-coordinate of the cell in which the value appears in the disk
   return (ds_grids[id].value_disk_y(x, y, r, val));
 }
 
-void ds_grid_shuffle(const unsigned int id)
+void ds_grid_shuffle(const uint64_t id)
 {
   //Shuffles the values in the grid such that they end up in a random order
   ds_grids[id].shuffle();
 }
 
-bool ds_grid_exists(const unsigned int id)
+bool ds_grid_exists(const uint64_t id)
 {
   //returns whether the grid exists
-  return (ds_grids.find(id) != ds_grids.end());
+  return ds_grids.exists(id);
 }
 
-unsigned int ds_grid_duplicate(const unsigned int source)
+uint64_t ds_grid_duplicate(const uint64_t source)
 {
   //creates and returns a new grid containing a copy of the source grid
-  ds_grids.insert(pair<unsigned int, grid<variant> >(ds_grids_maxid++, grid<variant>(0, 0)));
-  ds_grids[ds_grids_maxid-1].copy(ds_grids[source]);
-  return ds_grids_maxid-1;
+  return ds_grids.create(ds_grids[source]);
 }
 
-std::string ds_grid_write(const unsigned int id)
+std::string ds_grid_write(const uint64_t id)
 {
   std::stringstream ss;
   ss.flags(std::ios::hex | std::ios::uppercase | std::ios::internal);
   ss.width(4);
   ss.fill('0');
 
-  grid<variant> dsGrid = ds_grids[id];
+  const enigma::variant_grid &dsGrid = ds_grids[id];
 
   // Write size
   ss << std::hex << dsGrid.width();
@@ -759,7 +351,7 @@ std::string ds_grid_write(const unsigned int id)
   return ss.str();
 }
 
-void ds_grid_read(const unsigned int id, std::string value)
+void ds_grid_read(const uint64_t id, std::string value)
 {
   std::stringstream ss;
   int i = 8;
@@ -832,60 +424,97 @@ void ds_grid_read(const unsigned int id, std::string value)
   }
 }
 
+
+unsigned ds_grid_write_buffer(const uint64_t id, const int buffer, const bool compress)
+{
+  //Writes the grid into the buffer in binary form, compressed if asked; returns the bytes written
+  get_bufferr(binbuff, buffer, 0);
+  enigma::ds_binary::writer out;
+  const enigma::variant_grid &grid = ds_grids[id];
+  out.count(grid.width());
+  out.count(grid.height());
+  for (unsigned y = 0; y < grid.height(); ++y)
+    for (unsigned x = 0; x < grid.width(); ++x)
+      out.value(grid.find(x, y));
+  return out.flush(binbuff, enigma::ds_binary::GRID, compress);
+}
+
+bool ds_grid_read_buffer(const uint64_t id, const int buffer)
+{
+  //Replaces the grid with one written by ds_grid_write_buffer; returns false, changing nothing, if the buffer holds none
+  get_bufferr(binbuff, buffer, false);
+  enigma::ds_binary::reader in;
+  size_t count;
+  if (!in.open(binbuff, enigma::ds_binary::GRID) || !in.count(&count)) return false;
+  size_t height;
+  if (!in.count(&height)) return false;
+  if (count && height > in.remaining() / count) return false;
+  enigma::variant_grid grid(count, height);
+  variant vari;
+  for (unsigned y = 0; y < height; ++y)
+    for (unsigned x = 0; x < count; ++x) {
+      if (!in.value(&vari)) return false;
+      grid.insert(x, y, vari);
+    }
+  if (!in.close(binbuff)) return false;
+  ds_grids[id] = std::move(grid);
+  return true;
+}
+
 }
 
 /* ds_maps */
 
-static map<unsigned int, multimap<variant, variant> > ds_maps;
-static unsigned int ds_maps_maxid = 0;
+static enigma::ds_registry<enigma::variant_map> ds_maps("map");
 
 namespace enigma_user
 {
 
-unsigned int ds_map_create()
+uint64_t ds_map_create()
 {
   //Creates a new map. The function returns an integer as an id that must be used in all other functions to access the particular map.
-  ds_maps.insert(pair<unsigned int, multimap<variant, variant> >(ds_maps_maxid++, multimap<variant, variant>()));
-  return ds_maps_maxid-1;
+  return ds_maps.create();
 }
 
-void ds_map_destroy(const unsigned int id)
+void ds_map_destroy(const uint64_t id)
 {
   //Destroys the map
-  ds_maps.erase(ds_maps.find(id));
+  ds_maps.destroy(id);
 }
 
-void ds_map_clear(const unsigned int id)
+void ds_map_clear(const uint64_t id)
 {
   //Clears all values from the map
   ds_maps[id].clear();
 }
 
-void ds_map_copy(const unsigned int id, const unsigned int source)
+void ds_map_copy(const uint64_t id, const uint64_t source)
 {
   //Copies the source map onto the map
-  ds_maps[id] = ds_maps[source];
+  if (id == source) return;
+  const enigma::variant_map &src = ds_maps[source];
+  ds_maps[id] = src;
 }
 
-unsigned int ds_map_size(const unsigned int id)
+unsigned int ds_map_size(const uint64_t id)
 {
   //Returns the size of the map
   return ds_maps[id].size();
 }
 
-bool ds_map_empty(const unsigned int id)
+bool ds_map_empty(const uint64_t id)
 {
   //Returns whether the map contains no values
   return ds_maps[id].empty();
 }
 
-void ds_map_add(const unsigned int id, const variant key, const variant val)
+void ds_map_add(const uint64_t id, const variant key, const variant val)
 {
   //Adds the value and corresponding key to the map.
-  ds_maps[id].insert(pair<variant, variant>(key, val));
+  ds_maps[id].add(key, val);
 }
 
-void ds_map_replace(const unsigned int id, const variant key, const variant val)
+void ds_map_replace(const uint64_t id, const variant key, const variant val)
 {
   //TODO: Studio made it so this function will add the value if it is not in the map.
   //GM 8.1 does not have this behaviour. This has also been tested.
@@ -896,178 +525,168 @@ void ds_map_replace(const unsigned int id, const variant key, const variant val)
   //not exist in the global async_load map.
 
   //Replaces the value corresponding with the key with a new value
-  multimap<variant, variant>::iterator it = ds_maps[id].find(key);
-  if (it != ds_maps[id].end())
+  enigma::variant_map &map = ds_maps[id];
+  size_t it = map.find(key);
+  if (it != enigma::variant_map::npos)
   {
-    ds_maps[id].erase(it);
-    ds_maps[id].insert(pair<variant, variant>(key, val));
+    map.value(it) = val;
   }
 }
 
 //NOTE: Special function, see todo comment above.
-void ds_map_overwrite(const unsigned int id, const variant key, const variant val)
+void ds_map_overwrite(const uint64_t id, const variant key, const variant val)
 {
   //Replaces the value corresponding with the key with a new value, adding it if it was not found in the map.
-  multimap<variant, variant>::iterator it = ds_maps[id].find(key);
-  if (it != ds_maps[id].end())
+  enigma::variant_map &map = ds_maps[id];
+  size_t it = map.find(key);
+  if (it != enigma::variant_map::npos)
   {
-    ds_maps[id].erase(it);
+    map.value(it) = val;
+  }
+  else
+  {
+    map.add(key, val);
   }
-  ds_maps[id].insert(pair<variant, variant>(key, val));
 }
 
-void ds_map_delete(const unsigned int id, const variant key)
+void ds_map_delete(const uint64_t id, const variant key)
 {
   //Deletes the key and the corresponding value from the map
-  multimap<variant, variant>::iterator it = ds_maps[id].find(key);
-  if (it != ds_maps[id].end())
+  enigma::variant_map &map = ds_maps[id];
+  size_t it = map.find(key);
+  if (it != enigma::variant_map::npos)
   {
-    ds_maps[id].erase(it);
+    map.erase(it);
   }
 }
 
-void ds_map_delete(const unsigned int id, const variant first, const variant last)
+void ds_map_delete(const uint64_t id, const variant first, const variant last)
 {
-  //Deletes the keys and corresponding values in the range between first and last
-  multimap<variant, variant>::iterator itf = ds_maps[id].find(first), itl = ds_maps[id].find(last);
-  if (itf != ds_maps[id].end() && itl != ds_maps[id].end())
+  //Deletes the keys and corresponding values added from first up to, but not including, last
+  enigma::variant_map &map = ds_maps[id];
+  size_t itf = map.find(first), itl = map.find(last);
+  if (itf != enigma::variant_map::npos && itl != enigma::variant_map::npos && itf < itl)
   {
-    ds_maps[id].erase(itf, itl);
+    map.erase(itf, itl);
   }
 }
 
-bool ds_map_exists(const unsigned int id, const variant key)
+bool ds_map_exists(const uint64_t id, const variant key)
 {
   //returns whether the key exists in the map
-  return (ds_maps[id].find(key) != ds_maps[id].end());
+  return ds_maps[id].find(key) != enigma::variant_map::npos;
 }
 
-variant ds_map_find_value(const unsigned int id, const variant key)
+variant ds_map_find_value(const uint64_t id, const variant key)
 {
   //Returns the value corresponding to the key in the map
-  multimap<variant, variant>::iterator it = ds_maps[id].find(key);
-  return ((it == ds_maps[id].end()) ? variant() : (*it).second);
+  enigma::variant_map &map = ds_maps[id];
+  size_t it = map.find(key);
+  return (it == enigma::variant_map::npos) ? variant() : map.value(it);
 }
 
-variant ds_map_find_previous(const unsigned int id, const variant key)
+variant ds_map_find_previous(const uint64_t id, const variant key)
 {
-  //Returns the largest key in the map smaller than the indicated key
-  multimap<variant, variant>::reverse_iterator rit;
-  variant key_check;
-  for (rit = ds_maps[id].rbegin(); rit != ds_maps[id].rend(); rit++)
-  {
-    if ((key_check = (*rit).first) < key)
-    {
-      return key_check;
-    }
-  }
-  return variant();
+  //Returns the key first added to the map before the indicated key
+  enigma::variant_map &map = ds_maps[id];
+  size_t it = map.prev_key(map.find(key));
+  return (it == enigma::variant_map::npos) ? variant() : map.key(it);
 }
 
-variant ds_map_find_next(const unsigned int id, const variant key)
+variant ds_map_find_next(const uint64_t id, const variant key)
 {
-  //Returns the smallest key in the map larger than the indicated key
-  multimap<variant, variant>::iterator it;
-  variant key_check;
-  for (it = ds_maps[id].begin(); it != ds_maps[id].end(); it++)
-  {
-    if ((key_check = (*it).first) > key)
-    {
-      return key_check;
-    }
-  }
-  return variant();
+  //Returns the key first added to the map after the indicated key
+  enigma::variant_map &map = ds_maps[id];
+  size_t it = map.next_key(map.find(key));
+  return (it == enigma::variant_map::npos) ? variant() : map.key(it);
 }
 
-variant ds_map_find_first(const unsigned int id)
+variant ds_map_find_first(const uint64_t id)
 {
-  //Returns the smallest key in the map
-  multimap<variant, variant>::iterator it = ds_maps[id].begin();
-  return (it == ds_maps[id].end()) ? variant() : (*it).first;
+  //Returns the first key added to the map
+  enigma::variant_map &map = ds_maps[id];
+  size_t it = map.first_key();
+  return (it == enigma::variant_map::npos) ? variant() : map.key(it);
 }
 
-variant ds_map_find_last(const unsigned int id)
+variant ds_map_find_last(const uint64_t id)
 {
-  //Returns the largest key in the map
-  multimap<variant, variant>::reverse_iterator rit = ds_maps[id].rbegin();
-  return ((rit == ds_maps[id].rend()) ? variant() : (*rit).first);
+  //Returns the key first added to the map after all the others
+  enigma::variant_map &map = ds_maps[id];
+  size_t it = map.last_key();
+  return (it == enigma::variant_map::npos) ? variant() : map.key(it);
 }
 
-bool ds_map_exists(const unsigned int id)
+bool ds_map_exists(const uint64_t id)
 {
   //returns whether the map exists
-  return (ds_maps.find(id) != ds_maps.end());
+  return ds_maps.exists(id);
 }
 
-unsigned int ds_map_duplicate(const unsigned int source)
+uint64_t ds_map_duplicate(const uint64_t source)
 {
   //creates and returns a new map containing a copy of the source map
-  ds_maps.insert(pair<unsigned int, multimap<variant, variant> >(++ds_maps_maxid, multimap<variant, variant>()));
-  ds_maps[ds_maps_maxid-1] = ds_maps[source];
-  return ds_maps_maxid-1;
+  return ds_maps.create(ds_maps[source]);
 }
 
-std::string ds_map_write(const unsigned int id)
+std::string ds_map_write(const uint64_t id)
 {
   std::stringstream ss;
   ss.flags(std::ios::hex | std::ios::uppercase | std::ios::internal);
   ss.width(4);
   ss.fill('0');
 
-  std::multimap<variant, variant> dsMap = ds_maps[id];
+  const enigma::variant_map &dsMap = ds_maps[id];
 
   // Write size
   ss << std::hex << dsMap.size();
 
-  std::multimap<variant, variant>::iterator it = dsMap.begin();
-  while (it != dsMap.end())
+  for (size_t it = dsMap.first(); it != enigma::variant_map::npos; it = dsMap.next(it))
   {
     // Write type
     ss.width(2);
-    ss << (unsigned int)(((*it).first.type == ty_real) ? 0x00 : 0x01);
+    ss << (unsigned int)((dsMap.key(it).type == ty_real) ? 0x00 : 0x01);
 
     // Write data
-    if ((*it).first.type == ty_real)
+    if (dsMap.key(it).type == ty_real)
     {
       ss.width(16);
-            char* b = (char*)&(*it).first.rval.d;
+            char* b = (char*)&dsMap.key(it).rval.d;
             for (unsigned i = 0; i < sizeof(double); ++i)
             ss << b[i];
     }
     else
     {
-      ss.width(4); ss << (*it).first.string_length();
+      ss.width(4); ss << dsMap.key(it).string_length();
       ss.width(1);
-      for (size_t j = 0; j < (*it).first.string_length(); ++j)
-        ss << (*it).first.char_at(j);
+      for (size_t j = 0; j < dsMap.key(it).string_length(); ++j)
+        ss << dsMap.key(it).char_at(j);
     }
 
     // Write type
     ss.width(2);
-    ss << (unsigned int)(((*it).second.type == ty_real) ? 0x00 : 0x01);
+    ss << (unsigned int)((dsMap.value(it).type == ty_real) ? 0x00 : 0x01);
 
     // Write data
-    if ((*it).second.type == ty_real)
+    if (dsMap.value(it).type == ty_real)
     {
       ss.width(16);
-      char* b = (char*)&(*it).second.rval.d;
+      char* b = (char*)&dsMap.value(it).rval.d;
       for (unsigned i = 0; i < sizeof(double); ++i)
         ss << b[i];    }
     else
     {
-      ss.width(4); ss << (*it).second.string_length();
+      ss.width(4); ss << dsMap.value(it).string_length();
       ss.width(1);
-      for (size_t j = 0; j < (*it).second.string_length(); ++j)
-        ss << (*it).second.char_at(j);
+      for (size_t j = 0; j < dsMap.value(it).string_length(); ++j)
+        ss << dsMap.value(it).char_at(j);
     }
-
-    ++it;
   }
 
   return ss.str();
 }
 
-void ds_map_read(const unsigned int id, std::string value)
+void ds_map_read(const uint64_t id, std::string value)
 {
   std::stringstream ss;
   int i = 4;
@@ -1150,106 +769,143 @@ void ds_map_read(const unsigned int id, std::string value)
     }
 
     // Push value
-    ds_maps[id].insert(std::pair<variant, variant>(variKey, variValue));
+    ds_maps[id].add(variKey, variValue);
   }
 }
 
+
+unsigned ds_map_write_buffer(const uint64_t id, const int buffer, const bool compress)
+{
+  //Writes the map into the buffer in binary form, compressed if asked; returns the bytes written
+  get_bufferr(binbuff, buffer, 0);
+  enigma::ds_binary::writer out;
+  const enigma::variant_map &map = ds_maps[id];
+  out.count(map.size());
+  for (size_t i = map.first(); i != enigma::variant_map::npos; i = map.next(i)) {
+    out.value(map.key(i));
+    out.value(map.value(i));
+  }
+  return out.flush(binbuff, enigma::ds_binary::MAP, compress);
+}
+
+bool ds_map_read_buffer(const uint64_t id, const int buffer)
+{
+  //Replaces the map with one written by ds_map_write_buffer; returns false, changing nothing, if the buffer holds none
+  get_bufferr(binbuff, buffer, false);
+  enigma::ds_binary::reader in;
+  size_t count;
+  if (!in.open(binbuff, enigma::ds_binary::MAP) || !in.count(&count)) return false;
+  enigma::variant_map map;
+  variant key, vari;
+  for (size_t i = 0; i < count; ++i) {
+    if (!in.value(&key) || !in.value(&vari)) return false;
+    map.add(key, vari);
+  }
+  if (!in.close(binbuff)) return false;
+  ds_maps[id] = std::move(map);
+  return true;
+}
+
 }
 
 /* ds_lists */
 
-static map<unsigned int, vector<variant> > ds_lists;
-static unsigned int ds_lists_maxid = 0;
+static enigma::ds_registry<vector<variant> > ds_lists("list");
 
 namespace enigma_user
 {
 
-unsigned int ds_list_create()
+uint64_t ds_list_create()
 {
   //Creates a new list. The function returns an integer as an id that must be used in all other functions to access the particular list.
-  ds_lists.insert(pair<unsigned int, vector<variant> >(ds_lists_maxid++, vector<variant>()));
-  return ds_lists_maxid-1;
+  return ds_lists.create();
 }
 
-void ds_list_destroy(const unsigned int id)
+void ds_list_destroy(const uint64_t id)
 {
   //Destroys the list
-  ds_lists.erase(ds_lists.find(id));
+  ds_lists.destroy(id);
 }
 
-void ds_list_clear(const unsigned int id)
+void ds_list_clear(const uint64_t id)
 {
   //Clears all values from the list
   ds_lists[id].clear();
 }
 
-void ds_list_copy(const unsigned int id, const unsigned int source)
+void ds_list_copy(const uint64_t id, const uint64_t source)
 {
   //Copies the source list onto the list
-  ds_lists[id] = ds_lists[source];
+  if (id != source) ds_lists[id] = ds_lists[source];
 }
 
-unsigned int ds_list_size(const unsigned int id)
+unsigned int ds_list_size(const uint64_t id)
 {
   //Returns the size of the list
   return ds_lists[id].size();
 }
 
-bool ds_list_empty(const unsigned int id)
+bool ds_list_empty(const uint64_t id)
 {
   //Returns whether the list contains no values
   return ds_lists[id].empty();
 }
 
-void ds_list_add(const unsigned int id, const enigma::varargs &values)
+void ds_list_add(const uint64_t id, const enigma::varargs &values)
 {
   //Adds the values at the end of the list.
+  vector<variant> &list = ds_lists[id];
   for (int i = 0; i < values.argc; ++i)
-    ds_lists[id].push_back(values.get(i));
+    list.push_back(values.get(i));
 }
 
-void ds_list_insert(const unsigned int id, const unsigned int pos, const variant val)
+void ds_list_insert(const uint64_t id, const unsigned int pos, const variant val)
 {
   //Inserts val and the given pos in the list
+  vector<variant> &list = ds_lists[id];
 
-  if (pos <= ds_lists[id].size())
+  if (pos <= list.size())
   {
-    ds_lists[id].insert(ds_lists[id].begin() + pos, val);
+    list.insert(list.begin() + pos, val);
   }
 }
 
-void ds_list_replace(const unsigned int id, const unsigned int pos, const variant val)
+void ds_list_replace(const uint64_t id, const unsigned int pos, const variant val)
 {
   //replaces the value at pos with the val in the list
-  if (pos < ds_lists[id].size())
+  vector<variant> &list = ds_lists[id];
+  if (pos < list.size())
   {
-    ds_lists[id][pos] = val;
+    list[pos] = val;
   }
 }
 
-void ds_list_delete(const unsigned int id, const unsigned int pos)
+void ds_list_delete(const uint64_t id, const unsigned int pos)
 {
   //deletes the value at the given pos in the list
-  if (pos < ds_lists[id].size())
+  vector<variant> &list = ds_lists[id];
+  if (pos < list.size())
   {
-    ds_lists[id].erase(ds_lists[id].begin() + pos);
+    list.erase(list.begin() + pos);
   }
 }
 
-void ds_list_delete(const unsigned int id, const unsigned int first, const unsigned int last)
+void ds_list_delete(const uint64_t id, const unsigned int first, const unsigned int last)
 {
   //Deletes the values in the range between first and last
-  if (first < ds_lists[id].size() && last < ds_lists[id].size())
+  vector<variant> &list = ds_lists[id];
+  if (first < list.size() && last < list.size())
   {
-    ds_lists[id].erase(ds_lists[id].begin() + first, ds_lists[id].begin() + last+1);
+    list.erase(list.begin() + first, list.begin() + last+1);
   }
 }
 
-int ds_list_find_index(const unsigned int id, const variant val)
+int ds_list_find_index(const uint64_t id, const variant val)
 {
-  for (size_t i = 0; i < ds_lists[id].size(); i++)
+  vector<variant> &list = ds_lists[id];
+  for (size_t i = 0; i < list.size(); i++)
   {
-    if (ds_lists[id][i] == val)
+    if (list[i] == val)
     {
       return i;
     }
@@ -1257,54 +913,55 @@ int ds_list_find_index(const unsigned int id, const variant val)
   return -1;
 }
 
-variant ds_list_find_value(const unsigned int id, const unsigned int pos)
+variant ds_list_find_value(const uint64_t id, const unsigned int pos)
 {
   //Returns the value stored at the indicated position in the list
-  vector<variant>::iterator it = ds_lists[id].begin() + pos;
-  return ((it == ds_lists[id].end()) ? variant() : (*it));
+  vector<variant> &list = ds_lists[id];
+  vector<variant>::iterator it = list.begin() + pos;
+  return ((it == list.end()) ? variant() : (*it));
 }
 
-void ds_list_sort(const unsigned int id, const bool ascend)
+void ds_list_sort(const uint64_t id, const bool ascend)
 {
   //Sorts the values in the list. When ascend is true the values are sorted in ascending order, otherwise in descending order.
+  vector<variant> &list = ds_lists[id];
   if (ascend)
   {
-    sort(ds_lists[id].begin(), ds_lists[id].end());
+    sort(list.begin(), list.end());
   }
   else
   {
-    sort(ds_lists[id].rbegin(), ds_lists[id].rend());
+    sort(list.rbegin(), list.rend());
   }
 }
 
-void ds_list_shuffle(const unsigned int id)
+void ds_list_shuffle(const uint64_t id)
 {
   //shuffles the values in the list into a random order
-  mt_random_shuffle(ds_lists[id].begin(), ds_lists[id].end());
+  vector<variant> &list = ds_lists[id];
+  mt_random_shuffle(list.begin(), list.end());
 }
 
-bool ds_list_exists(const unsigned int id)
+bool ds_list_exists(const uint64_t id)
 {
   //returns whether the list exists
-  return (ds_lists.find(id) != ds_lists.end());
+  return ds_lists.exists(id);
 }
 
-unsigned int ds_list_duplicate(const unsigned int source)
+uint64_t ds_list_duplicate(const uint64_t source)
 {
   //creates and returns a new list containing a copy of the source list
-  ds_lists.insert(pair<unsigned int, vector<variant> >(++ds_lists_maxid, vector<variant>()));
-  ds_lists[ds_lists_maxid-1] = ds_lists[source];
-  return ds_lists_maxid-1;
+  return ds_lists.create(ds_lists[source]);
 }
 
-std::string ds_list_write(const unsigned int id)
+std::string ds_list_write(const uint64_t id)
 {
   std::stringstream ss;
   ss.flags(std::ios::hex | std::ios::uppercase | std::ios::internal);
   ss.width(4);
   ss.fill('0');
 
-  std::vector<variant> dsList = ds_lists[id];
+  const std::vector<variant> &dsList = ds_lists[id];
 
   // Write count
   ss << dsList.size();
@@ -1334,8 +991,9 @@ std::string ds_list_write(const unsigned int id)
   return ss.str();
 }
 
-void ds_list_read(const unsigned int id, std::string value)
+void ds_list_read(const uint64_t id, std::string value)
 {
+  vector<variant> &list = ds_lists[id];
   std::stringstream ss;
   int i = 4;
   int count;
@@ -1369,7 +1027,7 @@ void ds_list_read(const unsigned int id, std::string value)
       i += 16;
 
       vari.rval.d = d;
-      ds_lists[id].push_back(vari);
+      list.push_back(vari);
     }
     else
     {
@@ -1385,121 +1043,152 @@ void ds_list_read(const unsigned int id, std::string value)
       vari = value.substr(i, len);
       i += len;
 
-      ds_lists[id].push_back(vari);
+      list.push_back(vari);
     }
   }
 }
 
+
+unsigned ds_list_write_buffer(const uint64_t id, const int buffer, const bool compress)
+{
+  //Writes the list into the buffer in binary form, compressed if asked; returns the bytes written
+  get_bufferr(binbuff, buffer, 0);
+  enigma::ds_binary::writer out;
+  const vector<variant> &list = ds_lists[id];
+  out.count(list.size());
+  for (const variant &vari : list) out.value(vari);
+  return out.flush(binbuff, enigma::ds_binary::LIST, compress);
+}
+
+bool ds_list_read_buffer(const uint64_t id, const int buffer)
+{
+  //Replaces the list with one written by ds_list_write_buffer; returns false, changing nothing, if the buffer holds none
+  get_bufferr(binbuff, buffer, false);
+  enigma::ds_binary::reader in;
+  size_t count;
+  if (!in.open(binbuff, enigma::ds_binary::LIST) || !in.count(&count)) return false;
+  vector<variant> list(count);
+  for (variant &vari : list)
+    if (!in.value(&vari)) return false;
+  if (!in.close(binbuff)) return false;
+  ds_lists[id].swap(list);
+  return true;
+}
+
 }
 
 /* ds_prioritys */
 
-static map<unsigned int, multimap<variant, variant> > ds_prioritys;
-static unsigned int ds_prioritys_maxid = 0;
+static enigma::ds_registry<multimap<variant, variant> > ds_prioritys("priority queue");
 
 namespace enigma_user
 {
 
-unsigned int ds_priority_create()
+uint64_t ds_priority_create()
 {
   //Creates a new priority queue. The function returns an integer as an id that must be used in all other functions to access the particular priority queue.
-  ds_prioritys.insert(pair<unsigned int, multimap<variant, variant> >(ds_prioritys_maxid++, multimap<variant, variant>()));
-  return ds_prioritys_maxid-1;
+  return ds_prioritys.create();
 }
 
-void ds_priority_destroy(const unsigned int id)
+void ds_priority_destroy(const uint64_t id)
 {
   //Destroys the priority queue
-  ds_prioritys.erase(ds_prioritys.find(id));
+  ds_prioritys.destroy(id);
 }
 
-void ds_priority_clear(const unsigned int id)
+void ds_priority_clear(const uint64_t id)
 {
   //Clears all values from the priority queue
   ds_prioritys[id].clear();
 }
 
-void ds_priority_copy(const unsigned int id, const unsigned int source)
+void ds_priority_copy(const uint64_t id, const uint64_t source)
 {
   //Copies the source priority queue onto the priority queue
-  ds_prioritys[id] = ds_prioritys[source];
+  if (id != source) ds_prioritys[id] = ds_prioritys[source];
 }
 
-unsigned int ds_priority_size(const unsigned int id)
+unsigned int ds_priority_size(const uint64_t id)
 {
   //Returns the size of the priority queue
   return ds_prioritys[id].size();
 }
 
-bool ds_priority_empty(const unsigned int id)
+bool ds_priority_empty(const uint64_t id)
 {
   //Returns whether the priority queue contains no values
   return ds_prioritys[id].empty();
 }
 
-void ds_priority_add(const unsigned int id, const variant val, const variant prio)
+void ds_priority_add(const uint64_t id, const variant val, const variant prio)
 {
   //Adds the value with the given priority to the priority queue
   ds_prioritys[id].insert(pair<variant, variant>(val, prio));
 }
 
-void ds_priority_change_priority(const unsigned int id, const variant val, const variant prio)
+void ds_priority_change_priority(const uint64_t id, const variant val, const variant prio)
 {
   //Changes the priority of the given value in the priority queue
-  multimap<variant, variant>::iterator it = ds_prioritys[id].find(val);
-  if (it != ds_prioritys[id].end())
+  multimap<variant, variant> &pq = ds_prioritys[id];
+  multimap<variant, variant>::iterator it = pq.find(val);
+  if (it != pq.end())
   {
-    ds_prioritys[id].erase(it);
-    ds_prioritys[id].insert(pair<variant, variant>(val, prio));
+    pq.erase(it);
+    pq.insert(pair<variant, variant>(val, prio));
   }
 }
 
-variant ds_priority_find_priority(const unsigned int id, const variant val)
+variant ds_priority_find_priority(const uint64_t id, const variant val)
 {
   //Returns the priority of the given value in the priority queue
-  multimap<variant, variant>::iterator it = ds_prioritys[id].find(val);
-  return ((it == ds_prioritys[id].end()) ? variant() : (*it).second);
+  multimap<variant, variant> &pq = ds_prioritys[id];
+  multimap<variant, variant>::iterator it = pq.find(val);
+  return ((it == pq.end()) ? variant() : (*it).second);
 }
 
-void ds_priority_delete_value(const unsigned int id, const variant val)
+void ds_priority_delete_value(const uint64_t id, const variant val)
 {
   //Deletes the given value (with its priority) from the priority queue
-  multimap<variant, variant>::iterator it = ds_prioritys[id].find(val);
-  if (it != ds_prioritys[id].end())
+  multimap<variant, variant> &pq = ds_prioritys[id];
+  multimap<variant, variant>::iterator it = pq.find(val);
+  if (it != pq.end())
   {
-    ds_prioritys[id].erase(it);
+    pq.erase(it);
   }
 }
 
-bool ds_priority_value_exists(const unsigned int id, const variant val)
+bool ds_priority_value_exists(const uint64_t id, const variant val)
 {
   //returns whether the value exists in the priority queue
-  return (ds_prioritys[id].find(val) != ds_prioritys[id].end());
+  multimap<variant, variant> &pq = ds_prioritys[id];
+  return (pq.find(val) != pq.end());
 }
 
-variant ds_priority_delete_min(const unsigned int id)
+variant ds_priority_delete_min(const uint64_t id)
 {
   //Returns the value with the smallest priority but does not delete it from the priority queue
-  multimap<variant, variant>::iterator it = ds_prioritys[id].begin(), it_check;
-  if (it == ds_prioritys[id].end()) {return 0;}
+  multimap<variant, variant> &pq = ds_prioritys[id];
+  multimap<variant, variant>::iterator it = pq.begin(), it_check;
+  if (it == pq.end()) {return 0;}
   it_check = it++;
-  while (it != ds_prioritys[id].end())
+  while (it != pq.end())
   {
     if ((*it).second < (*it_check).second) {it_check = it;}
     it++;
   }
   const variant val = (*it_check).first;
-  ds_prioritys[id].erase(it_check);
+  pq.erase(it_check);
   return val;
 }
 
-variant ds_priority_find_min(const unsigned int id)
+variant ds_priority_find_min(const uint64_t id)
 {
   //Returns the value with the smallest priority but does not delete it from the priority queue
-  multimap<variant, variant>::iterator it = ds_prioritys[id].begin(), it_check;
-  if (it == ds_prioritys[id].end()) {return variant();}
+  multimap<variant, variant> &pq = ds_prioritys[id];
+  multimap<variant, variant>::iterator it = pq.begin(), it_check;
+  if (it == pq.end()) {return variant();}
   it_check = it++;
-  while (it != ds_prioritys[id].end())
+  while (it != pq.end())
   {
     if ((*it).second < (*it_check).second) {it_check = it;}
     it++;
@@ -1507,29 +1196,31 @@ variant ds_priority_find_min(const unsigned int id)
   return ((*it_check).first);
 }
 
-variant ds_priority_delete_max(const unsigned int id)
+variant ds_priority_delete_max(const uint64_t id)
 {
   //Returns the value with the smallest priority but does not delete it from the priority queue
-  multimap<variant, variant>::iterator it = ds_prioritys[id].begin(), it_check;
-  if (it == ds_prioritys[id].end()) {return variant();}
+  multimap<variant, variant> &pq = ds_prioritys[id];
+  multimap<variant, variant>::iterator it = pq.begin(), it_check;
+  if (it == pq.end()) {return variant();}
   it_check = it++;
-  while (it != ds_prioritys[id].end())
+  while (it != pq.end())
   {
     if ((*it).second > (*it_check).second) {it_check = it;}
     it++;
   }
   const variant val = (*it_check).first;
-  ds_prioritys[id].erase(it_check);
+  pq.erase(it_check);
   return val;
 }
 
-variant ds_priority_find_max(const unsigned int id)
+variant ds_priority_find_max(const uint64_t id)
 {
   //Returns the value with the smallest priority but does not delete it from the priority queue
-  multimap<variant, variant>::iterator it = ds_prioritys[id].begin(), it_check;
-  if (it == ds_prioritys[id].end()) {return variant();}
+  multimap<variant, variant> &pq = ds_prioritys[id];
+  multimap<variant, variant>::iterator it = pq.begin(), it_check;
+  if (it == pq.end()) {return variant();}
   it_check = it++;
-  while (it != ds_prioritys[id].end())
+  while (it != pq.end())
   {
     if ((*it).second > (*it_check).second) {it_check = it;}
     it++;
@@ -1537,33 +1228,31 @@ variant ds_priority_find_max(const unsigned int id)
   return ((*it_check).first);
 }
 
-bool ds_priority_exists(const unsigned int id)
+bool ds_priority_exists(const uint64_t id)
 {
   //returns whether the priority queue exists
-  return (ds_prioritys.find(id) != ds_prioritys.end());
+  return ds_prioritys.exists(id);
 }
 
-unsigned int ds_priority_duplicate(const unsigned int source)
+uint64_t ds_priority_duplicate(const uint64_t source)
 {
   //creates and returns a new priority queue containing a copy of the source priority queue
-  ds_prioritys.insert(pair<unsigned int, multimap<variant, variant> >(++ds_prioritys_maxid, multimap<variant, variant>()));
-  ds_prioritys[ds_prioritys_maxid-1] = ds_prioritys[source];
-  return ds_prioritys_maxid-1;
+  return ds_prioritys.create(ds_prioritys[source]);
 }
 
-std::string ds_priority_write(const unsigned int id)
+std::string ds_priority_write(const uint64_t id)
 {
   std::stringstream ss;
   ss.flags(std::ios::hex | std::ios::uppercase | std::ios::internal);
   ss.width(4);
   ss.fill('0');
 
-  std::multimap<variant, variant> dsPriority = ds_prioritys[id];
+  const std::multimap<variant, variant> &dsPriority = ds_prioritys[id];
 
   // Write size
   ss << std::hex << dsPriority.size();
 
-  std::multimap<variant, variant>::iterator it = dsPriority.begin();
+  std::multimap<variant, variant>::const_iterator it = dsPriority.begin();
   while (it != dsPriority.end())
   {
     // Write type
@@ -1596,7 +1285,7 @@ std::string ds_priority_write(const unsigned int id)
   return ss.str();
 }
 
-void ds_priority_read(const unsigned int id, std::string value)
+void ds_priority_read(const uint64_t id, std::string value)
 {
   std::stringstream ss;
   int i = 4;
@@ -1662,106 +1351,139 @@ void ds_priority_read(const unsigned int id, std::string value)
   }
 }
 
+
+unsigned ds_priority_write_buffer(const uint64_t id, const int buffer, const bool compress)
+{
+  //Writes the priority queue into the buffer in binary form, compressed if asked; returns the bytes written
+  get_bufferr(binbuff, buffer, 0);
+  enigma::ds_binary::writer out;
+  const multimap<variant, variant> &pq = ds_prioritys[id];
+  out.count(pq.size());
+  for (const auto &entry : pq) {
+    out.value(entry.first);
+    out.value(entry.second);
+  }
+  return out.flush(binbuff, enigma::ds_binary::PRIORITY, compress);
+}
+
+bool ds_priority_read_buffer(const uint64_t id, const int buffer)
+{
+  //Replaces the priority queue with one written by ds_priority_write_buffer; returns false, changing nothing, if the buffer holds none
+  get_bufferr(binbuff, buffer, false);
+  enigma::ds_binary::reader in;
+  size_t count;
+  if (!in.open(binbuff, enigma::ds_binary::PRIORITY) || !in.count(&count)) return false;
+  multimap<variant, variant> pq;
+  variant vari, prio;
+  for (size_t i = 0; i < count; ++i) {
+    if (!in.value(&vari) || !in.value(&prio)) return false;
+    pq.insert(pq.end(), pair<variant, variant>(vari, prio));
+  }
+  if (!in.close(binbuff)) return false;
+  ds_prioritys[id].swap(pq);
+  return true;
+}
+
 }
 
 /* ds_queues */
 
-static map<unsigned int, deque<variant> > ds_queues;
-static unsigned int ds_queues_maxid = 0;
+static enigma::ds_registry<deque<variant> > ds_queues("queue");
 
 namespace enigma_user
 {
 
-unsigned int ds_queue_create()
+uint64_t ds_queue_create()
 {
   //Creates a new queue. The function returns an integer as an id that must be used in all other functions to access the particular queue.
-  ds_queues.insert(pair<unsigned int, deque<variant> >(ds_queues_maxid++, deque<variant>()));
-  return ds_queues_maxid-1;
+  return ds_queues.create();
 }
 
-void ds_queue_destroy(const unsigned int id)
+void ds_queue_destroy(const uint64_t id)
 {
   //Destroys the queue
-  ds_queues.erase(ds_queues.find(id));
+  ds_queues.destroy(id);
 }
 
-void ds_queue_clear(const unsigned int id)
+void ds_queue_clear(const uint64_t id)
 {
   //Clears all values from the queue
   ds_queues[id].clear();
 }
 
-void ds_queue_copy(const unsigned int id, const unsigned int source)
+void ds_queue_copy(const uint64_t id, const uint64_t source)
 {
   //Copies the source queue onto the queue
-  ds_queues[id] = ds_queues[source];
+  if (id != source) ds_queues[id] = ds_queues[source];
 }
 
-unsigned int ds_queue_size(const unsigned int id)
+unsigned int ds_queue_size(const uint64_t id)
 {
   //Returns the size of the queue
   return ds_queues[id].size();
 }
 
-bool ds_queue_empty(const unsigned int id)
+bool ds_queue_empty(const uint64_t id)
 {
   //Returns whether the queue contains no values
   return ds_queues[id].empty();
 }
 
-void ds_queue_enqueue(const unsigned int id, const enigma::varargs &values)
+void ds_queue_enqueue(const uint64_t id, const enigma::varargs &values)
 {
   //Adds the values to the back of the queue
+  deque<variant> &queue = ds_queues[id];
   for (int i = 0; i < values.argc; ++i)
-    ds_queues[id].push_back(values.get(i));
+    queue.push_back(values.get(i));
 }
 
-variant ds_queue_dequeue(const unsigned int id)
+variant ds_queue_dequeue(const uint64_t id)
 {
   //Returns the value at the front of the queue and removes it from the queue
-  deque<variant>::iterator it = ds_queues[id].begin();
-  if (it == ds_queues[id].end()) {return 0;}
+  deque<variant> &queue = ds_queues[id];
+  deque<variant>::iterator it = queue.begin();
+  if (it == queue.end()) {return 0;}
   const variant val = *it;
-  ds_queues[id].pop_front();
+  queue.pop_front();
   return val;
 }
 
-variant ds_queue_head(const unsigned int id)
+variant ds_queue_head(const uint64_t id)
 {
   //Returns the value at the front of the queue
-  deque<variant>::iterator it = ds_queues[id].begin();
-  return ((it == ds_queues[id].end()) ? variant() : (*it));
+  deque<variant> &queue = ds_queues[id];
+  deque<variant>::iterator it = queue.begin();
+  return ((it == queue.end()) ? variant() : (*it));
 }
 
-variant ds_queue_tail(const unsigned int id)
+variant ds_queue_tail(const uint64_t id)
 {
   //Returns the value on the back of the queue
-  deque<variant>::reverse_iterator rit = ds_queues[id].rbegin();
-  return ((rit == ds_queues[id].rend()) ? variant() : (*rit));
+  deque<variant> &queue = ds_queues[id];
+  deque<variant>::reverse_iterator rit = queue.rbegin();
+  return ((rit == queue.rend()) ? variant() : (*rit));
 }
 
-bool ds_queue_exists(const unsigned int id)
+bool ds_queue_exists(const uint64_t id)
 {
   //returns whether the queue exists
-  return (ds_queues.find(id) != ds_queues.end());
+  return ds_queues.exists(id);
 }
 
-unsigned int ds_queue_duplicate(const unsigned int source)
+uint64_t ds_queue_duplicate(const uint64_t source)
 {
   //creates and returns a new queue containing a copy of the source queue
-  ds_queues.insert(pair<unsigned int, deque<variant> >(++ds_queues_maxid, deque<variant>()));
-  ds_queues[ds_queues_maxid-1] = ds_queues[source];
-  return ds_queues_maxid-1;
+  return ds_queues.create(ds_queues[source]);
 }
 
-std::string ds_queue_write(const unsigned int id)
+std::string ds_queue_write(const uint64_t id)
 {
   std::stringstream ss;
   ss.flags(std::ios::hex | std::ios::uppercase | std::ios::internal);
   ss.width(4);
   ss.fill('0');
 
-  std::deque<variant> dsQueue = ds_queues[id];
+  const std::deque<variant> &dsQueue = ds_queues[id];
 
   // Write size
   ss << std::hex << dsQueue.size();
@@ -1792,7 +1514,7 @@ std::string ds_queue_write(const unsigned int id)
   return ss.str();
 }
 
-void ds_queue_read(const unsigned int id, std::string value)
+void ds_queue_read(const uint64_t id, std::string value)
 {
   std::stringstream ss;
   int i = 4;
@@ -1846,99 +1568,125 @@ void ds_queue_read(const unsigned int id, std::string value)
   }
 }
 
+
+unsigned ds_queue_write_buffer(const uint64_t id, const int buffer, const bool compress)
+{
+  //Writes the queue into the buffer in binary form, compressed if asked; returns the bytes written
+  get_bufferr(binbuff, buffer, 0);
+  enigma::ds_binary::writer out;
+  const deque<variant> &queue = ds_queues[id];
+  out.count(queue.size());
+  for (const variant &vari : queue) out.value(vari);
+  return out.flush(binbuff, enigma::ds_binary::QUEUE, compress);
+}
+
+bool ds_queue_read_buffer(const uint64_t id, const int buffer)
+{
+  //Replaces the queue with one written by ds_queue_write_buffer; returns false, changing nothing, if the buffer holds none
+  get_bufferr(binbuff, buffer, false);
+  enigma::ds_binary::reader in;
+  size_t count;
+  if (!in.open(binbuff, enigma::ds_binary::QUEUE) || !in.count(&count)) return false;
+  deque<variant> queue(count);
+  for (variant &vari : queue)
+    if (!in.value(&vari)) return false;
+  if (!in.close(binbuff)) return false;
+  ds_queues[id].swap(queue);
+  return true;
+}
+
 }
 
 /* ds_stacks */
 
-static map<unsigned int, deque<variant> > ds_stacks;
-static unsigned int ds_stacks_maxid = 0;
+static enigma::ds_registry<deque<variant> > ds_stacks("stack");
 
 namespace enigma_user
 {
 
-unsigned int ds_stack_create()
+uint64_t ds_stack_create()
 {
   //Creates a new stack. The function returns an integer as an id that must be used in all other functions to access the particular stack.
-  ds_stacks.insert(pair<unsigned int, deque<variant> >(ds_stacks_maxid++, deque<variant>()));
-  return ds_stacks_maxid-1;
+  return ds_stacks.create();
 }
 
-void ds_stack_destroy(const unsigned int id)
+void ds_stack_destroy(const uint64_t id)
 {
   //Destroys the stack
-  ds_stacks.erase(ds_stacks.find(id));
+  ds_stacks.destroy(id);
 }
 
-void ds_stack_clear(const unsigned int id)
+void ds_stack_clear(const uint64_t id)
 {
   //Clears all values from the stack
   ds_stacks[id].clear();
 }
 
-void ds_stack_copy(const unsigned int id, const unsigned int source)
+void ds_stack_copy(const uint64_t id, const uint64_t source)
 {
   //Copies the source stack onto the stack
-  ds_stacks[id] = ds_stacks[source];
+  if (id != source) ds_stacks[id] = ds_stacks[source];
 }
 
-unsigned int ds_stack_size(const unsigned int id)
+unsigned int ds_stack_size(const uint64_t id)
 {
   //Returns the size of the stack
   return ds_stacks[id].size();
 }
 
-bool ds_stack_empty(const unsigned int id)
+bool ds_stack_empty(const uint64_t id)
 {
   //Returns whether the stack contains no values
   return ds_stacks[id].empty();
 }
 
-void ds_stack_push(const unsigned int id, const enigma::varargs &values)
+void ds_stack_push(const uint64_t id, const enigma::varargs &values)
 {
   //Pushes the values onto the stack
+  deque<variant> &stack = ds_stacks[id];
   for (int i = 0; i < values.argc; ++i)
-    ds_stacks[id].push_front(values.get(i));
+    stack.push_front(values.get(i));
 }
 
-variant ds_stack_pop(const unsigned int id)
+variant ds_stack_pop(const uint64_t id)
 {
   //Returns the value on the top of the stack and removes it from the stack
-  deque<variant>::iterator it = ds_stacks[id].begin();
-  if (it == ds_stacks[id].end()) {return 0;}
+  deque<variant> &stack = ds_stacks[id];
+  deque<variant>::iterator it = stack.begin();
+  if (it == stack.end()) {return 0;}
   const variant val = *it;
-  ds_stacks[id].pop_front();
+  stack.pop_front();
   return val;
 }
 
-variant ds_stack_top(const unsigned int id)
+variant ds_stack_top(const uint64_t id)
 {
   //Returns the value on the top of the stack
-  deque<variant>::iterator it = ds_stacks[id].begin();
-  return ((it == ds_stacks[id].end()) ? variant() : (*it));
+  deque<variant> &stack = ds_stacks[id];
+  deque<variant>::iterator it = stack.begin();
+  return ((it == stack.end()) ? variant() : (*it));
 }
 
-bool ds_stack_exists(const unsigned int id)
+bool ds_stack_exists(const uint64_t id)
 {
   //returns whether the stack exists
-  return (ds_stacks.find(id) != ds_stacks.end());
+  return ds_stacks.exists(id);
 }
 
-unsigned int ds_stack_duplicate(const unsigned int source)
+uint64_t ds_stack_duplicate(const uint64_t source)
 {
   //creates and returns a new stack containing a copy of the source stack
-  ds_stacks.insert(pair<unsigned int, deque<variant> >(++ds_stacks_maxid, deque<variant>()));
-  ds_stacks[ds_stacks_maxid-1] = ds_stacks[source];
-  return ds_stacks_maxid-1;
+  return ds_stacks.create(ds_stacks[source]);
 }
 
-std::string ds_stack_write(const unsigned int id)
+std::string ds_stack_write(const uint64_t id)
 {
   std::stringstream ss;
   ss.flags(std::ios::hex | std::ios::uppercase | std::ios::internal);
   ss.width(4);
   ss.fill('0');
 
-  std::deque<variant> dsStack = ds_stacks[id];
+  const std::deque<variant> &dsStack = ds_stacks[id];
 
   // Write size
   ss << std::hex << dsStack.size();
@@ -1969,7 +1717,7 @@ std::string ds_stack_write(const unsigned int id)
   return ss.str();
 }
 
-void ds_stack_read(const unsigned int id, std::string value)
+void ds_stack_read(const uint64_t id, std::string value)
 {
   std::stringstream ss;
   int i = 4;
@@ -2023,4 +1771,31 @@ void ds_stack_read(const unsigned int id, std::string value)
   }
 }
 
+
+unsigned ds_stack_write_buffer(const uint64_t id, const int buffer, const bool compress)
+{
+  //Writes the stack into the buffer in binary form, compressed if asked; returns the bytes written
+  get_bufferr(binbuff, buffer, 0);
+  enigma::ds_binary::writer out;
+  const deque<variant> &stack = ds_stacks[id];
+  out.count(stack.size());
+  for (const variant &vari : stack) out.value(vari);
+  return out.flush(binbuff, enigma::ds_binary::STACK, compress);
+}
+
+bool ds_stack_read_buffer(const uint64_t id, const int buffer)
+{
+  //Replaces the stack with one written by ds_stack_write_buffer; returns false, changing nothing, if the buffer holds none
+  get_bufferr(binbuff, buffer, false);
+  enigma::ds_binary::reader in;
+  size_t count;
+  if (!in.open(binbuff, enigma::ds_binary::STACK) || !in.count(&count)) return false;
+  deque<variant> stack(count);
+  for (variant &vari : stack)
+    if (!in.value(&vari)) return false;
+  if (!in.close(binbuff)) return false;
+  ds_stacks[id].swap(stack);
+  return true;
+}
+
 }
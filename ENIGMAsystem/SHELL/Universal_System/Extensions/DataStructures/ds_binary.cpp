@@ -0,0 +1,189 @@
+/** This file is a part of the ENIGMA Development Environment.
+***
+*** ENIGMA is free software: you can redistribute it and/or modify it under the
+*** terms of the GNU General Public License as published by the Free Software
+*** Foundation, version 3 of the license or any later version.
+***
+*** This application and its source code is distributed AS-IS, WITHOUT ANY
+*** WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+*** FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+*** details.
+***
+*** You should have received a copy of the GNU General Public License along
+*** with this code. If not, see <http://www.gnu.org/licenses/>
+**/
+
+#include "ds_binary.h"
+
+#include "Widget_Systems/widgets_mandatory.h"
+
+#include <cstring>
+#include <string>
+#include <zlib.h>
+
+namespace enigma {
+namespace ds_binary {
+
+namespace {
+
+const unsigned char kMagic[3] = {'E', 'D', 'S'};
+const unsigned char kVersion = 1;
+const unsigned kHeaderSize = 3 + 1 + 1 + 1 + 4 + 4;
+
+enum flag : unsigned char { COMPRESSED = 1 };
+enum tag : unsigned char { REAL = 0, STRING = 1, UNDEFINED = 2 };
+
+void put_u32(unsigned char *out, uint32_t n) {
+  for (int i = 0; i < 4; ++i) out[i] = (unsigned char) (n >> (i * 8));
+}
+
+uint32_t get_u32(const unsigned char *in) {
+  uint32_t n = 0;
+  for (int i = 0; i < 4; ++i) n |= uint32_t(in[i]) << (i * 8);
+  return n;
+}
+
+bool fail(const char *why) {
+  #ifdef DEBUG_MODE
+  DEBUG_MESSAGE(std::string("Cannot read data structure from buffer: ") + why, MESSAGE_TYPE::M_USER_ERROR);
+  #else
+  (void) why;
+  #endif
+  return false;
+}
+
+}  // namespace
+
+void writer::u32(uint32_t n) {
+  const size_t at = bytes_.size();
+  bytes_.resize(at + 4);
+  put_u32(&bytes_[at], n);
+}
+
+void writer::count(size_t n) { u32(uint32_t(n)); }
+
+void writer::value(const variant &v) {
+  if (v.type == variant::ty_real) {
+    uint64_t bits;
+    std::memcpy(&bits, &v.rval.d, sizeof bits);
+    bytes_.push_back(REAL);
+    for (int i = 0; i < 8; ++i) bytes_.push_back((unsigned char) (bits >> (i * 8)));
+  } else if (v.type == variant::ty_string) {
+    const std::string &str = v.sval();
+    bytes_.push_back(STRING);
+    u32(uint32_t(str.length()));
+    bytes_.insert(bytes_.end(), str.begin(), str.end());
+  } else {
+    // Pointers mean nothing outside the run that made them.
+    bytes_.push_back(UNDEFINED);
+  }
+}
+
+unsigned writer::flush(BinaryBuffer *buffer, kind k, bool compress) {
+  std::vector<unsigned char> record(kHeaderSize);
+  std::memcpy(&record[0], kMagic, sizeof kMagic);
+  record[3] = kVersion;
+  record[4] = k;
+  record[5] = 0;
+  put_u32(&record[6], uint32_t(bytes_.size()));
+
+  uLongf stored = 0;
+  if (compress && !bytes_.empty()) {
+    stored = compressBound(bytes_.size());
+    record.resize(kHeaderSize + stored);
+    if (compress2(&record[kHeaderSize], &stored, bytes_.data(), bytes_.size(), Z_DEFAULT_COMPRESSION) == Z_OK
+        && stored < bytes_.size()) {
+      record[5] = COMPRESSED;
+      record.resize(kHeaderSize + stored);
+    }
+  }
+  if (!record[5]) {
+    stored = bytes_.size();
+    record.resize(kHeaderSize);
+    record.insert(record.end(), bytes_.begin(), bytes_.end());
+  }
+  put_u32(&record[10], uint32_t(stored));
+
+  buffer->WriteBytes(record.data(), record.size());
+  return record.size();
+}
+
+bool reader::open(BinaryBuffer *buffer, kind k) {
+  const size_t start = buffer->position, size = buffer->GetSize();
+  if (start > size || size - start < kHeaderSize) return fail("no record at this position");
+  const unsigned char *head = buffer->data.data() + start;
+  if (std::memcmp(head, kMagic, sizeof kMagic)) return fail("no record at this position");
+  if (head[3] > kVersion) return fail("record was written by a newer version");
+  if (head[4] != k) return fail("record holds a different kind of data structure");
+
+  const uint32_t payload = get_u32(head + 6), stored = get_u32(head + 10);
+  if (size - start - kHeaderSize < stored) return fail("record is truncated");
+  const unsigned char *body = head + kHeaderSize;
+  if (head[5] & COMPRESSED) {
+    if (payload / 1032 > stored) return fail("record is corrupt");  // Past zlib's best ratio.
+    inflated_.resize(payload);
+    uLongf inflated_size = payload;
+    if (uncompress(inflated_.data(), &inflated_size, body, stored) != Z_OK || inflated_size != payload)
+      return fail("record is corrupt");
+    pos_ = inflated_.data();
+  } else {
+    if (stored != payload) return fail("record is corrupt");
+    pos_ = body;
+  }
+  end_ = pos_ + payload;
+  next_ = start + kHeaderSize + stored;
+  return true;
+}
+
+bool reader::close(BinaryBuffer *buffer) {
+  if (pos_ != end_) return fail("record is corrupt");
+  buffer->Seek(next_);
+  return true;
+}
+
+bool reader::u32(uint32_t *n) {
+  if (end_ - pos_ < 4) return fail("record is corrupt");
+  *n = get_u32(pos_);
+  pos_ += 4;
+  return true;
+}
+
+bool reader::count(size_t *n) {
+  uint32_t c;
+  if (!u32(&c)) return false;
+  if (c > remaining()) return fail("record is corrupt");
+  *n = c;
+  return true;
+}
+
+bool reader::value(variant *v) {
+  if (pos_ == end_) return fail("record is corrupt");
+  switch (*pos_++) {
+    case REAL: {
+      if (end_ - pos_ < 8) return fail("record is corrupt");
+      uint64_t bits = 0;
+      for (int i = 0; i < 8; ++i) bits |= uint64_t(pos_[i]) << (i * 8);
+      pos_ += 8;
+      double d;
+      std::memcpy(&d, &bits, sizeof d);
+      *v = d;
+      return true;
+    }
+    case STRING: {
+      uint32_t len;
+      if (!u32(&len)) return false;
+      if (len > remaining()) return fail("record is corrupt");
+      *v = std::string((const char*) pos_, len);
+      pos_ += len;
+      return true;
+    }
+    case UNDEFINED:
+      *v = variant();
+      v->type = enigma_user::ty_undefined;
+      return true;
+  }
+  return fail("record is corrupt");
+}
+
+}  // namespace ds_binary
+}  // namespace enigma
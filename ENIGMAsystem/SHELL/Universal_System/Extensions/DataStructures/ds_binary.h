@@ -0,0 +1,91 @@
+/** This file is a part of the ENIGMA Development Environment.
+***
+*** ENIGMA is free software: you can redistribute it and/or modify it under the
+*** terms of the GNU General Public License as published by the Free Software
+*** Foundation, version 3 of the license or any later version.
+***
+*** This application and its source code is distributed AS-IS, WITHOUT ANY
+*** WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+*** FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+*** details.
+***
+*** You should have received a copy of the GNU General Public License along
+*** with this code. If not, see <http://www.gnu.org/licenses/>
+**/
+
+#ifndef ENIGMA_DATASTRUCTURES_DS_BINARY_H
+#define ENIGMA_DATASTRUCTURES_DS_BINARY_H
+
+#include "Universal_System/buffers_internal.h"
+#include "Universal_System/var4.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace enigma {
+
+/// The binary form the ds_*_write_buffer functions put into a buffer, and
+/// the ds_*_read_buffer functions take back out. All integers are little
+/// endian. A record is a fixed header followed by the payload:
+///
+///   "EDS"  u8 version  u8 kind  u8 flags  u32 payload size  u32 stored size
+///
+/// The stored payload is zlib data when the compressed flag is set, and the
+/// payload itself otherwise. The payload is a sequence of u32 counts and
+/// values; each value is a tag byte followed by an f64 for reals, or by a
+/// u32 length and the bytes for strings.
+///
+/// Readers reject records of another kind or a newer version, so formats can
+/// grow without old games misreading new saves.
+namespace ds_binary {
+
+enum kind : unsigned char { GRID = 1, MAP, LIST, PRIORITY, QUEUE, STACK };
+
+/// Builds a payload, then writes it out as one record.
+class writer {
+ public:
+  void count(size_t n);
+  void value(const variant &v);
+
+  /// Writes the record at the buffer's position, growing or wrapping as
+  /// the buffer's type dictates. Returns the size of the record.
+  unsigned flush(BinaryBuffer *buffer, kind k, bool compress);
+
+ private:
+  std::vector<unsigned char> bytes_;
+
+  void u32(uint32_t n);
+};
+
+/// Decodes a record straight from a buffer's memory; only a compressed
+/// payload is inflated into memory of its own first.
+class reader {
+ public:
+  /// Checks the record at the buffer's position. Like every method here, it
+  /// reports what went wrong in debug mode before returning false.
+  bool open(BinaryBuffer *buffer, kind k);
+
+  /// Checks that the whole payload was used and moves the buffer past the
+  /// record. The buffer does not move if reading stopped short of this.
+  bool close(BinaryBuffer *buffer);
+
+  /// Reads a count. Counts larger than the rest of the payload could hold
+  /// are rejected, so corrupt input can't cause huge allocations.
+  bool count(size_t *n);
+  bool value(variant *v);
+
+  /// Bytes of payload left; every value takes at least one.
+  size_t remaining() const { return end_ - pos_; }
+
+ private:
+  std::vector<unsigned char> inflated_;
+  const unsigned char *pos_ = nullptr, *end_ = nullptr;
+  size_t next_ = 0;  ///< Buffer offset just past the record.
+
+  bool u32(uint32_t *n);
+};
+
+}  // namespace ds_binary
+}  // namespace enigma
+
+#endif  // ENIGMA_DATASTRUCTURES_DS_BINARY_H
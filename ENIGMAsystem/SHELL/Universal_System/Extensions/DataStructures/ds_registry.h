@@ -0,0 +1,116 @@
+/** This file is a part of the ENIGMA Development Environment.
+***
+*** ENIGMA is free software: you can redistribute it and/or modify it under the
+*** terms of the GNU General Public License as published by the Free Software
+*** Foundation, version 3 of the license or any later version.
+***
+*** This application and its source code is distributed AS-IS, WITHOUT ANY
+*** WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+*** FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+*** details.
+***
+*** You should have received a copy of the GNU General Public License along
+*** with this code. If not, see <http://www.gnu.org/licenses/>
+**/
+
+#ifndef ENIGMA_DATASTRUCTURES_DS_REGISTRY_H
+#define ENIGMA_DATASTRUCTURES_DS_REGISTRY_H
+
+#include "Widget_Systems/widgets_mandatory.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace enigma {
+
+/// Owns every data structure of one kind and hands out the IDs GML uses to
+/// refer to them. An ID packs a slot index into its low bits and that slot's
+/// generation above them. Destroying a structure frees its slot for reuse
+/// and bumps the generation, so IDs to the destroyed structure stop resolving
+/// rather than aliasing whatever takes the slot next. The first structure in
+/// each slot has generation zero, so fresh IDs still count up from 0.
+///
+/// IDs are kept below 2^53 so they survive being stored in a real. A slot
+/// whose generation has reached the top of that range is retired instead of
+/// being reused, since wrapping would bring destroyed IDs back to life.
+template<typename T> class ds_registry {
+ public:
+  explicit ds_registry(const char *kind): kind_(kind) {}
+
+  uint64_t create(T value = T()) {
+    uint64_t index;
+    if (free_.empty()) {
+      index = slots_.size();
+      slots_.push_back(slot{std::move(value), index, true});
+    } else {
+      index = free_.back();
+      free_.pop_back();
+      slot &s = slots_[index];
+      s.value = std::move(value);
+      s.live = true;
+    }
+    return slots_[index].id;
+  }
+
+  void destroy(uint64_t id) {
+    if (!exists(id)) {
+      missing(id);
+      return;
+    }
+    slot &s = slots_[id & kIndexMask];
+    s.value = T();
+    s.live = false;
+    const uint64_t generation = id >> kIndexBits;
+    if (generation == kMaxGeneration) return;
+    s.id = ((generation + 1) << kIndexBits) | (id & kIndexMask);
+    free_.push_back(id & kIndexMask);
+  }
+
+  bool exists(uint64_t id) const {
+    const uint64_t index = id & kIndexMask;
+    return index < slots_.size() && slots_[index].id == id && slots_[index].live;
+  }
+
+  /// Looks up a live structure. A bad ID yields an empty scratch structure
+  /// (and an error in debug mode), as scripts relied on never crashing here.
+  /// The reference is only good until the next create(), which may move
+  /// every structure when it grows the storage.
+  T &operator[](uint64_t id) {
+    const uint64_t index = id & kIndexMask;
+    if (index < slots_.size() && slots_[index].id == id && slots_[index].live)
+      return slots_[index].value;
+    return missing(id);
+  }
+
+ private:
+  static const unsigned kIndexBits = 20;
+  static const uint64_t kIndexMask = (uint64_t(1) << kIndexBits) - 1;
+  static const uint64_t kMaxGeneration = (uint64_t(1) << (53 - kIndexBits)) - 1;
+
+  struct slot {
+    T value;
+    uint64_t id;
+    bool live;
+  };
+
+  const char *kind_;
+  std::vector<slot> slots_;
+  std::vector<uint64_t> free_;
+  T scratch_;
+
+  T &missing(uint64_t id) {
+    #ifdef DEBUG_MODE
+    DEBUG_MESSAGE(std::string("Attempting to access non-existing ") + kind_ + " " + std::to_string(id),
+                  MESSAGE_TYPE::M_USER_ERROR);
+    #else
+    (void) id;
+    #endif
+    scratch_ = T();
+    return scratch_;
+  }
+};
+
+}  // namespace enigma
+
+#endif  // ENIGMA_DATASTRUCTURES_DS_REGISTRY_H
@@ -34,136 +34,149 @@
 namespace enigma_user
 {
 
-unsigned int ds_grid_create(const unsigned int w, const unsigned int h);
-void ds_grid_destroy(const unsigned int id);
-void ds_grid_clear(const unsigned int id, const variant val);
-void ds_grid_copy(const unsigned int id, const unsigned int source);
-void ds_grid_resize(const unsigned int id, const unsigned int w, const unsigned int h);
-unsigned int ds_grid_width(const unsigned int id);
-unsigned int ds_grid_height(const unsigned int id);
-void ds_grid_set(const unsigned int id, const unsigned int x, const unsigned int y, const variant val);
-void ds_grid_add(const unsigned int id, const unsigned int x, const unsigned int y, const variant val);
-void ds_grid_multiply(const unsigned int id, const unsigned int x, const unsigned int y, const double val);
-void ds_grid_set_region(const unsigned int id, const unsigned int x1, const unsigned int y1, const unsigned int x2, const unsigned int y2, const variant val);
-void ds_grid_add_region(const unsigned int id, const unsigned int x1, const unsigned int y1, const unsigned int x2, const unsigned int y2, const variant val);
-void ds_grid_multiply_region(const unsigned int id, const unsigned int x1, const unsigned int y1, const unsigned int x2, const unsigned int y2, const double val);
-void ds_grid_set_disk(const unsigned int id, const double x, const double y, const double r, const variant val);
-void ds_grid_add_disk(const unsigned int id, const double x, const double y, const double r, const variant val);
-void ds_grid_multiply_disk(const unsigned int id, const double x, const double y, const double r, const double val);
-void ds_grid_set_grid_region(const unsigned int id, const unsigned int source, const unsigned int x1, const unsigned int y1, const unsigned int x2, const unsigned int y2, const unsigned int xpos, const unsigned int ypos);
-void ds_grid_add_grid_region(const unsigned int id, const unsigned int source, const unsigned int x1, const unsigned int y1, const unsigned int x2, const unsigned int y2, const unsigned int xpos, const unsigned int ypos);
-void ds_grid_multiply_grid_region(const unsigned int id, const unsigned int source, const unsigned int x1, const unsigned int y1, const unsigned int x2, const unsigned int y2, const unsigned int xpos, const unsigned int ypos);
-variant ds_grid_get(const unsigned int id, const unsigned int x, const unsigned int y);
-variant ds_grid_get_sum(const unsigned int id, const unsigned int x1, const unsigned int y1, const unsigned int x2, const unsigned int y2);
-variant ds_grid_get_max(const unsigned int id, const unsigned int x1, const unsigned int y1, const unsigned int x2, const unsigned int y2);
-variant ds_grid_get_min(const unsigned int id, const unsigned int x1, const unsigned int y1, const unsigned int x2, const unsigned int y2);
-variant ds_grid_get_mean(const unsigned int id, const unsigned int x1, const unsigned int y1, const unsigned int x2, const unsigned int y2);
-variant ds_grid_get_disk_sum(const unsigned int id, const double x, const double y, const double r);
-variant ds_grid_get_disk_max(const unsigned int id, const double x, const double y, const double r);
-variant ds_grid_get_disk_min(const unsigned int id, const double x, const double y, const double r);
-variant ds_grid_get_disk_mean(const unsigned int id, const double x, const double y, const double r);
-bool ds_grid_value_exists(const unsigned int id, const unsigned int x1, const unsigned int y1, const unsigned int x2, const unsigned int y2, const variant val);
-int ds_grid_value_x(const unsigned int id, const unsigned int x1, const unsigned int y1, const unsigned int x2, const unsigned int y2, const variant val);
-int ds_grid_value_y(const unsigned int id, const unsigned int x1, const unsigned int y1, const unsigned int x2, const unsigned int y2, const variant val);
-bool ds_grid_value_disk_exists(const unsigned int id, const double x, const double y, const double r, const variant val);
-bool ds_grid_value_disk_x(const unsigned int id, const double x, const double y, const double r, const variant val);
-bool ds_grid_value_disk_y(const unsigned int id, const double x, const double y, const double r, const variant val);
-void ds_grid_shuffle(const unsigned int id);
-bool ds_grid_exists(const unsigned int id);
-unsigned int ds_grid_duplicate(const unsigned int source);
-std::string ds_grid_write(const unsigned int id);
-void ds_grid_read(const unsigned int id, std::string value);
+uint64_t ds_grid_create(const unsigned int w, const unsigned int h);
+void ds_grid_destroy(const uint64_t id);
+void ds_grid_clear(const uint64_t id, const variant val);
+void ds_grid_copy(const uint64_t id, const uint64_t source);
+void ds_grid_resize(const uint64_t id, const unsigned int w, const unsigned int h);
+unsigned int ds_grid_width(const uint64_t id);
+unsigned int ds_grid_height(const uint64_t id);
+void ds_grid_set(const uint64_t id, const unsigned int x, const unsigned int y, const variant val);
+void ds_grid_add(const uint64_t id, const unsigned int x, const unsigned int y, const variant val);
+void ds_grid_multiply(const uint64_t id, const unsigned int x, const unsigned int y, const double val);
+void ds_grid_set_region(const uint64_t id, const unsigned int x1, const unsigned int y1, const unsigned int x2, const unsigned int y2, const variant val);
+void ds_grid_add_region(const uint64_t id, const unsigned int x1, const unsigned int y1, const unsigned int x2, const unsigned int y2, const variant val);
+void ds_grid_multiply_region(const uint64_t id, const unsigned int x1, const unsigned int y1, const unsigned int x2, const unsigned int y2, const double val);
+void ds_grid_set_disk(const uint64_t id, const double x, const double y, const double r, const variant val);
+void ds_grid_add_disk(const uint64_t id, const double x, const double y, const double r, const variant val);
+void ds_grid_multiply_disk(const uint64_t id, const double x, const double y, const double r, const double val);
+void ds_grid_set_grid_region(const uint64_t id, const uint64_t source, const unsigned int x1, const unsigned int y1, const unsigned int x2, const unsigned int y2, const unsigned int xpos, const unsigned int ypos);
+void ds_grid_add_grid_region(const uint64_t id, const uint64_t source, const unsigned int x1, const unsigned int y1, const unsigned int x2, const unsigned int y2, const unsigned int xpos, const unsigned int ypos);
+void ds_grid_multiply_grid_region(const uint64_t id, const uint64_t source, const unsigned int x1, const unsigned int y1, const unsigned int x2, const unsigned int y2, const unsigned int xpos, const unsigned int ypos);
+void ds_grid_set_script(const uint64_t id, const int scr, variant arg0 = 0, variant arg1 = 0, variant arg2 = 0, variant arg3 = 0, variant arg4 = 0, variant arg5 = 0);
+variant ds_grid_get(const uint64_t id, const unsigned int x, const unsigned int y);
+variant ds_grid_get_sum(const uint64_t id, const unsigned int x1, const unsigned int y1, const unsigned int x2, const unsigned int y2);
+variant ds_grid_get_max(const uint64_t id, const unsigned int x1, const unsigned int y1, const unsigned int x2, const unsigned int y2);
+variant ds_grid_get_min(const uint64_t id, const unsigned int x1, const unsigned int y1, const unsigned int x2, const unsigned int y2);
+variant ds_grid_get_mean(const uint64_t id, const unsigned int x1, const unsigned int y1, const unsigned int x2, const unsigned int y2);
+variant ds_grid_get_disk_sum(const uint64_t id, const double x, const double y, const double r);
+variant ds_grid_get_disk_max(const uint64_t id, const double x, const double y, const double r);
+variant ds_grid_get_disk_min(const uint64_t id, const double x, const double y, const double r);
+variant ds_grid_get_disk_mean(const uint64_t id, const double x, const double y, const double r);
+bool ds_grid_value_exists(const uint64_t id, const unsigned int x1, const unsigned int y1, const unsigned int x2, const unsigned int y2, const variant val);
+int ds_grid_value_x(const uint64_t id, const unsigned int x1, const unsigned int y1, const unsigned int x2, const unsigned int y2, const variant val);
+int ds_grid_value_y(const uint64_t id, const unsigned int x1, const unsigned int y1, const unsigned int x2, const unsigned int y2, const variant val);
+bool ds_grid_value_disk_exists(const uint64_t id, const double x, const double y, const double r, const variant val);
+bool ds_grid_value_disk_x(const uint64_t id, const double x, const double y, const double r, const variant val);
+bool ds_grid_value_disk_y(const uint64_t id, const double x, const double y, const double r, const variant val);
+void ds_grid_shuffle(const uint64_t id);
+bool ds_grid_exists(const uint64_t id);
+uint64_t ds_grid_duplicate(const uint64_t source);
+std::string ds_grid_write(const uint64_t id);
+void ds_grid_read(const uint64_t id, std::string value);
+unsigned ds_grid_write_buffer(const uint64_t id, const int buffer, const bool compress = false);
+bool ds_grid_read_buffer(const uint64_t id, const int buffer);
 
-unsigned int ds_map_create();
-void ds_map_destroy(const unsigned int id);
-void ds_map_clear(const unsigned int id);
-void ds_map_copy(const unsigned int id, const unsigned int source);
-unsigned int ds_map_size(const unsigned int id);
-bool ds_map_empty(const unsigned int id);
-void ds_map_add(const unsigned int id, const variant key, const variant val);
-void ds_map_replace(const unsigned int id, const variant key, const variant val);
-void ds_map_overwrite(const unsigned int id, const variant key, const variant val);
-void ds_map_delete(const unsigned int id, const variant key);
-void ds_map_delete(const unsigned int id, const variant first, const variant last);
-bool ds_map_exists(const unsigned int id, const variant key);
-variant ds_map_find_value(const unsigned int id, const variant key);
-variant ds_map_find_previous(const unsigned int id, const variant key);
-variant ds_map_find_next(const unsigned int id, const variant key);
-variant ds_map_find_first(const unsigned int id);
-variant ds_map_find_last(const unsigned int id);
-bool ds_map_exists(const unsigned int id);
-unsigned int ds_map_duplicate(const unsigned int source);
-std::string ds_map_write(const unsigned int source);
-void ds_map_read(const unsigned int id, std::string value);
+uint64_t ds_map_create();
+void ds_map_destroy(const uint64_t id);
+void ds_map_clear(const uint64_t id);
+void ds_map_copy(const uint64_t id, const uint64_t source);
+unsigned int ds_map_size(const uint64_t id);
+bool ds_map_empty(const uint64_t id);
+void ds_map_add(const uint64_t id, const variant key, const variant val);
+void ds_map_replace(const uint64_t id, const variant key, const variant val);
+void ds_map_overwrite(const uint64_t id, const variant key, const variant val);
+void ds_map_delete(const uint64_t id, const variant key);
+void ds_map_delete(const uint64_t id, const variant first, const variant last);
+bool ds_map_exists(const uint64_t id, const variant key);
+variant ds_map_find_value(const uint64_t id, const variant key);
+variant ds_map_find_previous(const uint64_t id, const variant key);
+variant ds_map_find_next(const uint64_t id, const variant key);
+variant ds_map_find_first(const uint64_t id);
+variant ds_map_find_last(const uint64_t id);
+bool ds_map_exists(const uint64_t id);
+uint64_t ds_map_duplicate(const uint64_t source);
+std::string ds_map_write(const uint64_t source);
+void ds_map_read(const uint64_t id, std::string value);
+unsigned ds_map_write_buffer(const uint64_t id, const int buffer, const bool compress = false);
+bool ds_map_read_buffer(const uint64_t id, const int buffer);
 
-unsigned int ds_list_create();
-void ds_list_destroy(const unsigned int id);
-void ds_list_clear(const unsigned int id);
-void ds_list_copy(const unsigned int id, const unsigned int source);
-unsigned int ds_list_size(const unsigned int id);
-bool ds_list_empty(const unsigned int id);
-void ds_list_add(const unsigned int id, const enigma::varargs &values);
-void ds_list_insert(const unsigned int id, const unsigned int pos, const variant val);
-void ds_list_replace(const unsigned int id, const unsigned int pos, const variant val);
-void ds_list_delete(const unsigned int id, const unsigned int pos);
-void ds_list_delete(const unsigned int id, const unsigned int first, const unsigned int last);
-int ds_list_find_index(const unsigned int id, const variant val);
-variant ds_list_find_value(const unsigned int id, const unsigned int pos);
-void ds_list_sort(const unsigned int id, const bool ascend);
-void ds_list_shuffle(const unsigned int id);
-bool ds_list_exists(const unsigned int id);
-unsigned int ds_list_duplicate(const unsigned int source);
-std::string ds_list_write(const unsigned int id);
-void ds_list_read(const unsigned int id, std::string value);
+uint64_t ds_list_create();
+void ds_list_destroy(const uint64_t id);
+void ds_list_clear(const uint64_t id);
+void ds_list_copy(const uint64_t id, const uint64_t source);
+unsigned int ds_list_size(const uint64_t id);
+bool ds_list_empty(const uint64_t id);
+void ds_list_add(const uint64_t id, const enigma::varargs &values);
+void ds_list_insert(const uint64_t id, const unsigned int pos, const variant val);
+void ds_list_replace(const uint64_t id, const unsigned int pos, const variant val);
+void ds_list_delete(const uint64_t id, const unsigned int pos);
+void ds_list_delete(const uint64_t id, const unsigned int first, const unsigned int last);
+int ds_list_find_index(const uint64_t id, const variant val);
+variant ds_list_find_value(const uint64_t id, const unsigned int pos);
+void ds_list_sort(const uint64_t id, const bool ascend);
+void ds_list_shuffle(const uint64_t id);
+bool ds_list_exists(const uint64_t id);
+uint64_t ds_list_duplicate(const uint64_t source);
+std::string ds_list_write(const uint64_t id);
+void ds_list_read(const uint64_t id, std::string value);
+unsigned ds_list_write_buffer(const uint64_t id, const int buffer, const bool compress = false);
+bool ds_list_read_buffer(const uint64_t id, const int buffer);
 
-unsigned int ds_priority_create();
-void ds_priority_destroy(const unsigned int id);
-void ds_priority_clear(const unsigned int id);
-void ds_priority_copy(const unsigned int id, const unsigned int source);
-unsigned int ds_priority_size(const unsigned int id);
-bool ds_priority_empty(const unsigned int id);
-void ds_priority_add(const unsigned int id, const variant val, const variant prio);
-void ds_priority_change_priority(const unsigned int id, const variant val, const variant prio);
-variant ds_priority_find_priority(const unsigned int id, const variant val);
-void ds_priority_delete_value(const unsigned int id, const variant val);
-bool ds_priority_value_exists(const unsigned int id, const variant val);
-variant ds_priority_delete_min(const unsigned int id);
-variant ds_priority_find_min(const unsigned int id);
-variant ds_priority_delete_max(const unsigned int id);
-variant ds_priority_find_max(const unsigned int id);
-bool ds_priority_exists(const unsigned int id);
-unsigned int ds_priority_duplicate(const unsigned int source);
-std::string ds_priority_write(const unsigned int id);
-void ds_priority_read(const unsigned int id, std::string value);
+uint64_t ds_priority_create();
+void ds_priority_destroy(const uint64_t id);
+void ds_priority_clear(const uint64_t id);
+void ds_priority_copy(const uint64_t id, const uint64_t source);
+unsigned int ds_priority_size(const uint64_t id);
+bool ds_priority_empty(const uint64_t id);
+void ds_priority_add(const uint64_t id, const variant val, const variant prio);
+void ds_priority_change_priority(const uint64_t id, const variant val, const variant prio);
+variant ds_priority_find_priority(const uint64_t id, const variant val);
+void ds_priority_delete_value(const uint64_t id, const variant val);
+bool ds_priority_value_exists(const uint64_t id, const variant val);
+variant ds_priority_delete_min(const uint64_t id);
+variant ds_priority_find_min(const uint64_t id);
+variant ds_priority_delete_max(const uint64_t id);
+variant ds_priority_find_max(const uint64_t id);
+bool ds_priority_exists(const uint64_t id);
+uint64_t ds_priority_duplicate(const uint64_t source);
+std::string ds_priority_write(const uint64_t id);
+void ds_priority_read(const uint64_t id, std::string value);
+unsigned ds_priority_write_buffer(const uint64_t id, const int buffer, const bool compress = false);
+bool ds_priority_read_buffer(const uint64_t id, const int buffer);
 
-unsigned int ds_queue_create();
-void ds_queue_destroy(const unsigned int id);
-void ds_queue_clear(const unsigned int id);
-void ds_queue_copy(const unsigned int id, const unsigned int source);
-unsigned int ds_queue_size(const unsigned int id);
-bool ds_queue_empty(const unsigned int id);
-void ds_queue_enqueue(const unsigned int id, const enigma::varargs &values);
-variant ds_queue_dequeue(const unsigned int id);
-variant ds_queue_head(const unsigned int id);
-variant ds_queue_tail(const unsigned int id);
-bool ds_queue_exists(const unsigned int id);
-unsigned int ds_queue_duplicate(const unsigned int source);
-std::string ds_queue_write(const unsigned int id);
-void ds_queue_read(const unsigned int id, std::string value);
+uint64_t ds_queue_create();
+void ds_queue_destroy(const uint64_t id);
+void ds_queue_clear(const uint64_t id);
+void ds_queue_copy(const uint64_t id, const uint64_t source);
+unsigned int ds_queue_size(const uint64_t id);
+bool ds_queue_empty(const uint64_t id);
+void ds_queue_enqueue(const uint64_t id, const enigma::varargs &values);
+variant ds_queue_dequeue(const uint64_t id);
+variant ds_queue_head(const uint64_t id);
+variant ds_queue_tail(const uint64_t id);
+bool ds_queue_exists(const uint64_t id);
+uint64_t ds_queue_duplicate(const uint64_t source);
+std::string ds_queue_write(const uint64_t id);
+void ds_queue_read(const uint64_t id, std::string value);
+unsigned ds_queue_write_buffer(const uint64_t id, const int buffer, const bool compress = false);
+bool ds_queue_read_buffer(const uint64_t id, const int buffer);
 
-unsigned int ds_stack_create();
-void ds_stack_destroy(const unsigned int id);
-void ds_stack_clear(const unsigned int id);
-void ds_stack_copy(const unsigned int id, const unsigned int source);
-unsigned int ds_stack_size(const unsigned int id);
-bool ds_stack_empty(const unsigned int id);
-void ds_stack_push(const unsigned int id, const enigma::varargs &values);
-variant ds_stack_pop(const unsigned int id);
-variant ds_stack_top(const unsigned int id);
-bool ds_stack_exists(const unsigned int id);
-unsigned int ds_stack_duplicate(const unsigned int source);
-std::string ds_stack_write(const unsigned int id);
-void ds_stack_read(const unsigned int id, std::string value);
+uint64_t ds_stack_create();
+void ds_stack_destroy(const uint64_t id);
+void ds_stack_clear(const uint64_t id);
+void ds_stack_copy(const uint64_t id, const uint64_t source);
+unsigned int ds_stack_size(const uint64_t id);
+bool ds_stack_empty(const uint64_t id);
+void ds_stack_push(const uint64_t id, const enigma::varargs &values);
+variant ds_stack_pop(const uint64_t id);
+variant ds_stack_top(const uint64_t id);
+bool ds_stack_exists(const uint64_t id);
+uint64_t ds_stack_duplicate(const uint64_t source);
+std::string ds_stack_write(const uint64_t id);
+void ds_stack_read(const uint64_t id, std::string value);
+unsigned ds_stack_write_buffer(const uint64_t id, const int buffer, const bool compress = false);
+bool ds_stack_read_buffer(const uint64_t id, const int buffer);
 
 }
 
@@ -0,0 +1,601 @@
+/** This file is a part of the ENIGMA Development Environment.
+***
+*** ENIGMA is free software: you can redistribute it and/or modify it under the
+*** terms of the GNU General Public License as published by the Free Software
+*** Foundation, version 3 of the license or any later version.
+***
+*** This application and its source code is distributed AS-IS, WITHOUT ANY
+*** WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+*** FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+*** details.
+***
+*** You should have received a copy of the GNU General Public License along
+*** with this code. If not, see <http://www.gnu.org/licenses/>
+**/
+
+#include "variant_grid.h"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+namespace enigma {
+
+namespace {
+
+enum { kSet, kAdd, kMultiply };
+
+template<bool kMax> inline double extreme(double a, double b) {
+  return kMax ? (b > a ? b : a) : (b < a ? b : a);
+}
+
+}  // namespace
+
+variant_grid::variant_grid(unsigned w, unsigned h): w_(w), h_(h), reals_(size_t(w) * h, 0.0) {}
+
+// Bookkeeping
+// =============================================================================
+
+void variant_grid::changed() {
+  sat_valid_ = min_valid_ = max_valid_ = false;
+  sum_scanned_ = range_scanned_ = 0;
+}
+
+void variant_grid::to_variants() {
+  cells_.resize(reals_.size());
+  for (size_t i = 0; i < reals_.size(); ++i) cells_[i] = reals_[i];
+  std::vector<double>().swap(reals_);
+  numeric_ = false;
+  nonreal_ = 0;
+}
+
+// Goes back to packed reals once nothing else is left in the grid.
+void variant_grid::settle() {
+  if (numeric_ || nonreal_) return;
+  reals_.resize(cells_.size());
+  for (size_t i = 0; i < cells_.size(); ++i) reals_[i] = cells_[i].rval.d;
+  std::vector<variant>().swap(cells_);
+  numeric_ = true;
+}
+
+void variant_grid::store(size_t ind, const variant &val) {
+  if (cells_[ind].type != variant::ty_real) --nonreal_;
+  if (val.type != variant::ty_real) ++nonreal_;
+  cells_[ind] = val;
+}
+
+bool variant_grid::clip_region(unsigned x1, unsigned y1, unsigned x2, unsigned y2, rect *r) const {
+  const int tx1 = std::min(x1, x2), ty1 = std::min(y1, y2), tx2 = std::max(x1, x2), ty2 = std::max(y1, y2);
+  const int xd = w_ - tx1, yd = h_ - ty1;
+  if (xd <= 0 || yd <= 0) return false;
+  *r = rect{std::max(tx1, 0), std::max(ty1, 0), std::min(tx2 + 1, int(w_)), std::min(ty2 + 1, int(h_))};
+  return r->x1 < r->x2 && r->y1 < r->y2;
+}
+
+bool variant_grid::clip_disk(double x, double y, double r, rect *box) const {
+  const int tx1 = int(x - r), ty1 = int(y - r), tx2 = int(x + r + 1), ty2 = int(y + r + 1);
+  if (tx2 < 0 || ty2 < 0 || tx1 >= int(w_) || ty1 >= int(h_)) return false;
+  *box = rect{std::max(tx1, 0), std::max(ty1, 0), std::min(tx2, int(w_)), std::min(ty2, int(h_))};
+  return true;
+}
+
+// Finds the run of cells in one row of the disk. The ends come from the
+// circle equation, then get nudged with the exact per-cell test so the disk
+// covers the same cells it always has, whatever sqrt rounds to.
+bool variant_grid::disk_span(double x, double y, double rr, int row, const rect &box, int *x1, int *x2) const {
+  const double dy = y - row, rem = rr - dy * dy;
+  if (rem < 0) return false;
+  auto inside = [&](int c) { return (x - c) * (x - c) + dy * dy <= rr; };
+  const double s = std::sqrt(rem);
+  int a = int(std::max<double>(box.x1, std::min<double>(box.x2, std::ceil(x - s))));
+  int b = int(std::max<double>(a, std::min<double>(box.x2, std::floor(x + s) + 1)));
+  while (a < b && !inside(a)) ++a;
+  while (a > box.x1 && inside(a - 1)) --a;
+  while (b > a && !inside(b - 1)) --b;
+  while (b < box.x2 && inside(b)) ++b;
+  *x1 = a;
+  *x2 = b;
+  return a < b;
+}
+
+template<typename F> void variant_grid::for_disk(double x, double y, double r, F span) {
+  rect box;
+  if (!clip_disk(x, y, r, &box)) return;
+  const double rr = r * r;
+  for (int i = box.y1; i < box.y2; ++i) {
+    int a, b;
+    if (disk_span(x, y, rr, i, box, &a, &b)) span(i, a, b);
+  }
+}
+
+// Whole-grid operations
+// =============================================================================
+
+void variant_grid::clear(const variant &val) {
+  const size_t count = size_t(w_) * h_;
+  if (val.type == variant::ty_real) {
+    numeric_ = true;
+    reals_.assign(count, val.rval.d);
+    std::vector<variant>().swap(cells_);
+  } else {
+    numeric_ = false;
+    cells_.assign(count, val);
+    nonreal_ = count;
+    std::vector<double>().swap(reals_);
+  }
+  changed();
+}
+
+void variant_grid::resize(unsigned w, unsigned h) {
+  const unsigned wm = std::min(w_, w), hm = std::min(h_, h);
+  // New cells are default variants, which are only reals in some settings.
+  const bool grows = size_t(w) * h != size_t(wm) * hm;
+  if (numeric_ && (!grows || variant().type == variant::ty_real)) {
+    std::vector<double> resized(size_t(w) * h, 0.0);
+    for (unsigned i = 0; i < hm; ++i)
+      std::copy(reals_.begin() + size_t(i) * w_, reals_.begin() + size_t(i) * w_ + wm, resized.begin() + size_t(i) * w);
+    reals_.swap(resized);
+  } else {
+    if (numeric_) to_variants();
+    std::vector<variant> resized(size_t(w) * h);
+    for (unsigned i = 0; i < hm; ++i)
+      for (unsigned ii = 0; ii < wm; ++ii)
+        resized[size_t(i) * w + ii] = cells_[size_t(i) * w_ + ii];
+    cells_.swap(resized);
+    nonreal_ = 0;
+    for (const variant &cell : cells_) nonreal_ += cell.type != variant::ty_real;
+  }
+  w_ = w;
+  h_ = h;
+  changed();
+  settle();
+}
+
+void variant_grid::shuffle() {
+  // The last cell has never taken part; scripts may depend on that.
+  std::random_device rd;
+  std::mt19937 g(rd());
+  if (numeric_) {
+    if (reals_.size() > 1) std::shuffle(reals_.begin(), reals_.end() - 1, g);
+  } else {
+    if (cells_.size() > 1) std::shuffle(cells_.begin(), cells_.end() - 1, g);
+  }
+  changed();
+}
+
+// Single cells
+// =============================================================================
+
+variant variant_grid::find(unsigned x, unsigned y) const {
+  if (x >= w_ || y >= h_) return variant();
+  const size_t ind = size_t(y) * w_ + x;
+  return numeric_ ? variant(reals_[ind]) : cells_[ind];
+}
+
+void variant_grid::insert(unsigned x, unsigned y, const variant &val) {
+  if (x >= w_ || y >= h_) return;
+  const size_t ind = size_t(y) * w_ + x;
+  if (numeric_ && val.type == variant::ty_real) {
+    reals_[ind] = val.rval.d;
+  } else {
+    if (numeric_) to_variants();
+    store(ind, val);
+  }
+  changed();
+}
+
+// Adding anything but a real goes through variant +=, exactly as it always
+// has; the grid switches back to reals at the next region operation.
+void variant_grid::add(unsigned x, unsigned y, const variant &val) {
+  if (x >= w_ || y >= h_) return;
+  const size_t ind = size_t(y) * w_ + x;
+  if (numeric_ && val.type != variant::ty_real) to_variants();
+  if (numeric_) reals_[ind] += val.rval.d;
+  else cells_[ind] += val;
+  changed();
+}
+
+void variant_grid::multiply(unsigned x, unsigned y, double val) {
+  if (x >= w_ || y >= h_) return;
+  const size_t ind = size_t(y) * w_ + x;
+  if (numeric_) {
+    reals_[ind] *= val;
+  } else {
+    store(ind, cells_[ind] * val);
+  }
+  changed();
+}
+
+// Regions and disks
+// =============================================================================
+// The numeric paths work on whole rows of packed doubles with no calls or
+// branches inside, which the compiler turns into vector code.
+
+void variant_grid::insert_region(unsigned x1, unsigned y1, unsigned x2, unsigned y2, const variant &val) {
+  rect r;
+  if (!clip_region(x1, y1, x2, y2, &r)) return;
+  settle();
+  if (numeric_ && val.type != variant::ty_real) to_variants();
+  for (int i = r.y1; i < r.y2; ++i) {
+    if (numeric_) {
+      std::fill(reals_.begin() + size_t(i) * w_ + r.x1, reals_.begin() + size_t(i) * w_ + r.x2, val.rval.d);
+    } else {
+      for (int ii = r.x1; ii < r.x2; ++ii) store(size_t(i) * w_ + ii, val);
+    }
+  }
+  changed();
+  settle();
+}
+
+void variant_grid::add_region(unsigned x1, unsigned y1, unsigned x2, unsigned y2, const variant &val) {
+  rect r;
+  if (!clip_region(x1, y1, x2, y2, &r)) return;
+  settle();
+  if (numeric_ && val.type != variant::ty_real) to_variants();
+  for (int i = r.y1; i < r.y2; ++i) {
+    if (numeric_) {
+      double *row = reals_.data() + size_t(i) * w_;
+      const double v = val.rval.d;
+      for (int ii = r.x1; ii < r.x2; ++ii) row[ii] += v;
+    } else {
+      for (int ii = r.x1; ii < r.x2; ++ii) cells_[size_t(i) * w_ + ii] += val;
+    }
+  }
+  changed();
+  settle();
+}
+
+void variant_grid::multiply_region(unsigned x1, unsigned y1, unsigned x2, unsigned y2, double val) {
+  rect r;
+  if (!clip_region(x1, y1, x2, y2, &r)) return;
+  settle();
+  for (int i = r.y1; i < r.y2; ++i) {
+    if (numeric_) {
+      double *row = reals_.data() + size_t(i) * w_;
+      for (int ii = r.x1; ii < r.x2; ++ii) row[ii] *= val;
+    } else {
+      for (int ii = r.x1; ii < r.x2; ++ii) store(size_t(i) * w_ + ii, cells_[size_t(i) * w_ + ii] * val);
+    }
+  }
+  changed();
+  settle();
+}
+
+void variant_grid::insert_disk(double x, double y, double r, const variant &val) {
+  settle();
+  if (numeric_ && val.type != variant::ty_real) to_variants();
+  for_disk(x, y, r, [&](int i, int a, int b) {
+    if (numeric_) {
+      std::fill(reals_.begin() + size_t(i) * w_ + a, reals_.begin() + size_t(i) * w_ + b, val.rval.d);
+    } else {
+      for (int ii = a; ii < b; ++ii) store(size_t(i) * w_ + ii, val);
+    }
+  });
+  changed();
+  settle();
+}
+
+void variant_grid::add_disk(double x, double y, double r, const variant &val) {
+  settle();
+  if (numeric_ && val.type != variant::ty_real) to_variants();
+  for_disk(x, y, r, [&](int i, int a, int b) {
+    if (numeric_) {
+      double *row = reals_.data() + size_t(i) * w_;
+      const double v = val.rval.d;
+      for (int ii = a; ii < b; ++ii) row[ii] += v;
+    } else {
+      for (int ii = a; ii < b; ++ii) cells_[size_t(i) * w_ + ii] += val;
+    }
+  });
+  changed();
+  settle();
+}
+
+void variant_grid::multiply_disk(double x, double y, double r, double val) {
+  settle();
+  for_disk(x, y, r, [&](int i, int a, int b) {
+    if (numeric_) {
+      double *row = reals_.data() + size_t(i) * w_;
+      for (int ii = a; ii < b; ++ii) row[ii] *= val;
+    } else {
+      for (int ii = a; ii < b; ++ii) store(size_t(i) * w_ + ii, cells_[size_t(i) * w_ + ii] * val);
+    }
+  });
+  changed();
+  settle();
+}
+
+// Cells are visited in the same order as always, so a grid copying from an
+// overlapping region of itself gives the same result it always did.
+template<int kOp> void variant_grid::apply_grid_region(const variant_grid &source, unsigned sx1, unsigned sy1,
+                                                      unsigned sx2, unsigned sy2, unsigned x, unsigned y) {
+  if (x >= w_ || y >= h_) return;
+  const int tx1 = std::min(sx1, sx2), ty1 = std::min(sy1, sy2), tx2 = std::max(sx1, sx2), ty2 = std::max(sy1, sy2);
+  const int xd = source.w_ - tx1, yd = source.h_ - ty1;
+  if (xd <= 0 || yd <= 0 || tx1 < 0 || ty1 < 0) return;
+  const int upx = std::min(tx2 - tx1 + 1, std::min(int(w_ - x), xd));
+  const int upy = std::min(ty2 - ty1 + 1, std::min(int(h_ - y), yd));
+  if (upx <= 0 || upy <= 0) return;
+
+  settle();
+  if (kOp != kMultiply && numeric_ && !source.numeric_) to_variants();
+  for (int i = 0; i < upy; ++i) {
+    const size_t d = size_t(y + i) * w_ + x, s = size_t(ty1 + i) * source.w_ + tx1;
+    for (int ii = 0; ii < upx; ++ii) {
+      if (numeric_) {
+        const double v = source.numeric_ ? source.reals_[s + ii] : source.cells_[s + ii].rval.d;
+        if (kOp == kSet) reals_[d + ii] = v;
+        else if (kOp == kAdd) reals_[d + ii] += v;
+        else reals_[d + ii] *= v;
+      } else {
+        const variant v = source.numeric_ ? variant(source.reals_[s + ii]) : source.cells_[s + ii];
+        if (kOp == kSet) store(d + ii, v);
+        else if (kOp == kAdd) cells_[d + ii] += v;
+        else store(d + ii, cells_[d + ii] * v);
+      }
+    }
+  }
+  changed();
+  settle();
+}
+
+void variant_grid::insert_grid_region(const variant_grid &source, unsigned sx1, unsigned sy1, unsigned sx2,
+                                      unsigned sy2, unsigned x, unsigned y) {
+  apply_grid_region<kSet>(source, sx1, sy1, sx2, sy2, x, y);
+}
+
+void variant_grid::add_grid_region(const variant_grid &source, unsigned sx1, unsigned sy1, unsigned sx2,
+                                   unsigned sy2, unsigned x, unsigned y) {
+  apply_grid_region<kAdd>(source, sx1, sy1, sx2, sy2, x, y);
+}
+
+void variant_grid::multiply_grid_region(const variant_grid &source, unsigned sx1, unsigned sy1, unsigned sx2,
+                                        unsigned sy2, unsigned x, unsigned y) {
+  apply_grid_region<kMultiply>(source, sx1, sy1, sx2, sy2, x, y);
+}
+
+// Queries
+// =============================================================================
+
+// Sums are kept in long double so that differences of large table entries
+// still agree with a direct sum to well within variant::epsilon.
+long double variant_grid::rect_sum(const rect &r) {
+  if (!sat_valid_) {
+    sum_scanned_ += size_t(r.x2 - r.x1) * (r.y2 - r.y1);
+    if (sum_scanned_ < reals_.size()) {
+      double sum = 0;
+      for (int i = r.y1; i < r.y2; ++i) {
+        const double *row = reals_.data() + size_t(i) * w_;
+        for (int ii = r.x1; ii < r.x2; ++ii) sum += row[ii];
+      }
+      return sum;
+    }
+    const size_t stride = w_ + 1;
+    sat_.assign(stride * (h_ + 1), 0);
+    for (unsigned i = 0; i < h_; ++i) {
+      long double run = 0;
+      for (unsigned ii = 0; ii < w_; ++ii) {
+        run += reals_[size_t(i) * w_ + ii];
+        sat_[(i + 1) * stride + ii + 1] = sat_[i * stride + ii + 1] + run;
+      }
+    }
+    sat_valid_ = true;
+  }
+  const size_t stride = w_ + 1;
+  return sat_[r.y2 * stride + r.x2] - sat_[r.y1 * stride + r.x2] - sat_[r.y2 * stride + r.x1]
+       + sat_[r.y1 * stride + r.x1];
+}
+
+// Level k holds the extreme of every 2^k by 2^k square, by its top-left cell.
+// There is a level for every square that fits in the grid.
+template<bool kMax> void variant_grid::build_levels(std::vector<std::vector<double>> *levels) const {
+  levels->clear();
+  const double *prev = reals_.data();
+  unsigned prev_w = w_;
+  for (int k = 1; (1u << k) <= std::min(w_, h_); ++k) {
+    const unsigned half = 1u << (k - 1), lw = w_ - (1u << k) + 1, lh = h_ - (1u << k) + 1;
+    std::vector<double> level(size_t(lw) * lh);
+    for (unsigned i = 0; i < lh; ++i) {
+      const double *top = prev + size_t(i) * prev_w, *bottom = prev + size_t(i + half) * prev_w;
+      double *out = level.data() + size_t(i) * lw;
+      for (unsigned ii = 0; ii < lw; ++ii)
+        out[ii] = extreme<kMax>(extreme<kMax>(top[ii], top[ii + half]), extreme<kMax>(bottom[ii], bottom[ii + half]));
+    }
+    levels->push_back(std::move(level));
+    prev = levels->back().data();
+    prev_w = lw;
+  }
+}
+
+// Covers the rectangle with the largest squares that fit in it; the squares
+// may overlap, which is harmless for min and max. That takes four lookups for
+// a square, and more the longer the rectangle is than it is wide.
+template<bool kMax> double variant_grid::rect_extreme(const rect &r) {
+  std::vector<std::vector<double>> &levels = kMax ? max_levels_ : min_levels_;
+  bool &valid = kMax ? max_valid_ : min_valid_;
+  if (!valid) {
+    range_scanned_ += size_t(r.x2 - r.x1) * (r.y2 - r.y1);
+    if (range_scanned_ >= reals_.size()) {
+      build_levels<kMax>(&levels);
+      valid = true;
+    }
+  }
+
+  const int side = std::min(r.x2 - r.x1, r.y2 - r.y1);
+  int k = 0;
+  if (valid) while (k < int(levels.size()) && (2 << k) <= side) ++k;
+  if (!k) {
+    double best = reals_[size_t(r.y1) * w_ + r.x1];
+    for (int i = r.y1; i < r.y2; ++i) {
+      const double *row = reals_.data() + size_t(i) * w_;
+      for (int ii = r.x1; ii < r.x2; ++ii) best = extreme<kMax>(best, row[ii]);
+    }
+    return best;
+  }
+
+  const int s = 1 << k;
+  const unsigned lw = w_ - s + 1;
+  const double *level = levels[k - 1].data();
+  double best = level[size_t(r.y1) * lw + r.x1];
+  for (int i = r.y1;; i += s) {
+    const int yy = std::min(i, r.y2 - s);
+    for (int ii = r.x1;; ii += s) {
+      const int xx = std::min(ii, r.x2 - s);
+      best = extreme<kMax>(best, level[size_t(yy) * lw + xx]);
+      if (xx == r.x2 - s) break;
+    }
+    if (yy == r.y2 - s) break;
+  }
+  return best;
+}
+
+variant variant_grid::find_region_sum(unsigned x1, unsigned y1, unsigned x2, unsigned y2) {
+  rect r;
+  if (!clip_region(x1, y1, x2, y2, &r)) return variant();
+  settle();
+  if (numeric_) return double(rect_sum(r));
+  double sum = 0;
+  for (int i = r.y1; i < r.y2; ++i)
+    for (int ii = r.x1; ii < r.x2; ++ii)
+      sum += cells_[size_t(i) * w_ + ii].rval.d;
+  return sum;
+}
+
+variant variant_grid::find_region_mean(unsigned x1, unsigned y1, unsigned x2, unsigned y2) {
+  rect r;
+  if (!clip_region(x1, y1, x2, y2, &r)) return variant();
+  const double region_size = double(r.y2 - r.y1) * (r.x2 - r.x1);
+  return double(find_region_sum(x1, y1, x2, y2)) / region_size;
+}
+
+// Mixed grids compare as variants do: fuzzily, with strings above reals.
+template<bool kMax> variant variant_grid::find_region_extreme(unsigned x1, unsigned y1, unsigned x2, unsigned y2) {
+  rect r;
+  if (!clip_region(x1, y1, x2, y2, &r)) return variant();
+  settle();
+  if (numeric_) return rect_extreme<kMax>(r);
+  variant best = cells_[size_t(r.y1) * w_ + r.x1];
+  for (int i = r.y1; i < r.y2; ++i)
+    for (int ii = r.x1; ii < r.x2; ++ii) {
+      const variant &cell = cells_[size_t(i) * w_ + ii];
+      if (kMax ? cell > best : cell < best) best = cell;
+    }
+  return best;
+}
+
+variant variant_grid::find_region_max(unsigned x1, unsigned y1, unsigned x2, unsigned y2) {
+  return find_region_extreme<true>(x1, y1, x2, y2);
+}
+
+variant variant_grid::find_region_min(unsigned x1, unsigned y1, unsigned x2, unsigned y2) {
+  return find_region_extreme<false>(x1, y1, x2, y2);
+}
+
+variant variant_grid::find_disk_sum(double x, double y, double r) {
+  rect box;
+  if (!clip_disk(x, y, r, &box)) return variant();
+  settle();
+  long double sum = 0;
+  for_disk(x, y, r, [&](int i, int a, int b) {
+    if (numeric_) {
+      sum += rect_sum(rect{a, i, b, i + 1});
+    } else {
+      for (int ii = a; ii < b; ++ii) sum += cells_[size_t(i) * w_ + ii].rval.d;
+    }
+  });
+  return double(sum);
+}
+
+variant variant_grid::find_disk_mean(double x, double y, double r) {
+  rect box;
+  if (!clip_disk(x, y, r, &box)) return variant();
+  double region_size = 0;
+  for_disk(x, y, r, [&](int, int a, int b) { region_size += b - a; });
+  return double(find_disk_sum(x, y, r)) / region_size;
+}
+
+// Disk extremes have always compared cells as plain reals.
+template<bool kMax> variant variant_grid::find_disk_extreme(double x, double y, double r) {
+  settle();
+  bool found = false;
+  double best = 0;
+  for_disk(x, y, r, [&](int i, int a, int b) {
+    for (int ii = a; ii < b; ++ii) {
+      const size_t ind = size_t(i) * w_ + ii;
+      const double cell = numeric_ ? reals_[ind] : cells_[ind].rval.d;
+      best = found ? extreme<kMax>(best, cell) : cell;
+      found = true;
+    }
+  });
+  return found ? variant(best) : variant();
+}
+
+variant variant_grid::find_disk_max(double x, double y, double r) {
+  return find_disk_extreme<true>(x, y, r);
+}
+
+variant variant_grid::find_disk_min(double x, double y, double r) {
+  return find_disk_extreme<false>(x, y, r);
+}
+
+bool variant_grid::find_value(const rect &r, const variant &val, int *fx, int *fy) const {
+  if (numeric_ && val.type != variant::ty_real) return false;
+  for (int i = r.y1; i < r.y2; ++i)
+    for (int ii = r.x1; ii < r.x2; ++ii) {
+      const size_t ind = size_t(i) * w_ + ii;
+      const bool match = numeric_ ? reals_[ind] - variant::epsilon <= val.rval.d
+                                    && reals_[ind] + variant::epsilon >= val.rval.d
+                                  : cells_[ind] == val;
+      if (match) {
+        *fx = ii;
+        *fy = i;
+        return true;
+      }
+    }
+  return false;
+}
+
+bool variant_grid::find_disk_value(double x, double y, double r, const variant &val, int *fx, int *fy) {
+  bool found = false;
+  for_disk(x, y, r, [&](int i, int a, int b) {
+    if (!found) found = find_value(rect{a, i, b, i + 1}, val, fx, fy);
+  });
+  return found;
+}
+
+bool variant_grid::value_region_exists(unsigned x1, unsigned y1, unsigned x2, unsigned y2, const variant &val) {
+  rect r;
+  int fx, fy;
+  return clip_region(x1, y1, x2, y2, &r) && find_value(r, val, &fx, &fy);
+}
+
+int variant_grid::value_region_x(unsigned x1, unsigned y1, unsigned x2, unsigned y2, const variant &val) {
+  rect r;
+  int fx, fy;
+  return clip_region(x1, y1, x2, y2, &r) && find_value(r, val, &fx, &fy) ? fx : 0;
+}
+
+int variant_grid::value_region_y(unsigned x1, unsigned y1, unsigned x2, unsigned y2, const variant &val) {
+  rect r;
+  int fx, fy;
+  return clip_region(x1, y1, x2, y2, &r) && find_value(r, val, &fx, &fy) ? fy : 0;
+}
+
+bool variant_grid::value_disk_exists(double x, double y, double r, const variant &val) {
+  int fx, fy;
+  return find_disk_value(x, y, r, val, &fx, &fy);
+}
+
+// The disk lookups have always reported the row as x and the column as y;
+// scripts written against them expect that.
+int variant_grid::value_disk_x(double x, double y, double r, const variant &val) {
+  int fx, fy;
+  return find_disk_value(x, y, r, val, &fx, &fy) ? fy : 0;
+}
+
+int variant_grid::value_disk_y(double x, double y, double r, const variant &val) {
+  int fx, fy;
+  return find_disk_value(x, y, r, val, &fx, &fy) ? fx : 0;
+}
+
+}  // namespace enigma
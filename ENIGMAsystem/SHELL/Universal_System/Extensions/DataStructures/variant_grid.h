@@ -0,0 +1,127 @@
+/** This file is a part of the ENIGMA Development Environment.
+***
+*** ENIGMA is free software: you can redistribute it and/or modify it under the
+*** terms of the GNU General Public License as published by the Free Software
+*** Foundation, version 3 of the license or any later version.
+***
+*** This application and its source code is distributed AS-IS, WITHOUT ANY
+*** WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+*** FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+*** details.
+***
+*** You should have received a copy of the GNU General Public License along
+*** with this code. If not, see <http://www.gnu.org/licenses/>
+**/
+
+#ifndef ENIGMA_DATASTRUCTURES_VARIANT_GRID_H
+#define ENIGMA_DATASTRUCTURES_VARIANT_GRID_H
+
+#include "Universal_System/var4.h"
+
+#include <vector>
+
+namespace enigma {
+
+/// The storage behind ds_grid. While every cell holds a real, the cells are
+/// kept as a packed array of doubles, which the region and disk operations
+/// run over a row at a time; storing anything else switches the grid to an
+/// array of variants until the last non-real cell is overwritten.
+///
+/// Rectangle sums and means are answered from a summed-area table, and
+/// rectangle minima and maxima from a sparse table of power-of-two squares,
+/// which holds one level per square size and so about log2(min(w, h)) times
+/// as many cells as the grid.
+/// Both are built lazily, only once brute-force scans since the last change
+/// have touched more cells than the grid holds, so grids that are written
+/// more often than they are queried never pay for them.
+///
+/// Coordinates follow the old ds_grid rules: rectangles are inclusive and
+/// may be given in either order, and are clipped to the grid.
+class variant_grid {
+ public:
+  variant_grid() {}
+  variant_grid(unsigned w, unsigned h);
+
+  unsigned width() const { return w_; }
+  unsigned height() const { return h_; }
+
+  void clear(const variant &val);
+  void resize(unsigned w, unsigned h);
+  void copy(const variant_grid &source) { *this = source; }
+  void shuffle();
+
+  variant find(unsigned x, unsigned y) const;
+  void insert(unsigned x, unsigned y, const variant &val);
+  void add(unsigned x, unsigned y, const variant &val);
+  void multiply(unsigned x, unsigned y, double val);
+
+  void insert_region(unsigned x1, unsigned y1, unsigned x2, unsigned y2, const variant &val);
+  void add_region(unsigned x1, unsigned y1, unsigned x2, unsigned y2, const variant &val);
+  void multiply_region(unsigned x1, unsigned y1, unsigned x2, unsigned y2, double val);
+  void insert_disk(double x, double y, double r, const variant &val);
+  void add_disk(double x, double y, double r, const variant &val);
+  void multiply_disk(double x, double y, double r, double val);
+  void insert_grid_region(const variant_grid &source, unsigned sx1, unsigned sy1, unsigned sx2, unsigned sy2,
+                          unsigned x, unsigned y);
+  void add_grid_region(const variant_grid &source, unsigned sx1, unsigned sy1, unsigned sx2, unsigned sy2,
+                       unsigned x, unsigned y);
+  void multiply_grid_region(const variant_grid &source, unsigned sx1, unsigned sy1, unsigned sx2, unsigned sy2,
+                            unsigned x, unsigned y);
+
+  variant find_region_sum(unsigned x1, unsigned y1, unsigned x2, unsigned y2);
+  variant find_region_max(unsigned x1, unsigned y1, unsigned x2, unsigned y2);
+  variant find_region_min(unsigned x1, unsigned y1, unsigned x2, unsigned y2);
+  variant find_region_mean(unsigned x1, unsigned y1, unsigned x2, unsigned y2);
+  variant find_disk_sum(double x, double y, double r);
+  variant find_disk_max(double x, double y, double r);
+  variant find_disk_min(double x, double y, double r);
+  variant find_disk_mean(double x, double y, double r);
+
+  bool value_region_exists(unsigned x1, unsigned y1, unsigned x2, unsigned y2, const variant &val);
+  int value_region_x(unsigned x1, unsigned y1, unsigned x2, unsigned y2, const variant &val);
+  int value_region_y(unsigned x1, unsigned y1, unsigned x2, unsigned y2, const variant &val);
+  bool value_disk_exists(double x, double y, double r, const variant &val);
+  int value_disk_x(double x, double y, double r, const variant &val);
+  int value_disk_y(double x, double y, double r, const variant &val);
+
+ private:
+  /// Half-open cell bounds, already clipped to the grid.
+  struct rect { int x1, y1, x2, y2; };
+
+  unsigned w_ = 0, h_ = 0;
+  bool numeric_ = true;
+  std::vector<double> reals_;     ///< Cells while the grid is numeric.
+  std::vector<variant> cells_;    ///< Cells otherwise.
+  size_t nonreal_ = 0;            ///< Cells in cells_ that are not reals.
+
+  // Lazily built query tables; see the class comment.
+  size_t sum_scanned_ = 0, range_scanned_ = 0;
+  bool sat_valid_ = false, min_valid_ = false, max_valid_ = false;
+  std::vector<long double> sat_;
+  std::vector<std::vector<double>> min_levels_, max_levels_;
+
+  bool clip_region(unsigned x1, unsigned y1, unsigned x2, unsigned y2, rect *r) const;
+  bool clip_disk(double x, double y, double r, rect *box) const;
+  bool disk_span(double x, double y, double rr, int row, const rect &box, int *x1, int *x2) const;
+  template<typename F> void for_disk(double x, double y, double r, F span);
+
+  void changed();
+  void to_variants();
+  void settle();
+  void store(size_t ind, const variant &val);
+
+  bool find_value(const rect &r, const variant &val, int *fx, int *fy) const;
+  bool find_disk_value(double x, double y, double r, const variant &val, int *fx, int *fy);
+  template<bool kMax> variant find_region_extreme(unsigned x1, unsigned y1, unsigned x2, unsigned y2);
+  template<bool kMax> variant find_disk_extreme(double x, double y, double r);
+  template<int kOp> void apply_grid_region(const variant_grid &source, unsigned sx1, unsigned sy1, unsigned sx2,
+                                           unsigned sy2, unsigned x, unsigned y);
+
+  long double rect_sum(const rect &r);
+  template<bool kMax> double rect_extreme(const rect &r);
+  template<bool kMax> void build_levels(std::vector<std::vector<double>> *levels) const;
+};
+
+}  // namespace enigma
+
+#endif  // ENIGMA_DATASTRUCTURES_VARIANT_GRID_H
@@ -0,0 +1,251 @@
+/** This file is a part of the ENIGMA Development Environment.
+***
+*** ENIGMA is free software: you can redistribute it and/or modify it under the
+*** terms of the GNU General Public License as published by the Free Software
+*** Foundation, version 3 of the license or any later version.
+***
+*** This application and its source code is distributed AS-IS, WITHOUT ANY
+*** WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+*** FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+*** details.
+***
+*** You should have received a copy of the GNU General Public License along
+*** with this code. If not, see <http://www.gnu.org/licenses/>
+**/
+
+#ifndef ENIGMA_DATASTRUCTURES_VARIANT_MAP_H
+#define ENIGMA_DATASTRUCTURES_VARIANT_MAP_H
+
+#include "Universal_System/var4.h"
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace enigma {
+
+/// The storage behind ds_map: a multimap from variant to variant that keeps
+/// its entries in insertion order and indexes them with an open-addressing
+/// (linear probing) hash table.
+///
+/// Keys compare exactly as variant::operator== does, so real keys within
+/// variant::epsilon of each other are the same key. To keep that consistent
+/// with hashing, reals hash by the integer they round to; a lookup whose
+/// epsilon window straddles a rounding boundary probes both candidates.
+///
+/// Entries with equal keys are found in the order they were added, so a
+/// lookup returns the first one, as the ordered multimap used to. Walking the
+/// keys rather than the entries visits each key once, at its first entry.
+class variant_map {
+ public:
+  static const size_t npos = size_t(-1);
+
+  struct entry {
+    variant key, value;
+    uint32_t hash;
+    bool live;
+  };
+
+  variant_map() {}
+
+  size_t size() const { return live_; }
+  bool empty() const { return !live_; }
+
+  void clear() {
+    entries_.clear();
+    slots_.clear();
+    live_ = 0;
+  }
+
+  const variant &key(size_t ind) const { return entries_[ind].key; }
+  const variant &value(size_t ind) const { return entries_[ind].value; }
+  variant &value(size_t ind) { return entries_[ind].value; }
+
+  /// Appends a new entry, even if an equal key is already present.
+  void add(const variant &key, const variant &value) {
+    if ((live_ + 1) * 2 > slots_.size()) rehash(slots_.empty() ? 16 : slots_.size() * 2);
+    const uint32_t hash = hash_of(key);
+    entries_.push_back(entry{key, value, hash, true});
+    place(uint32_t(entries_.size() - 1), hash);
+    ++live_;
+  }
+
+  /// Returns the index of the oldest entry with the given key, or npos.
+  size_t find(const variant &key) const {
+    if (!live_) return npos;
+    uint32_t lo, hi;
+    if (!candidate_hashes(key, &lo, &hi)) return entry_at(probe(key, lo));
+    // Equal keys share a hash, so each candidate's first match is the oldest
+    // entry for that hash; take whichever of the two was added first.
+    const size_t a = entry_at(probe(key, lo)), b = entry_at(probe(key, hi));
+    return a < b ? a : b;
+  }
+
+  /// Removes the entry at the given index.
+  void erase(size_t ind) {
+    kill(ind);
+    shrink();
+  }
+
+  /// Removes every entry from index first up to, but not including, last.
+  void erase(size_t first, size_t last) {
+    for (size_t i = first; i < last; ++i) if (entries_[i].live) kill(i);
+    shrink();
+  }
+
+  /// Iteration in insertion order; each returns npos once out of entries.
+  size_t first() const { return next_live(0); }
+  size_t last() const { return prev_live(entries_.size()); }
+  size_t next(size_t ind) const { return ind == npos ? npos : next_live(ind + 1); }
+  size_t prev(size_t ind) const { return ind == npos ? npos : prev_live(ind); }
+
+  /// Iteration over distinct keys, in the order each was first added: these
+  /// only stop at an entry that is the oldest one with its key, so a walk
+  /// visits every key once however its duplicates are interleaved.
+  size_t first_key() const { return next_key_from(first()); }
+  size_t last_key() const { return prev_key_from(last()); }
+  size_t next_key(size_t ind) const { return next_key_from(next(ind)); }
+  size_t prev_key(size_t ind) const { return prev_key_from(prev(ind)); }
+
+ private:
+  static const uint32_t kEmpty = uint32_t(-1);
+
+  struct slot {
+    uint32_t index;  ///< Position in entries_, or kEmpty.
+    uint32_t hash;   ///< Copy of the entry's hash, to skip most key compares.
+  };
+
+  std::vector<entry> entries_;
+  std::vector<slot> slots_;
+  size_t live_ = 0;
+
+  static uint32_t mix(uint64_t x) {
+    x ^= x >> 30; x *= 0xBF58476D1CE4E5B9ULL;
+    x ^= x >> 27; x *= 0x94D049BB133111EBULL;
+    x ^= x >> 31;
+    return uint32_t(x ^ (x >> 32));
+  }
+
+  static uint32_t hash_real(int type, double d) {
+    uint64_t bits;
+    if (std::fabs(d) < 4503599627370496.0) {  // 2^52; past that, no two doubles are within epsilon.
+      bits = uint64_t(std::llround(d));
+    } else {
+      std::memcpy(&bits, &d, sizeof bits);
+    }
+    return mix(bits + uint64_t(type + 1) * 0x9E3779B97F4A7C15ULL);
+  }
+
+  static uint32_t hash_of(const variant &key) {
+    if (key.type == variant::ty_string)
+      return mix(std::hash<std::string>()(key.sval()) ^ 0x9E3779B97F4A7C15ULL);
+    return hash_real(key.type, key.rval.d);
+  }
+
+  /// Yields the hashes any key equal to this one could have been stored
+  /// under; returns whether there are two of them.
+  static bool candidate_hashes(const variant &key, uint32_t *lo, uint32_t *hi) {
+    if (key.type == variant::ty_string) {
+      *lo = *hi = hash_of(key);
+      return false;
+    }
+    *lo = hash_real(key.type, key.rval.d - variant::epsilon);
+    *hi = hash_real(key.type, key.rval.d + variant::epsilon);
+    return *lo != *hi;
+  }
+
+  size_t entry_at(size_t pos) const { return pos == npos ? npos : slots_[pos].index; }
+
+  size_t probe(const variant &key, uint32_t hash) const {
+    const size_t mask = slots_.size() - 1;
+    for (size_t pos = hash & mask; slots_[pos].index != kEmpty; pos = (pos + 1) & mask) {
+      if (slots_[pos].hash == hash && entries_[slots_[pos].index].key == key) return pos;
+    }
+    return npos;
+  }
+
+  // New entries go in the first free slot of their cluster, which is after
+  // every older entry with the same home slot; that is what keeps probing in
+  // insertion order for equal keys.
+  void place(uint32_t ind, uint32_t hash) {
+    const size_t mask = slots_.size() - 1;
+    size_t pos = hash & mask;
+    while (slots_[pos].index != kEmpty) pos = (pos + 1) & mask;
+    slots_[pos] = slot{ind, hash};
+  }
+
+  // Backward-shift deletion: no tombstones, and entries sharing a home slot
+  // keep their relative order.
+  void unplace(size_t hole) {
+    const size_t mask = slots_.size() - 1;
+    for (size_t pos = (hole + 1) & mask; slots_[pos].index != kEmpty; pos = (pos + 1) & mask) {
+      const size_t home = slots_[pos].hash & mask;
+      if (((pos - home) & mask) >= ((pos - hole) & mask)) {
+        slots_[hole] = slots_[pos];
+        hole = pos;
+      }
+    }
+    slots_[hole].index = kEmpty;
+  }
+
+  void rehash(size_t capacity) {
+    slots_.assign(capacity, slot{kEmpty, 0});
+    for (size_t i = 0; i < entries_.size(); ++i)
+      if (entries_[i].live) place(uint32_t(i), entries_[i].hash);
+  }
+
+  void compact() {
+    size_t out = 0;
+    for (size_t i = 0; i < entries_.size(); ++i)
+      if (entries_[i].live) {
+        if (out != i) entries_[out] = std::move(entries_[i]);
+        ++out;
+      }
+    entries_.resize(out);
+    rehash(slots_.size());
+  }
+
+  void kill(size_t ind) {
+    entry &e = entries_[ind];
+    const size_t mask = slots_.size() - 1;
+    size_t pos = e.hash & mask;
+    while (slots_[pos].index != ind) pos = (pos + 1) & mask;
+    unplace(pos);
+    e.live = false;
+    e.key = variant();
+    e.value = variant();
+    --live_;
+  }
+
+  // Dead entries only cost iteration time; drop them once they dominate.
+  void shrink() {
+    const size_t dead = entries_.size() - live_;
+    if (dead >= 16 && dead > live_) compact();
+  }
+
+  bool oldest(size_t ind) const { return find(entries_[ind].key) == ind; }
+  size_t next_key_from(size_t ind) const {
+    while (ind != npos && !oldest(ind)) ind = next(ind);
+    return ind;
+  }
+  size_t prev_key_from(size_t ind) const {
+    while (ind != npos && !oldest(ind)) ind = prev(ind);
+    return ind;
+  }
+
+  size_t next_live(size_t ind) const {
+    for (; ind < entries_.size(); ++ind) if (entries_[ind].live) return ind;
+    return npos;
+  }
+  size_t prev_live(size_t ind) const {
+    while (ind--) if (entries_[ind].live) return ind;
+    return npos;
+  }
+};
+
+}  // namespace enigma
+
+#endif  // ENIGMA_DATASTRUCTURES_VARIANT_MAP_H
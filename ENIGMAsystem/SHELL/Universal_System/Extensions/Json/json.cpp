@@ -22,172 +22,334 @@
 **/
 
 #include "Widget_Systems/widgets_mandatory.h"
+#include "Universal_System/buffers_internal.h"
 #include "json.h"
-#include <cstdio>
-#include <iostream>
-#include <sstream>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
 #include "../DataStructures/include.h"
-#include "libjson.h"
 
 using std::string;
 
-namespace enigma_user
+namespace {
+
+// Reads JSON text in a single pass, creating each ds_map and ds_list as its
+// opening bracket is reached and filling it as its members are parsed, so no
+// document tree is ever built. Comments are skipped, as the old jsoncpp
+// reader did; a repeated key keeps its last value.
+class JsonDecoder
 {
-	int RecursiveDSList(Json::Value value);
+	public:
+		JsonDecoder(const char *begin, const char *end): begin_(begin), pos_(begin), end_(end) {}
+
+		// Returns the id of the root map or list, or -1 after reporting an error.
+		variant decode();
+
+		// How much of the text the root value took up.
+		size_t consumed() const { return pos_ - begin_; }
+
+	private:
+		struct Open { uint64_t id; bool object; variant key; };
 
-	int RecursiveDSMap(Json::Value root)
+		const char *begin_, *pos_, *end_;
+		std::vector<Open> open_;                      // Containers being filled, innermost last.
+		std::vector<std::pair<uint64_t, bool> > made_; // Every container created, in case we fail.
+
+		bool at(char c) const { return pos_ != end_ && *pos_ == c; }
+		bool fail(const char *what);
+		void skip_space();
+		bool read_key();
+		bool read_scalar(variant *value);
+		bool read_string(string *str);
+		bool read_hex4(unsigned *code);
+		bool read_number(variant *value);
+		bool read_word(const char *word, double as, variant *value);
+};
+
+bool JsonDecoder::fail(const char *what)
+{
+	const int line = 1 + std::count(begin_, pos_, '\n');
+	DEBUG_MESSAGE("Failed to parse JSON: " + string(what) + " at line " + std::to_string(line), MESSAGE_TYPE::M_ERROR);
+	for (const auto &made : made_)
 	{
-		int jsonObject=ds_map_create();
+		if (made.second) enigma_user::ds_map_destroy(made.first);
+		else enigma_user::ds_list_destroy(made.first);
+	}
+	made_.clear();
+	return false;
+}
 
-		Json::Value::Members m=root.getMemberNames();
-		for (Json::Value::Members::iterator it = m.begin() ; it != m.end(); ++it)
+void JsonDecoder::skip_space()
+{
+	while (pos_ != end_)
+	{
+		if (*pos_ == ' ' || *pos_ == '\t' || *pos_ == '\n' || *pos_ == '\r')
+			++pos_;
+		else if (*pos_ == '/' && end_ - pos_ > 1 && pos_[1] == '/')
+			while (pos_ != end_ && *pos_ != '\n') ++pos_;
+		else if (*pos_ == '/' && end_ - pos_ > 1 && pos_[1] == '*')
 		{
-			if (root[*it].isNull())
-			{
-				ds_map_add(jsonObject,*it,0);
-			}
-			else if (root[*it].isBool())
-			{
-				ds_map_add(jsonObject,*it,root[*it].asInt());
-			}
-			else if (root[*it].isInt())
-			{
-				ds_map_add(jsonObject,*it,root[*it].asInt());
-			}
-			else if (root[*it].isUInt())
-			{
-				ds_map_add(jsonObject,*it,root[*it].asUInt());
-			}
-			else if (root[*it].isIntegral())
-			{
-				ds_map_add(jsonObject,*it,root[*it].asInt());
-			}
-			else if (root[*it].isDouble())
-			{
-				ds_map_add(jsonObject,*it,root[*it].asDouble());
-			}
-			else if (root[*it].isNumeric())
-			{
-				ds_map_add(jsonObject,*it,root[*it].asDouble());
-			}
-			else if (root[*it].isString())
-			{
-				ds_map_add(jsonObject,*it,root[*it].asString());
-			}
-			else if (root[*it].isArray())
+			const char *close = std::search(pos_ + 2, end_, "*/", "*/" + 2);
+			pos_ = close == end_ ? end_ : close + 2;
+		}
+		else
+			return;
+	}
+}
+
+variant JsonDecoder::decode()
+{
+	skip_space();
+	if (pos_ == end_)
+	{
+		fail("no value");
+		return -1;
+	}
+	if (*pos_ != '{' && *pos_ != '[')
+	{
+		DEBUG_MESSAGE("Invalid JSON. The root is not as array of objects or an object.", MESSAGE_TYPE::M_ERROR);
+		return -1;
+	}
+
+	for (;;)
+	{
+		variant value;
+		skip_space();
+		if (at('{') || at('['))
+		{
+			const bool object = *pos_++ == '{';
+			const uint64_t id = object ? enigma_user::ds_map_create() : enigma_user::ds_list_create();
+			made_.push_back(std::make_pair(id, object));
+			open_.push_back(Open{id, object, variant()});
+			skip_space();
+			if (!at(object ? '}' : ']'))
 			{
-				int dsmap=RecursiveDSList(root[*it]);
-				if (dsmap==-1)
-				{
-					return -1;
-				}
-				ds_map_add(jsonObject,*it,dsmap);
+				if (object && !read_key()) return -1;
+				continue;
 			}
-			else if (root[*it].isObject())
+			++pos_;
+			open_.pop_back();
+			value = id;
+		}
+		else if (!read_scalar(&value))
+		{
+			return -1;
+		}
+
+		// Store the value, then close every container that ends right after it.
+		for (;;)
+		{
+			if (open_.empty()) return value;
+			Open &top = open_.back();
+			if (top.object)
+				enigma_user::ds_map_overwrite(top.id, top.key, value);
+			else
+				enigma_user::ds_list_add(top.id, (enigma::varargs(), value));
+
+			skip_space();
+			if (at(','))
 			{
-				int dsmap=RecursiveDSMap(root[*it]);
-				if (dsmap==-1)
-				{
-					return -1;
-				}
-				ds_map_add(jsonObject,*it,dsmap);
+				++pos_;
+				if (top.object && !read_key()) return -1;
+				break;
 			}
-			else
+			if (!at(top.object ? '}' : ']'))
 			{
+				fail(top.object ? "expected ',' or '}'" : "expected ',' or ']'");
 				return -1;
 			}
+			++pos_;
+			value = top.id;
+			open_.pop_back();
+		}
+	}
+}
+
+bool JsonDecoder::read_key()
+{
+	skip_space();
+	string key;
+	if (!at('"')) return fail("expected a member name");
+	if (!read_string(&key)) return false;
+	skip_space();
+	if (!at(':')) return fail("expected ':'");
+	++pos_;
+	open_.back().key = std::move(key);
+	return true;
+}
+
+bool JsonDecoder::read_scalar(variant *value)
+{
+	if (pos_ == end_) return fail("unexpected end of text");
+	switch (*pos_)
+	{
+		case '"':
+		{
+			string str;
+			if (!read_string(&str)) return false;
+			*value = std::move(str);
+			return true;
 		}
-		return jsonObject;
+		case 't': return read_word("true", 1, value);
+		case 'f': return read_word("false", 0, value);
+		case 'n': return read_word("null", 0, value);
+		default:
+			if (*pos_ == '-' || (*pos_ >= '0' && *pos_ <= '9')) return read_number(value);
+			return fail("unexpected character");
+	}
+}
+
+bool JsonDecoder::read_word(const char *word, double as, variant *value)
+{
+	const size_t len = strlen(word);
+	if (size_t(end_ - pos_) < len || strncmp(pos_, word, len)) return fail("unexpected character");
+	pos_ += len;
+	*value = as;
+	return true;
+}
+
+bool JsonDecoder::read_number(variant *value)
+{
+	const char *start = pos_;
+	while (pos_ != end_ && (strchr("+-.eE", *pos_) || (*pos_ >= '0' && *pos_ <= '9'))) ++pos_;
+	// strtod needs a terminator, which text in a buffer may not have.
+	char digits[64];
+	const size_t len = pos_ - start;
+	if (len >= sizeof digits) return fail("number is too long");
+	memcpy(digits, start, len);
+	digits[len] = 0;
+	char *parsed;
+	const double d = strtod(digits, &parsed);
+	if (parsed != digits + len) return fail("malformed number");
+	*value = d;
+	return true;
+}
+
+bool JsonDecoder::read_hex4(unsigned *code)
+{
+	if (end_ - pos_ < 4) return fail("bad unicode escape");
+	*code = 0;
+	for (int i = 0; i < 4; ++i, ++pos_)
+	{
+		const char c = *pos_;
+		*code <<= 4;
+		if (c >= '0' && c <= '9') *code |= c - '0';
+		else if (c >= 'a' && c <= 'f') *code |= c - 'a' + 10;
+		else if (c >= 'A' && c <= 'F') *code |= c - 'A' + 10;
+		else return fail("bad unicode escape");
 	}
-	
-	int RecursiveDSList(Json::Value root)
+	return true;
+}
+
+bool JsonDecoder::read_string(string *str)
+{
+	++pos_;  // Opening quote.
+	for (;;)
 	{
-		int jsonArray=ds_list_create();
+		const char *run = pos_;
+		while (pos_ != end_ && *pos_ != '"' && *pos_ != '\\') ++pos_;
+		str->append(run, pos_);
+		if (pos_ == end_) return fail("unterminated string");
+		if (*pos_++ == '"') return true;
 
-		for (int i=0; i<root.size(); ++i)
+		if (pos_ == end_) return fail("unterminated string");
+		const char c = *pos_++;
+		switch (c)
 		{
-			if (root[i].isNull())
-			{
-				ds_list_add(jsonArray,(enigma::varargs(), 0));
-			}
-			else if (root[i].isBool())
-			{
-				ds_list_add(jsonArray,(enigma::varargs(), root[i].asInt()));
-			}
-			else if (root[i].isInt())
-			{
-				ds_list_add(jsonArray,(enigma::varargs(), root[i].asInt()));
-			}
-			else if (root[i].isUInt())
+			case '"': case '\\': case '/': *str += c; break;
+			case 'b': *str += '\b'; break;
+			case 'f': *str += '\f'; break;
+			case 'n': *str += '\n'; break;
+			case 'r': *str += '\r'; break;
+			case 't': *str += '\t'; break;
+			case 'u':
 			{
-				ds_list_add(jsonArray,(enigma::varargs(), root[i].asUInt()));
-			}
-			else if (root[i].isIntegral())
-			{
-				ds_list_add(jsonArray,(enigma::varargs(), root[i].asInt()));
-			}
-			else if (root[i].isDouble())
-			{
-				ds_list_add(jsonArray,(enigma::varargs(), root[i].asDouble()));
-			}
-			else if (root[i].isNumeric())
-			{
-				ds_list_add(jsonArray,(enigma::varargs(), root[i].asDouble()));
-			}
-			else if (root[i].isString())
-			{
-				ds_list_add(jsonArray,(enigma::varargs(), root[i].asString()));
-			}
-			else if (root[i].isArray())
-			{
-				int dsmap=RecursiveDSList(root[i]);
-				if (dsmap==-1)
+				unsigned code;
+				if (!read_hex4(&code)) return false;
+				if (code >= 0xD800 && code < 0xDC00)
 				{
-					return -1;
+					unsigned low;
+					if (end_ - pos_ < 2 || pos_[0] != '\\' || pos_[1] != 'u') return fail("bad surrogate pair");
+					pos_ += 2;
+					if (!read_hex4(&low)) return false;
+					if (low < 0xDC00 || low >= 0xE000) return fail("bad surrogate pair");
+					code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
 				}
-				ds_list_add(jsonArray,(enigma::varargs(), dsmap));
-			}
-			else if (root[i].isObject())
-			{
-				int dsmap=RecursiveDSMap(root[i]);
-				if (dsmap==-1)
+				if (code < 0x80) *str += char(code);
+				else if (code < 0x800)
 				{
-					return -1;
+					*str += char(0xC0 | (code >> 6));
+					*str += char(0x80 | (code & 0x3F));
 				}
-				ds_list_add(jsonArray,(enigma::varargs(), dsmap));
-			}
-			else
-			{
-				return -1;
+				else if (code < 0x10000)
+				{
+					*str += char(0xE0 | (code >> 12));
+					*str += char(0x80 | ((code >> 6) & 0x3F));
+					*str += char(0x80 | (code & 0x3F));
+				}
+				else
+				{
+					*str += char(0xF0 | (code >> 18));
+					*str += char(0x80 | ((code >> 12) & 0x3F));
+					*str += char(0x80 | ((code >> 6) & 0x3F));
+					*str += char(0x80 | (code & 0x3F));
+				}
+				break;
 			}
+			default: return fail("bad escape sequence");
 		}
-		return jsonArray;
 	}
-	
-	variant json_decode(string data)
+}
+
+void append_json_string(string *out, const string &str)
+{
+	static const char hex[] = "0123456789abcdef";
+	*out += '"';
+	for (const char c : str)
 	{
-		Json::Value root;
-		Json::Reader reader;
-		bool parsingSuccessful = reader.parse( string(data), root );
-		if ( !parsingSuccessful )
+		switch (c)
 		{
-			DEBUG_MESSAGE("Failed to parse configuration" + reader.getFormattedErrorMessages(), MESSAGE_TYPE::M_ERROR);
-			return -1;
+			case '"':  *out += "\\\""; break;
+			case '\\': *out += "\\\\"; break;
+			case '\n': *out += "\\n"; break;
+			case '\r': *out += "\\r"; break;
+			case '\t': *out += "\\t"; break;
+			case '\b': *out += "\\b"; break;
+			case '\f': *out += "\\f"; break;
+			default:
+				if ((unsigned char) c < 0x20)
+				{
+					*out += "\\u00";
+					*out += hex[c >> 4];
+					*out += hex[c & 15];
+				}
+				else
+					*out += c;
 		}
+	}
+	*out += '"';
+}
 
-		if (root.isObject())
-		{
-			return RecursiveDSMap(root);
-		}
-		else if (root.isArray())
-		{
-			return RecursiveDSList(root);
-		}
-		else
-		{
-			DEBUG_MESSAGE("Invalid JSON. The root is not as array of objects or an object.", MESSAGE_TYPE::M_ERROR);
-			return -1;
-		}
+}  // namespace
+
+namespace enigma_user
+{
+	variant json_decode(string data)
+	{
+		return JsonDecoder(data.data(), data.data() + data.length()).decode();
+	}
+
+	variant json_decode_buffer(int buffer)
+	{
+		get_bufferr(binbuff, buffer, -1);
+		// Text written with buffer_string ends in a zero; buffer_text has none.
+		const char *text = (const char*) binbuff->data.data() + std::min<size_t>(binbuff->position, binbuff->GetSize());
+		const char *end = (const char*) binbuff->data.data() + binbuff->GetSize();
+		JsonDecoder decoder(text, std::find(text, end, '\0'));
+		const variant root = decoder.decode();
+		if (root != -1) binbuff->Seek(binbuff->position + decoder.consumed());
+		return root;
 	}
 
 	/*
@@ -199,30 +361,25 @@ namespace enigma_user
 				return string("{}");
 		}
 
-		std::stringstream encoding_accumulator;
-
-		encoding_accumulator << '{';
-
+		string encoding_accumulator = "{";
+		const unsigned size = enigma_user::ds_map_size(ds_map);
 		variant key{enigma_user::ds_map_find_first(ds_map)};
 
-		for (int i = 0; i < enigma_user::ds_map_size(ds_map); i++) {
-			encoding_accumulator << '\"' << string(key) << '\"' << ':';
-
-			variant value {enigma_user::ds_map_find_value(ds_map, key)};
+		for (unsigned i = 0; i < size; i++) {
+			if (i) encoding_accumulator += ',';
+			append_json_string(&encoding_accumulator, enigma_user::toString(key));
+			encoding_accumulator += ':';
 
+			const variant value{enigma_user::ds_map_find_value(ds_map, key)};
 			if (enigma_user::is_string(value))
-				encoding_accumulator << '\"' << enigma_user::toString(value) << '\"';
-			else 
-				encoding_accumulator << enigma_user::toString(value);
+				append_json_string(&encoding_accumulator, value.sval());
+			else
+				encoding_accumulator += enigma_user::toString(value);
 
 			key = enigma_user::ds_map_find_next(ds_map, key);
-			
-			// Add comma if not last element
-			if (i != enigma_user::ds_map_size(ds_map) - 1) encoding_accumulator << ',';
 		}
 
-		encoding_accumulator << '}';
-
-		return encoding_accumulator.str();
+		encoding_accumulator += '}';
+		return encoding_accumulator;
 	}
 }
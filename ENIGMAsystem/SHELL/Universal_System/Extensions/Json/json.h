@@ -33,6 +33,7 @@
 namespace enigma_user
 {
 	variant json_decode(std::string data);
+	variant json_decode_buffer(int buffer);
 
 	std::string json_encode(variant ds_map);
 }
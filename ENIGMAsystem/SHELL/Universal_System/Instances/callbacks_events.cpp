@@ -58,5 +58,17 @@ namespace enigma {
   void register_callback_clean_up_roomend(callback_t callback) {
     clean_up_roomend_callbacks.push_back(callback);
   }
+
+  // Room start.
+  list<callback_t> room_start_callbacks;
+  void perform_callbacks_room_start() {
+    list<callback_t>::iterator it_end = room_start_callbacks.end();
+    for (list<callback_t>::iterator it = room_start_callbacks.begin(); it != it_end; it++) {
+      (*it)();
+    }
+  }
+  void register_callback_room_start(callback_t callback) {
+    room_start_callbacks.push_back(callback);
+  }
 }
 
@@ -30,6 +30,10 @@ namespace enigma {
   // Clean up room-end.
   void perform_callbacks_clean_up_roomend();
   void register_callback_clean_up_roomend(void (*callback)());
+
+  // Room start, once the room's assets are loaded and before its tiles are.
+  void perform_callbacks_room_start();
+  void register_callback_room_start(void (*callback)());
 }
 
 #endif // ENIGMA_CALLBACKS_EVENTS_H
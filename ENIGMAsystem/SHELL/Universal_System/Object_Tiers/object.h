@@ -73,6 +73,7 @@ namespace enigma
       virtual variant myevent_roomstart();
       virtual variant myevent_roomend();
       virtual variant myevent_destroy();
+      virtual variant myevent_task();
 
       object_basic();
       object_basic(int uid, int uoid);
@@ -37,6 +37,10 @@
 
 namespace enigma {
 
+// Assets may defer expensive setup, such as creating textures from the
+// resource module, until they are first looked up; overload this for them.
+template<typename T> inline void realize_asset(T&) {}
+
 template<typename T, int LEFT> 
 class OffsetVector {
   std::vector<T> data_owner_;
@@ -148,12 +152,14 @@ class AssetArray {
   T& get(int id) {
     static T sentinel;
     CHECK_ID(id,sentinel);
+    realize_asset(assets_[id]);
     return assets_[id];
   }
   
   const T& get(int id) const {
     static T sentinel;
     CHECK_ID(id,sentinel);
+    realize_asset(const_cast<T&>(assets_[id]));
     return assets_[id];
   }
 
@@ -0,0 +1,67 @@
+/** This file is a part of the ENIGMA Development Environment.
+***
+*** ENIGMA is free software: you can redistribute it and/or modify it under the
+*** terms of the GNU General Public License as published by the Free Software
+*** Foundation, version 3 of the license or any later version.
+***
+*** This application and its source code is distributed AS-IS, WITHOUT ANY
+*** WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+*** FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+*** details.
+***
+*** You should have received a copy of the GNU General Public License along
+*** with this code. If not, see <http://www.gnu.org/licenses/>
+**/
+
+#include "asset_groups.h"
+#include "resource_module.h"
+#include "sprites_internal.h"
+#include "backgrounds_internal.h"
+
+#include <vector>
+
+namespace enigma {
+
+void asset_group_prefetch(const roomassets& group) {
+  for (int id : group.sprites) {
+    if (sprites.exists(id)) sprites[id].Stage();
+  }
+  for (int id : group.backgrounds) {
+    if (backgrounds.exists(id)) backgrounds[id].Stage();
+  }
+}
+
+void asset_group_enter(const roomassets& group, bool evict) {
+  if (evict) {
+    std::vector<bool> keep(sprites.size());
+    for (int id : group.sprites) {
+      if (sprites.exists(id)) keep[id] = true;
+    }
+    for (std::pair<int, Sprite&> spr : sprites) {
+      if (!keep[spr.first]) spr.second.Flush();
+    }
+
+    keep.assign(backgrounds.size(), false);
+    for (int id : group.backgrounds) {
+      if (backgrounds.exists(id)) keep[id] = true;
+    }
+    for (std::pair<int, Background&> bkg : backgrounds) {
+      if (!keep[bkg.first]) bkg.second.Flush();
+    }
+  }
+
+  // Anything prefetched is inflated by now, or nearly; upload it before the
+  // room's first frame rather than in the middle of drawing it.
+  for (int id : group.sprites) {
+    if (sprites.exists(id)) sprites[id].Prefetch();
+  }
+  for (int id : group.backgrounds) {
+    if (backgrounds.exists(id)) backgrounds[id].Realize();
+  }
+
+  // What is still prefetched was staged for a room that was never entered;
+  // don't hold its pixels for the rest of the game.
+  module_discard_prefetches();
+}
+
+}  // namespace enigma
@@ -0,0 +1,35 @@
+/** This file is a part of the ENIGMA Development Environment.
+***
+*** ENIGMA is free software: you can redistribute it and/or modify it under the
+*** terms of the GNU General Public License as published by the Free Software
+*** Foundation, version 3 of the license or any later version.
+***
+*** This application and its source code is distributed AS-IS, WITHOUT ANY
+*** WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+*** FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+*** details.
+***
+*** You should have received a copy of the GNU General Public License along
+*** with this code. If not, see <http://www.gnu.org/licenses/>
+**/
+
+#ifndef ENIGMA_ASSET_GROUPS_H
+#define ENIGMA_ASSET_GROUPS_H
+
+#include "Universal_System/roomsystem.h"
+
+namespace enigma {
+
+/// Starts inflating the group's pending sprites and backgrounds on the worker
+/// pool. Cheap to call repeatedly; images already staged are skipped.
+void asset_group_prefetch(const roomassets& group);
+
+/// Uploads the group's sprites and backgrounds, then, if evict is set, frees
+/// the textures of every other sprite and background the module can restore.
+/// Groups only steer residency: anything evicted is decoded again on use.
+/// Images prefetched for any other room are dropped.
+void asset_group_enter(const roomassets& group, bool evict);
+
+}  // namespace enigma
+
+#endif  // ENIGMA_ASSET_GROUPS_H
@@ -17,9 +17,9 @@
 **/
 
 #include "backgrounds_internal.h"
+#include "image_pipeline.h"
 #include "libEGMstd.h"
 #include "resinit.h"
-#include "Universal_System/zlib.h"
 #include "Universal_System/image_formats.h"
 #include "Universal_System/nlpo2.h"
 #include "Graphics_Systems/graphics_mandatory.h"
@@ -28,6 +28,7 @@
 #include "Platforms/General/fileio.h"
 
 #include <cstring>
+#include <vector>
 
 namespace enigma
 {
@@ -52,6 +53,8 @@ namespace enigma
     if (bkgcount == 0) return;
     backgrounds.resize(bkg_highid+1);
 
+    ImagePipeline pipeline;
+
     for (int i = 0; i < bkgcount; i++)
     {
       int unpacked;
@@ -74,29 +77,25 @@ namespace enigma
       unsigned int size;
       if (!fread_wrapper(&size,4,1,exe)){};
       
-      unsigned char* cpixels=new unsigned char[size+1];
-      if (!cpixels)
-      {
-        DEBUG_MESSAGE("Failed to load background: Cannot allocate enough memory " + enigma_user::toString(unpacked), MESSAGE_TYPE::M_ERROR);
-        break;
-      }
-      unsigned int sz2=fread_wrapper(cpixels,1,size,exe);
+      std::vector<unsigned char> cpixels(size);
+      unsigned int sz2=fread_wrapper(cpixels.data(),1,size,exe);
       if (size!=sz2) {
         DEBUG_MESSAGE("Failed to load background: Data is truncated before exe end. Read " + enigma_user::toString(sz2) + " out of expected " + enigma_user::toString(size), MESSAGE_TYPE::M_ERROR);
         return;
       }
-      unsigned char* pixels=new unsigned char[unpacked+1];
-      if (zlib_decompress(cpixels,size,unpacked,pixels) != unpacked)
-      {
-        DEBUG_MESSAGE("Background load error: Background does not match expected size", MESSAGE_TYPE::M_ERROR);
-        continue;
-      }
-      delete[] cpixels;
 
-      unsigned fw, fh;
-      int texID = graphics_create_texture(RawImage(pixels, width, height), false, &fw, &fh);
-      Background bkg(width, height, fw, fh, texID, useAsTileset, tileWidth, tileHeight, hOffset, vOffset, hSep, vSep);
-      backgrounds.assign(bkgid, std::move(bkg));
+      // Inflated on the worker pool; the texture is created on this thread.
+      pipeline.add(std::move(cpixels), unpacked, width, height,
+                   [=](RawImage&& img) {
+        if (!img.pxdata) {
+          DEBUG_MESSAGE("Background load error: Background does not match expected size", MESSAGE_TYPE::M_ERROR);
+          return;
+        }
+        unsigned fw, fh;
+        int texID = graphics_create_texture(img, false, &fw, &fh);
+        Background bkg(width, height, fw, fh, texID, useAsTileset, tileWidth, tileHeight, hOffset, vOffset, hSep, vSep);
+        backgrounds.assign(bkgid, std::move(bkg));
+      });
     }
   }
 } //namespace enigma
@@ -121,6 +121,17 @@ bool background_exists(int back) {
   return backgrounds.exists(back);
 }
 
+int background_prefetch(int back) {
+  if (!backgrounds.exists(back)) return -1;
+  backgrounds.get(back);  // Looking a background up creates its texture
+  return 0;
+}
+
+int background_flush(int back) {
+  if (!backgrounds.exists(back)) return -1;
+  return backgrounds[back].Flush() ? 0 : -1;
+}
+
 // FIXME: free_texture unused
 void background_set_alpha_from_background(int back, int copy_background, bool free_texture) {
   enigma::graphics_replace_texture_alpha_from_texture(backgrounds.get(back).textureID, backgrounds.get(copy_background).textureID);
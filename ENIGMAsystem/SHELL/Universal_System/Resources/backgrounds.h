@@ -15,6 +15,11 @@ int background_get_texture(int backId);
 int background_get_width(int backId);
 int background_get_height(int backId);
 var background_get_uvs(int backId);
+/// Creates the texture of a background still packed in the resource module. Returns 0 on success, -1 otherwise.
+int background_prefetch(int back);
+/// Frees a background's texture until next use, if it can be reloaded from the resource module.
+/// Returns 0 on success, -1 otherwise.
+int background_flush(int back);
 
 // Used for testing
 bool background_textures_equal(int id1, int id2);
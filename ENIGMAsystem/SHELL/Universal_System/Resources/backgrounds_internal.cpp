@@ -1,5 +1,6 @@
 #include "backgrounds_internal.h"
 #include "Graphics_Systems/graphics_mandatory.h"
+#include "Widget_Systems/widgets_mandatory.h"
 
 namespace enigma {
 
@@ -23,6 +24,7 @@ Background::Background(const Background& b, bool duplicateTexture) {
   vOffset = b.vOffset;
   hSep = b.hSep;
   vSep = b.vSep;
+  pending = b.pending;
 }
 
 void Background::FreeTexture() {
@@ -30,4 +32,28 @@ void Background::FreeTexture() {
   textureID = -1;
 }
 
+void Background::Realize() {
+  if (textureID != -1 || !pending) return;
+  unsigned char* pixels = module_inflate(pending);
+  if (!pixels) {
+    DEBUG_MESSAGE("Background load error: Background does not match expected size", MESSAGE_TYPE::M_ERROR);
+    pending = PendingImage();  // Don't retry on every draw
+    return;
+  }
+  unsigned fw, fh;
+  textureID = graphics_create_texture(RawImage(pixels, width, height), false, &fw, &fh);
+  textureBounds = TexRect(0, 0, (gs_scalar)width/fw, (gs_scalar)height/fh);
+}
+
+void Background::Stage() const {
+  if (textureID == -1 && pending) module_prefetch(pending);
+}
+
+bool Background::Flush() {
+  if (!pending) return false;
+  module_discard_prefetch(pending);
+  if (textureID != -1) FreeTexture();
+  return true;
+}
+
 }
@@ -21,6 +21,7 @@
 #define ENIGMA_BACKGROUND_INTERNAL_H
 
 #include "AssetArray.h"
+#include "resource_module.h"
 #include "Universal_System/scalar.h"
 
 #include <string>
@@ -43,6 +44,14 @@ struct Background {
     vSep(vs) {}
   Background(const Background& b, bool duplicateTexture = true);
   void FreeTexture();
+
+  /// Creates the texture from the resource module if it is still pending.
+  void Realize();
+  /// Starts inflating a pending texture in the background; see Sprite::Stage().
+  void Stage() const;
+  /// Frees the texture if it can be recreated from the resource module; it is
+  /// decoded again on next use. Returns false if it could not be flushed.
+  bool Flush();
   
   unsigned width, height;
   int textureID;
@@ -52,6 +61,9 @@ struct Background {
   unsigned tileWidth, tileHeight;
   int hOffset, vOffset;
   int hSep, vSep;
+
+  /// Packed pixels in the resource module; see Realize().
+  PendingImage pending;
   
   // AssArray mandatory
   static const char* getAssetTypeName() { return "Background"; }
@@ -64,6 +76,11 @@ protected:
 
 extern AssetArray<Background> backgrounds;
 
+// Create pending textures the first time a background is looked up.
+inline void realize_asset(Background& b) {
+  if (b.textureID == -1 && b.pending) b.Realize();
+}
+
 } //namespace enigma
 
 
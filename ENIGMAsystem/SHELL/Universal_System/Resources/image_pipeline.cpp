@@ -0,0 +1,87 @@
+/** This file is a part of the ENIGMA Development Environment.
+***
+*** ENIGMA is free software: you can redistribute it and/or modify it under the
+*** terms of the GNU General Public License as published by the Free Software
+*** Foundation, version 3 of the license or any later version.
+***
+*** This application and its source code is distributed AS-IS, WITHOUT ANY
+*** WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+*** FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+*** details.
+***
+*** You should have received a copy of the GNU General Public License along
+*** with this code. If not, see <http://www.gnu.org/licenses/>
+**/
+
+#include "image_pipeline.h"
+#include "Universal_System/zlib.h"
+#include "Universal_System/worker_pool.h"
+
+#include <condition_variable>
+#include <mutex>
+
+namespace enigma {
+
+struct ImagePipeline::Job {
+  std::vector<unsigned char> packed;
+  unsigned unpacked, w, h;
+  Upload upload;
+  unsigned char* pixels = nullptr;
+  bool ready = false;
+};
+
+ImagePipeline::ImagePipeline() {}
+
+ImagePipeline::~ImagePipeline() {
+  flush();
+}
+
+void ImagePipeline::add(std::vector<unsigned char>&& packed, unsigned unpacked, unsigned w, unsigned h,
+                        Upload upload) {
+  std::unique_ptr<Job> job(new Job);
+  job->packed = std::move(packed);
+  job->unpacked = unpacked;
+  job->w = w;
+  job->h = h;
+  job->upload = std::move(upload);
+  jobs_.push_back(std::move(job));
+
+  queued_bytes_ += unpacked;
+  if (queued_bytes_ >= kMaxQueuedBytes) flush();
+}
+
+void ImagePipeline::flush() {
+  if (jobs_.empty()) return;
+
+  std::mutex mutex;
+  std::condition_variable ready;
+  for (std::unique_ptr<Job>& j : jobs_) {
+    Job* job = j.get();
+    worker_submit([job, &mutex, &ready] {
+      unsigned char* pixels = new unsigned char[job->unpacked + 1];
+      if (zlib_decompress(job->packed.data(), job->packed.size(), job->unpacked, pixels) != int(job->unpacked)) {
+        delete[] pixels;
+        pixels = nullptr;
+      }
+      std::vector<unsigned char>().swap(job->packed);
+      std::lock_guard<std::mutex> lock(mutex);
+      job->pixels = pixels;
+      job->ready = true;
+      ready.notify_all();
+    });
+  }
+
+  // Upload in submission order while later images are still inflating.
+  for (std::unique_ptr<Job>& job : jobs_) {
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      ready.wait(lock, [&] { return job->ready; });
+    }
+    job->upload(job->pixels ? RawImage(job->pixels, job->w, job->h) : RawImage());
+  }
+
+  jobs_.clear();
+  queued_bytes_ = 0;
+}
+
+}  // namespace enigma
@@ -0,0 +1,59 @@
+/** This file is a part of the ENIGMA Development Environment.
+***
+*** ENIGMA is free software: you can redistribute it and/or modify it under the
+*** terms of the GNU General Public License as published by the Free Software
+*** Foundation, version 3 of the license or any later version.
+***
+*** This application and its source code is distributed AS-IS, WITHOUT ANY
+*** WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+*** FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+*** details.
+***
+*** You should have received a copy of the GNU General Public License along
+*** with this code. If not, see <http://www.gnu.org/licenses/>
+**/
+
+#ifdef INCLUDED_FROM_SHELLMAIN
+#  error This file includes non-ENIGMA STL headers and should not be included from SHELLmain.
+#endif
+
+#ifndef ENIGMA_IMAGE_PIPELINE_H
+#define ENIGMA_IMAGE_PIPELINE_H
+
+#include "Universal_System/image_formats.h"
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace enigma {
+
+/// Splits loading packed module images into a CPU stage, which inflates them
+/// on the worker pool, and an upload stage, which hands them to a callback on
+/// the calling thread strictly in the order they were added. Textures may
+/// only be created on the main thread, so that is where the callbacks go.
+class ImagePipeline {
+ public:
+  /// Receives the inflated image, or an empty one (null pxdata) on failure.
+  using Upload = std::function<void(RawImage&& img)>;
+
+  ImagePipeline();
+  ~ImagePipeline();
+
+  /// Queues a zlib-packed image; the pipeline drains itself once enough
+  /// unpacked bytes are queued, bounding the memory held at once.
+  void add(std::vector<unsigned char>&& packed, unsigned unpacked, unsigned w, unsigned h, Upload upload);
+  /// Inflates everything queued and runs the upload callbacks in order.
+  void flush();
+
+ private:
+  static const size_t kMaxQueuedBytes = 64 << 20;
+
+  struct Job;
+  std::vector<std::unique_ptr<Job>> jobs_;
+  size_t queued_bytes_ = 0;
+};
+
+}  // namespace enigma
+
+#endif  // ENIGMA_IMAGE_PIPELINE_H
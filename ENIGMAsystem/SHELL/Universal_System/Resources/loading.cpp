@@ -17,6 +17,7 @@
 **/
 
 #include "resinit.h"
+#include "resource_module.h"
 #include "sprites_internal.h"
 #include "backgrounds_internal.h"
 #include "Universal_System/roomsystem.h"
@@ -31,6 +32,7 @@
 #include "Platforms/General/fileio.h"
 
 #include <ctime>
+#include <string>
 
 namespace enigma_user
 {
@@ -72,32 +74,48 @@ namespace enigma
     // Open the exe for resource load
     do { // Allows break
       FILE_t* resfile;
-      if (resource_file_path != std::string("$exe")) {
-        if (!(resfile = fopen_wrapper(resource_file_path,"rb"))) {
-          DEBUG_MESSAGE("Resource load fail: exe unopenable", MESSAGE_TYPE::M_ERROR);
-          break;
-        }
-      } else {
+      std::string respath = resource_file_path;
+      if (respath == "$exe") {
         char exename[4097];
         windowsystem_write_exename(exename);
+        respath = exename;
         if (!(resfile = fopen_wrapper(exename,"rb"))) {
           DEBUG_MESSAGE("No resource data in exe", MESSAGE_TYPE::M_ERROR);
           break;
         }
+      } else if (!(resfile = fopen_wrapper(resource_file_path,"rb"))) {
+        DEBUG_MESSAGE("Resource load fail: exe unopenable", MESSAGE_TYPE::M_ERROR);
+        break;
       }
       int nullhere;
       // Read the magic number so we know we're looking at our own data
       fseek_wrapper(resfile,-8,SEEK_END);
       char str_quad[4];
-      if (!fread_wrapper(str_quad,4,1,resfile) or str_quad[0] != 'r' or str_quad[1] != 'e' or str_quad[2] != 's' or str_quad[3] != '0') {
+      if (!fread_wrapper(str_quad,4,1,resfile) or str_quad[0] != 'r' or str_quad[1] != 'e' or str_quad[2] != 's'
+          or (str_quad[3] != '0' and str_quad[3] != '1')) {
         DEBUG_MESSAGE("No resource data in exe", MESSAGE_TYPE::M_ERROR);
         break;
       }
+      const bool indexed = str_quad[3] == '1';
 
       // Get where our resources are located in the module
       int pos;
       if (!fread_wrapper(&pos,4,1,resfile)) break;
 
+      // Version 1 modules carry an index, which lets us map the module and
+      // defer decoding sprites and backgrounds until they are first used.
+      int index_pos;
+      if (indexed and !fseek_wrapper(resfile,-12,SEEK_END) and fread_wrapper(&index_pos,4,1,resfile)
+          and enigma::module_load_indexed(respath.c_str(), index_pos)) {
+        fseek_wrapper(resfile,enigma::module_section_offset("FNT "),SEEK_SET);
+        enigma::exe_loadfonts(resfile);
+        #ifdef PATH_EXT_SET
+        enigma::exe_loadpaths(resfile);
+        #endif
+        fclose_wrapper(resfile);
+        break;
+      }
+
       // Go to the start of the resource data
       fseek_wrapper(resfile,pos,SEEK_SET);
       if (!fread_wrapper(&nullhere,4,1,resfile)) break;
@@ -0,0 +1,373 @@
+/** This file is a part of the ENIGMA Development Environment.
+***
+*** ENIGMA is free software: you can redistribute it and/or modify it under the
+*** terms of the GNU General Public License as published by the Free Software
+*** Foundation, version 3 of the license or any later version.
+***
+*** This application and its source code is distributed AS-IS, WITHOUT ANY
+*** WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+*** FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+*** details.
+***
+*** You should have received a copy of the GNU General Public License along
+*** with this code. If not, see <http://www.gnu.org/licenses/>
+**/
+
+#include "resource_module.h"
+#include "sprites_internal.h"
+#include "backgrounds_internal.h"
+#include "Universal_System/zlib.h"
+#include "Universal_System/worker_pool.h"
+#include "Audio_Systems/audio_mandatory.h"
+#include "Widget_Systems/widgets_mandatory.h"
+
+#include <condition_variable>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <string>
+#include <tuple>
+#include <vector>
+
+namespace enigma {
+
+namespace {
+
+// Must match ModuleIndex in the compiler.
+const uint32_t kIndexVersion = 1;
+
+struct IndexEntry {
+  char kind[4];
+  int32_t id, subimage;
+  uint64_t offset;
+  uint32_t size, unpacked, hash;
+};
+
+// The module stays mapped for the life of the program; pending assets point into it.
+FileMapping module_mapping;
+std::map<std::tuple<std::string, int, int>, IndexEntry> module_index;
+
+// Images inflated ahead of use by module_prefetch, keyed by packed data.
+struct Prefetched {
+  unsigned char* pixels = nullptr;
+  bool ready = false, corrupt = false, discarded = false;
+};
+std::map<const unsigned char*, Prefetched> prefetched;
+std::mutex prefetch_mutex;
+std::condition_variable prefetch_ready;
+
+// Bounds-checked reader over the mapped module.
+class ModuleCursor {
+ public:
+  explicit ModuleCursor(uint64_t pos): pos_(pos) {}
+
+  template<typename T> bool read(T* out) {
+    if (!fits(sizeof(T))) return false;
+    memcpy(out, module_mapping.data + pos_, sizeof(T));
+    pos_ += sizeof(T);
+    return true;
+  }
+  bool expect(const char* magic) {
+    if (!fits(4) || memcmp(module_mapping.data + pos_, magic, 4)) return false;
+    pos_ += 4;
+    return true;
+  }
+  bool skip(uint64_t count) {
+    if (!fits(count)) return false;
+    pos_ += count;
+    return true;
+  }
+  uint64_t pos() const { return pos_; }
+
+ private:
+  uint64_t pos_;
+  bool fits(uint64_t count) const {
+    return pos_ <= module_mapping.size && count <= module_mapping.size - pos_;
+  }
+};
+
+#ifdef DEBUG_MODE
+uint32_t fnv1a(const unsigned char* data, unsigned size) {
+  uint32_t hash = 2166136261u;
+  for (unsigned i = 0; i < size; ++i) {
+    hash ^= data[i];
+    hash *= 16777619u;
+  }
+  return hash;
+}
+#endif
+
+bool read_index(int64_t index_pos) {
+  ModuleCursor cur(index_pos);
+  uint32_t version, count;
+  if (!cur.expect("TOC ") || !cur.read(&version) || !cur.read(&count)) return false;
+  if (version != kIndexVersion) return false;
+  for (uint32_t i = 0; i < count; ++i) {
+    IndexEntry e;
+    if (!cur.read(&e.kind) || !cur.read(&e.id) || !cur.read(&e.subimage) || !cur.read(&e.offset) ||
+        !cur.read(&e.size) || !cur.read(&e.unpacked) || !cur.read(&e.hash))
+      return false;
+    if (e.offset > module_mapping.size || e.size > module_mapping.size - e.offset) return false;
+    module_index[std::make_tuple(std::string(e.kind, 4), e.id, e.subimage)] = e;
+  }
+  return true;
+}
+
+const IndexEntry* find_entry(const char* kind, int id, int subimage = 0) {
+  auto it = module_index.find(std::make_tuple(std::string(kind, 4), id, subimage));
+  return it == module_index.end() ? nullptr : &it->second;
+}
+
+// Looks up the payload the index records for an asset, checking that it is
+// the one the section walk arrived at.
+bool pending_from_index(const char* kind, int id, int subimage, const ModuleCursor& cur,
+                        PendingImage* out) {
+  const IndexEntry* e = find_entry(kind, id, subimage);
+  if (!e || e->offset != cur.pos()) {
+    DEBUG_MESSAGE("Resource index does not match module contents for " + std::string(kind, 3) + " " +
+                  std::to_string(id), MESSAGE_TYPE::M_ERROR);
+    return false;
+  }
+  out->data = module_mapping.data + e->offset;
+  out->size = e->size;
+  out->unpacked = e->unpacked;
+  out->hash = e->hash;
+  return true;
+}
+
+// Everything the sections describe, held back until all of them have been
+// read so that a bad section leaves no half-loaded assets behind.
+struct MappedAssets {
+  int spr_highid = -1, bkg_highid = -1;
+  std::vector<std::pair<int, Sprite>> sprites;
+  std::vector<std::pair<int, Background>> backgrounds;
+  struct Sound { int id; const unsigned char* data; unsigned size; };
+  std::vector<Sound> sounds;
+};
+
+// These mirror exe_loadsprs, exe_loadsounds and exe_loadbackgrounds, reading
+// headers straight from the mapping and leaving pixel data where it is. They
+// return false if the section is cut short or does not match the index.
+
+bool map_sprites(uint64_t section, MappedAssets* out) {
+  ModuleCursor cur(section);
+  int sprcount, spr_highid;
+  if (!cur.expect("SPR ") || !cur.read(&sprcount) || !cur.read(&spr_highid)) return false;
+  if (sprcount == 0) return true;
+  out->spr_highid = spr_highid;
+
+  for (int i = 0; i < sprcount; i++) {
+    unsigned sprid, width, height, bbt, bbb, bbl, bbr, bbm, shape;
+    int xorig, yorig, subimages;
+    if (!cur.read(&sprid) || !cur.read(&width) || !cur.read(&height) || !cur.read(&xorig) ||
+        !cur.read(&yorig) || !cur.read(&bbt) || !cur.read(&bbb) || !cur.read(&bbl) || !cur.read(&bbr) ||
+        !cur.read(&bbm) || !cur.read(&shape) || !cur.read(&subimages))
+      return false;
+
+    collision_type coll_type;
+    switch (shape) {
+      case ct_precise: coll_type = ct_precise; break;
+      case ct_ellipse: coll_type = ct_ellipse; break;
+      case ct_diamond: coll_type = ct_diamond; break;
+      case ct_circle: coll_type = ct_circle; break;
+      default: coll_type = ct_bbox; break;  //FIXME: ct_polygon once polygons are supported.
+    }
+
+    Sprite spr(width, height, xorig, yorig);
+    spr.SetBBox(bbl, bbt, bbr-bbl, bbb-bbt);
+
+    for (int ii = 0; ii < subimages; ii++) {
+      unsigned unpacked, size;
+      int nullhere;
+      PendingImage img;
+      if (!cur.read(&unpacked) || !cur.read(&size)) return false;
+      if (!pending_from_index("SPR ", sprid, ii, cur, &img) || !cur.skip(size)) return false;
+      if (!cur.read(&nullhere) || nullhere) {
+        DEBUG_MESSAGE("Sprite load error: Null terminator expected", MESSAGE_TYPE::M_ERROR);
+        return false;
+      }
+      spr.AddSubimage(img, coll_type);
+    }
+
+    out->sprites.emplace_back(sprid, std::move(spr));
+  }
+  return true;
+}
+
+bool map_sounds(uint64_t section, MappedAssets* out) {
+  ModuleCursor cur(section);
+  int sndcount, snd_highid;
+  if (!cur.expect("SND ") || !cur.read(&sndcount) || !cur.read(&snd_highid)) return false;
+
+  for (int i = 0; i < sndcount; i++) {
+    int id;
+    unsigned size;
+    if (!cur.read(&id) || !cur.read(&size)) return false;
+    const unsigned char* data = module_mapping.data + cur.pos();
+    if (!cur.skip(size)) return false;
+    out->sounds.push_back({id, data, size});
+  }
+  return true;
+}
+
+bool map_backgrounds(uint64_t section, MappedAssets* out) {
+  ModuleCursor cur(section);
+  int bkgcount, bkg_highid;
+  if (!cur.expect("BKG ") || !cur.read(&bkgcount) || !cur.read(&bkg_highid)) return false;
+  if (bkgcount == 0) return true;
+  out->bkg_highid = bkg_highid;
+
+  for (int i = 0; i < bkgcount; i++) {
+    unsigned bkgid, width, height, transparent, smoothEdges, preload, useAsTileset, tileWidth, tileHeight,
+             hOffset, vOffset, hSep, vSep, size;
+    if (!cur.read(&bkgid) || !cur.read(&width) || !cur.read(&height) || !cur.read(&transparent) ||
+        !cur.read(&smoothEdges) || !cur.read(&preload) || !cur.read(&useAsTileset) || !cur.read(&tileWidth) ||
+        !cur.read(&tileHeight) || !cur.read(&hOffset) || !cur.read(&vOffset) || !cur.read(&hSep) ||
+        !cur.read(&vSep) || !cur.read(&size))
+      return false;
+
+    PendingImage img;
+    if (!pending_from_index("BKG ", bkgid, 0, cur, &img) || !cur.skip(size)) return false;
+
+    Background bkg(width, height, width, height, -1, useAsTileset, tileWidth, tileHeight, hOffset, vOffset, hSep, vSep);
+    bkg.pending = img;
+    out->backgrounds.emplace_back(bkgid, std::move(bkg));
+  }
+  return true;
+}
+
+void register_assets(MappedAssets& mapped) {
+  if (mapped.spr_highid >= 0) sprites.resize(mapped.spr_highid + 1);
+  for (auto& spr : mapped.sprites) sprites.assign(spr.first, std::move(spr.second));
+  for (size_t i = 0; i < mapped.sounds.size(); ++i) {
+    const MappedAssets::Sound& snd = mapped.sounds[i];
+    // Audio systems decode or copy the buffer right away; hand them the
+    // mapped bytes rather than another heap copy.
+    int e = sound_add_from_buffer(snd.id, const_cast<unsigned char*>(snd.data), snd.size);
+    if (e) DEBUG_MESSAGE("Failed to load sound " + std::to_string(i) + " error " + std::to_string(e), MESSAGE_TYPE::M_ERROR);
+  }
+  if (mapped.bkg_highid >= 0) backgrounds.resize(mapped.bkg_highid + 1);
+  for (auto& bkg : mapped.backgrounds) backgrounds.assign(bkg.first, std::move(bkg.second));
+}
+
+// Safe to call from worker threads; reporting is left to the caller.
+unsigned char* inflate(const PendingImage& img, bool* corrupt) {
+  #ifdef DEBUG_MODE
+  if (fnv1a(img.data, img.size) != img.hash) {
+    *corrupt = true;
+    return nullptr;
+  }
+  #endif
+  unsigned char* pixels = new unsigned char[img.unpacked + 1];
+  if (zlib_decompress(const_cast<unsigned char*>(img.data), img.size, img.unpacked, pixels) != int(img.unpacked)) {
+    delete[] pixels;
+    return nullptr;
+  }
+  return pixels;
+}
+
+}  // namespace
+
+unsigned char* module_inflate(const PendingImage& img) {
+  bool corrupt = false;
+  unsigned char* pixels = nullptr;
+  std::unique_lock<std::mutex> lock(prefetch_mutex);
+  auto it = prefetched.find(img.data);
+  if (it != prefetched.end() && !it->second.discarded) {
+    prefetch_ready.wait(lock, [&] { return it->second.ready; });
+    pixels = it->second.pixels;
+    corrupt = it->second.corrupt;
+    prefetched.erase(it);
+    lock.unlock();
+  } else {
+    lock.unlock();
+    pixels = inflate(img, &corrupt);
+  }
+  if (corrupt) DEBUG_MESSAGE("Resource module data is corrupt", MESSAGE_TYPE::M_ERROR);
+  return pixels;
+}
+
+void module_prefetch(const PendingImage& img) {
+  {
+    std::lock_guard<std::mutex> lock(prefetch_mutex);
+    auto it = prefetched.find(img.data);
+    if (it != prefetched.end()) {
+      it->second.discarded = false;
+      return;
+    }
+    prefetched[img.data];
+  }
+  worker_submit([img] {
+    bool corrupt = false;
+    unsigned char* pixels = inflate(img, &corrupt);
+    std::lock_guard<std::mutex> lock(prefetch_mutex);
+    auto it = prefetched.find(img.data);
+    if (it->second.discarded) {
+      delete[] pixels;
+      prefetched.erase(it);
+      return;
+    }
+    it->second.pixels = pixels;
+    it->second.corrupt = corrupt;
+    it->second.ready = true;
+    prefetch_ready.notify_all();
+  });
+}
+
+void module_discard_prefetch(const PendingImage& img) {
+  std::lock_guard<std::mutex> lock(prefetch_mutex);
+  auto it = prefetched.find(img.data);
+  if (it == prefetched.end()) return;
+  if (!it->second.ready) {
+    it->second.discarded = true;  // The worker frees it when done.
+    return;
+  }
+  delete[] it->second.pixels;
+  prefetched.erase(it);
+}
+
+void module_discard_prefetches() {
+  std::lock_guard<std::mutex> lock(prefetch_mutex);
+  for (auto it = prefetched.begin(); it != prefetched.end();) {
+    if (!it->second.ready) {
+      it->second.discarded = true;
+      ++it;
+      continue;
+    }
+    delete[] it->second.pixels;
+    it = prefetched.erase(it);
+  }
+}
+
+bool module_load_indexed(const char* path, int64_t index_pos) {
+  if (!fmap_wrapper(path, &module_mapping)) return false;
+  if (!read_index(index_pos)) {
+    DEBUG_MESSAGE("Resource index unreadable; loading resources sequentially", MESSAGE_TYPE::M_WARNING);
+    module_index.clear();
+    funmap_wrapper(&module_mapping);
+    return false;
+  }
+
+  // Nothing is registered until every section has been read, so falling back
+  // only has to drop what was mapped.
+  MappedAssets mapped;
+  const IndexEntry* e;
+  if (((e = find_entry("SPR ", -1)) && !map_sprites(e->offset, &mapped)) ||
+      ((e = find_entry("SND ", -1)) && !map_sounds(e->offset, &mapped)) ||
+      ((e = find_entry("BKG ", -1)) && !map_backgrounds(e->offset, &mapped))) {
+    DEBUG_MESSAGE("Resource module section " + std::string(e->kind, 3) + " unreadable; loading resources sequentially",
+                  MESSAGE_TYPE::M_WARNING);
+    module_index.clear();
+    funmap_wrapper(&module_mapping);
+    return false;
+  }
+  register_assets(mapped);
+  return true;
+}
+
+int64_t module_section_offset(const char* kind) {
+  const IndexEntry* e = find_entry(kind, -1);
+  return e ? int64_t(e->offset) : -1;
+}
+
+}  // namespace enigma
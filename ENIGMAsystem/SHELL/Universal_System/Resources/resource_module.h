@@ -0,0 +1,60 @@
+/** This file is a part of the ENIGMA Development Environment.
+***
+*** ENIGMA is free software: you can redistribute it and/or modify it under the
+*** terms of the GNU General Public License as published by the Free Software
+*** Foundation, version 3 of the license or any later version.
+***
+*** This application and its source code is distributed AS-IS, WITHOUT ANY
+*** WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+*** FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+*** details.
+***
+*** You should have received a copy of the GNU General Public License along
+*** with this code. If not, see <http://www.gnu.org/licenses/>
+**/
+
+#ifndef ENIGMA_RESOURCE_MODULE_H
+#define ENIGMA_RESOURCE_MODULE_H
+
+#include "Platforms/General/fileio.h"
+
+#include <cstdint>
+
+namespace enigma {
+
+/// An image whose packed pixels still live in the mapped resource module.
+/// Assets holding one are uploaded to the GPU on first use instead of at load.
+struct PendingImage {
+  const unsigned char* data = nullptr;
+  unsigned size = 0, unpacked = 0;
+  uint32_t hash = 0;
+  explicit operator bool() const { return data != nullptr; }
+};
+
+/// Inflates a pending image into a new[]-allocated buffer of img.unpacked
+/// bytes, suitable for handing to RawImage. Returns nullptr on corrupt data.
+/// If the image was prefetched, this waits for and returns that result.
+unsigned char* module_inflate(const PendingImage& img);
+
+/// Starts inflating a pending image on the worker pool, so that a later
+/// module_inflate of it only has to pick up the pixels.
+void module_prefetch(const PendingImage& img);
+/// Drops a prefetched image that is no longer wanted, freeing its pixels.
+void module_discard_prefetch(const PendingImage& img);
+/// Drops every prefetched image that has not been picked up yet.
+void module_discard_prefetches();
+
+/// Loads the sprites, sounds and backgrounds of an indexed ("res1") module.
+/// Sprites and backgrounds are registered with their metadata only and decode
+/// on first use; the mapping is kept alive for the rest of the program to back
+/// them. Returns false, having loaded nothing, if the module cannot be mapped
+/// or its index is unreadable; the caller should then read it sequentially.
+bool module_load_indexed(const char* path, int64_t index_pos);
+
+/// File offset of the given resource section (e.g. "FNT ") of the indexed
+/// module, or -1 if the module has no such section.
+int64_t module_section_offset(const char* kind);
+
+}  // namespace enigma
+
+#endif  // ENIGMA_RESOURCE_MODULE_H
@@ -18,7 +18,7 @@
 #include "libEGMstd.h"
 #include "resinit.h"
 #include "sprites_internal.h"
-#include "Universal_System/zlib.h"
+#include "image_pipeline.h"
 #include "Platforms/General/fileio.h"
 #include "Graphics_Systems/graphics_mandatory.h"
 #include "Platforms/platforms_mandatory.h"
@@ -26,6 +26,7 @@
 
 #include <cstring>
 #include <string>
+#include <vector>
 
 using enigma_user::toString;
 
@@ -52,6 +53,8 @@ namespace enigma
     if (sprcount == 0) return;
     sprites.resize(spr_highid+1);
 
+    ImagePipeline pipeline;
+
     for (int i = 0; i < sprcount; i++)
     {
       if (!fread_wrapper(&sprid, 4,1,exe)) return;
@@ -84,46 +87,33 @@ namespace enigma
       Sprite spr(width, height, xorig, yorig);
       spr.SetBBox(bbl, bbt, bbr-bbl, bbb-bbt);
       
+      sprites.assign(sprid, std::move(spr));
+
       for (int ii=0;ii<subimages;ii++)
       {
         int unpacked;
         if (!fread_wrapper(&unpacked,4,1,exe)) return;
         unsigned int size;
         if (!fread_wrapper(&size,4,1,exe)) return; //co//ut << "Alloc size: " << size << endl;
-        unsigned char* cpixels=new unsigned char[size+1];
-        if (!cpixels)
-        {  //FIXME: Uncomment these when tostring is available
-          DEBUG_MESSAGE("Failed to load sprite: Cannot allocate enough memory "+ toString(unpacked), MESSAGE_TYPE::M_ERROR);
-          break;
-        }
-        unsigned int sz2=fread_wrapper(cpixels,1,size,exe);
+        std::vector<unsigned char> cpixels(size);
+        unsigned int sz2=fread_wrapper(cpixels.data(),1,size,exe);
         if (size!=sz2) {
           DEBUG_MESSAGE("Failed to load sprite: Data is truncated before exe end. Read "+toString(sz2)+
                                   " out of expected "+toString(size), MESSAGE_TYPE::M_ERROR);
           return;
         }
-        unsigned char* pixels=new unsigned char[unpacked+1];
-        if (zlib_decompress(cpixels,size,unpacked,pixels) != unpacked)
-        {
-          DEBUG_MESSAGE("Sprite load error: Sprite does not match expected size", MESSAGE_TYPE::M_ERROR);
-          continue;
-        }
-        delete[] cpixels;
 
-        unsigned char* collision_data = 0;
-        switch (coll_type)
-        {
-          case ct_precise: collision_data = pixels; break;
-          case ct_circle:
-          case ct_ellipse:
-          case ct_diamond:
-          case ct_bbox: collision_data = 0; break;
-          case ct_polygon: collision_data = 0; break; //FIXME: Support vertex data.
-          default: collision_data = 0; break;
-        };
-
-        spr.AddSubimage(RawImage(pixels, width, height), coll_type, collision_data);
-        
+        // Inflated on the worker pool; the texture is created here, on the
+        // main thread, in subimage order.
+        pipeline.add(std::move(cpixels), unpacked, width, height, [sprid, coll_type](RawImage&& img) {
+          if (!img.pxdata) {
+            DEBUG_MESSAGE("Sprite load error: Sprite does not match expected size", MESSAGE_TYPE::M_ERROR);
+            return;
+          }
+          unsigned char* collision_data = (coll_type == ct_precise) ? img.pxdata : 0; //FIXME: Support vertex data.
+          sprites.get(sprid).AddSubimage(img, coll_type, collision_data);
+        });
+
         if (!fread_wrapper(&nullhere,4,1,exe)) return;
 
         if (nullhere)
@@ -132,8 +122,6 @@ namespace enigma
           break;
         }
       }
-      
-      sprites.assign(sprid, std::move(spr));
     }
   }
 }
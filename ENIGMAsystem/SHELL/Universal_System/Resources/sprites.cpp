@@ -165,6 +165,17 @@ bool sprite_exists(int spr) {
   return sprites.exists(spr);
 }
 
+int sprite_prefetch(int ind) {
+  if (!sprites.exists(ind)) return -1;
+  sprites.get(ind).Prefetch();
+  return 0;
+}
+
+int sprite_flush(int ind) {
+  if (!sprites.exists(ind)) return -1;
+  return sprites[ind].Flush() ? 0 : -1;
+}
+
 void sprite_delete(int ind, bool free_texture) {
   if (free_texture) sprites.get(ind).FreeTextures();
   sprites.destroy(ind);
@@ -70,6 +70,11 @@ void sprite_set_bbox(int ind, int left, int top, int right, int bottom);
 void sprite_collision_mask(int ind, bool sepmasks, int mode, int left, int top, int right, int bottom, int kind,
                            unsigned char tolerance); //FIXME: This only updates the bbox currently
 var sprite_get_uvs(int ind, int subimg);
+/// Creates the textures of a sprite still packed in the resource module. Returns 0 on success, -1 otherwise.
+int sprite_prefetch(int ind);
+/// Frees a sprite's textures until next use, if they can be reloaded from the resource module.
+/// Returns 0 on success, -1 otherwise.
+int sprite_flush(int ind);
 
 // Used for testing
 int sprite_create_color(unsigned w, unsigned h, int col); 
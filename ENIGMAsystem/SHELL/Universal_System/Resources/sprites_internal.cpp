@@ -4,6 +4,7 @@
 #include "Universal_System/Instances/instance_system.h"
 #include "Universal_System/Object_Tiers/graphics_object.h"
 #include "sprites_internal.h"
+#include "Widget_Systems/widgets_mandatory.h"
 
 namespace enigma {
 
@@ -20,6 +21,7 @@ Subimage::Subimage(const Subimage &s, bool duplicateTexture) {
   textureBounds = s.textureBounds;
   collisionType = s.collisionType;
   collisionData  = s.collisionData;
+  pending = s.pending;
 }
 
 void Subimage::FreeTexture() {
@@ -31,6 +33,7 @@ void Sprite::SetTexture(int subimg, int textureID, TexRect texRect) {
   Subimage& s = _subimages.get(subimg);
   s.textureID = textureID;
   s.textureBounds = texRect;
+  s.pending = PendingImage();  // The texture no longer derives from the module
 }
 
 const int Sprite::ModSubimage(int subimg) const {
@@ -72,6 +75,62 @@ void Sprite::AddSubimage(const Subimage& s) {
   _subimages.add(std::move(copy));
 }
 
+int Sprite::AddSubimage(const PendingImage& img, collision_type ct) {
+  Subimage subimg;
+  subimg.collisionType = ct;
+  subimg.pending = img;
+  return _subimages.add(std::move(subimg));
+}
+
+void Sprite::LoadPending(Subimage& s) const {
+  unsigned char* pixels = module_inflate(s.pending);
+  if (!pixels) {
+    DEBUG_MESSAGE("Sprite load error: Sprite does not match expected size", MESSAGE_TYPE::M_ERROR);
+    s.pending = PendingImage();  // Don't retry on every draw
+    return;
+  }
+  RawImage img(pixels, width, height);
+  unsigned fullwidth, fullheight;
+  s.textureID = graphics_create_texture(img, false, &fullwidth, &fullheight);
+  s.textureBounds = TexRect(0, 0, static_cast<gs_scalar>(img.w) / fullwidth, static_cast<gs_scalar>(img.h) / fullheight);
+  if (!s.collisionData)
+    s.collisionData = get_collision_mask(*this, s.collisionType == ct_precise ? pixels : nullptr, s.collisionType);
+}
+
+void Sprite::Prefetch() const {
+  for (size_t i = 0; i < SubimageCount(); ++i) Realize(i);
+}
+
+void Sprite::Stage() const {
+  for (std::pair<int, Subimage&> s : _subimages) {
+    if (s.second.textureID == -1 && s.second.pending) module_prefetch(s.second.pending);
+  }
+}
+
+bool Sprite::IsLoaded() const {
+  for (std::pair<int, Subimage&> s : _subimages) {
+    if (s.second.textureID == -1 && s.second.pending) return false;
+  }
+  return true;
+}
+
+void Sprite::CollectTextures(std::set<int>* out) const {
+  for (std::pair<int, Subimage&> s : _subimages) {
+    if (s.second.textureID != -1) out->insert(s.second.textureID);
+  }
+}
+
+bool Sprite::Flush() {
+  bool flushed = false;
+  for (std::pair<int, Subimage&> s : _subimages) {
+    if (!s.second.pending) continue;
+    module_discard_prefetch(s.second.pending);
+    if (s.second.textureID != -1) s.second.FreeTexture();
+    flushed = true;
+  }
+  return flushed;
+}
+
 const BoundingBox& sprite_get_bbox(int ind) {
   return sprites.get(ind).bbox;
 }
@@ -26,10 +26,13 @@
 #define ENIGMA_SPRITESTRUCT
 
 #include "AssetArray.h"
+#include "resource_module.h"
 #include "Collision_Systems/collision_types.h"
 #include "Universal_System/scalar.h"
 #include "Universal_System/image_formats.h"
 
+#include <set>
+
 namespace enigma {
 
 using BoundingBox = Rect<int>;
@@ -51,6 +54,9 @@ struct Subimage {
   TexRect textureBounds;
   collision_type collisionType = enigma::ct_precise;
   void* collisionData = nullptr;
+  /// Packed pixels in the resource module; the texture is created from these
+  /// on first use, and again after the sprite is flushed.
+  PendingImage pending;
 };
 
 class Sprite {
@@ -63,10 +69,10 @@ public:
   size_t SubimageCount() const { return _subimages.size(); }
   
   void FreeTextures() { for (std::pair<int, Subimage&> s : _subimages) s.second.FreeTexture(); }
-  const int& GetTexture(int subimg) const { return _subimages.get(subimg).textureID; }
+  const int& GetTexture(int subimg) const { return Realize(subimg).textureID; }
   const int ModSubimage(int subimg) const;
   void SetTexture(int subimg, int textureID, TexRect texRect);
-  const TexRect& GetTextureRect(int subimg) const { return _subimages.get(subimg).textureBounds; } 
+  const TexRect& GetTextureRect(int subimg) const { return Realize(subimg).textureBounds; } 
   
   /// Add Subimage from existing texture
   int AddSubimage(int texid, TexRect texRect, collision_type ct = ct_precise, void* collisionData = nullptr, bool mipmap = false);
@@ -74,8 +80,23 @@ public:
   int AddSubimage(const RawImage& img, collision_type ct = ct_precise, void* collisionData = nullptr, bool mipmap = false);
   /// Copy an existing subimage into the sprite (duplicating the texture)
   void AddSubimage(const Subimage& s);
+  /// Add Subimage whose pixels stay packed in the resource module until first use
+  int AddSubimage(const PendingImage& img, collision_type ct = ct_precise);
   
-  const Subimage& GetSubimage(int index) const { return _subimages.get(index); }
+  const Subimage& GetSubimage(int index) const { return Realize(index); }
+
+  /// Creates the textures of all subimages still pending in the resource module.
+  void Prefetch() const;
+  /// Starts inflating pending subimages in the background, without creating
+  /// textures; Prefetch() or first use then only has to upload them.
+  void Stage() const;
+  /// Frees the textures of subimages that can be recreated from the resource
+  /// module; they are decoded again on next use. Returns false if none could.
+  bool Flush();
+  /// Whether every subimage has its texture, without creating any.
+  bool IsLoaded() const;
+  /// Adds the textures its subimages already have to out, without creating any.
+  void CollectTextures(std::set<int>* out) const;
   
   void SetBBox(int x, int y, int w, int h) { bbox = {x, y, w, h}; }
   
@@ -93,7 +114,15 @@ public:
   
 protected:
   bool _destroyed = false;
-  AssetArray<Subimage> _subimages;
+  // Mutable so that const accessors can create pending textures on demand.
+  mutable AssetArray<Subimage> _subimages;
+
+  const Subimage& Realize(int subimg) const {
+    Subimage& s = _subimages.get(subimg);
+    if (s.textureID == -1 && s.pending) LoadPending(s);
+    return s;
+  }
+  void LoadPending(Subimage& s) const;
 };
 
 extern AssetArray<Sprite> sprites;
@@ -0,0 +1,234 @@
+/** This file is a part of the ENIGMA Development Environment.
+***
+*** ENIGMA is free software: you can redistribute it and/or modify it under the
+*** terms of the GNU General Public License as published by the Free Software
+*** Foundation, version 3 of the license or any later version.
+***
+*** This application and its source code is distributed AS-IS, WITHOUT ANY
+*** WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+*** FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+*** details.
+***
+*** You should have received a copy of the GNU General Public License along
+*** with this code. If not, see <http://www.gnu.org/licenses/>
+**/
+
+#include "buffer_codecs.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+namespace enigma {
+
+namespace {
+
+const char kHex[] = "0123456789abcdef";
+const char kBase64[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+std::string to_hex(const unsigned char *digest, size_t size) {
+  std::string hex(size * 2, '0');
+  for (size_t i = 0; i < size; ++i) {
+    hex[i * 2] = kHex[digest[i] >> 4];
+    hex[i * 2 + 1] = kHex[digest[i] & 15];
+  }
+  return hex;
+}
+
+inline uint32_t rotl(uint32_t x, int n) { return (x << n) | (x >> (32 - n)); }
+
+// Both digests take 64-byte blocks and pad the message the same way, except
+// that MD5 stores the bit length little endian and SHA-1 big endian.
+template<typename Block> void for_each_block(const unsigned char *data, size_t size, bool big_endian, Block block) {
+  size_t whole = size & ~size_t(63);
+  for (size_t i = 0; i < whole; i += 64) block(data + i);
+
+  unsigned char tail[128] = {};
+  const size_t rest = size - whole;
+  if (rest) std::memcpy(tail, data + whole, rest);
+  tail[rest] = 0x80;
+  const size_t tail_size = rest < 56 ? 64 : 128;
+  const uint64_t bits = uint64_t(size) * 8;
+  for (int i = 0; i < 8; ++i)
+    tail[tail_size - 8 + i] = (unsigned char) (bits >> (big_endian ? 56 - i * 8 : i * 8));
+  block(tail);
+  if (tail_size == 128) block(tail + 64);
+}
+
+}  // namespace
+
+void fill_pattern(unsigned char *dst, size_t size, const unsigned char *pattern, size_t pattern_size, size_t phase) {
+  if (!size || !pattern_size) return;
+  if (std::all_of(pattern + 1, pattern + pattern_size, [&](unsigned char c) { return c == pattern[0]; })) {
+    std::memset(dst, pattern[0], size);
+    return;
+  }
+  const size_t seed = std::min(size, pattern_size);
+  for (size_t i = 0; i < seed; ++i) dst[i] = pattern[(phase + i) % pattern_size];
+  // What is written so far is a whole number of periods, so it can be copied
+  // onward as is.
+  for (size_t done = seed; done < size; ) {
+    const size_t n = std::min(done, size - done);
+    std::memcpy(dst + done, dst, n);
+    done += n;
+  }
+}
+
+std::string md5_hex(const unsigned char *data, size_t size) {
+  static const uint32_t K[64] = {
+    0xd76aa478, 0xe8c7b756, 0x242070db, 0xc1bdceee, 0xf57c0faf, 0x4787c62a, 0xa8304613, 0xfd469501,
+    0x698098d8, 0x8b44f7af, 0xffff5bb1, 0x895cd7be, 0x6b901122, 0xfd987193, 0xa679438e, 0x49b40821,
+    0xf61e2562, 0xc040b340, 0x265e5a51, 0xe9b6c7aa, 0xd62f105d, 0x02441453, 0xd8a1e681, 0xe7d3fbc8,
+    0x21e1cde6, 0xc33707d6, 0xf4d50d87, 0x455a14ed, 0xa9e3e905, 0xfcefa3f8, 0x676f02d9, 0x8d2a4c8a,
+    0xfffa3942, 0x8771f681, 0x6d9d6122, 0xfde5380c, 0xa4beea44, 0x4bdecfa9, 0xf6bb4b60, 0xbebfbc70,
+    0x289b7ec6, 0xeaa127fa, 0xd4ef3085, 0x04881d05, 0xd9d4d039, 0xe6db99e5, 0x1fa27cf8, 0xc4ac5665,
+    0xf4292244, 0x432aff97, 0xab9423a7, 0xfc93a039, 0x655b59c3, 0x8f0ccc92, 0xffeff47d, 0x85845dd1,
+    0x6fa87e4f, 0xfe2ce6e0, 0xa3014314, 0x4e0811a1, 0xf7537e82, 0xbd3af235, 0x2ad7d2bb, 0xeb86d391};
+  static const int R[16] = {7, 12, 17, 22, 5, 9, 14, 20, 4, 11, 16, 23, 6, 10, 15, 21};
+
+  uint32_t h[4] = {0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476};
+  for_each_block(data, size, false, [&](const unsigned char *p) {
+    uint32_t m[16];
+    for (int i = 0; i < 16; ++i)
+      m[i] = p[i * 4] | (p[i * 4 + 1] << 8) | (p[i * 4 + 2] << 16) | (uint32_t(p[i * 4 + 3]) << 24);
+    uint32_t a = h[0], b = h[1], c = h[2], d = h[3];
+    for (int i = 0; i < 64; ++i) {
+      uint32_t f;
+      int g;
+      switch (i / 16) {
+        case 0: f = (b & c) | (~b & d); g = i; break;
+        case 1: f = (d & b) | (~d & c); g = (5 * i + 1) & 15; break;
+        case 2: f = b ^ c ^ d; g = (3 * i + 5) & 15; break;
+        default: f = c ^ (b | ~d); g = (7 * i) & 15; break;
+      }
+      const uint32_t next = d;
+      d = c;
+      c = b;
+      b += rotl(a + f + K[i] + m[g], R[(i / 16) * 4 + (i & 3)]);
+      a = next;
+    }
+    h[0] += a; h[1] += b; h[2] += c; h[3] += d;
+  });
+
+  unsigned char digest[16];
+  for (int i = 0; i < 16; ++i) digest[i] = (unsigned char) (h[i / 4] >> ((i & 3) * 8));
+  return to_hex(digest, 16);
+}
+
+std::string sha1_hex(const unsigned char *data, size_t size) {
+  uint32_t h[5] = {0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476, 0xc3d2e1f0};
+  for_each_block(data, size, true, [&](const unsigned char *p) {
+    uint32_t w[80];
+    for (int i = 0; i < 16; ++i)
+      w[i] = (uint32_t(p[i * 4]) << 24) | (p[i * 4 + 1] << 16) | (p[i * 4 + 2] << 8) | p[i * 4 + 3];
+    for (int i = 16; i < 80; ++i) w[i] = rotl(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+    uint32_t a = h[0], b = h[1], c = h[2], d = h[3], e = h[4];
+    for (int i = 0; i < 80; ++i) {
+      uint32_t f, k;
+      if (i < 20)      { f = (b & c) | (~b & d);          k = 0x5a827999; }
+      else if (i < 40) { f = b ^ c ^ d;                   k = 0x6ed9eba1; }
+      else if (i < 60) { f = (b & c) | (b & d) | (c & d); k = 0x8f1bbcdc; }
+      else             { f = b ^ c ^ d;                   k = 0xca62c1d6; }
+      const uint32_t t = rotl(a, 5) + f + e + k + w[i];
+      e = d;
+      d = c;
+      c = rotl(b, 30);
+      b = a;
+      a = t;
+    }
+    h[0] += a; h[1] += b; h[2] += c; h[3] += d; h[4] += e;
+  });
+
+  unsigned char digest[20];
+  for (int i = 0; i < 20; ++i) digest[i] = (unsigned char) (h[i / 4] >> (24 - (i & 3) * 8));
+  return to_hex(digest, 20);
+}
+
+std::string base64_encode(const unsigned char *data, size_t size) {
+  // Each 12-bit half of a 3-byte group maps straight to two characters.
+  static const struct Pairs {
+    char chars[4096][2];
+    Pairs() {
+      for (int i = 0; i < 4096; ++i) {
+        chars[i][0] = kBase64[i >> 6];
+        chars[i][1] = kBase64[i & 63];
+      }
+    }
+  } pairs;
+
+  std::string text((size + 2) / 3 * 4, '=');
+  char *out = &text[0];
+  size_t i = 0;
+  for (; i + 3 <= size; i += 3, out += 4) {
+    const uint32_t n = (uint32_t(data[i]) << 16) | (data[i + 1] << 8) | data[i + 2];
+    std::memcpy(out, pairs.chars[n >> 12], 2);
+    std::memcpy(out + 2, pairs.chars[n & 4095], 2);
+  }
+  if (i < size) {
+    const uint32_t n = (uint32_t(data[i]) << 16) | (i + 1 < size ? data[i + 1] << 8 : 0);
+    out[0] = kBase64[n >> 18];
+    out[1] = kBase64[(n >> 12) & 63];
+    if (i + 1 < size) out[2] = kBase64[(n >> 6) & 63];
+  }
+  return text;
+}
+
+bool base64_decode(const std::string &text, std::vector<unsigned char> *out) {
+  static const struct Table {
+    signed char value[256];
+    Table() {
+      std::memset(value, -1, sizeof value);
+      for (int i = 0; i < 64; ++i) value[(unsigned char) kBase64[i]] = i;
+      value['='] = -2;
+      value[' '] = value['\t'] = value['\n'] = value['\r'] = -3;
+    }
+  } table;
+
+  out->resize(text.size() / 4 * 3 + 3);
+  unsigned char *dst = out->data();
+  const unsigned char *src = (const unsigned char*) text.data(), *end = src + text.size();
+
+  // Runs of whole groups take the fast path; anything unusual falls through
+  // to the general loop below.
+  while (end - src >= 4) {
+    const int a = table.value[src[0]], b = table.value[src[1]], c = table.value[src[2]], d = table.value[src[3]];
+    if ((a | b | c | d) < 0) break;
+    const uint32_t n = (a << 18) | (b << 12) | (c << 6) | d;
+    dst[0] = (unsigned char) (n >> 16);
+    dst[1] = (unsigned char) (n >> 8);
+    dst[2] = (unsigned char) n;
+    dst += 3;
+    src += 4;
+  }
+
+  uint32_t bits = 0;
+  int count = 0;
+  bool padded = false;
+  for (; src != end; ++src) {
+    const signed char v = table.value[*src];
+    if (v == -3) continue;
+    if (v == -2) {
+      padded = true;
+      continue;
+    }
+    if (v < 0 || padded) return false;
+    bits = (bits << 6) | v;
+    if (++count == 4) {
+      *dst++ = (unsigned char) (bits >> 16);
+      *dst++ = (unsigned char) (bits >> 8);
+      *dst++ = (unsigned char) bits;
+      bits = 0;
+      count = 0;
+    }
+  }
+  if (count == 1) return false;
+  if (count == 2) *dst++ = (unsigned char) (bits >> 4);
+  if (count == 3) {
+    *dst++ = (unsigned char) (bits >> 10);
+    *dst++ = (unsigned char) (bits >> 2);
+  }
+  out->resize(dst - out->data());
+  return true;
+}
+
+}  // namespace enigma
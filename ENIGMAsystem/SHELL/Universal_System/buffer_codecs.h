@@ -0,0 +1,48 @@
+/** This file is a part of the ENIGMA Development Environment.
+***
+*** ENIGMA is free software: you can redistribute it and/or modify it under the
+*** terms of the GNU General Public License as published by the Free Software
+*** Foundation, version 3 of the license or any later version.
+***
+*** This application and its source code is distributed AS-IS, WITHOUT ANY
+*** WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+*** FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+*** details.
+***
+*** You should have received a copy of the GNU General Public License along
+*** with this code. If not, see <http://www.gnu.org/licenses/>
+**/
+
+#ifdef INCLUDED_FROM_SHELLMAIN
+#  error This file includes non-ENIGMA STL headers and should not be included from SHELLmain.
+#endif
+
+#ifndef ENIGMA_BUFFER_CODECS_H
+#define ENIGMA_BUFFER_CODECS_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// Bulk encoders and digests behind the buffer_* functions of the same names.
+namespace enigma {
+
+/// Repeats pattern over dst, starting phase bytes into the pattern. The first
+/// period is written once; the rest is copied from what was already written,
+/// doubling each time, so long fills are a handful of memcpy calls.
+void fill_pattern(unsigned char *dst, size_t size, const unsigned char *pattern, size_t pattern_size, size_t phase);
+
+/// Lowercase hex digests.
+std::string md5_hex(const unsigned char *data, size_t size);
+std::string sha1_hex(const unsigned char *data, size_t size);
+
+/// Standard base64 with '=' padding.
+std::string base64_encode(const unsigned char *data, size_t size);
+
+/// Decodes base64, with or without padding. Whitespace is skipped; any other
+/// character outside the alphabet makes it return false.
+bool base64_decode(const std::string &text, std::vector<unsigned char> *out);
+
+}  // namespace enigma
+
+#endif  // ENIGMA_BUFFER_CODECS_H
@@ -65,13 +65,20 @@ void buffer_copy(int src_buffer, unsigned src_offset, unsigned size, int dest_bu
 void buffer_save(int buffer, std::string filename);
 void buffer_save_ext(int buffer, std::string filename, unsigned offset, unsigned size);
 int buffer_load(std::string filename);
+// Like buffer_load, but the buffer views the file through a memory mapping,
+// so pages are only read as they are used. Writes to the buffer never reach
+// the file; the first resize copies the contents to ordinary memory.
+int buffer_load_mmap(std::string filename);
 void buffer_load_ext(int buffer, std::string filename, unsigned offset);
 
 int buffer_base64_decode(std::string str);
+// Returns how many decoded bytes were stored, which is fewer than decoded when
+// a fixed buffer ends first.
 int buffer_base64_decode_ext(int buffer, std::string str, unsigned offset);
 std::string buffer_base64_encode(int buffer, unsigned offset, unsigned size);
 std::string buffer_md5(int buffer, unsigned offset, unsigned size);
 std::string buffer_sha1(int buffer, unsigned offset, unsigned size);
+unsigned buffer_crc32(int buffer, unsigned offset, unsigned size);
 
 void *buffer_get_address(int buffer);
 unsigned buffer_get_size(int buffer);
@@ -22,13 +22,61 @@
 #ifndef ENIGMA_BUFFERS_INTERNAL_H
 #define ENIGMA_BUFFERS_INTERNAL_H
 
+#include "Platforms/General/fileio.h"
+
 #include <vector>
 
 namespace enigma
 {
+  /// The bytes of a buffer. They live on the heap, or in a private view of a
+  /// mapped file, which buffer writes may change without touching the file.
+  /// A mapped buffer moves to the heap the first time its size changes.
+  class buffer_storage
+  {
+    public:
+      typedef unsigned char *iterator;
+
+      buffer_storage() {}
+      buffer_storage(const buffer_storage &other): heap_(other.data(), other.data() + other.size()) {}
+      buffer_storage &operator=(const buffer_storage &other);
+      ~buffer_storage() { funmap_wrapper(&mapping_); }
+
+      /// Replaces the contents with a copy-on-write view of the named file.
+      bool map(const char *fname);
+      bool mapped() const { return mapping_.data != nullptr; }
+
+      unsigned char *data() { return mapped() ? const_cast<unsigned char*>(mapping_.data) : heap_.data(); }
+      const unsigned char *data() const { return mapped() ? mapping_.data : heap_.data(); }
+      size_t size() const { return mapped() ? mapping_.size : heap_.size(); }
+      unsigned char &operator[](size_t i) { return data()[i]; }
+      iterator begin() { return data(); }
+      iterator end() { return data() + size(); }
+
+      void resize(size_t count, unsigned char fill = 0);
+      template<typename It> void insert(iterator pos, It first, It last)
+      {
+        const size_t at = pos - begin();
+        if (!mapped())
+        {
+          heap_.insert(heap_.begin() + at, first, last);
+          return;
+        }
+        // The range may point into the mapping, which unmapping frees.
+        std::vector<unsigned char> bytes(first, last);
+        unmap(size());
+        heap_.insert(heap_.begin() + at, bytes.begin(), bytes.end());
+      }
+
+    private:
+      std::vector<unsigned char> heap_;
+      FileMapping mapping_;
+
+      void unmap(size_t keep);  ///< Copies the first keep bytes to the heap.
+  };
+
   struct BinaryBuffer
   {
-    std::vector<unsigned char> data;
+    buffer_storage data;
     unsigned position;
     unsigned alignment;
     int type;
@@ -40,9 +88,13 @@ namespace enigma
     void Seek(unsigned offset);  
     unsigned char ReadByte();
     void WriteByte(unsigned char byte);
+    void WriteBytes(const unsigned char *bytes, unsigned count);
   };
   
   extern std::vector<BinaryBuffer*> buffers;
+
+  /// Stores a new buffer in the first free slot and returns its id.
+  int add_buffer(BinaryBuffer *buffer);
 }
 
 #ifdef DEBUG_MODE
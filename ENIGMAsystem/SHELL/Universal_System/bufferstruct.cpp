@@ -17,6 +17,7 @@
 
 #include "buffers.h"
 #include "buffers_internal.h"
+#include "buffer_codecs.h"
 #include "libEGMstd.h"
 
 #include "Resources/AssetArray.h" // TODO: start actually using for this resource
@@ -24,15 +25,48 @@
 #include "Graphics_Systems/General/GSsurface.h"
 #include "Widget_Systems/widgets_mandatory.h"
 
+#include <algorithm>
 #include <cstring>
 #include <fstream>
 #include <iostream>
+#include <zlib.h>
 
 using std::string;
 
 namespace enigma {
 std::vector<BinaryBuffer*> buffers(0);
 
+buffer_storage &buffer_storage::operator=(const buffer_storage &other) {
+  if (this != &other) {
+    std::vector<unsigned char> copy(other.data(), other.data() + other.size());
+    funmap_wrapper(&mapping_);
+    heap_.swap(copy);
+  }
+  return *this;
+}
+
+bool buffer_storage::map(const char *fname) {
+  FileMapping mapping;
+  if (!fmap_wrapper(fname, &mapping, true)) return false;
+  funmap_wrapper(&mapping_);
+  mapping_ = mapping;
+  std::vector<unsigned char>().swap(heap_);
+  return true;
+}
+
+void buffer_storage::resize(size_t count, unsigned char fill) {
+  if (mapped()) {
+    if (count == mapping_.size) return;
+    unmap(std::min(count, mapping_.size));
+  }
+  heap_.resize(count, fill);
+}
+
+void buffer_storage::unmap(size_t keep) {
+  heap_.assign(mapping_.data, mapping_.data + keep);
+  funmap_wrapper(&mapping_);
+}
+
 BinaryBuffer::BinaryBuffer(unsigned size) {
   data.resize(size, 0);
   position = 0;
@@ -74,6 +108,20 @@ void BinaryBuffer::WriteByte(unsigned char byte) {
   Seek(position + 1);
 }
 
+// Same result as writing the bytes one at a time, but a single copy when
+// they fit, which they always do in a growable buffer.
+void BinaryBuffer::WriteBytes(const unsigned char *bytes, unsigned count) {
+  if (!count) return;
+  Seek(position);
+  if (type == enigma_user::buffer_grow && position + count > GetSize()) Resize(position + count);
+  if (position + count <= GetSize()) {
+    std::memcpy(&data[position], bytes, count);
+    Seek(position + count);
+    return;
+  }
+  for (unsigned i = 0; i < count; i++) WriteByte(bytes[i]);
+}
+
 int get_free_buffer() {
   for (unsigned i = 0; i < buffers.size(); i++) {
     if (!buffers[i]) {
@@ -83,6 +131,13 @@ int get_free_buffer() {
   return buffers.size();
 }
 
+int add_buffer(BinaryBuffer *buffer) {
+  const int id = get_free_buffer();
+  if (size_t(id) == buffers.size()) buffers.push_back(buffer);
+  else buffers[id] = buffer;
+  return id;
+}
+
 std::vector<unsigned char> valToBytes(variant value, unsigned count) {
   std::vector<unsigned char> result(0);
   for (unsigned i = 0; i < count; i++) {
@@ -90,6 +145,51 @@ std::vector<unsigned char> valToBytes(variant value, unsigned count) {
   }
   return result;
 }
+
+namespace {
+
+// Points at up to size bytes from offset. They stop at the end of the buffer,
+// except in a wrap buffer, where they go round to the start and so must be
+// gathered into scratch.
+const unsigned char *read_region(BinaryBuffer *buffer, unsigned offset, unsigned size,
+                                 std::vector<unsigned char> *scratch, size_t *count) {
+  const size_t total = buffer->GetSize();
+  *count = 0;
+  if (!total) return nullptr;
+  if (buffer->type == enigma_user::buffer_wrap) {
+    offset %= total;
+    *count = std::min<size_t>(size, total);
+    if (offset + *count > total) {
+      scratch->assign(buffer->data.begin() + offset, buffer->data.end());
+      scratch->insert(scratch->end(), buffer->data.begin(), buffer->data.begin() + (offset + *count - total));
+      return scratch->data();
+    }
+  } else if (offset < total) {
+    *count = std::min<size_t>(size, total - offset);
+  }
+  return buffer->data.data() + std::min<size_t>(offset, total);
+}
+
+// Hands write() the spans that size bytes from offset land in, along with how
+// many bytes precede each span. Grow buffers are enlarged to hold them all;
+// wrap buffers go round, keeping only the last lap; fixed buffers stop short.
+template<typename Write> void write_region(BinaryBuffer *buffer, size_t offset, size_t size, Write write) {
+  if (buffer->type == enigma_user::buffer_grow && offset + size > buffer->GetSize()) buffer->Resize(offset + size);
+  const size_t total = buffer->GetSize();
+  if (!total || !size) return;
+  if (buffer->type == enigma_user::buffer_wrap) {
+    const size_t skip = size > total ? size - total : 0;
+    size -= skip;
+    offset = (offset % total + skip) % total;
+    const size_t first = std::min(size, total - offset);
+    write(buffer->data.data() + offset, first, skip);
+    if (first < size) write(buffer->data.data(), size - first, skip + first);
+  } else if (offset < total) {
+    write(buffer->data.data() + offset, std::min(size, total - offset), size_t(0));
+  }
+}
+
+}  // namespace
 }  // namespace enigma
 
 namespace enigma_user {
@@ -98,9 +198,7 @@ int buffer_create(unsigned size, int type, unsigned alignment) {
   enigma::BinaryBuffer* buffer = new enigma::BinaryBuffer(size);
   buffer->type = type;
   buffer->alignment = alignment;
-  int id = enigma::get_free_buffer();
-  enigma::buffers.insert(enigma::buffers.begin() + id, buffer);
-  return id;
+  return enigma::add_buffer(buffer);
 }
 
 void buffer_delete(int buffer) {
@@ -117,22 +215,17 @@ void buffer_copy(int src_buffer, unsigned src_offset, unsigned size, int dest_bu
   get_buffer(srcbuff, src_buffer);
   get_buffer(dstbuff, dest_buffer);
 
-  unsigned over = size - srcbuff->GetSize();
-  switch (dstbuff->type) {
-    case buffer_wrap:
-      dstbuff->data.insert(dstbuff->data.begin() + dest_offset, srcbuff->data.begin() + src_offset,
-                           srcbuff->data.begin() + src_offset + size - over);
-      dstbuff->data.insert(dstbuff->data.begin() + dest_offset, srcbuff->data.begin(), srcbuff->data.begin() + over);
-      break;
-    case buffer_grow:
-      dstbuff->data.insert(dstbuff->data.begin() + dest_offset, srcbuff->data.begin() + src_offset,
-                           srcbuff->data.begin() + src_offset + size);
-      break;
-    default:
-      dstbuff->data.insert(dstbuff->data.begin() + dest_offset, srcbuff->data.begin() + src_offset,
-                           srcbuff->data.begin() + src_offset + size - over);
-      break;
+  std::vector<unsigned char> scratch;
+  size_t count;
+  const unsigned char *src = enigma::read_region(srcbuff, src_offset, size, &scratch, &count);
+  // Growing the destination would move a source in the same buffer.
+  if (srcbuff == dstbuff && src != scratch.data()) {
+    scratch.assign(src, src + count);
+    src = scratch.data();
   }
+  enigma::write_region(dstbuff, dest_offset, count, [src](unsigned char *dst, size_t n, size_t done) {
+    std::memcpy(dst, src + done, n);
+  });
 }
 
 void buffer_save(int buffer, string filename) {
@@ -174,21 +267,31 @@ void buffer_save_ext(int buffer, string filename, unsigned offset, unsigned size
 }
 
 int buffer_load(string filename) {
-  enigma::BinaryBuffer* buffer = new enigma::BinaryBuffer(0);
-  buffer->type = buffer_grow;
-  buffer->alignment = 1;
-  int id = enigma::get_free_buffer();
-  enigma::buffers.insert(enigma::buffers.begin() + id, buffer);
-
-  std::ifstream myfile(filename.c_str());
+  std::ifstream myfile(filename.c_str(), std::ios::binary | std::ios::ate);
   if (!myfile.is_open()) {
     DEBUG_MESSAGE("Unable to open file " + filename, MESSAGE_TYPE::M_ERROR);
     return -1;
   }
-  myfile.read(reinterpret_cast<char*>(&buffer->data[0]), myfile.tellg());
+  enigma::BinaryBuffer* buffer = new enigma::BinaryBuffer(myfile.tellg());
+  buffer->type = buffer_grow;
+  buffer->alignment = 1;
+  myfile.seekg(0);
+  myfile.read(reinterpret_cast<char*>(buffer->data.data()), buffer->GetSize());
   myfile.close();
 
-  return id;
+  return enigma::add_buffer(buffer);
+}
+
+int buffer_load_mmap(string filename) {
+  enigma::BinaryBuffer* buffer = new enigma::BinaryBuffer(0);
+  if (!buffer->data.map(filename.c_str())) {
+    // Empty files can't be mapped, and some platforms can't map at all.
+    delete buffer;
+    return buffer_load(filename);
+  }
+  buffer->type = buffer_grow;
+  buffer->alignment = 1;
+  return enigma::add_buffer(buffer);
 }
 
 void buffer_load_ext(int buffer, string filename, unsigned offset) {
@@ -220,20 +323,18 @@ void buffer_load_ext(int buffer, string filename, unsigned offset) {
 
 void buffer_fill(int buffer, unsigned offset, int type, variant value, unsigned size) {
   get_buffer(binbuff, buffer);
-  unsigned nsize = offset + size;
-  if (binbuff->GetSize() < nsize && binbuff->type == buffer_grow) {
-    binbuff->data.resize(nsize);
-  }
-  unsigned pos = offset;
-  for (unsigned i = 0; i < buffer_sizeof(type); i++) {
-    binbuff[pos] = value[i];
-    if (i > binbuff->GetSize()) {
-      if (binbuff->type != buffer_wrap) {
-        break;
-      }
-      pos = 0;
-    }
+  std::vector<unsigned char> pattern;
+  if (type == buffer_string || type == buffer_text) {
+    const string str = value.to_string();
+    pattern.assign(str.begin(), str.end());
+    if (type == buffer_string) pattern.push_back(0);
+  } else {
+    pattern = enigma::valToBytes(value, buffer_sizeof(type));
   }
+  if (pattern.empty()) return;
+  enigma::write_region(binbuff, offset, size, [&pattern](unsigned char *dst, size_t n, size_t done) {
+    enigma::fill_pattern(dst, n, pattern.data(), pattern.size(), done % pattern.size());
+  });
 }
   
 void *buffer_get_address(int buffer) {
@@ -380,37 +481,63 @@ void buffer_write(int buffer, int type, variant value) {
 }
 
 string buffer_md5(int buffer, unsigned offset, unsigned size) {
-  //get_bufferr(binbuff, buffer, 0);
-  //TODO: Write this function
-  return NULL;
+  get_bufferr(binbuff, buffer, "");
+  std::vector<unsigned char> scratch;
+  size_t count;
+  const unsigned char *data = enigma::read_region(binbuff, offset, size, &scratch, &count);
+  return enigma::md5_hex(data, count);
 }
 
 string buffer_sha1(int buffer, unsigned offset, unsigned size) {
-  //get_bufferr(binbuff, buffer, 0);
-  //TODO: Write this function
-  return NULL;
+  get_bufferr(binbuff, buffer, "");
+  std::vector<unsigned char> scratch;
+  size_t count;
+  const unsigned char *data = enigma::read_region(binbuff, offset, size, &scratch, &count);
+  return enigma::sha1_hex(data, count);
+}
+
+unsigned buffer_crc32(int buffer, unsigned offset, unsigned size) {
+  get_bufferr(binbuff, buffer, 0);
+  std::vector<unsigned char> scratch;
+  size_t count;
+  const unsigned char *data = enigma::read_region(binbuff, offset, size, &scratch, &count);
+  return crc32(crc32(0L, Z_NULL, 0), data, count);
 }
 
 int buffer_base64_decode(string str) {
-  enigma::BinaryBuffer* buffer = new enigma::BinaryBuffer(0);
+  std::vector<unsigned char> bytes;
+  if (!enigma::base64_decode(str, &bytes)) {
+    DEBUG_MESSAGE("Invalid base64 string", MESSAGE_TYPE::M_USER_ERROR);
+    return -1;
+  }
+  enigma::BinaryBuffer* buffer = new enigma::BinaryBuffer(bytes.size());
   buffer->type = buffer_grow;
   buffer->alignment = 1;
-  int id = enigma::get_free_buffer();
-  enigma::buffers.insert(enigma::buffers.begin() + id, buffer);
-  //TODO: Write this function
-  return id;
+  std::copy(bytes.begin(), bytes.end(), buffer->data.begin());
+  return enigma::add_buffer(buffer);
 }
 
 int buffer_base64_decode_ext(int buffer, string str, unsigned offset) {
-  //get_bufferr(binbuff, buffer, -1);
-  //TODO: Write this function
-  return 0;
+  get_bufferr(binbuff, buffer, -1);
+  std::vector<unsigned char> bytes;
+  if (!enigma::base64_decode(str, &bytes)) {
+    DEBUG_MESSAGE("Invalid base64 string", MESSAGE_TYPE::M_USER_ERROR);
+    return -1;
+  }
+  size_t written = 0;
+  enigma::write_region(binbuff, offset, bytes.size(), [&bytes, &written](unsigned char *dst, size_t n, size_t done) {
+    std::memcpy(dst, bytes.data() + done, n);
+    written += n;
+  });
+  return written;
 }
 
 string buffer_base64_encode(int buffer, unsigned offset, unsigned size) {
-  //get_bufferr(binbuff, buffer, 0);
-  //TODO: Write this function
-  return NULL;
+  get_bufferr(binbuff, buffer, "");
+  std::vector<unsigned char> scratch;
+  size_t count;
+  const unsigned char *data = enigma::read_region(binbuff, offset, size, &scratch, &count);
+  return enigma::base64_encode(data, count);
 }
 
 void game_save_buffer(int buffer) {
@@ -19,6 +19,7 @@
 
 #include <stdio.h>
 #include <string.h>
+#include <algorithm>
 #include <cstdlib>
 #include <vector>
 #include "var4.h"
@@ -67,6 +68,92 @@ static const char ldgrs[256] = {
   1,1,1,1,1,1,1,1,1,1,1,0,0,0,0,0
 };
 
+namespace {
+
+bool utf8_lead(char c) { return (c & 0xC0) != 0x80; }
+
+// Where every kStride-th code point of a string starts, so finding any one
+// takes a jump and a short scan instead of a walk from the front.
+struct utf8_index {
+  static const size_t kStride = 32;
+
+  const char *data = nullptr;       ///< The buffer indexed, when it is cached.
+  size_t size = 0;                  ///< Its size in bytes.
+  char sample[64];                  ///< Bytes spread over it; see sample_of.
+  size_t length = 0;                ///< In code points.
+  bool ascii = true;                ///< Then code points are bytes.
+  std::vector<size_t> checkpoints;  ///< Byte offset of code point k * kStride.
+
+  void build(const string &str) {
+    length = 0;
+    ascii = true;
+    checkpoints.clear();
+    for (size_t i = 0; i < str.length(); ++i) {
+      if (!utf8_lead(str[i])) continue;
+      if (length % kStride == 0) checkpoints.push_back(i);
+      ascii &= (unsigned char) str[i] < 0x80;
+      ++length;
+    }
+  }
+
+  // Byte offset of a code point, or the end of the string past the last.
+  size_t offset(const string &str, size_t cp) const {
+    if (cp >= length) return str.length();
+    if (ascii) return cp;
+    size_t at = checkpoints[cp / kStride];
+    for (size_t k = cp % kStride; k; --k)
+      do ++at; while (!utf8_lead(str[at]));
+    return at;
+  }
+
+  // The code point that the byte at an offset belongs to.
+  size_t code_point(const string &str, size_t at) const {
+    if (ascii) return at;
+    const size_t k = std::upper_bound(checkpoints.begin(), checkpoints.end(), at) - checkpoints.begin() - 1;
+    size_t cp = k * kStride;
+    for (size_t i = checkpoints[k] + 1; i <= at; ++i)
+      if (utf8_lead(str[i])) ++cp;
+    return cp;
+  }
+};
+
+// Indexing only pays for itself on long strings. A cached index is found by
+// the buffer and size of the string it was built from, so that a loop over a
+// string's characters does constant work per call. Those can survive the
+// string being reassigned or its memory reused, so 64 bytes spread over the
+// string, including both ends, must also still match; a string of the same
+// size that differs elsewhere is the one case that reuses a stale index.
+const size_t kMinCachedSize = 256;
+
+void sample_of(const string &str, char *out) {
+  const size_t words = 8, last = str.length() - 8;
+  for (size_t w = 0; w < words; ++w)
+    memcpy(out + w * 8, str.data() + last * w / (words - 1), 8);
+}
+
+const utf8_index &utf8_index_of(const string &str) {
+  thread_local utf8_index scratch;
+  if (str.length() < kMinCachedSize) {
+    scratch.build(str);
+    return scratch;
+  }
+  char sample[sizeof scratch.sample];
+  sample_of(str, sample);
+  thread_local utf8_index cache[4];
+  thread_local unsigned next = 0;
+  for (const utf8_index &idx : cache)
+    if (idx.data == str.data() && idx.size == str.length() && !memcmp(idx.sample, sample, sizeof sample))
+      return idx;
+  utf8_index &idx = cache[next++ % 4];
+  idx.data = str.data();
+  idx.size = str.length();
+  memcpy(idx.sample, sample, sizeof sample);
+  idx.build(str);
+  return idx;
+}
+
+}  // namespace
+
 static const std::string base64_chars = 
              "ABCDEFGHIJKLMNOPQRSTUVWXYZ"
              "abcdefghijklmnopqrstuvwxyz"
@@ -168,17 +255,13 @@ double real(variant str) { return str.type ? atof(((string)str).c_str()) : (doub
 
 string ansi_char(char byte) { return string(1,byte); }
 string chr(char val) { return string(1,val); }
-int ord(string str)  { return str[0]; }
+int ord(const string &str)  { return str[0]; }
 
-size_t string_length(string str) { return str.length(); }
+size_t string_length(const string &str) { return str.length(); }
 size_t string_length(const char* str) { return strlen(str); }
 
-size_t string_length_utf8(string str) { 
-  size_t res = 0; 
-  for (size_t i = 0; i < str.length(); ++i) 
-    if ((str[i] & 0xC0) != 0x80) 
-      ++res; 
-  return res; 
+size_t string_length_utf8(const string &str) {
+  return std::count_if(str.begin(), str.end(), utf8_lead);
 }
 
 size_t string_length_utf8(const char* str) { 
@@ -189,11 +272,31 @@ size_t string_length_utf8(const char* str) {
   return res; 
 }
 
-size_t string_pos(string substr,string str) {
+size_t string_pos(const string &substr, const string &str) {
   const size_t res = str.find(substr,0)+1;
   return res == string::npos ? 0 : (int)res;
 }
 
+string string_char_at_utf8(const string &str, int index) {
+  const utf8_index &idx = utf8_index_of(str);
+  const size_t cp = index <= 1 ? 0 : size_t(index - 1);
+  const size_t at = idx.offset(str, cp);
+  return str.substr(at, idx.offset(str, cp + 1) - at);
+}
+
+string string_copy_utf8(const string &str, int index, int count) {
+  if (count < 1) return "";
+  const utf8_index &idx = utf8_index_of(str);
+  const size_t cp = index <= 1 ? 0 : size_t(index - 1);
+  const size_t at = idx.offset(str, cp);
+  return str.substr(at, idx.offset(str, cp + count) - at);
+}
+
+size_t string_pos_utf8(const string &substr, const string &str) {
+  const size_t pos = str.find(substr);
+  return pos == string::npos ? 0 : utf8_index_of(str).code_point(str, pos) + 1;
+}
+
 string string_format(double val, unsigned tot, unsigned dec) {
   std::vector<char> sbuf(19 + tot + dec);
   sbuf[0] = 0;
@@ -201,7 +304,7 @@ string string_format(double val, unsigned tot, unsigned dec) {
   return sbuf.data();
 }
 
-string string_copy(string str, int index, int count) {
+string string_copy(const string &str, int index, int count) {
   index = index < 0 ? 0 : index;
   return (size_t)index > str.length()? "": str.substr(index < 2? 0: index-1, count < 1? 0: count);
 }
@@ -212,7 +315,7 @@ string string_set_byte_at(string str, int index, char byte) {
   return x>str.length()? str + byte: str.replace(x, 1, 1, byte);
 }
 
-char string_byte_at(string str, int index) {
+char string_byte_at(const string &str, int index) {
   unsigned int n = index <= 1 ? 0 : (unsigned int)(index - 1);
   #ifdef DEBUG_MODE
     if (n > str.length())
@@ -221,7 +324,7 @@ char string_byte_at(string str, int index) {
   return str[n];
 }
 
-string string_char_at(string str,int index) {
+string string_char_at(const string &str, int index) {
   unsigned int n = index <= 1 ? 0 : (unsigned int)(index - 1);
   #ifdef DEBUG_MODE
     if (n > str.length())
@@ -234,22 +337,22 @@ string string_delete(string str,int index,int count) {
   return str.erase(index < 2? 0: index-1, count < 1? 0: count);
 }
 
-string string_insert(string substr,string str,int index) {
+string string_insert(const string &substr, string str, int index) {
   if (index<=1) return substr + str;
   const size_t x = index-1;
   return x>str.length()? str + substr: str.insert(x, substr);
 }
 
-string string_replace(string str,string substr,string newstr) {
+string string_replace(string str, const string &substr, const string &newstr) {
   size_t pos=str.find(substr,0);
   return pos==(size_t)-1?str:str.replace(pos,substr.length(),newstr);
 }
 
-string string_replace_all(string str,string substr,string newstr) {
-  return ::string_replace_all(str, substr, newstr);
+string string_replace_all(string str, const string &substr, const string &newstr) {
+  return ::string_replace_all(std::move(str), substr, newstr);
 }
 
-size_t string_count(string substr,string str) {
+size_t string_count(const string &substr, const string &str) {
   size_t pos = 0, occ = 0;
   const size_t sublen = substr.length();
   while((pos=str.find(substr,pos)) != string::npos)
@@ -273,48 +376,48 @@ string string_upper(string str) {
   return str;
 }
 
-string string_repeat(string str,int count) {
+string string_repeat(const string &str, int count) {
   string ret; ret.reserve(str.length() * count);
   for(int i = count; i; i--) ret.append(str);
   return ret;
 }
 
-string string_letters(string str) {
+string string_letters(const string &str) {
   string ret;
   for(const char*c=str.c_str();*c;c++)
     if(ldgrs[(unsigned char)*c]&3) ret+=*c;
   return ret;
 }
 
-string string_digits(string str) {
+string string_digits(const string &str) {
   string ret;
   for(const char*c=str.c_str();*c;c++)
     if(ldgrs[(unsigned char)*c]&4) ret += *c;
   return ret;
 }
 
-string string_lettersdigits(string str) {
+string string_lettersdigits(const string &str) {
   string ret;
   for(const char*c=str.c_str();*c;c++)
     if(ldgrs[(unsigned char)*c]) ret += *c;
   return ret;
 }
 
-bool string_isletters(string str) {
+bool string_isletters(const string &str) {
   for(const char*c = str.c_str(); *c; c++)
     if(!(ldgrs[(unsigned char)*c] & 3))
       return false;
   return true;
 }
 
-bool string_isdigits(string str) {
+bool string_isdigits(const string &str) {
   for(const char*c = str.c_str(); *c; c++)
     if(!(ldgrs[(unsigned char)*c] & 4))
       return false;
   return true;
 }
 
-bool string_islettersdigits(string str) {
+bool string_islettersdigits(const string &str) {
   for(const char*c=str.c_str(); *c; c++)
     if(!ldgrs[(unsigned char)*c])
       return false;
@@ -323,19 +426,19 @@ bool string_islettersdigits(string str) {
 
 //filename fucntions place here as they are just string based
 
-string filename_name(string fname)
+string filename_name(const string &fname)
 {
   size_t fp = fname.find_last_of("/\\");
   return fname.substr(fp+1);
 }
 
-string filename_path(string fname)
+string filename_path(const string &fname)
 {
   size_t fp = fname.find_last_of("/\\");
   return fname.substr(0,fp+1);
 }
 
-string filename_dir(string fname)
+string filename_dir(const string &fname)
 {
   size_t fp = fname.find_last_of("/\\");
   if (fp == string::npos)
@@ -343,7 +446,7 @@ string filename_dir(string fname)
   return fname.substr(0, fp);
 }
 
-string filename_drive(string fname)
+string filename_drive(const string &fname)
 {
   size_t fp = fname.find_first_of("/\\");
   if (!fp || fp == string::npos || fname[fp-1] != ':')
@@ -351,16 +454,16 @@ string filename_drive(string fname)
   return fname.substr(0, fp);
 }
 
-string filename_ext(string fname)
+string filename_ext(const string &fname)
 {
-  fname = filename_name(fname);
+  const size_t name = fname.find_last_of("/\\") + 1;
   size_t fp = fname.find_last_of(".");
-  if (fp == string::npos)
+  if (fp == string::npos || fp < name)
     return "";
   return fname.substr(fp);
 }
 
-string filename_change_ext(string fname, string newext)
+string filename_change_ext(string fname, const string &newext)
 {
   size_t fp = fname.find_last_of(".");
   if (fp == string::npos)
@@ -43,47 +43,54 @@ bool is_base64(unsigned char byte);
 
 std::string ansi_char(char byte);
 std::string chr(char val);
-int ord(std::string str);
+int ord(const std::string &str);
 
 double real(variant str);
 
-size_t string_length(std::string str);
+size_t string_length(const std::string &str);
 size_t string_length(const char* str);
 #define string_byte_length(x) string_length(x)
-size_t string_length_utf8(std::string str);
+size_t string_length_utf8(const std::string &str);
 size_t string_length_utf8(const char* str);
-size_t string_pos(std::string substr, std::string str);
+size_t string_pos(const std::string &substr, const std::string &str);
+
+// Code point counterparts of string_char_at, string_copy and string_pos. Long
+// strings are indexed on first use, so walking one a character at a time
+// costs the same per step at the end as at the start.
+std::string string_char_at_utf8(const std::string &str, int index);
+std::string string_copy_utf8(const std::string &str, int index, int count);
+size_t string_pos_utf8(const std::string &substr, const std::string &str);
 
 std::string string_format(double val, unsigned tot, unsigned dec);
-std::string string_copy(std::string str, int index, int count);
+std::string string_copy(const std::string &str, int index, int count);
 std::string string_set_byte_at(std::string str, int pos, char byte);
-char string_byte_at(std::string str, int index);
-std::string string_char_at(std::string str, int index);
+char string_byte_at(const std::string &str, int index);
+std::string string_char_at(const std::string &str, int index);
 std::string string_delete(std::string str, int index, int count);
-std::string string_insert(std::string substr, std::string str, int index);
-std::string string_replace(std::string str, std::string substr, std::string newstr);
-std::string string_replace_all(std::string str, std::string substr, std::string newstr);
-size_t string_count(std::string substr, std::string str);
+std::string string_insert(const std::string &substr, std::string str, int index);
+std::string string_replace(std::string str, const std::string &substr, const std::string &newstr);
+std::string string_replace_all(std::string str, const std::string &substr, const std::string &newstr);
+size_t string_count(const std::string &substr, const std::string &str);
 
 std::string string_lower(std::string str);
 std::string string_upper(std::string str);
 
-std::string string_repeat(std::string str, int count);
+std::string string_repeat(const std::string &str, int count);
 
-std::string string_letters(std::string str);
-std::string string_digits(std::string str);
-std::string string_lettersdigits(std::string str);
+std::string string_letters(const std::string &str);
+std::string string_digits(const std::string &str);
+std::string string_lettersdigits(const std::string &str);
 
-bool string_isletters(std::string str);
-bool string_isdigits(std::string str);
-bool string_islettersdigits(std::string str);
+bool string_isletters(const std::string &str);
+bool string_isdigits(const std::string &str);
+bool string_islettersdigits(const std::string &str);
 
-std::string filename_name(std::string fname);
-std::string filename_path(std::string fname);
-std::string filename_dir(std::string fname);
-std::string filename_drive(std::string fname);
-std::string filename_ext(std::string fname);
-std::string filename_change_ext(std::string fname, std::string newext);
+std::string filename_name(const std::string &fname);
+std::string filename_path(const std::string &fname);
+std::string filename_dir(const std::string &fname);
+std::string filename_drive(const std::string &fname);
+std::string filename_ext(const std::string &fname);
+std::string filename_change_ext(std::string fname, const std::string &newext);
 
 var string_split(const std::string &str, const std::string &delim,
                  bool skip_empty = false);
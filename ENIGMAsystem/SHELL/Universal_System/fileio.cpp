@@ -20,9 +20,14 @@
 #include "Platforms/General/fileio.h"
 #include "Resources/AssetArray.h"
 #include "Widget_Systems/widgets_mandatory.h"
+#include "buffers.h"
+#include "buffers_internal.h"
 
+#include <algorithm>
 #include <fstream>
 #include <iostream>
+#include <iterator>
+#include <memory>
 #include <string>
 #include <iomanip>
 
@@ -33,17 +38,90 @@
 #endif
 
 namespace enigma {
-  
+
+  // Serves reads straight out of a memory mapped file.
+  class mapped_buf : public std::streambuf {
+   public:
+    mapped_buf(const FileMapping& mapping) {
+      char* data = reinterpret_cast<char*>(const_cast<unsigned char*>(mapping.data));
+      setg(data, data, data + mapping.size);
+    }
+
+   protected:
+    pos_type seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode which) override {
+      if (!(which & std::ios::in)) return pos_type(off_type(-1));
+      char* base = dir == std::ios::beg ? eback() : dir == std::ios::cur ? gptr() : egptr();
+      if (off < eback() - base || off > egptr() - base) return pos_type(off_type(-1));
+      setg(eback(), base + off, egptr());
+      return pos_type(gptr() - eback());
+    }
+    pos_type seekpos(pos_type pos, std::ios_base::openmode which) override {
+      return seekoff(off_type(pos), std::ios::beg, which);
+    }
+    std::streamsize showmanyc() override { return egptr() - gptr(); }
+  };
+
+  // A filebuf with a much larger buffer than the default, so that byte-sized
+  // reads and writes cost a syscall per 64K rather than per few K.
+  class buffered_filebuf : public std::filebuf {
+   public:
+    static const size_t kSize = 64 * 1024;
+    buffered_filebuf() : storage_(new char[kSize]) { pubsetbuf(storage_.get(), kSize); }
+    ~buffered_filebuf() { close(); }  // Flush before storage_ goes away.
+
+   private:
+    std::unique_ptr<char[]> storage_;
+  };
+
   struct file {
+    static const size_t kMinMappedSize = 256 * 1024;
+
     file() {}
-    file(const std::string& fName, std::ios_base::openmode mode) : fn(fName) { fs.open(fName, mode); }
-    file(file&& other) : fn(other.fn) { fs.swap(other.fs); }
+    file(const std::string& fName, std::ios_base::openmode mode) : fn(fName) { open(mode); }
+    file(file&& other) : fn(std::move(other.fn)), mapping(other.mapping), buf(std::move(other.buf)) {
+      fs.rdbuf(buf.get());
+      fs.clear(other.fs.rdstate());
+      other.mapping = FileMapping();
+      other.fs.rdbuf(nullptr);
+    }
+    ~file() { close(); }
     std::string fn;
-    std::fstream fs;
+    FileMapping mapping;                  // Set while a read-only file is mapped.
+    std::unique_ptr<std::streambuf> buf;  // Reads the mapping, or a buffered_filebuf.
+    std::iostream fs{nullptr};
+
+    bool open(std::ios_base::openmode mode) {
+      close();
+      #ifdef _WIN32
+      // Text mode translates line endings, which a mapping would not.
+      const bool mappable = mode == (std::ios::in | std::ios::binary);
+      #else
+      const bool mappable = (mode & ~std::ios::binary) == std::ios::in;
+      #endif
+      // Small files gain nothing from a mapping. Like any mapping, it must not
+      // be truncated by another handle while this one is open.
+      if (mappable && fmap_wrapper(fn.c_str(), &mapping) && mapping.size < kMinMappedSize)
+        funmap_wrapper(&mapping);
+      if (mapping.data) {
+        buf.reset(new mapped_buf(mapping));
+      } else {
+        std::unique_ptr<buffered_filebuf> fb(new buffered_filebuf);
+        if (!fb->open(fn, mode)) return false;
+        buf = std::move(fb);
+      }
+      fs.rdbuf(buf.get());
+      return true;
+    }
+    bool is_open() const { return buf != nullptr; }
+    void close() {
+      fs.rdbuf(nullptr);
+      buf.reset();
+      funmap_wrapper(&mapping);
+    }
     // AssArray mandatory
     static const char* getAssetTypeName() { return "FileHandle"; }
     bool isDestroyed() const { return false; }
-    void destroy() { fs.close(); }
+    void destroy() { close(); }
   };
   
   AssetArray<file> files;
@@ -63,7 +141,7 @@ namespace enigma {
     
     try_io_and_print(f)
     
-    if (f.fs.is_open()) {
+    if (f.is_open()) {
       files.add(std::move(f));
       return files.size()-1;
     } else return -1;
@@ -91,7 +169,7 @@ int file_text_open_append(const std::string& fname) {
 // Closes the file with the given file id
 void file_text_close(int fileid) {
   if (fileid >= 0 && fileid < static_cast<int>(enigma::files.size())) {
-    enigma::files.get(fileid).fs.close();
+    enigma::files.get(fileid).close();
   } else DEBUG_MESSAGE("Cannot close an unopened file: " + std::to_string(fileid), MESSAGE_TYPE::M_USER_ERROR);
 }
 
@@ -129,12 +207,24 @@ std::string file_text_read_string(int fileid) {
   return line;
 }
 
+// Reads the rest of the file in one go, newlines included.
 std::string file_text_read_all(int fileid) {
-  std::string all, line;
-  while(std::getline(enigma::files.get(fileid).fs, line)) {
-    try_io_and_print(enigma::files.get(fileid))
-    all += line;
+  std::iostream& fs = enigma::files.get(fileid).fs;
+  std::string all;
+  const std::streampos at = fs.tellg();
+  const std::streampos end = fs.seekg(0, std::ios::end).tellg();
+  if (at != std::streampos(-1) && end != std::streampos(-1)) {
+    fs.seekg(at);
+    // Text mode may shrink line endings, so the read can come up short.
+    all.resize(std::max<std::streamoff>(end - at, 0));
+    fs.read(&all[0], all.size());
+    all.resize(fs.gcount());
+  } else {
+    fs.clear();
+    all.assign(std::istreambuf_iterator<char>(fs), std::istreambuf_iterator<char>());
   }
+  fs.clear();
+  fs.setstate(std::ios::eofbit);
   return all;
 }
 
@@ -179,15 +269,14 @@ int file_bin_open(const std::string& fname, int mode) {
 
 // Rewrites the file with the given file id, that is, clears it and starts writing at the start.
 bool file_bin_rewrite(int fileid) {
-  enigma::files.get(fileid).fs.close();
-  enigma::files.get(fileid).fs.open(enigma::files.get(fileid).fn, std::ios::in | std::ios::out | std::ios::binary | std::ios::trunc);
+  enigma::files.get(fileid).open(std::ios::in | std::ios::out | std::ios::binary | std::ios::trunc);
   try_io_and_print(enigma::files.get(fileid))
   return enigma::files.get(fileid).fs.good();
 }
 
 // Closes the file with the given file id.
 void file_bin_close(int fileid) {
-  enigma::files.get(fileid).fs.close();
+  enigma::files.get(fileid).close();
 }
 
 // Returns the size (in bytes) of the file with the given file id.
@@ -213,17 +302,50 @@ void file_bin_seek(int fileid, size_t pos) {
 
 // Writes a byte of data to the file with the given file id.
 void file_bin_write_byte(int fileid, unsigned char byte) {
-  enigma::files.get(fileid).fs << byte;
+  enigma::files.get(fileid).fs.put(byte);
   try_io_and_print(enigma::files.get(fileid))
 }
 
 // Reads a byte of data from the file and returns this
 int file_bin_read_byte(int fileid) {
-  unsigned char byte = 0;
-  enigma::files.get(fileid).fs >> std::noskipws >> byte;
+  const int byte = enigma::files.get(fileid).fs.get();
   bool good = enigma::files.get(fileid).fs.good();
   try_io_and_print(enigma::files.get(fileid))
-  return (!good) ? -1 : static_cast<int>(byte);
+  return (!good) ? -1 : byte;
+}
+
+// Reads up to size bytes from the file's position into the buffer at offset, and returns how many were read. Grow buffers are enlarged to fit; other buffers only take what fits.
+size_t file_bin_read_buffer(int fileid, int buffer, size_t offset, size_t size) {
+  get_bufferr(binbuff, buffer, 0);
+  const size_t old_size = binbuff->GetSize();
+  if (binbuff->type == buffer_grow) {
+    if (offset + size > old_size) binbuff->Resize(offset + size);
+  } else {
+    size = offset < old_size ? std::min(size, old_size - offset) : 0;
+  }
+  std::iostream& fs = enigma::files.get(fileid).fs;
+  if (size) fs.read(reinterpret_cast<char*>(binbuff->data.data() + offset), size);
+  const size_t read = fs.gcount();
+  if (read < size && binbuff->GetSize() > old_size)
+    binbuff->Resize(std::max(old_size, offset + read));
+  if (read < size && fs.eof()) {
+    fs.clear(std::ios::eofbit);  // Running out of file is not an error here.
+  } else {
+    try_io_and_print(enigma::files.get(fileid))
+  }
+  return read;
+}
+
+// Writes size bytes of the buffer, starting at offset, at the file's position, and returns how many were written.
+size_t file_bin_write_buffer(int fileid, int buffer, size_t offset, size_t size) {
+  get_bufferr(binbuff, buffer, 0);
+  const size_t buffer_size = binbuff->GetSize();
+  size = offset < buffer_size ? std::min(size, buffer_size - offset) : 0;
+  std::iostream& fs = enigma::files.get(fileid).fs;
+  if (size) fs.write(reinterpret_cast<const char*>(binbuff->data.data() + offset), size);
+  const bool good = fs.good();
+  try_io_and_print(enigma::files.get(fileid))
+  return good ? size : 0;
 }
 
 } // NAMESPACE enigma_user
@@ -33,6 +33,7 @@
 #include "Instances/instance.h"
 #include "Object_Tiers/planar_object.h"
 #include "Resources/backgrounds.h"
+#include "Resources/asset_groups.h"
 
 #include "roomsystem.h"
 #include "depth_draw.h"
@@ -170,6 +171,8 @@ namespace enigma
     }
   }
 
+  bool room_evict_assets = false;
+
   void roomstruct::gotome(bool gamestart)
   {
     using namespace enigma_user;
@@ -178,6 +181,8 @@ namespace enigma
 
     perform_callbacks_clean_up_roomend();
 
+    asset_group_enter(assets, room_evict_assets);
+
     // Set the index to self
     room.rval.d = id;
     room_caption = cap;
@@ -244,6 +249,8 @@ namespace enigma
       enigma_user::screen_refresh();
     }
 
+    perform_callbacks_room_start();
+
     //Load tiles
     delete_tiles();
     for (enigma::diter dit = drawing_depths.rbegin(); dit != drawing_depths.rend(); dit++){
@@ -345,9 +352,22 @@ int room_goto(int indx)
   errcheck(indx,"Attempting to go to nonexisting room", 0);
   enigma::room_switching_id = indx;
   enigma::room_switching_restartgame = false;
+  room_prefetch(enigma::room_switching_id);
+  return 1;
+}
+
+int room_prefetch(int indx)
+{
+  if (!room_exists(indx)) return 0;
+  enigma::asset_group_prefetch(enigma::roomdata[indx]->assets);
   return 1;
 }
 
+void room_set_asset_eviction(bool enable)
+{
+  enigma::room_evict_assets = enable;
+}
+
 int room_restart()
 {
   int indx=(int)room.rval.d;
@@ -374,6 +394,7 @@ int room_goto_absolute(int indx)
 
   enigma::room_switching_id = index;
   enigma::room_switching_restartgame = false;
+  room_prefetch(enigma::room_switching_id);
   return 1;
 }
 
@@ -388,6 +409,7 @@ int room_goto_first(bool restart_game)
   enigma::roomstruct *rit = enigma::roomorder[0];
   enigma::room_switching_id = rit->id;
   enigma::room_switching_restartgame = restart_game;
+  room_prefetch(enigma::room_switching_id);
   return 1;
 }
 
@@ -401,6 +423,7 @@ int room_goto_next()
 
   enigma::room_switching_id = rit->id;
   enigma::room_switching_restartgame = false;
+  room_prefetch(enigma::room_switching_id);
   return 1;
 }
 
@@ -414,6 +437,7 @@ int room_goto_previous()
 
   enigma::room_switching_id = rit->id;
   enigma::room_switching_restartgame = false;
+  room_prefetch(enigma::room_switching_id);
   return 1;
 }
 
@@ -682,6 +706,7 @@ int room_duplicate(int indx, bool ass, int assroom)
   rm->precreatecode = copyrm->precreatecode;
   rm->instances = copyrm->instances;
   rm->tiles = copyrm->tiles;
+  rm->assets = copyrm->assets;
 
   enigma::viewstruct vw, vc;
   for (int i = 0; i < 8; i++)
@@ -53,6 +53,12 @@ int room_goto_next();
 int room_next(int num);
 int room_previous(int num);
 bool room_exists(int roomid);
+/// Starts decoding the sprites and backgrounds the given room uses in the background.
+/// Whatever the next room entered does not use is dropped again.
+int room_prefetch(int indx);
+/// When enabled, entering a room frees the textures of sprites and backgrounds
+/// it does not use; they are decoded again from the game module if needed.
+void room_set_asset_eviction(bool enable);
 int room_set_width(int indx, int wid);
 int room_set_height(int indx, int hei);
 int room_set_background(int indx, int bind, bool vis, bool fore, bool back, double x, double y, bool htiled, bool vtiled, double hspeed, double vspeed, double alpha = 1, int color = 0xFFFFFF);
@@ -153,6 +159,11 @@ namespace enigma
     double alpha;
     int color;
   };
+  /// Resources a room can use, as worked out by the compiler. Sprites and
+  /// backgrounds in the group are decoded ahead of entering the room.
+  struct roomassets {
+    std::vector<int> sprites, backgrounds, sounds, fonts;
+  };
   struct roomstruct
   {
     int id;
@@ -170,10 +181,14 @@ namespace enigma
     backstruct backs[10];
     std::vector<inst> instances;
     std::vector<tile> tiles;
+    roomassets assets;
 
     void end();
     void gotome(bool gamestart = false);
   };
+  extern roomstruct** roomdata;   // by room ID
+  extern roomstruct** roomorder;  // by room order
+  extern int room_loadtimecount;
   void update_mouse_variables();
   extern int maxid, maxtileid;
   extern int room_switching_id; // -1 indicates no room set.
@@ -0,0 +1,191 @@
+/** This file is a part of the ENIGMA Development Environment.
+***
+*** ENIGMA is free software: you can redistribute it and/or modify it under the
+*** terms of the GNU General Public License as published by the Free Software
+*** Foundation, version 3 of the license or any later version.
+***
+*** This application and its source code is distributed AS-IS, WITHOUT ANY
+*** WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+*** FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+*** details.
+***
+*** You should have received a copy of the GNU General Public License along
+*** with this code. If not, see <http://www.gnu.org/licenses/>
+**/
+
+#include "worker_pool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace enigma {
+
+namespace {
+
+// Index of the worker running on this thread, or -1 off the pool.
+thread_local int current_worker = -1;
+
+// Each worker owns a queue. Tasks submitted from a worker go on its own
+// queue, which it drains newest first while the data they touch is still
+// in cache; idle workers steal from the other end of their peers' queues.
+class WorkerPool {
+ public:
+  WorkerPool() {
+    unsigned hw = std::thread::hardware_concurrency();
+    count_ = hw > 1 ? hw - 1 : 0;
+    queues_.reset(new Queue[count_]);
+    for (size_t i = 0; i < count_; ++i) threads_.emplace_back([this, i] { run(int(i)); });
+  }
+
+  ~WorkerPool() {
+    {
+      std::lock_guard<std::mutex> lock(sleep_mutex_);
+      stopping_ = true;
+    }
+    wake_.notify_all();
+    for (std::thread& t : threads_) t.join();
+  }
+
+  size_t size() const { return count_; }
+
+  void submit(std::function<void()> task) {
+    if (!count_) {
+      task();
+      return;
+    }
+    const size_t q = current_worker >= 0 ? size_t(current_worker) : next_queue_++ % count_;
+    {
+      std::lock_guard<std::mutex> lock(queues_[q].mutex);
+      queues_[q].tasks.push_back(std::move(task));
+    }
+    {
+      std::lock_guard<std::mutex> lock(sleep_mutex_);
+      ++pending_;
+    }
+    wake_.notify_one();
+  }
+
+  bool help() {
+    std::function<void()> task;
+    if (!take(current_worker, &task)) return false;
+    task();
+    return true;
+  }
+
+ private:
+  struct Queue {
+    std::mutex mutex;
+    std::deque<std::function<void()>> tasks;
+  };
+
+  size_t count_;
+  std::unique_ptr<Queue[]> queues_;
+  std::vector<std::thread> threads_;
+  std::atomic<size_t> next_queue_{0};
+  std::atomic<long> pending_{0};  // Raised under sleep_mutex_, so sleepers can't miss it.
+  std::mutex sleep_mutex_;
+  std::condition_variable wake_;
+  bool stopping_ = false;
+
+  bool pop(Queue& q, bool newest, std::function<void()>* task) {
+    std::lock_guard<std::mutex> lock(q.mutex);
+    if (q.tasks.empty()) return false;
+    if (newest) {
+      *task = std::move(q.tasks.back());
+      q.tasks.pop_back();
+    } else {
+      *task = std::move(q.tasks.front());
+      q.tasks.pop_front();
+    }
+    --pending_;
+    return true;
+  }
+
+  bool take(int self, std::function<void()>* task) {
+    if (self >= 0 && pop(queues_[self], true, task)) return true;
+    const size_t first = self >= 0 ? size_t(self) + 1 : 0;
+    for (size_t k = 0; k < count_; ++k) {
+      const size_t victim = (first + k) % count_;
+      if (int(victim) != self && pop(queues_[victim], false, task)) return true;
+    }
+    return false;
+  }
+
+  void run(int self) {
+    current_worker = self;
+    for (;;) {
+      std::function<void()> task;
+      if (take(self, &task)) {
+        task();
+        continue;
+      }
+      std::unique_lock<std::mutex> lock(sleep_mutex_);
+      wake_.wait(lock, [this] { return stopping_ || pending_ > 0; });
+      if (stopping_ && pending_ <= 0) return;
+    }
+  }
+};
+
+WorkerPool& pool() {
+  static WorkerPool instance;
+  return instance;
+}
+
+}  // namespace
+
+size_t worker_count() {
+  return pool().size();
+}
+
+void worker_submit(std::function<void()> task) {
+  pool().submit(std::move(task));
+}
+
+bool worker_help() {
+  return pool().help();
+}
+
+void parallel_for(size_t count, const std::function<void(size_t)>& job) {
+  const size_t helpers = std::min(worker_count(), count ? count - 1 : 0);
+  if (!helpers) {
+    for (size_t i = 0; i < count; ++i) job(i);
+    return;
+  }
+
+  // Indices are claimed from a shared counter, so a slow job never leaves
+  // the other threads idle while there is still work left.
+  std::atomic<size_t> next{0};
+  size_t finished = 0;
+  std::mutex mutex;
+  std::condition_variable done;
+  auto work = [&] {
+    for (size_t i; (i = next++) < count; ) job(i);
+  };
+
+  for (size_t h = 0; h < helpers; ++h) {
+    worker_submit([&] {
+      work();
+      std::lock_guard<std::mutex> lock(mutex);
+      if (++finished == helpers) done.notify_one();
+    });
+  }
+  work();
+
+  // Run other queued tasks rather than block, so that a parallel_for called
+  // from inside a task can't stall waiting on helpers queued behind it.
+  std::unique_lock<std::mutex> lock(mutex);
+  while (finished != helpers) {
+    lock.unlock();
+    const bool helped = worker_help();
+    lock.lock();
+    if (!helped) done.wait(lock, [&] { return finished == helpers; });
+  }
+}
+
+}  // namespace enigma
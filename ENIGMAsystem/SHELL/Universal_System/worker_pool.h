@@ -0,0 +1,47 @@
+/** This file is a part of the ENIGMA Development Environment.
+***
+*** ENIGMA is free software: you can redistribute it and/or modify it under the
+*** terms of the GNU General Public License as published by the Free Software
+*** Foundation, version 3 of the license or any later version.
+***
+*** This application and its source code is distributed AS-IS, WITHOUT ANY
+*** WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+*** FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+*** details.
+***
+*** You should have received a copy of the GNU General Public License along
+*** with this code. If not, see <http://www.gnu.org/licenses/>
+**/
+
+#ifdef INCLUDED_FROM_SHELLMAIN
+#  error This file includes non-ENIGMA STL headers and should not be included from SHELLmain.
+#endif
+
+#ifndef ENIGMA_WORKER_POOL_H
+#define ENIGMA_WORKER_POOL_H
+
+#include <cstddef>
+#include <functional>
+
+namespace enigma {
+
+/// Number of background threads owned by the runtime's worker pool. The pool
+/// is started on first use with one thread less than the hardware offers, so
+/// it may be zero on single-core machines.
+size_t worker_count();
+
+/// Queues a task to run on a worker thread. With no workers, it runs at once
+/// on the calling thread. Tasks must not touch graphics, audio or instances.
+void worker_submit(std::function<void()> task);
+
+/// Runs one queued task on the calling thread, if there is one. Returns
+/// whether it did. Threads waiting on pool work call this to help out.
+bool worker_help();
+
+/// Runs job(0) ... job(count - 1) across the workers and the calling thread,
+/// returning once every call has finished. It may be called from a task.
+void parallel_for(size_t count, const std::function<void(size_t)>& job);
+
+}  // namespace enigma
+
+#endif  // ENIGMA_WORKER_POOL_H